@@ -0,0 +1,112 @@
+#!/bin/bash
+set -o errexit -o pipefail -o nounset
+
+function display_help ()
+{
+    echo '
+usage: compare-build-size.sh --platform-id=<6|8|10|12|13|22|23|25|26>
+                             [--app=<app>] [--output-directory=<directory>]
+                             [--help]
+
+Build the Device OS and an application in the four combinations of
+MODULAR=y|n and COMPILE_LTO=n|y, and print the time it took to build and the
+output of `arm-none-eabi-size` for every `.elf` file produced by each build.
+The output of each build is saved to a log file next to its directory. The
+script does not measure the run time of the images.
+
+  -a, --app               Application to build. Defaults to `tinker`.
+  -h, --help              Display this help and exit.
+  -i, --platform-id       Specify the desired platform id.
+  -o, --output-directory  Root directory for the build artifacts. Each
+                            combination is built in its own subdirectory.
+                            Defaults to `<particle-iot/device-os>...
+                            /build/target/compare`.
+'
+}
+
+OPTIONS=a:hi:o:
+LONGOPTS=app:,help,platform-id:,output-directory:
+
+! PARSED=$(getopt --options=$OPTIONS --longoptions=$LONGOPTS --name "$0" -- "$@")
+if [ ${PIPESTATUS[0]} -ne 0 ]; then
+    exit 2
+fi
+eval set -- "$PARSED"
+
+APP="tinker"
+PLATFORM_ID=""
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+ROOT_DIR="$(dirname "$SCRIPT_DIR")"
+OUTPUT_DIRECTORY="$SCRIPT_DIR/target/compare"
+
+while true; do
+    case "$1" in
+        -a|--app)
+            APP="$2"
+            shift 2
+            ;;
+        -h|--help)
+            display_help
+            exit 0
+            ;;
+        -i|--platform-id)
+            PLATFORM_ID="$2"
+            shift 2
+            ;;
+        -o|--output-directory)
+            OUTPUT_DIRECTORY="$2"
+            shift 2
+            ;;
+        --)
+            shift
+            break
+            ;;
+        *)
+            echo "Encountered error while parsing arguments!"
+            exit 3
+            ;;
+    esac
+done
+
+if [ -z "$PLATFORM_ID" ]; then
+    echo "USAGE ERROR: \`--platform-id\` is required!"
+    exit 5
+fi
+
+mkdir -p "$OUTPUT_DIRECTORY"
+OUTPUT_DIRECTORY="$(cd "$OUTPUT_DIRECTORY" && pwd)"
+REPORT=""
+FAILED=0
+
+for modular in y n; do
+    # Monolithic images are built from `main`, modular ones from `modules` (see release.sh)
+    if [ "$modular" = "y" ]; then
+        make_dir="$ROOT_DIR/modules"
+    else
+        make_dir="$ROOT_DIR/main"
+    fi
+    for compile_lto in n y; do
+        config="MODULAR=$modular COMPILE_LTO=$compile_lto"
+        build_dir="$OUTPUT_DIRECTORY/modular-$modular-lto-$compile_lto"
+        rm -rf "$build_dir"
+        echo "Building with $config"
+        start=$(date +%s)
+        if ! make -s -C "$make_dir" clean all PLATFORM_ID=$PLATFORM_ID APP=$APP MODULAR=$modular \
+                COMPILE_LTO=$compile_lto BUILD_PATH_BASE="$build_dir" > "$build_dir.log" 2>&1; then
+            echo "Build failed, see $build_dir.log"
+            REPORT+="
+## $config: build failed, see $build_dir.log
+"
+            FAILED=1
+            continue
+        fi
+        end=$(date +%s)
+        REPORT+="
+## $config, build time: $((end - start)) s
+$(find "$build_dir" -name '*.elf' -print0 | sort -z | xargs -0 arm-none-eabi-size)
+"
+    done
+done
+
+echo "$REPORT"
+exit $FAILED
@@ -23,6 +23,11 @@ else
 CFLAGS += -DRELEASE_BUILD
 endif
 
+# Collect per-thread CPU time and stack usage statistics (Gen 3 platforms only)
+ifeq ("$(THREAD_PROFILER)","y")
+CFLAGS += -DTHREAD_PROFILER
+endif
+
 ifdef SPARK_TEST_DRIVER
 CFLAGS += -DSPARK_TEST_DRIVER=$(SPARK_TEST_DRIVER)
 endif
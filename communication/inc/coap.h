@@ -110,9 +110,29 @@ namespace CoAPCode {
 namespace CoAPOption {
 	enum Enum {
 		NONE = 0,
+		ETAG = 4,
 		LOCATION_PATH = 8,
 		URI_PATH = 11,
-		URI_QUERY = 15
+		CONTENT_FORMAT = 12,
+		URI_QUERY = 15,
+		BLOCK2 = 23
+	};
+}
+
+/**
+ * Values of the Content-Format option.
+ */
+namespace CoAPContentFormat {
+	enum Enum {
+		TEXT_PLAIN = 0,
+		OCTET_STREAM = 42,
+		JSON = 50,
+		CBOR = 60,
+		/**
+		 * Raw deflate stream (RFC 1951) of a text payload. This value is from the range reserved
+		 * for experimental use and is only sent to a server that has advertised its support.
+		 */
+		DEFLATE = 65000
 	};
 }
 
@@ -191,6 +211,55 @@ public:
     static size_t token(const unsigned char* message, token_t* token);
     static size_t option_decode(unsigned char **option);
 
+    /**
+     * Finds the first instance of an option in a CoAP message.
+     *
+     * @param message Message data.
+     * @param size Message size.
+     * @param option Option number.
+     * @param[out] value Option value.
+     * @param[out] value_size Size of the option value.
+     * @return `true` if the option was found or `false` otherwise.
+     */
+    static bool find_option(const uint8_t* message, size_t size, unsigned option, const uint8_t** value, size_t* value_size);
+
+    /**
+     * Finds the payload of a CoAP message.
+     *
+     * @return `true` if the message has a payload or `false` otherwise.
+     */
+    static bool find_payload(const uint8_t* message, size_t size, const uint8_t** payload, size_t* payload_size);
+
+    /**
+     * Adds a Content-Format option to the buffer.
+     */
+    static size_t content_format_option(uint8_t* buf, CoAPOption::Enum previous, uint16_t format);
+
+    /**
+     * Maximum value of the SZX field of a block option (RFC 7959).
+     */
+    static const uint8_t MAX_BLOCK_SZX = 6;
+
+    /**
+     * Returns the block size for a given SZX value.
+     */
+    static size_t block_size(uint8_t szx)
+    {
+        return (size_t)1 << (szx + 4);
+    }
+
+    /**
+     * Adds a Block1 or Block2 option (RFC 7959) to the buffer.
+     */
+    static size_t block_option(uint8_t* buf, CoAPOption::Enum previous, CoAPOption::Enum option, uint32_t num, bool more, uint8_t szx);
+
+    /**
+     * Decodes the value of a Block1 or Block2 option.
+     *
+     * @return `false` if the option value is malformed.
+     */
+    static bool decode_block_option(const uint8_t* value, size_t size, uint32_t* num, bool* more, uint8_t* szx);
+
     /**
      * Computes the length indicator for a value encoded in CoAP.
      * Values less than 13 are encoded directly. Values between 13 and 268 (inclusive) are encoded as 13 (and later as a single byte extended option)
@@ -77,6 +77,29 @@ namespace SubscriptionScope {
 typedef void (*EventHandler)(const char *event_name, const char *data);
 typedef void (*EventHandlerWithData)(void *handler_data, const char *event_name, const char *data);
 
+/**
+ * Handler for events that may carry binary data. The data is NUL-terminated for convenience but
+ * may contain NUL characters, so `data_size` should be used to determine its size.
+ */
+typedef void (*EventHandlerWithSize)(void *handler_data, const char *event_name, const char *data,
+    size_t data_size, unsigned content_type);
+
+namespace SubscriptionFlag {
+  enum Enum {
+    BINARY_DATA = 0x01 // The handler is an EventHandlerWithSize
+  };
+}
+
+/**
+ * Additional parameters passed to SparkDescriptor::call_event_handler().
+ */
+struct EventDataInfo
+{
+  uint16_t size;
+  uint16_t content_type; // See CoAPContentFormat
+  size_t data_size;
+};
+
 /**
  *  This is used in a callback so only change by adding fields to the end
  */
@@ -87,6 +110,7 @@ struct FilteringEventHandler
   void *handler_data;
   SubscriptionScope::Enum scope;
   char device_id[13];
+  uint8_t flags; // See SubscriptionFlag
 };
 
 
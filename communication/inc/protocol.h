@@ -123,6 +123,11 @@ class Protocol
 
 	uint8_t initialized;
 
+	/**
+	 * Set if the server has advertised support for compressed payloads in its hello message.
+	 */
+	bool compressed_payloads_accepted;
+
 protected:
 	/**
 	 * Protocol flags.
@@ -144,7 +149,11 @@ protected:
 		/**
 		 * Support for compressed/combined OTA updates.
 		 */
-		COMPRESSED_OTA = 0x10
+		COMPRESSED_OTA = 0x10,
+		/**
+		 * Support for compressed event and response payloads.
+		 */
+		COMPRESSED_PAYLOADS = 0x20
 	};
 
 	/**
@@ -314,7 +323,8 @@ public:
 			publisher(this),
 			last_ack_handlers_update(0),
 			protocol_flags(0),
-			initialized(false)
+			initialized(false),
+			compressed_payloads_accepted(false)
 	{
 	}
 
@@ -348,6 +358,19 @@ public:
 		protocol_flags |= ProtocolFlag::COMPRESSED_OTA;
 	}
 
+	void enable_compressed_payloads()
+	{
+		protocol_flags |= ProtocolFlag::COMPRESSED_PAYLOADS;
+	}
+
+	/**
+	 * Returns `true` if outgoing event and response payloads can be compressed.
+	 */
+	bool is_payload_compression_enabled() const
+	{
+		return compressed_payloads_accepted;
+	}
+
 	void set_handlers(CommunicationsHandlers& handlers)
 	{
 		copy_and_init(&this->handlers, sizeof(this->handlers), &handlers, handlers.size);
@@ -414,14 +437,22 @@ public:
 	// Returns true on success, false on sending timeout or rate-limiting failure
 	bool send_event(const char *event_name, const char *data, int ttl,
 			EventType::Enum event_type, int flags, CompletionHandler handler)
+	{
+		const size_t data_size = data ? strnlen(data, MAX_EVENT_DATA_LENGTH) : 0;
+		return send_event(event_name, data, data_size, CoAPContentFormat::TEXT_PLAIN, ttl, event_type, flags,
+				std::move(handler));
+	}
+
+	bool send_event(const char *event_name, const char *data, size_t data_size, unsigned content_format, int ttl,
+			EventType::Enum event_type, int flags, CompletionHandler handler)
 	{
 		if (chunkedTransfer.is_updating())
 		{
 			handler.setError(SYSTEM_ERROR_BUSY);
 			return false;
 		}
-		const ProtocolError error = publisher.send_event(channel, event_name, data, ttl, event_type, flags,
-				callbacks.millis(), std::move(handler));
+		const ProtocolError error = publisher.send_event(channel, event_name, data, data_size, content_format, ttl,
+				event_type, flags, callbacks.millis(), std::move(handler), compressed_payloads_accepted);
 		if (error != NO_ERROR)
 		{
 			handler.setError(toSystemError(error));
@@ -440,10 +471,10 @@ public:
 
 	inline bool add_event_handler(const char *event_name, EventHandler handler,
 			void *handler_data, SubscriptionScope::Enum scope,
-			const char* device_id)
+			const char* device_id, uint8_t flags = 0)
 	{
 		return !subscriptions.add_event_handler(event_name, handler,
-				handler_data, scope, device_id);
+				handler_data, scope, device_id, flags);
 	}
 
 	inline bool remove_event_handlers(const char* name)
@@ -123,7 +123,8 @@ enum Enum
     PING = 0, ///< Set keepalive interval.
     FAST_OTA = 1, ///< Enable/disable fast OTA.
     DEVICE_INITIATED_DESCRIBE = 2, ///< Enable device-initiated describe messages.
-    COMPRESSED_OTA = 3 ///< Enable support for compressed/combined OTA updates.
+    COMPRESSED_OTA = 3, ///< Enable support for compressed/combined OTA updates.
+    COMPRESSED_PAYLOADS = 4 ///< Enable support for compressed event and response payloads.
 };
 
 }
@@ -125,6 +125,22 @@ struct SparkDescriptor
      * @param context Context of the variable request. This argument needs to be passed to the completion callback.
      */
     void (*get_variable_async)(const char* key, GetVariableCallback callback, void* context);
+
+    /**
+     * Read a block of a string variable's value. Optional, may be null.
+     *
+     * This callback is used to serve large variable values in blocks (RFC 7959) without copying
+     * the entire value. The callback is invoked synchronously for each requested block.
+     *
+     * @param key Variable name.
+     * @param offset Offset in the variable value.
+     * @param data Destination buffer.
+     * @param size Size of the destination buffer.
+     * @param[out] total_size Total size of the variable value.
+     * @return Number of bytes read, or a negative value (`-ProtocolError`) in case of an error.
+     *         `-ProtocolError::NOT_IMPLEMENTED` indicates that the variable cannot be read in blocks.
+     */
+    int (*get_variable_block)(const char* key, size_t offset, void* data, size_t size, size_t* total_size);
 };
 
-PARTICLE_STATIC_ASSERT(SparkDescriptor_size, sizeof(SparkDescriptor)==60 || sizeof(void*)!=4);
+PARTICLE_STATIC_ASSERT(SparkDescriptor_size, sizeof(SparkDescriptor)==64 || sizeof(void*)!=4);
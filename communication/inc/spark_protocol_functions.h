@@ -176,7 +176,14 @@ typedef struct {
     void* handler_data;
 } completion_handler_data;
 
-typedef completion_handler_data spark_protocol_send_event_data;
+typedef struct {
+    size_t size;
+    completion_callback handler_callback;
+    void* handler_data;
+    size_t data_size; // Size of the event data. For text data, 0 means the data is null-terminated
+    uint16_t content_type; // Content format of the event data (see CoAPContentFormat)
+    uint16_t reserved; // make the padding explicit
+} spark_protocol_send_event_data;
 
 bool spark_protocol_send_event(ProtocolFacade* protocol, const char *event_name, const char *data,
                 int ttl, uint32_t flags, void* reserved);
@@ -277,6 +284,23 @@ typedef struct protocol_status {
  */
 int spark_protocol_get_status(ProtocolFacade* protocol, protocol_status* status, void* reserved);
 
+/**
+ * Register an event handler.
+ *
+ * @param protocol Protocol instance.
+ * @param event_name Event name prefix.
+ * @param handler Event handler. If `flags` contains `SubscriptionFlag::BINARY_DATA`, the handler
+ *        is expected to be an `EventHandlerWithSize`.
+ * @param scope Subscription scope.
+ * @param id Device ID or NULL.
+ * @param handler_data Handler data.
+ * @param flags Subscription flags (see `SubscriptionFlag`).
+ * @param reserved This argument should be set to NULL.
+ * @return `true` on success.
+ */
+bool spark_protocol_add_event_handler_ex(ProtocolFacade* protocol, const char *event_name, EventHandler handler,
+        SubscriptionScope::Enum scope, const char* id, void* handler_data, unsigned flags, void* reserved);
+
 /**
  * Decrypt a buffer using the given public key.
  * @param ciphertext        The ciphertext to decrypt
@@ -32,6 +32,7 @@ CPPSRC += $(TARGET_SRC_PATH)/protocol_defs.cpp
 CPPSRC += $(TARGET_SRC_PATH)/mbedtls_communication.cpp
 CPPSRC += $(TARGET_SRC_PATH)/communication_diagnostic.cpp
 CPPSRC += $(TARGET_SRC_PATH)/variables.cpp
+CPPSRC += $(TARGET_SRC_PATH)/payload_compression.cpp
 
 # ASM source files included in this build.
 ASRC +=
@@ -103,6 +103,139 @@ size_t CoAP::option_decode(unsigned char **option) {
     return option_length;
 }
 
+namespace {
+
+// Parses the option at the current position. Returns false if there are no more options or the
+// option is malformed
+bool next_option(const uint8_t** pos, const uint8_t* end, unsigned* number, size_t* length, bool* error) {
+    const uint8_t* p = *pos;
+    if (p >= end || *p == 0xff) { // 0xff is the payload marker
+        return false;
+    }
+    size_t fields[2] = { (size_t)(*p >> 4), (size_t)(*p & 0x0f) }; // Delta and length
+    ++p;
+    for (auto& field: fields) {
+        if (field == 13) {
+            if (p + 1 > end) {
+                *error = true;
+                return false;
+            }
+            field = *p + 13;
+            p += 1;
+        } else if (field == 14) {
+            if (p + 2 > end) {
+                *error = true;
+                return false;
+            }
+            field = ((p[0] << 8) | p[1]) + 269;
+            p += 2;
+        } else if (field == 15) {
+            *error = true; // Reserved
+            return false;
+        }
+    }
+    if (p + fields[1] > end) {
+        *error = true;
+        return false;
+    }
+    *number += fields[0];
+    *length = fields[1];
+    *pos = p;
+    return true;
+}
+
+} // namespace
+
+bool CoAP::find_option(const uint8_t* message, size_t size, unsigned option, const uint8_t** value, size_t* value_size) {
+    if (size < 4) {
+        return false;
+    }
+    const size_t token_size = message[0] & 0x0f;
+    const uint8_t* p = message + 4 + token_size;
+    const uint8_t* const end = message + size;
+    unsigned number = 0;
+    size_t length = 0;
+    bool error = false;
+    while (next_option(&p, end, &number, &length, &error)) {
+        if (number == option) {
+            *value = p;
+            *value_size = length;
+            return true;
+        }
+        if (number > option) {
+            break; // Options are sorted by their numbers
+        }
+        p += length;
+    }
+    return false;
+}
+
+bool CoAP::find_payload(const uint8_t* message, size_t size, const uint8_t** payload, size_t* payload_size) {
+    if (size < 4) {
+        return false;
+    }
+    const size_t token_size = message[0] & 0x0f;
+    const uint8_t* p = message + 4 + token_size;
+    const uint8_t* const end = message + size;
+    unsigned number = 0;
+    size_t length = 0;
+    bool error = false;
+    while (next_option(&p, end, &number, &length, &error)) {
+        p += length;
+    }
+    if (error || p + 1 >= end) { // No payload marker or an empty payload
+        return false;
+    }
+    *payload = p + 1;
+    *payload_size = end - p - 1;
+    return true;
+}
+
+size_t CoAP::content_format_option(uint8_t* buf, CoAPOption::Enum previous, uint16_t format) {
+    uint8_t data[2] = {};
+    size_t n = 0;
+    if (format > 0xff) {
+        data[n++] = format >> 8;
+    }
+    if (format > 0) {
+        data[n++] = format & 0xff;
+    }
+    return add_option(buf, previous, CoAPOption::CONTENT_FORMAT, data, n);
+}
+
+size_t CoAP::block_option(uint8_t* buf, CoAPOption::Enum previous, CoAPOption::Enum option, uint32_t num, bool more, uint8_t szx) {
+    const uint32_t v = (num << 4) | (more ? 0x08 : 0x00) | (szx & 0x07);
+    uint8_t data[3] = {};
+    size_t n = 0;
+    if (v > 0xffff) {
+        data[n++] = (v >> 16) & 0xff;
+    }
+    if (v > 0xff) {
+        data[n++] = (v >> 8) & 0xff;
+    }
+    if (v > 0) {
+        data[n++] = v & 0xff;
+    }
+    return add_option(buf, previous, option, data, n);
+}
+
+bool CoAP::decode_block_option(const uint8_t* value, size_t size, uint32_t* num, bool* more, uint8_t* szx) {
+    if (size > 3) {
+        return false;
+    }
+    uint32_t v = 0;
+    for (size_t i = 0; i < size; ++i) {
+        v = (v << 8) | value[i];
+    }
+    if ((v & 0x07) == 7) {
+        return false; // Reserved SZX value
+    }
+    *num = v >> 4;
+    *more = v & 0x08;
+    *szx = v & 0x07;
+    return true;
+}
+
 CoAPCode::Enum CoAP::codeForProtocolError(ProtocolError error) {
     switch (error) {
     case ProtocolError::NO_ERROR:
@@ -19,8 +19,11 @@
 
 #include "messages.h"
 
+#include "payload_compression.h"
 #include "appender.h"
 
+#include <algorithm>
+
 namespace particle {
 
 namespace protocol {
@@ -300,8 +303,23 @@ size_t Messages::separate_response_with_payload(unsigned char *buf, uint16_t mes
 	return len;
 }
 
-size_t Messages::event(uint8_t buf[], uint16_t message_id, const char *event_name,
-             const char *data, int ttl, EventType::Enum event_type, bool confirmable)
+size_t Messages::block2_response_header(uint8_t* buf, message_id_t message_id, token_t token, uint8_t code,
+		uint32_t block_num, bool more, uint8_t szx, bool confirmable, const uint8_t* etag, size_t etag_size)
+{
+	size_t len = separate_response(buf, message_id, token, code, confirmable);
+	CoAPOption::Enum prev_option = CoAPOption::NONE;
+	if (etag && etag_size)
+	{
+		len += CoAP::add_option(buf + len, prev_option, CoAPOption::ETAG, etag, etag_size);
+		prev_option = CoAPOption::ETAG;
+	}
+	len += CoAP::block_option(buf + len, prev_option, CoAPOption::BLOCK2, block_num, more, szx);
+	buf[len++] = 0xFF; // Payload marker
+	return len;
+}
+
+size_t Messages::event_header(uint8_t buf[], uint16_t message_id, const char *event_name,
+             int ttl, EventType::Enum event_type, bool confirmable, unsigned content_format)
 {
   uint8_t *p = buf;
   *p++ = confirmable ? 0x40 : 0x50; // non-confirmable /confirmable, no token
@@ -314,26 +332,103 @@ size_t Messages::event(uint8_t buf[], uint16_t message_id, const char *event_nam
   size_t name_data_len = strnlen(event_name, MAX_EVENT_NAME_LENGTH);
   p += event_name_uri_path(p, event_name, name_data_len);
 
+  CoAPOption::Enum prev_option = CoAPOption::URI_PATH;
+  if (CoAPContentFormat::TEXT_PLAIN != content_format)
+  {
+    p += CoAP::content_format_option(p, prev_option, content_format);
+    prev_option = CoAPOption::CONTENT_FORMAT;
+  }
+
   if (60 != ttl)
   {
-    *p++ = 0x33;
+    *p++ = (14 /* Max-Age */ - prev_option) << 4 | 0x03;
     *p++ = (ttl >> 16) & 0xff;
     *p++ = (ttl >> 8) & 0xff;
     *p++ = ttl & 0xff;
   }
 
+  return p - buf;
+}
+
+size_t Messages::event(uint8_t buf[], uint16_t message_id, const char *event_name,
+             const char *data, int ttl, EventType::Enum event_type, bool confirmable)
+{
+  const size_t data_len = data ? strnlen(data, MAX_EVENT_DATA_LENGTH) : 0;
+  return event(buf, message_id, event_name, data, data_len, ttl, event_type, confirmable, CoAPContentFormat::TEXT_PLAIN);
+}
+
+size_t Messages::event(uint8_t buf[], uint16_t message_id, const char *event_name,
+             const char *data, size_t data_len, int ttl, EventType::Enum event_type, bool confirmable,
+             unsigned content_format)
+{
+  uint8_t *p = buf + event_header(buf, message_id, event_name, ttl, event_type, confirmable, content_format);
+
   if (NULL != data)
   {
-    name_data_len = strnlen(data, MAX_EVENT_DATA_LENGTH);
-
     *p++ = 0xff;
-    memcpy(p, data, name_data_len);
-    p += name_data_len;
+    memcpy(p, data, data_len);
+    p += data_len;
   }
 
   return p - buf;
 }
 
+size_t Messages::compressed_event(uint8_t buf[], size_t buf_size, uint16_t message_id, const char *event_name,
+             const char *data, int ttl, EventType::Enum event_type, bool confirmable)
+{
+  const size_t data_len = strnlen(data, MAX_EVENT_DATA_LENGTH);
+  return compressed_event(buf, buf_size, message_id, event_name, data, data_len, ttl, event_type, confirmable);
+}
+
+size_t Messages::compressed_event(uint8_t buf[], size_t buf_size, uint16_t message_id, const char *event_name,
+             const char *data, size_t data_len, int ttl, EventType::Enum event_type, bool confirmable)
+{
+  if (data_len < MIN_COMPRESSED_PAYLOAD_SIZE)
+  {
+    return 0;
+  }
+  // The compressed message has to be smaller than the uncompressed one, including the Content-Format option
+  const size_t plain_header_len = event_header(buf, message_id, event_name, ttl, event_type, confirmable, CoAPContentFormat::TEXT_PLAIN);
+  const size_t header_len = event_header(buf, message_id, event_name, ttl, event_type, confirmable, CoAPContentFormat::DEFLATE);
+  const size_t extra_len = header_len - plain_header_len;
+  if (header_len + 1 >= buf_size || data_len <= extra_len)
+  {
+    return 0;
+  }
+  buf[header_len] = 0xff;
+  const size_t max_len = std::min(buf_size - header_len - 1, data_len - extra_len - 1);
+  const int r = compress_payload(data, data_len, (char*)buf + header_len + 1, max_len);
+  if (r < 0)
+  {
+    return 0;
+  }
+  return header_len + 1 + r;
+}
+
+size_t Messages::compressed_response(uint8_t* buf, size_t buf_size, message_id_t message_id, token_t token,
+		uint8_t code, const uint8_t* payload, size_t payload_len, bool confirmable)
+{
+	if (payload_len < MIN_COMPRESSED_PAYLOAD_SIZE)
+	{
+		return 0;
+	}
+	size_t len = separate_response(buf, message_id, token, code, confirmable);
+	const size_t opt_len = CoAP::content_format_option(buf + len, CoAPOption::NONE, CoAPContentFormat::DEFLATE);
+	len += opt_len;
+	buf[len++] = 0xFF; // Payload marker
+	if (len >= buf_size || payload_len <= opt_len)
+	{
+		return 0;
+	}
+	const size_t max_len = std::min(buf_size - len, payload_len - opt_len - 1);
+	const int r = compress_payload((const char*)payload, payload_len, (char*)buf + len, max_len);
+	if (r < 0)
+	{
+		return 0;
+	}
+	return len + r;
+}
+
 size_t Messages::coded_ack(uint8_t* buf, uint8_t token, uint8_t code,
                            uint8_t message_id_msb, uint8_t message_id_lsb,
                            uint8_t* data, size_t data_len)
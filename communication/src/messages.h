@@ -77,8 +77,71 @@ public:
 			unsigned char token, unsigned char code, const unsigned char* payload,
 			unsigned payload_len, bool confirmable);
 
+	/**
+	 * Encodes the header of a separate response carrying a block of a larger payload (RFC 7959).
+	 *
+	 * The header includes an optional ETag option, a Block2 option and the payload marker. Clearing
+	 * `more` never makes the header larger, but it makes it one byte shorter for the first block of
+	 * the smallest size, whose option value is then empty.
+	 *
+	 * @param etag ETag of the payload, or `nullptr`.
+	 * @param etag_size ETag size, which can't exceed `MAX_BLOCK2_ETAG_SIZE`.
+	 * @return Header size.
+	 */
+	static size_t block2_response_header(uint8_t* buf, message_id_t message_id, token_t token, uint8_t code,
+			uint32_t block_num, bool more, uint8_t szx, bool confirmable, const uint8_t* etag = nullptr,
+			size_t etag_size = 0);
+
+	/**
+	 * Maximum size of the ETag of a Block2 response.
+	 */
+	static const size_t MAX_BLOCK2_ETAG_SIZE = 4;
+
+	/**
+	 * Maximum size of a header encoded by `block2_response_header()`.
+	 */
+	static const size_t MAX_BLOCK2_RESPONSE_HEADER_SIZE = 12 + MAX_BLOCK2_ETAG_SIZE;
+
+	static size_t event(uint8_t buf[], uint16_t message_id, const char *event_name,
+	             const char *data, int ttl, EventType::Enum event_type, bool confirmable);
+
+	/**
+	 * Encodes an event message with a payload of a given size and content format.
+	 *
+	 * The caller is responsible for limiting the payload size to `MAX_EVENT_DATA_LENGTH`.
+	 */
 	static size_t event(uint8_t buf[], uint16_t message_id, const char *event_name,
+	             const char *data, size_t data_len, int ttl, EventType::Enum event_type, bool confirmable,
+	             unsigned content_format);
+
+	/**
+	 * Encodes the header of an event message, without the payload marker.
+	 *
+	 * @param content_format Content format of the payload (see `CoAPContentFormat`). A Content-Format
+	 *        option is only added for formats other than `CoAPContentFormat::TEXT_PLAIN`.
+	 */
+	static size_t event_header(uint8_t buf[], uint16_t message_id, const char *event_name,
+	             int ttl, EventType::Enum event_type, bool confirmable, unsigned content_format);
+
+	/**
+	 * Encodes an event message with a compressed payload.
+	 *
+	 * @return Message size, or 0 if the payload is too short to benefit from the compression or
+	 *         the compressed message would not be smaller than an uncompressed one.
+	 */
+	static size_t compressed_event(uint8_t buf[], size_t buf_size, uint16_t message_id, const char *event_name,
 	             const char *data, int ttl, EventType::Enum event_type, bool confirmable);
+	static size_t compressed_event(uint8_t buf[], size_t buf_size, uint16_t message_id, const char *event_name,
+	             const char *data, size_t data_len, int ttl, EventType::Enum event_type, bool confirmable);
+
+	/**
+	 * Encodes a separate response with a compressed payload.
+	 *
+	 * @return Message size, or 0 if the compressed message would not be smaller than an
+	 *         uncompressed one.
+	 */
+	static size_t compressed_response(uint8_t* buf, size_t buf_size, message_id_t message_id, token_t token,
+			uint8_t code, const uint8_t* payload, size_t payload_len, bool confirmable);
 
 
     static inline size_t empty_ack(unsigned char *buf,
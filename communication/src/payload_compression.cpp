@@ -0,0 +1,258 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "payload_compression.h"
+
+#include "hal_platform.h"
+#include "system_error.h"
+
+#if HAL_PLATFORM_COMPRESSED_OTA
+#include "inflate.h"
+#endif
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+namespace particle {
+
+namespace protocol {
+
+namespace {
+
+const size_t WINDOW_SIZE = (size_t)1 << PAYLOAD_COMPRESSION_WINDOW_BITS;
+const unsigned HASH_BITS = 8;
+const size_t HASH_SIZE = (size_t)1 << HASH_BITS;
+
+const unsigned MIN_MATCH = 3;
+const unsigned MAX_MATCH = 258;
+
+const uint16_t NO_POS = 0xffff;
+
+// RFC 1951, 3.2.5
+constexpr uint16_t LENGTH_BASE[] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115,
+        131, 163, 195, 227, 258 };
+constexpr uint8_t LENGTH_EXTRA[] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+constexpr uint16_t DIST_BASE[] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769 };
+constexpr uint8_t DIST_EXTRA[] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8 };
+
+static_assert(DIST_BASE[sizeof(DIST_BASE) / sizeof(DIST_BASE[0]) - 1] + (1 << DIST_EXTRA[sizeof(DIST_EXTRA) - 1]) - 1 >= WINDOW_SIZE,
+        "Distance table doesn't cover the compression window");
+
+class BitWriter {
+public:
+    BitWriter(char* buf, size_t size) :
+            buf_(buf),
+            size_(size),
+            offs_(0),
+            bits_(0),
+            count_(0),
+            overflow_(false) {
+    }
+
+    void write(uint32_t value, unsigned count) {
+        bits_ |= value << count_;
+        count_ += count;
+        while (count_ >= 8) {
+            put(bits_ & 0xff);
+            bits_ >>= 8;
+            count_ -= 8;
+        }
+    }
+
+    // Huffman codes are packed starting with the most significant bit
+    void writeCode(uint32_t code, unsigned count) {
+        uint32_t v = 0;
+        for (unsigned i = 0; i < count; ++i) {
+            v = (v << 1) | ((code >> i) & 1);
+        }
+        write(v, count);
+    }
+
+    void flush() {
+        if (count_ > 0) {
+            put(bits_ & 0xff);
+            bits_ = 0;
+            count_ = 0;
+        }
+    }
+
+    size_t size() const {
+        return offs_;
+    }
+
+    bool overflow() const {
+        return overflow_;
+    }
+
+private:
+    char* buf_;
+    size_t size_;
+    size_t offs_;
+    uint32_t bits_;
+    unsigned count_;
+    bool overflow_;
+
+    void put(uint8_t b) {
+        if (offs_ < size_) {
+            buf_[offs_++] = b;
+        } else {
+            overflow_ = true;
+        }
+    }
+};
+
+void writeSymbol(BitWriter* w, unsigned sym) {
+    if (sym < 144) {
+        w->writeCode(0x30 + sym, 8);
+    } else if (sym < 256) {
+        w->writeCode(0x190 + sym - 144, 9);
+    } else if (sym < 280) {
+        w->writeCode(sym - 256, 7);
+    } else {
+        w->writeCode(0xc0 + sym - 280, 8);
+    }
+}
+
+void writeMatch(BitWriter* w, unsigned len, unsigned dist) {
+    unsigned i = sizeof(LENGTH_BASE) / sizeof(LENGTH_BASE[0]) - 1;
+    while (LENGTH_BASE[i] > len) {
+        --i;
+    }
+    writeSymbol(w, 257 + i);
+    w->write(len - LENGTH_BASE[i], LENGTH_EXTRA[i]);
+    unsigned j = sizeof(DIST_BASE) / sizeof(DIST_BASE[0]) - 1;
+    while (DIST_BASE[j] > dist) {
+        --j;
+    }
+    w->writeCode(j, 5);
+    w->write(dist - DIST_BASE[j], DIST_EXTRA[j]);
+}
+
+inline unsigned hash3(const uint8_t* p) {
+    return ((p[0] << 4) ^ (p[1] << 2) ^ p[2]) & (HASH_SIZE - 1);
+}
+
+#if HAL_PLATFORM_COMPRESSED_OTA
+
+struct InflateOutput {
+    char* data;
+    size_t size;
+    size_t offs;
+};
+
+int inflateOutput(const char* data, size_t size, void* user_data) {
+    const auto out = (InflateOutput*)user_data;
+    if (out->offs + size > out->size) {
+        return SYSTEM_ERROR_TOO_LARGE;
+    }
+    memcpy(out->data + out->offs, data, size);
+    out->offs += size;
+    return size;
+}
+
+#endif // HAL_PLATFORM_COMPRESSED_OTA
+
+} // namespace
+
+int compress_payload(const char* src, size_t src_size, char* dest, size_t dest_size) {
+    if (src_size >= NO_POS) {
+        return SYSTEM_ERROR_TOO_LARGE;
+    }
+    const auto data = (const uint8_t*)src;
+    uint16_t head[HASH_SIZE];
+    for (auto& pos: head) {
+        pos = NO_POS;
+    }
+    BitWriter w(dest, dest_size);
+    w.write(1, 1); // BFINAL
+    w.write(1, 2); // BTYPE: fixed Huffman codes
+    size_t pos = 0;
+    while (pos < src_size && !w.overflow()) {
+        unsigned bestLen = 0;
+        unsigned bestDist = 0;
+        if (pos + MIN_MATCH <= src_size) {
+            const unsigned h = hash3(data + pos);
+            const uint16_t cand = head[h];
+            head[h] = pos;
+            if (cand != NO_POS && pos - cand <= WINDOW_SIZE) {
+                const size_t maxLen = std::min<size_t>(MAX_MATCH, src_size - pos);
+                unsigned len = 0;
+                while (len < maxLen && data[cand + len] == data[pos + len]) {
+                    ++len;
+                }
+                if (len >= MIN_MATCH) {
+                    bestLen = len;
+                    bestDist = pos - cand;
+                }
+            }
+        }
+        if (bestLen) {
+            writeMatch(&w, bestLen, bestDist);
+            // Index the positions covered by the match so that later data can refer to them
+            const size_t end = pos + bestLen;
+            for (++pos; pos < end && pos + MIN_MATCH <= src_size; ++pos) {
+                head[hash3(data + pos)] = pos;
+            }
+            pos = end;
+        } else {
+            writeSymbol(&w, data[pos]);
+            ++pos;
+        }
+    }
+    writeSymbol(&w, 256); // End of block
+    w.flush();
+    if (w.overflow()) {
+        return SYSTEM_ERROR_TOO_LARGE;
+    }
+    return w.size();
+}
+
+int decompress_payload(const char* src, size_t src_size, char* dest, size_t dest_size) {
+#if HAL_PLATFORM_COMPRESSED_OTA
+    inflate_opts opts = {};
+    opts.window_bits = PAYLOAD_COMPRESSION_WINDOW_BITS;
+    InflateOutput out = {};
+    out.data = dest;
+    out.size = dest_size;
+    inflate_ctx* ctx = nullptr;
+    int r = inflate_create(&ctx, &opts, inflateOutput, &out);
+    if (r < 0) {
+        return r;
+    }
+    size_t n = src_size;
+    r = inflate_input(ctx, src, &n, 0 /* flags */);
+    inflate_destroy(ctx);
+    if (r < 0) {
+        return r;
+    }
+    if (r != INFLATE_DONE) {
+        return SYSTEM_ERROR_BAD_DATA;
+    }
+    return out.offs;
+#else
+    return SYSTEM_ERROR_NOT_SUPPORTED;
+#endif // !HAL_PLATFORM_COMPRESSED_OTA
+}
+
+bool is_payload_decompression_supported() {
+    return HAL_PLATFORM_COMPRESSED_OTA;
+}
+
+} // namespace protocol
+
+} // namespace particle
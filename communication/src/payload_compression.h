@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+namespace particle {
+
+namespace protocol {
+
+/**
+ * Size of the sliding window used for compressed payloads, in bits.
+ *
+ * Both peers must not reference data further back than this, which keeps the decompressor's
+ * buffer small enough to be allocated per message.
+ */
+const unsigned PAYLOAD_COMPRESSION_WINDOW_BITS = 10;
+
+/**
+ * Payloads shorter than this are always sent uncompressed.
+ */
+const size_t MIN_COMPRESSED_PAYLOAD_SIZE = 32;
+
+/**
+ * Compresses a payload as a raw deflate stream (RFC 1951) using the fixed Huffman codes.
+ *
+ * The encoder needs no heap memory, which makes it usable in the system thread while a message
+ * is being built. It is not as efficient as a general-purpose compressor, but typical JSON
+ * telemetry shrinks to 40-60% of its original size.
+ *
+ * @param src Source data.
+ * @param src_size Size of the source data.
+ * @param dest Destination buffer.
+ * @param dest_size Size of the destination buffer.
+ * @return Size of the compressed data or a negative result code in case of an error.
+ * @retval SYSTEM_ERROR_TOO_LARGE The compressed data doesn't fit in the destination buffer.
+ */
+int compress_payload(const char* src, size_t src_size, char* dest, size_t dest_size);
+
+/**
+ * Decompresses a payload.
+ *
+ * @param src Compressed data.
+ * @param src_size Size of the compressed data.
+ * @param dest Destination buffer.
+ * @param dest_size Size of the destination buffer.
+ * @return Size of the decompressed data or a negative result code in case of an error.
+ * @retval SYSTEM_ERROR_NOT_SUPPORTED Decompression is not supported on this platform.
+ * @retval SYSTEM_ERROR_TOO_LARGE The decompressed data doesn't fit in the destination buffer.
+ */
+int decompress_payload(const char* src, size_t src_size, char* dest, size_t dest_size);
+
+/**
+ * Returns `true` if compressed payloads can be decompressed on this platform.
+ */
+bool is_payload_decompression_supported();
+
+} // namespace protocol
+
+} // namespace particle
@@ -40,9 +40,14 @@ enum HelloFlag {
 	// Flag 0x08 is reserved to indicate support for the HandshakeComplete message
 	HELLO_FLAG_GOODBYE_SUPPORT = 0x10,
 	HELLO_FLAG_DEVICE_INITIATED_DESCRIBE = 0x20,
-	HELLO_FLAG_COMPRESSED_OTA = 0x40
+	HELLO_FLAG_COMPRESSED_OTA = 0x40,
+	HELLO_FLAG_COMPRESSED_PAYLOADS = 0x80
 };
 
+// Offset of the flags field in the payload of a hello message. The server's hello uses the same
+// layout as the device's hello, and older servers send no payload at all
+const size_t HELLO_FLAGS_OFFSET = 5;
+
 } // namespace
 
 /**
@@ -156,11 +161,18 @@ ProtocolError Protocol::handle_received_message(Message& message,
 		callbacks.signal(false, 0, NULL);
 		return channel.send(message);
 
-	case CoAPMessageType::HELLO:
+	case CoAPMessageType::HELLO: {
+		// Parse the flags before the message buffer is reused for the acknowledgement
+		const uint8_t* payload = nullptr;
+		size_t payload_size = 0;
+		compressed_payloads_accepted = (protocol_flags & ProtocolFlag::COMPRESSED_PAYLOADS) &&
+				CoAP::find_payload(queue, message.length(), &payload, &payload_size) &&
+				payload_size > HELLO_FLAGS_OFFSET && (payload[HELLO_FLAGS_OFFSET] & HELLO_FLAG_COMPRESSED_PAYLOADS);
 		if (message.get_type()==CoAPType::CON)
 			send_empty_ack(message, msg_id);
 		descriptor.ota_upgrade_status_sent();
 		break;
+	}
 
 	case CoAPMessageType::TIME:
 		handle_time_response(
@@ -410,6 +422,11 @@ ProtocolError Protocol::hello(bool was_ota_upgrade_successful)
 	if (protocol_flags & ProtocolFlag::COMPRESSED_OTA) {
 		flags |= HELLO_FLAG_COMPRESSED_OTA;
 	}
+	if (protocol_flags & ProtocolFlag::COMPRESSED_PAYLOADS) {
+		flags |= HELLO_FLAG_COMPRESSED_PAYLOADS;
+	}
+	// Payloads are sent uncompressed until the server confirms its support in the hello response
+	compressed_payloads_accepted = false;
 	size_t len = build_hello(message, flags);
 	message.set_length(len);
 	message.set_confirm_received(true); // Send synchronously
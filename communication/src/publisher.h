@@ -89,8 +89,24 @@ public:
 
 	ProtocolError send_event(MessageChannel& channel, const char* event_name,
 			const char* data, int ttl, EventType::Enum event_type, int flags,
-			system_tick_t time, CompletionHandler handler)
+			system_tick_t time, CompletionHandler handler, bool compress = false)
 	{
+		const size_t data_size = data ? strnlen(data, MAX_EVENT_DATA_LENGTH) : 0;
+		return send_event(channel, event_name, data, data_size, CoAPContentFormat::TEXT_PLAIN, ttl, event_type, flags,
+				time, std::move(handler), compress);
+	}
+
+	/**
+	 * Sends an event with a payload of a given size and content format. Only text payloads are
+	 * compressed.
+	 */
+	ProtocolError send_event(MessageChannel& channel, const char* event_name,
+			const char* data, size_t data_size, unsigned content_format, int ttl, EventType::Enum event_type,
+			int flags, system_tick_t time, CompletionHandler handler, bool compress = false)
+	{
+		if (data_size > MAX_EVENT_DATA_LENGTH) {
+			return INSUFFICIENT_STORAGE;
+		}
 		bool is_system_event = is_system(event_name);
 		bool rate_limited = is_rate_limited(is_system_event, time);
 		if (rate_limited) {
@@ -106,8 +122,18 @@ public:
 		} else if (flags & EventType::WITH_ACK) {
 			confirmable = true;
 		}
-		size_t msglen = Messages::event(message.buf(), 0, event_name, data, ttl,
-				event_type, confirmable);
+		size_t msglen = 0;
+		if (compress && data && content_format == CoAPContentFormat::TEXT_PLAIN)
+		{
+			// Falls back to an uncompressed payload if the compression doesn't make the message smaller
+			msglen = Messages::compressed_event(message.buf(), message.capacity(), 0, event_name, data, data_size,
+					ttl, event_type, confirmable);
+		}
+		if (!msglen)
+		{
+			msglen = Messages::event(message.buf(), 0, event_name, data, data_size, ttl,
+					event_type, confirmable, content_format);
+		}
 		message.set_length(msglen);
 		const ProtocolError result = channel.send(message);
 		if (result == NO_ERROR) {
@@ -23,6 +23,7 @@
 #include "handshake.h"
 #include "debug.h"
 #include <stdlib.h>
+#include <stddef.h>
 
 using particle::CompletionHandler;
 using particle::protocol::ProtocolError;
@@ -132,11 +133,20 @@ bool spark_protocol_send_event(ProtocolFacade* protocol, const char *event_name,
                 int ttl, uint32_t flags, void* reserved) {
     ASSERT_ON_SYSTEM_THREAD();
 	CompletionHandler handler;
+	unsigned content_type = particle::protocol::CoAPContentFormat::TEXT_PLAIN;
+	size_t data_size = 0;
 	if (reserved) {
 		auto r = static_cast<const spark_protocol_send_event_data*>(reserved);
 		handler = CompletionHandler(r->handler_callback, r->handler_data);
+		if (offsetof(spark_protocol_send_event_data, content_type) + sizeof(spark_protocol_send_event_data::content_type) <= r->size) {
+			content_type = r->content_type;
+			data_size = r->data_size;
+		}
 	}
 	EventType::Enum event_type = EventType::extract_event_type(flags);
+	if (content_type != particle::protocol::CoAPContentFormat::TEXT_PLAIN || data_size > 0) {
+		return protocol->send_event(event_name, data, data_size, content_type, ttl, event_type, flags, std::move(handler));
+	}
 	return protocol->send_event(event_name, data, ttl, event_type, flags, std::move(handler));
 }
 
@@ -158,6 +168,13 @@ bool spark_protocol_add_event_handler(ProtocolFacade* protocol, const char *even
     return protocol->add_event_handler(event_name, handler, handler_data, scope, device_id);
 }
 
+bool spark_protocol_add_event_handler_ex(ProtocolFacade* protocol, const char *event_name, EventHandler handler,
+        SubscriptionScope::Enum scope, const char* device_id, void* handler_data, unsigned flags, void* reserved) {
+    ASSERT_ON_SYSTEM_OR_MAIN_THREAD();
+    (void)reserved;
+    return protocol->add_event_handler(event_name, handler, handler_data, scope, device_id, flags);
+}
+
 bool spark_protocol_send_time_request(ProtocolFacade* protocol, void* reserved) {
     ASSERT_ON_SYSTEM_THREAD();
     (void)reserved;
@@ -213,6 +230,10 @@ int spark_protocol_set_connection_property(ProtocolFacade* protocol, unsigned pr
         protocol->enable_compressed_ota();
         return 0;
     }
+    case particle::protocol::Connection::COMPRESSED_PAYLOADS: {
+        protocol->enable_compressed_payloads();
+        return 0;
+    }
     default:
         return particle::protocol::ProtocolError::NOT_IMPLEMENTED;
     }
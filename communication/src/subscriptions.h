@@ -22,9 +22,12 @@
 #include "protocol_defs.h"
 #include "events.h"
 #include "message_channel.h"
+#include "payload_compression.h"
 
 #include "spark_wiring_vector.h"
 
+#include <memory>
+#include <new>
 #include <stdint.h>
 
 namespace particle
@@ -140,7 +143,22 @@ public:
 		}
 		event_name_length = next_dst - event_name;
 
-		if (next_src < end && 0x30 == (*next_src & 0xf0))
+		unsigned content_format = CoAPContentFormat::TEXT_PLAIN;
+		unsigned option = CoAPOption::URI_PATH;
+		if (next_src < end && ((CoAPOption::CONTENT_FORMAT - option) << 4) == (*next_src & 0xf0))
+		{
+			// Content-Format option
+			size_t next_len = CoAP::option_decode(&next_src);
+			content_format = 0;
+			for (size_t i = 0; i < next_len && next_src + i < end; ++i)
+			{
+				content_format = (content_format << 8) | next_src[i];
+			}
+			next_src += next_len;
+			option = CoAPOption::CONTENT_FORMAT;
+		}
+
+		if (next_src < end && ((14 /* Max-Age */ - option) << 4) == (*next_src & 0xf0))
 		{
 			// Max-Age option is next, which we ignore
 			size_t next_len = CoAP::option_decode(&next_src);
@@ -148,13 +166,41 @@ public:
 		}
 
 		unsigned char *data = NULL;
+		size_t data_size = 0;
+		std::unique_ptr<char[]> inflated_data;
 		if (next_src < end && 0xff == *next_src)
 		{
 			// payload is next
 			data = next_src + 1;
-			// null terminate data string
-			*end = 0;
+			if (content_format == CoAPContentFormat::DEFLATE)
+			{
+				inflated_data.reset(new(std::nothrow) char[MAX_EVENT_DATA_LENGTH + 1]);
+				if (!inflated_data)
+				{
+					return NO_MEMORY;
+				}
+				const int r = decompress_payload((const char*)data, end - data, inflated_data.get(), MAX_EVENT_DATA_LENGTH);
+				if (r < 0)
+				{
+					// The event has already been acknowledged, drop it
+					return NO_ERROR;
+				}
+				inflated_data[r] = 0;
+				data = (unsigned char*)inflated_data.get();
+				data_size = r;
+				content_format = CoAPContentFormat::TEXT_PLAIN;
+			}
+			else
+			{
+				// null terminate data string
+				*end = 0;
+				data_size = end - data;
+			}
 		}
+		EventDataInfo data_info = {};
+		data_info.size = sizeof(data_info);
+		data_info.content_type = content_format;
+		data_info.data_size = data_size;
 		// null terminate event name string
 		event_name[event_name_length] = 0;
 
@@ -183,7 +229,14 @@ public:
 				// don't call the handler directly, use a callback for it.
 				if (!call_event_handler)
 				{
-					if (event_handlers[i].handler_data)
+					if (event_handlers[i].flags & SubscriptionFlag::BINARY_DATA)
+					{
+						EventHandlerWithSize handler =
+								(EventHandlerWithSize) event_handlers[i].handler;
+						handler(event_handlers[i].handler_data, (char *) event_name,
+								(char *) data, data_size, content_format);
+					}
+					else if (event_handlers[i].handler_data)
 					{
 						EventHandlerWithData handler =
 								(EventHandlerWithData) event_handlers[i].handler;
@@ -200,7 +253,7 @@ public:
 				{
 					call_event_handler(sizeof(FilteringEventHandler),
 							&event_handlers[i], (const char*) event_name,
-							(const char*) data, NULL);
+							(const char*) data, &data_info);
 				}
 			}
 			// else continue the for loop to try the next handler
@@ -292,7 +345,7 @@ public:
 	 * Adds the given handler.
 	 */
 	ProtocolError add_event_handler(const char *event_name, EventHandler handler,
-			void *handler_data, SubscriptionScope::Enum scope, const char* id)
+			void *handler_data, SubscriptionScope::Enum scope, const char* id, uint8_t flags = 0)
 	{
 		if (event_handler_exists(event_name, handler, handler_data, scope, id))
 			return NO_ERROR;
@@ -314,6 +367,7 @@ public:
 				memcpy(event_handlers[i].device_id, id, id_len);
 				event_handlers[i].device_id[id_len] = 0;
 				event_handlers[i].scope = scope;
+				event_handlers[i].flags = flags;
 				return NO_ERROR;
 			}
 		}
@@ -22,6 +22,7 @@
 
 #include "endian_util.h"
 
+#include <algorithm>
 #include <memory>
 #include <cstring>
 
@@ -29,34 +30,86 @@ namespace particle {
 
 namespace protocol {
 
+namespace {
+
+// Computes the ETag of a variable value sent in blocks, so that the client can detect that the
+// value has changed during the transfer (RFC 7959, 2.4). FNV-1a is used since the value may need
+// to be hashed in chunks
+class ValueETag {
+public:
+    ValueETag() :
+            hash_(2166136261u) {
+    }
+
+    void update(const void* data, size_t size) {
+        const auto d = (const uint8_t*)data;
+        for (size_t i = 0; i < size; ++i) {
+            hash_ = (hash_ ^ d[i]) * 16777619u;
+        }
+    }
+
+    // Encodes the ETag. The buffer must be `Messages::MAX_BLOCK2_ETAG_SIZE` bytes long
+    void encode(uint8_t* buf) const {
+        const uint32_t h = nativeToBigEndian(hash_);
+        memcpy(buf, &h, sizeof(h));
+    }
+
+private:
+    uint32_t hash_;
+};
+
+static_assert(Messages::MAX_BLOCK2_ETAG_SIZE == sizeof(uint32_t), "Unexpected ETag size");
+
+} // namespace
+
 struct Variables::Context {
-    Context(Variables* self, token_t token) :
+    Context(Variables* self, token_t token, const BlockRequest& block) :
             self(self),
-            token(token) {
+            token(token),
+            block(block) {
     }
 
     Variables* self;
     token_t token;
+    BlockRequest block;
 };
 
 ProtocolError Variables::handle_request(Message& message, token_t token, message_id_t id) {
     char key[MAX_VARIABLE_KEY_LENGTH + 1];
-    auto result = decode_request(message, key);
+    BlockRequest block = {};
+    auto result = decode_request(message, key, &block);
     if (result != ProtocolError::NO_ERROR) {
         return send_error_ack(message, token, id, CoAPCode::BAD_REQUEST);
     }
-    if (protocol_->getDescriptor().get_variable_async) {
-        result = handle_request(message, token, id, key);
+    const auto& descriptor = protocol_->getDescriptor();
+    if (descriptor.get_variable_block) {
+        // Check if the variable can be read in blocks
+        size_t total_size = 0;
+        const int ret = descriptor.get_variable_block(key, 0 /* offset */, nullptr /* data */, 0 /* size */, &total_size);
+        if (ret != -ProtocolError::NOT_IMPLEMENTED) {
+            if (ret < 0) {
+                return send_error_ack(message, token, id, CoAP::codeForProtocolError((ProtocolError)-ret));
+            }
+            // Acknowledge the request. Note that the request and response messages share the same buffer
+            result = send_empty_ack(message, id);
+            if (result != ProtocolError::NO_ERROR) {
+                return result;
+            }
+            return send_block_response(token, key, block);
+        }
+    }
+    if (descriptor.get_variable_async) {
+        result = handle_request(message, token, id, key, block);
     } else {
         // Use the compatibility callback
-        result = handle_request_compat(message, token, id, key);
+        result = handle_request_compat(message, token, id, key, block);
     }
     return result;
 }
 
-ProtocolError Variables::handle_request(Message& message, token_t token, message_id_t id, const char* key) {
+ProtocolError Variables::handle_request(Message& message, token_t token, message_id_t id, const char* key, const BlockRequest& block) {
     // Allocate a context for the request
-    std::unique_ptr<Context> ctx(new(std::nothrow) Context(this, token));
+    std::unique_ptr<Context> ctx(new(std::nothrow) Context(this, token, block));
     if (!ctx) {
         return send_error_ack(message, token, id, CoAPCode::INTERNAL_SERVER_ERROR);
     }
@@ -71,7 +124,7 @@ ProtocolError Variables::handle_request(Message& message, token_t token, message
     return ProtocolError::NO_ERROR;
 }
 
-ProtocolError Variables::handle_request_compat(Message& message, token_t token, message_id_t id, const char* key) {
+ProtocolError Variables::handle_request_compat(Message& message, token_t token, message_id_t id, const char* key, const BlockRequest& block) {
     const auto& descriptor = protocol_->getDescriptor();
     const auto value = descriptor.get_variable(key);
     if (!value) {
@@ -106,10 +159,10 @@ ProtocolError Variables::handle_request_compat(Message& message, token_t token,
         return result;
     }
     // Send a separate response
-    return send_response(token, value, value_size, value_type);
+    return send_response(token, value, value_size, value_type, block);
 }
 
-ProtocolError Variables::decode_request(Message& message, char* key) {
+ProtocolError Variables::decode_request(Message& message, char* key, BlockRequest* block) {
     uint8_t* queue = message.buf();
     uint8_t queue_offset = 8;
     // copy the variable key
@@ -125,12 +178,34 @@ ProtocolError Variables::decode_request(Message& message, char* key) {
     }
     memcpy(key, queue + queue_offset, key_length);
     memset(key + key_length, 0, MAX_VARIABLE_KEY_LENGTH - key_length + 1);
+    const uint8_t* opt = nullptr;
+    size_t opt_size = 0;
+    if (CoAP::find_option(message.buf(), message.length(), CoAPOption::BLOCK2, &opt, &opt_size)) {
+        bool more = false;
+        if (!CoAP::decode_block_option(opt, opt_size, &block->num, &more, &block->szx)) {
+            return ProtocolError::MALFORMED_MESSAGE;
+        }
+        block->present = true;
+    }
     return ProtocolError::NO_ERROR;
 }
 
 ProtocolError Variables::encode_response(Message& message, token_t token, const void* value, size_t value_size,
-        SparkReturnType::Enum value_type) {
+        SparkReturnType::Enum value_type, const BlockRequest& block) {
+    if (value_type == SparkReturnType::STRING && !block.present && protocol_->is_payload_compression_enabled()) {
+        auto& channel = protocol_->getChannel();
+        const size_t msg_size = Messages::compressed_response(message.buf(), message.capacity(), 0 /* message_id */, token,
+                CoAPCode::CONTENT, (const uint8_t*)value, value_size, channel.is_unreliable());
+        if (msg_size) {
+            message.set_length(msg_size);
+            return ProtocolError::NO_ERROR;
+        }
+    }
     size_t msg_size = Messages::response_size(value_size, true /* has_token */);
+    if (value_type == SparkReturnType::STRING && (block.present || msg_size > message.capacity())) {
+        // Send the value in blocks rather than truncating it
+        return encode_block_response(message, token, value, value_size, block);
+    }
     if (msg_size > message.capacity()) {
         // Truncate the value data accordingly
         const size_t d = msg_size - message.capacity();
@@ -175,23 +250,123 @@ ProtocolError Variables::encode_response(Message& message, token_t token, const
     return ProtocolError::NO_ERROR;
 }
 
+ProtocolError Variables::encode_block_response(Message& message, token_t token, const void* value, size_t value_size,
+        const BlockRequest& block) {
+    uint32_t num = 0;
+    uint8_t szx = 0;
+    size_t offset = 0;
+    const auto result = select_block(message.capacity(), block, &num, &szx, &offset);
+    if (result != ProtocolError::NO_ERROR) {
+        return result;
+    }
+    if (offset > value_size) {
+        return ProtocolError::MALFORMED_MESSAGE;
+    }
+    const size_t n = std::min(CoAP::block_size(szx), value_size - offset);
+    const bool more = (offset + n < value_size);
+    ValueETag etag;
+    etag.update(value, value_size);
+    uint8_t etag_data[Messages::MAX_BLOCK2_ETAG_SIZE] = {};
+    etag.encode(etag_data);
+    auto& channel = protocol_->getChannel();
+    size_t msg_size = Messages::block2_response_header(message.buf(), 0 /* message_id */, token, CoAPCode::CONTENT, num, more, szx,
+            channel.is_unreliable(), etag_data, sizeof(etag_data));
+    if (n) {
+        memcpy(message.buf() + msg_size, (const uint8_t*)value + offset, n);
+        msg_size += n;
+    } else {
+        --msg_size; // Remove the payload marker
+    }
+    message.set_length(msg_size);
+    return ProtocolError::NO_ERROR;
+}
+
 size_t Variables::encode_response(uint8_t* buffer, token_t token, const void* value, size_t value_size) {
     auto& channel = protocol_->getChannel();
     return Messages::separate_response_with_payload(buffer, 0 /* message_id */, token, CoAPCode::CONTENT,
             (const uint8_t*)value, value_size, channel.is_unreliable());
 }
 
-ProtocolError Variables::send_response(token_t token, const void* value, size_t value_size, SparkReturnType::Enum value_type) {
+ProtocolError Variables::send_response(token_t token, const void* value, size_t value_size, SparkReturnType::Enum value_type,
+        const BlockRequest& block) {
+    Message msg;
+    auto& channel = protocol_->getChannel();
+    ProtocolError result = channel.create(msg);
+    if (result != ProtocolError::NO_ERROR) {
+        return result;
+    }
+    result = encode_response(msg, token, value, value_size, value_type, block);
+    if (result != ProtocolError::NO_ERROR) {
+        const auto code = (result == ProtocolError::MALFORMED_MESSAGE) ? CoAPCode::BAD_OPTION : CoAPCode::INTERNAL_SERVER_ERROR;
+        return send_error_response(msg, token, code);
+    }
+    return channel.send(msg);
+}
+
+ProtocolError Variables::send_block_response(token_t token, const char* key, const BlockRequest& block) {
     Message msg;
     auto& channel = protocol_->getChannel();
     ProtocolError result = channel.create(msg);
     if (result != ProtocolError::NO_ERROR) {
         return result;
     }
-    result = encode_response(msg, token, value, value_size, value_type);
+    uint32_t num = 0;
+    uint8_t szx = 0;
+    size_t offset = 0;
+    result = select_block(msg.capacity(), block, &num, &szx, &offset);
     if (result != ProtocolError::NO_ERROR) {
         return send_error_response(msg, token, CoAPCode::INTERNAL_SERVER_ERROR);
     }
+    // The value is read in blocks and hashed to get its ETag. The part of the message buffer that
+    // follows the largest possible header is used as a temporary buffer
+    const auto buf = msg.buf();
+    const auto& descriptor = protocol_->getDescriptor();
+    const size_t block_size = CoAP::block_size(szx);
+    ValueETag etag;
+    size_t total_size = 0;
+    size_t pos = 0;
+    do {
+        const int n = descriptor.get_variable_block(key, pos, buf + Messages::MAX_BLOCK2_RESPONSE_HEADER_SIZE, block_size,
+                &total_size);
+        if (n < 0) {
+            return send_error_response(msg, token, CoAP::codeForProtocolError((ProtocolError)-n));
+        }
+        if (n == 0) {
+            break;
+        }
+        etag.update(buf + Messages::MAX_BLOCK2_RESPONSE_HEADER_SIZE, n);
+        pos += n;
+    } while (pos < total_size);
+    uint8_t etag_data[Messages::MAX_BLOCK2_ETAG_SIZE] = {};
+    etag.encode(etag_data);
+    // Read the block directly into the message buffer. The header is encoded with the "more" flag set
+    // first, since the option value can only get shorter when the flag is cleared
+    size_t header_size = Messages::block2_response_header(buf, 0 /* message_id */, token, CoAPCode::CONTENT, num, true /* more */,
+            szx, channel.is_unreliable(), etag_data, sizeof(etag_data));
+    const int n = descriptor.get_variable_block(key, offset, buf + header_size, block_size, &total_size);
+    if (n < 0) {
+        return send_error_response(msg, token, CoAP::codeForProtocolError((ProtocolError)-n));
+    }
+    if (offset > total_size) {
+        return send_error_response(msg, token, CoAPCode::BAD_OPTION);
+    }
+    const bool more = (offset + n < total_size);
+    if (!block.present && !more) {
+        // The value fits in a single message, send it without a Block2 option
+        const size_t size = encode_response(buf, token, nullptr /* value */, 0 /* value_size */);
+        buf[size] = 0xff; // Payload marker
+        memmove(buf + size + 1, buf + header_size, n);
+        header_size = size + 1;
+    } else if (!more) {
+        const size_t size = Messages::block2_response_header(buf, 0 /* message_id */, token, CoAPCode::CONTENT, num, false /* more */,
+                szx, channel.is_unreliable(), etag_data, sizeof(etag_data));
+        if (size != header_size) {
+            memmove(buf + size, buf + header_size, n);
+            header_size = size;
+        }
+    }
+    // Remove the payload marker if the payload is empty
+    msg.set_length(n ? header_size + n : header_size - 1);
     return channel.send(msg);
 }
 
@@ -234,12 +409,33 @@ void Variables::get_variable_callback(int result, int type, void* data, size_t s
         const auto code = CoAP::codeForProtocolError((ProtocolError)result);
         p->self->send_error_response(p->token, code);
     } else {
-        p->self->send_response(p->token, data, size, (SparkReturnType::Enum)type);
+        p->self->send_response(p->token, data, size, (SparkReturnType::Enum)type, p->block);
     }
     free(data);
     delete p;
 }
 
+ProtocolError Variables::select_block(size_t capacity, const BlockRequest& block, uint32_t* num, uint8_t* szx, size_t* offset) {
+    if (capacity <= Messages::MAX_BLOCK2_RESPONSE_HEADER_SIZE) {
+        return ProtocolError::INSUFFICIENT_STORAGE;
+    }
+    const size_t max_size = capacity - Messages::MAX_BLOCK2_RESPONSE_HEADER_SIZE;
+    uint8_t s = block.present ? block.szx : CoAP::MAX_BLOCK_SZX;
+    // The offset is determined by the block size requested by the client
+    const size_t off = block.present ? block.num * CoAP::block_size(block.szx) : 0;
+    // Use a smaller block size if necessary
+    while (s > 0 && CoAP::block_size(s) > max_size) {
+        --s;
+    }
+    if (CoAP::block_size(s) > max_size) {
+        return ProtocolError::INSUFFICIENT_STORAGE;
+    }
+    *num = off / CoAP::block_size(s);
+    *szx = s;
+    *offset = off;
+    return ProtocolError::NO_ERROR;
+}
+
 } // namespace protocol
 
 } // namespace particle
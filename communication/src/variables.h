@@ -42,16 +42,27 @@ public:
 private:
     struct Context;
 
+    // Requested block of a variable value (RFC 7959)
+    struct BlockRequest {
+        uint32_t num;
+        uint8_t szx;
+        bool present; // Set if the request contains a Block2 option
+    };
+
     Protocol* protocol_;
 
-    ProtocolError handle_request(Message& message, token_t token, message_id_t id, const char* key);
-    ProtocolError handle_request_compat(Message& message, token_t token, message_id_t id, const char* key);
+    ProtocolError handle_request(Message& message, token_t token, message_id_t id, const char* key, const BlockRequest& block);
+    ProtocolError handle_request_compat(Message& message, token_t token, message_id_t id, const char* key, const BlockRequest& block);
 
-    ProtocolError decode_request(Message& message, char* key);
-    ProtocolError encode_response(Message& message, token_t token, const void* value, size_t value_size, SparkReturnType::Enum value_type);
+    ProtocolError decode_request(Message& message, char* key, BlockRequest* block);
+    ProtocolError encode_response(Message& message, token_t token, const void* value, size_t value_size, SparkReturnType::Enum value_type,
+            const BlockRequest& block);
+    ProtocolError encode_block_response(Message& message, token_t token, const void* value, size_t value_size, const BlockRequest& block);
     size_t encode_response(uint8_t* buffer, token_t token, const void* value, size_t value_size);
 
-    ProtocolError send_response(token_t token, const void* value, size_t value_size, SparkReturnType::Enum value_type);
+    ProtocolError send_response(token_t token, const void* value, size_t value_size, SparkReturnType::Enum value_type,
+            const BlockRequest& block);
+    ProtocolError send_block_response(token_t token, const char* key, const BlockRequest& block);
     ProtocolError send_error_response(token_t token, uint8_t code);
     ProtocolError send_error_response(Message& message, token_t token, uint8_t code);
 
@@ -59,6 +70,9 @@ private:
     ProtocolError send_error_ack(Message& message, token_t token, message_id_t id, uint8_t code);
 
     static void get_variable_callback(int result, int type, void* data, size_t size, void* context); // SparkDescriptor::GetVariableCallback
+
+    // Selects the size and number of the response block that fits in a message of a given capacity
+    static ProtocolError select_block(size_t capacity, const BlockRequest& block, uint32_t* num, uint8_t* szx, size_t* offset);
 };
 
 inline Variables::Variables(Protocol* protocol) :
@@ -235,6 +235,45 @@ typedef enum {
  */
 os_scheduler_state_t os_scheduler_get_state(void* reserved);
 
+/**
+ * Maximum length of a thread name, including the terminating null character.
+ */
+#define OS_THREAD_STATS_NAME_SIZE 16
+
+/**
+ * Thread statistics flags.
+ */
+typedef enum os_thread_stats_flag_t {
+    OS_THREAD_STATS_FLAG_IDLE = 0x01 ///< The thread is the idle thread of the scheduler.
+} os_thread_stats_flag_t;
+
+/**
+ * Run-time statistics of a thread.
+ */
+typedef struct os_thread_stats_t {
+    uint16_t size; ///< Size of this structure.
+    uint16_t flags; ///< Flags (see `os_thread_stats_flag_t`).
+    os_thread_t thread; ///< Thread handle.
+    char name[OS_THREAD_STATS_NAME_SIZE]; ///< Thread name.
+    uint64_t cpu_time; ///< Time spent running the thread in microseconds.
+    uint32_t switch_count; ///< Number of times the thread was scheduled to run.
+    uint32_t stack_free; ///< Smallest amount of free stack space observed, in bytes.
+} os_thread_stats_t;
+
+/**
+ * Get run-time statistics of the existing threads.
+ *
+ * The statistics are only collected if the firmware is built with the thread profiler enabled.
+ *
+ * @param stats Array of structures to fill. The `size` field of each structure must be initialized
+ *        by the caller.
+ * @param count Number of elements in the array.
+ * @param reserved Reserved argument. Should be set to NULL.
+ * @return Total number of threads, which may be greater than `count`, or a negative result code
+ *         in case of an error.
+ */
+int os_thread_get_stats(os_thread_stats_t* stats, size_t count, void* reserved);
+
 /**
  * Create a new timer. Returns 0 on success.
  */
@@ -71,6 +71,7 @@ DYNALIB_FN(32, hal_concurrent, os_semaphore_take, int(os_semaphore_t, system_tic
 DYNALIB_FN(33, hal_concurrent, os_semaphore_give, int(os_semaphore_t, bool))
 DYNALIB_FN(34, hal_concurrent, os_scheduler_get_state, os_scheduler_state_t(void*))
 DYNALIB_FN(35, hal_concurrent, os_queue_peek, int(os_queue_t, void* item, system_tick_t, void*))
+DYNALIB_FN(36, hal_concurrent, os_thread_get_stats, int(os_thread_stats_t*, size_t, void*))
 #endif // PLATFORM_THREADING
 
 DYNALIB_END(hal_concurrent)
@@ -28,6 +28,7 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
+#include <sys/uio.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -82,14 +83,19 @@ DYNALIB_FN(23, hal_posix_syscall, fchdir, int(int fd))
 DYNALIB_FN(24, hal_posix_syscall, getcwd, char*(char* buf, size_t size))
 DYNALIB_FN(25, hal_posix_syscall, truncate, int(const char*, off_t))
 DYNALIB_FN(26, hal_posix_syscall, ftruncate, int(int, off_t))
-// DYNALIB_FN(27, hal_posix_syscall, _execve, int(const char* filename, char* const argv[], char* const envp[]))
-// DYNALIB_FN(28, hal_posix_syscall, _fork, pid_t(void))
-// DYNALIB_FN(29, hal_posix_syscall, _getpid, pid_t(void))
-// DYNALIB_FN(30, hal_posix_syscall, _gettimeofday, int(struct timeval* tv, void* tz))
-// DYNALIB_FN(31, hal_posix_syscall, _kill, int(pid_t pid, int sig))
-// DYNALIB_FN(32, hal_posix_syscall, _sbrk, void*(intptr_t increment))
-// DYNALIB_FN(33, hal_posix_syscall, _times, clock_t(struct tms* buf))
-// DYNALIB_FN(34, hal_posix_syscall, _wait, pid_t(int* status))
+DYNALIB_FN(27, hal_posix_syscall, readv, ssize_t(int, const struct iovec*, int))
+DYNALIB_FN(28, hal_posix_syscall, writev, ssize_t(int, const struct iovec*, int))
+DYNALIB_FN(29, hal_posix_syscall, pread, ssize_t(int, void*, size_t, off_t))
+DYNALIB_FN(30, hal_posix_syscall, pwrite, ssize_t(int, const void*, size_t, off_t))
+// The following functions are not exported
+// DYNALIB_FN(_, hal_posix_syscall, _execve, int(const char* filename, char* const argv[], char* const envp[]))
+// DYNALIB_FN(_, hal_posix_syscall, _fork, pid_t(void))
+// DYNALIB_FN(_, hal_posix_syscall, _getpid, pid_t(void))
+// DYNALIB_FN(_, hal_posix_syscall, _gettimeofday, int(struct timeval* tv, void* tz))
+// DYNALIB_FN(_, hal_posix_syscall, _kill, int(pid_t pid, int sig))
+// DYNALIB_FN(_, hal_posix_syscall, _sbrk, void*(intptr_t increment))
+// DYNALIB_FN(_, hal_posix_syscall, _times, clock_t(struct tms* buf))
+// DYNALIB_FN(_, hal_posix_syscall, _wait, pid_t(int* status))
 
 DYNALIB_END(hal_posix_syscall)
 
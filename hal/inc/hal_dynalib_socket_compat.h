@@ -52,6 +52,13 @@ DYNALIB_FN(15, hal_socket, socket_peer, sock_result_t(sock_handle_t, sock_peer_t
 DYNALIB_FN(16, hal_socket, socket_shutdown, sock_result_t(sock_handle_t, int))
 DYNALIB_FN(17, hal_socket, socket_send_ex, sock_result_t(sock_handle_t, const void*, socklen_t, uint32_t, system_tick_t, void*))
 DYNALIB_FN(18, hal_socket, socket_receivefrom_ex, sock_result_t(sock_handle_t, void*, socklen_t, uint32_t, sockaddr_t*, socklen_t*, system_tick_t, void*))
+#if HAL_PLATFORM_SOCKET_BUFFERS
+DYNALIB_FN(19, hal_socket, socket_receive_buffer, sock_result_t(sock_handle_t, socket_buffer_t*, system_tick_t, void*))
+DYNALIB_FN(20, hal_socket, socket_buffer_next, sock_result_t(socket_buffer_t*, void*))
+DYNALIB_FN(21, hal_socket, socket_release_buffer, void(socket_buffer_t*, void*))
+DYNALIB_FN(22, hal_socket, socket_alloc_buffer, sock_result_t(sock_handle_t, socket_buffer_t*, socklen_t, void*))
+DYNALIB_FN(23, hal_socket, socket_send_buffer, sock_result_t(sock_handle_t, socket_buffer_t*, socklen_t, const sockaddr_t*, void*))
+#endif // HAL_PLATFORM_SOCKET_BUFFERS
 
 DYNALIB_END(hal_socket)
 
@@ -374,6 +374,11 @@
 # ifndef HAL_PLATFORM_EXTERNAL_RTC_CAL_XT
 #  define HAL_PLATFORM_EXTERNAL_RTC_CAL_XT (0)
 # endif /* HAL_PLATFORM_EXTERNAL_RTC_CAL_XT */
+// Time in milliseconds during which the time is derived from the system tick instead of being read
+// from the RTC. Set to 0 to disable caching
+# ifndef HAL_PLATFORM_EXTERNAL_RTC_CACHE_TIMEOUT
+#  define HAL_PLATFORM_EXTERNAL_RTC_CACHE_TIMEOUT (60000)
+# endif /* HAL_PLATFORM_EXTERNAL_RTC_CACHE_TIMEOUT */
 #endif /* HAL_PLATFORM_EXTERNAL_RTC */
 
 #ifndef HAL_PLATFORM_FILE_MAXIMUM_FD
@@ -384,6 +389,10 @@
 #define HAL_PLATFORM_SOCKET_IOCTL_NOTIFY (0)
 #endif // HAL_PLATFORM_SOCKET_IOCTL_NOTIFY
 
+#ifndef HAL_PLATFORM_SOCKET_BUFFERS
+#define HAL_PLATFORM_SOCKET_BUFFERS (0)
+#endif // HAL_PLATFORM_SOCKET_BUFFERS
+
 #ifndef HAL_PLATFORM_NEWLIB
 #define HAL_PLATFORM_NEWLIB (0)
 #endif // HAL_PLATFORM_NEWLIB
@@ -400,4 +409,8 @@
 #define HAL_PLATFORM_USART_NUM (0)
 #endif // HAL_PLATFORM_USART_NUM
 
+#ifndef HAL_PLATFORM_THREAD_PROFILER
+#define HAL_PLATFORM_THREAD_PROFILER (0)
+#endif // HAL_PLATFORM_THREAD_PROFILER
+
 #endif /* HAL_PLATFORM_H */
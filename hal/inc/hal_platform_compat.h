@@ -94,6 +94,10 @@
 #define HAL_PLATFORM_NETWORK_MULTICAST (1)
 #endif // HAL_PLATFORM_WIFI
 
+#if PLATFORM_ID == PLATFORM_PHOTON_PRODUCTION || PLATFORM_ID == PLATFORM_P1
+#define HAL_PLATFORM_SOCKET_BUFFERS (1)
+#endif // PLATFORM_ID == PLATFORM_PHOTON_PRODUCTION || PLATFORM_ID == PLATFORM_P1
+
 #if PLATFORM_ID == PLATFORM_GCC
 #define PRODUCT_SERIES                      "gcc"
 #endif
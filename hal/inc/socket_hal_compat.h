@@ -144,6 +144,91 @@ typedef struct sock_peer_t {
 } sock_peer_t;
 sock_result_t socket_peer(sock_handle_t sd, sock_peer_t* peer, void* reserved);
 
+#if HAL_PLATFORM_SOCKET_BUFFERS
+
+/**
+ * Network buffer lent to the caller by the socket HAL.
+ *
+ * A received packet can be stored in a chain of buffers of the network stack. The `data` and `len`
+ * fields reference the current fragment of the packet, use `socket_buffer_next()` to get to the
+ * next fragment.
+ */
+typedef struct socket_buffer_t {
+    uint16_t size; ///< Size of this structure.
+    uint16_t len; ///< Size of the current fragment.
+    uint8_t* data; ///< Data of the current fragment.
+    sockaddr_t addr; ///< Address of the remote host (UDP only).
+    void* handle; ///< Internal.
+    uint16_t offset; ///< Internal.
+    uint16_t end; ///< Internal.
+} socket_buffer_t;
+
+/**
+ * Receives data from a socket without copying it.
+ *
+ * For a UDP socket, this function receives the next datagram. For a TCP socket, it receives the
+ * next packet, or the remaining data of a packet partially read with `socket_receive()`.
+ * The buffer must be released with `socket_release_buffer()` once it's no longer needed.
+ *
+ * @param sd Socket handle.
+ * @param buf Buffer.
+ * @param timeout Timeout in milliseconds.
+ * @param reserved Reserved argument (should be set to NULL).
+ * @return Total size of the received data, 0 if no data was received within the timeout, or a
+ *         negative result code in case of an error.
+ */
+sock_result_t socket_receive_buffer(sock_handle_t sd, socket_buffer_t* buf, system_tick_t timeout, void* reserved);
+
+/**
+ * Moves to the next fragment of a received packet.
+ *
+ * @param buf Buffer.
+ * @param reserved Reserved argument (should be set to NULL).
+ * @return Size of the fragment, 0 if there are no more fragments, or a negative result code in
+ *         case of an error.
+ */
+sock_result_t socket_buffer_next(socket_buffer_t* buf, void* reserved);
+
+/**
+ * Releases a buffer. The unread data of a received packet is discarded.
+ *
+ * @param buf Buffer.
+ * @param reserved Reserved argument (should be set to NULL).
+ */
+void socket_release_buffer(socket_buffer_t* buf, void* reserved);
+
+/**
+ * Allocates a buffer for sending data.
+ *
+ * On success, the `data` field of the buffer points to a contiguous area of memory that can be
+ * filled with the data to send, and the `len` field contains its size, which can be smaller than
+ * the requested size. The buffer should be then sent with `socket_send_buffer()` or released with
+ * `socket_release_buffer()`.
+ *
+ * @param sd Socket handle.
+ * @param buf Buffer.
+ * @param len Requested size.
+ * @param reserved Reserved argument (should be set to NULL).
+ * @return Size of the allocated buffer or a negative result code in case of an error.
+ */
+sock_result_t socket_alloc_buffer(sock_handle_t sd, socket_buffer_t* buf, socklen_t len, void* reserved);
+
+/**
+ * Sends a buffer allocated with `socket_alloc_buffer()`.
+ *
+ * The buffer is released in any case.
+ *
+ * @param sd Socket handle.
+ * @param buf Buffer.
+ * @param len Size of the data.
+ * @param addr Destination address (UDP only).
+ * @param reserved Reserved argument (should be set to NULL).
+ * @return Number of bytes sent or a negative result code in case of an error.
+ */
+sock_result_t socket_send_buffer(sock_handle_t sd, socket_buffer_t* buf, socklen_t len, const sockaddr_t* addr, void* reserved);
+
+#endif // HAL_PLATFORM_SOCKET_BUFFERS
+
 //------------ Socket Types ------------
 
 // don't redefine when building GCC target on OSX or linux
@@ -20,6 +20,7 @@
 #include "wifi_ncp_client.h"
 
 #include "file_util.h"
+#include "timer_hal.h"
 #include "logging.h"
 #include "scope_guard.h"
 #include "check.h"
@@ -179,7 +180,9 @@ void sortByRssi(Vector<WifiScanResult>* scanResults) {
 } // unnamed
 
 WifiNetworkManager::WifiNetworkManager(WifiNcpClient* client) :
-        client_(client) {
+        client_(client),
+        scanTime_(0),
+        scanCacheValid_(false) {
 }
 
 WifiNetworkManager::~WifiNetworkManager() {
@@ -204,62 +207,68 @@ int WifiNetworkManager::connect(const char* ssid) {
     // Connect to the network
     bool updateConfig = false;
     auto network = &networks.at(index);
-    // Always perform a network scan for now, because ESP32 doesn't support 802.11v/k/r
-#if 0
-    int r = client_->connect(network->ssid(), network->bssid(), network->security(), network->credentials());
-#else
-    int r = SYSTEM_ERROR_INTERNAL;
-#endif
+    int r = SYSTEM_ERROR_NOT_FOUND;
+    if (network->bssid() != INVALID_MAC_ADDRESS && !hasScanCache(DEFAULT_WIFI_SCAN_CACHE_MAX_AGE)) {
+        // Try to join the access point used last time without scanning. ESP32 doesn't support
+        // 802.11v/k/r, so if the device has moved out of range of that access point, the network
+        // scan below will find another one
+        r = client_->connect(network->ssid(), network->bssid(), network->security(), network->credentials());
+        if (r < 0) {
+            LOG(TRACE, "Unable to join the last used access point: %d", r);
+        }
+    }
     if (r < 0) {
-        // Perform network scan
-        Vector<WifiScanResult> scanResults;
-        CHECK_TRUE(scanResults.reserve(10), SYSTEM_ERROR_NO_MEMORY);
-        CHECK(client_->scan([](WifiScanResult result, void* data) -> int {
-            auto scanResults = (Vector<WifiScanResult>*)data;
-            CHECK_TRUE(scanResults->append(std::move(result)), SYSTEM_ERROR_NO_MEMORY);
-            return 0;
-        }, &scanResults));
-        // Sort discovered networks by RSSI
-        sortByRssi(&scanResults);
-        // Try to connect to any known network among the discovered ones
+        // Recent scan results, e.g. the ones requested in the listening mode, are good enough for
+        // a first attempt
+        bool cached = hasScanCache(DEFAULT_WIFI_SCAN_CACHE_MAX_AGE);
         bool connected = false;
-        for (const auto& ap: scanResults) {
-            if (!ssid) {
-                index = 0;
-                for (; index < networks.size(); ++index) {
-                    network = &networks.at(index);
-                    if (strcmp(network->ssid(), ap.ssid()) == 0) {
-                        break;
+        for (;;) {
+            // Perform network scan
+            Vector<WifiScanResult> scanResults;
+            CHECK_TRUE(scanResults.reserve(10), SYSTEM_ERROR_NO_MEMORY);
+            CHECK(scan([](WifiScanResult result, void* data) -> int {
+                auto scanResults = (Vector<WifiScanResult>*)data;
+                CHECK_TRUE(scanResults->append(std::move(result)), SYSTEM_ERROR_NO_MEMORY);
+                return 0;
+            }, &scanResults, cached ? DEFAULT_WIFI_SCAN_CACHE_MAX_AGE : 0));
+            // Sort discovered networks by RSSI
+            sortByRssi(&scanResults);
+            // Try to connect to any known network among the discovered ones
+            for (const auto& ap: scanResults) {
+                if (!ssid) {
+                    index = 0;
+                    for (; index < networks.size(); ++index) {
+                        network = &networks.at(index);
+                        if (strcmp(network->ssid(), ap.ssid()) == 0) {
+                            break;
+                        }
                     }
-                }
-                if (index == networks.size()) {
+                    if (index == networks.size()) {
+                        continue;
+                    }
+                } else if (strcmp(ssid, ap.ssid()) != 0) {
                     continue;
                 }
-            } else if (strcmp(ssid, ap.ssid()) != 0) {
-                continue;
-            }
-            r = client_->connect(network->ssid(), ap.bssid(), network->security(), network->credentials());
-            if (r == 0) {
-                if (network->bssid() != ap.bssid()) {
-                    // Update BSSID
-                    network->bssid(ap.bssid());
-                    updateConfig = true;
+                r = client_->connect(network->ssid(), ap.bssid(), network->security(), network->credentials());
+                if (r == 0) {
+                    if (network->bssid() != ap.bssid()) {
+                        // Update BSSID
+                        network->bssid(ap.bssid());
+                        updateConfig = true;
+                    }
+                    connected = true;
+                    break;
                 }
-                connected = true;
+            }
+            if (connected || !cached) {
                 break;
             }
+            // The cached results may be outdated, perform a new scan
+            cached = false;
         }
         if (!connected) {
             return SYSTEM_ERROR_NOT_FOUND;
         }
-    } else if (network->bssid() == INVALID_MAC_ADDRESS) {
-        // Update BSSID
-        WifiNetworkInfo info;
-        r = client_->getNetworkInfo(&info);
-        if (r == 0) {
-            network->bssid(info.bssid());
-            updateConfig = true;
-        }
     }
     if (index != 0) {
         // Move the network to the beginning of the list
@@ -273,6 +282,47 @@ int WifiNetworkManager::connect(const char* ssid) {
     return 0;
 }
 
+int WifiNetworkManager::scan(WifiScanCallback callback, void* data, system_tick_t maxAge) {
+    const NcpClientLock lock(client_);
+    if (hasScanCache(maxAge)) {
+        for (const auto& result: scanCache_) {
+            CHECK(callback(result, data));
+        }
+        return 0;
+    }
+    struct ScanContext {
+        Vector<WifiScanResult> results;
+        WifiScanCallback callback;
+        void* data;
+    };
+    ScanContext ctx = {};
+    ctx.callback = callback;
+    ctx.data = data;
+    CHECK(client_->scan([](WifiScanResult result, void* data) -> int {
+        const auto ctx = (ScanContext*)data;
+        for (auto& r: ctx->results) {
+            if (r.bssid() == result.bssid() && strcmp(r.ssid(), result.ssid()) == 0) {
+                // The same access point has already been reported
+                if (result.rssi() > r.rssi()) {
+                    r.rssi(result.rssi());
+                }
+                return 0;
+            }
+        }
+        CHECK_TRUE(ctx->results.append(result), SYSTEM_ERROR_NO_MEMORY);
+        CHECK(ctx->callback(std::move(result), ctx->data));
+        return 0;
+    }, &ctx));
+    scanCache_ = std::move(ctx.results);
+    scanTime_ = HAL_Timer_Get_Milli_Seconds();
+    scanCacheValid_ = true;
+    return 0;
+}
+
+bool WifiNetworkManager::hasScanCache(system_tick_t maxAge) const {
+    return scanCacheValid_ && HAL_Timer_Get_Milli_Seconds() - scanTime_ < maxAge;
+}
+
 int WifiNetworkManager::setNetworkConfig(WifiNetworkConfig conf) {
     CHECK_TRUE(conf.ssid(), SYSTEM_ERROR_INVALID_ARGUMENT);
     Vector<WifiNetworkConfig> networks;
@@ -19,6 +19,9 @@
 
 #include "addr_util.h"
 #include "c_string.h"
+#include "system_tick_hal.h"
+
+#include "spark_wiring_vector.h"
 
 #include <cstdint>
 
@@ -35,6 +38,9 @@ const size_t MAX_SSID_SIZE = 32;
 // Maximum length of a WPA/WPA2 key
 const size_t MAX_WPA_WPA2_PSK_SIZE = 64;
 
+// Maximum age of the cached scan results that are reported instead of performing a new scan (milliseconds)
+const system_tick_t DEFAULT_WIFI_SCAN_CACHE_MAX_AGE = 10000;
+
 enum class WifiSecurity {
     NONE = 0,
     WEP = 1,
@@ -148,6 +154,19 @@ public:
     int connect(const char* ssid);
     int connect();
 
+    /**
+     * Scan for networks.
+     *
+     * The results are reported as they're received from the NCP. An access point that is seen more
+     * than once during the scan is reported only once. If the results of a previous scan are not
+     * older than `maxAge`, they're reported instead of performing a new scan.
+     *
+     * @param callback Callback invoked for each discovered access point.
+     * @param data User data.
+     * @param maxAge Maximum age of the cached results (milliseconds). 0 forces a new scan.
+     */
+    int scan(WifiScanCallback callback, void* data, system_tick_t maxAge = DEFAULT_WIFI_SCAN_CACHE_MAX_AGE);
+
     static int setNetworkConfig(WifiNetworkConfig conf);
     static int getNetworkConfig(const char* ssid, WifiNetworkConfig* conf);
     static int getNetworkConfig(GetNetworkConfigCallback callback, void* data);
@@ -159,6 +178,11 @@ public:
 
 private:
     WifiNcpClient* client_;
+    spark::Vector<WifiScanResult> scanCache_;
+    system_tick_t scanTime_;
+    bool scanCacheValid_;
+
+    bool hasScanCache(system_tick_t maxAge) const;
 };
 
 inline WifiCredentials::WifiCredentials() :
@@ -66,6 +66,7 @@ const auto ESP32_NCP_KEEPALIVE_MAX_MISSED = 5;
 
 // FIXME: for now using a very large buffer
 const auto ESP32_NCP_AT_CHANNEL_RX_BUFFER_SIZE = 4096;
+const auto ESP32_NCP_AT_CHANNEL_TX_BUFFER_SIZE = 256;
 
 const auto ESP32_NCP_DEFAULT_SERIAL_BAUDRATE = 921600;
 
@@ -106,7 +107,7 @@ int Esp32NcpClient::init(const NcpClientConfig& conf) {
     // Initialize muxed channel stream
     decltype(muxerAtStream_) muxStrm(new(std::nothrow) decltype(muxerAtStream_)::element_type(&muxer_, ESP32_NCP_AT_CHANNEL));
     CHECK_TRUE(muxStrm, SYSTEM_ERROR_NO_MEMORY);
-    CHECK(muxStrm->init(ESP32_NCP_AT_CHANNEL_RX_BUFFER_SIZE));
+    CHECK(muxStrm->init(ESP32_NCP_AT_CHANNEL_RX_BUFFER_SIZE, ESP32_NCP_AT_CHANNEL_TX_BUFFER_SIZE));
     CHECK(initParser(serial.get()));
     serial_ = std::move(serial);
     muxerAtStream_ = std::move(muxStrm);
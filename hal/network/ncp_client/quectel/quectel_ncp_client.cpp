@@ -97,6 +97,7 @@ const auto QUECTEL_NCP_KEEPALIVE_MAX_MISSED = 5;
 
 // FIXME: for now using a very large buffer
 const auto QUECTEL_NCP_AT_CHANNEL_RX_BUFFER_SIZE = 4096;
+const auto QUECTEL_NCP_AT_CHANNEL_TX_BUFFER_SIZE = 256;
 const auto QUECTEL_NCP_PPP_CHANNEL_RX_BUFFER_SIZE = 256;
 
 const auto QUECTEL_NCP_AT_CHANNEL = 1;
@@ -110,6 +111,12 @@ const unsigned REGISTRATION_INTERVENTION_TIMEOUT = 15 * 1000;
 const unsigned REGISTRATION_TWILIO_HOLDOFF_TIMEOUT = 5 * 60 * 1000;
 
 const system_tick_t QUECTEL_COPS_TIMEOUT = 3 * 60 * 1000;
+
+// Minimum interval between the queries of the signal quality and network identity, even if the
+// modem reports a change via an URC
+const system_tick_t QUECTEL_NETWORK_INFO_MIN_REFRESH_INTERVAL = 1000;
+// Maximum age of the cached signal quality and network identity, in case a change was not reported
+const system_tick_t QUECTEL_NETWORK_INFO_MAX_AGE = 60 * 1000;
 const system_tick_t QUECTEL_CFUN_TIMEOUT = 3 * 60 * 1000;
 
 // Undefine hardware version
@@ -128,6 +135,17 @@ using CidType = decltype(CellularGlobalIdentity::cell_id);
 const int QUECTEL_DEFAULT_CID = 1;
 const char QUECTEL_DEFAULT_PDP_TYPE[] = "IP";
 
+bool isCachedInfoFresh(bool valid, bool changed, system_tick_t time) {
+    if (!valid) {
+        return false;
+    }
+    const auto age = millis() - time;
+    if (changed) {
+        return age < QUECTEL_NETWORK_INFO_MIN_REFRESH_INTERVAL;
+    }
+    return age < QUECTEL_NETWORK_INFO_MAX_AGE;
+}
+
 } // anonymous
 
 QuectelNcpClient::QuectelNcpClient() {
@@ -161,7 +179,7 @@ int QuectelNcpClient::init(const NcpClientConfig& conf) {
     // Initialize muxed channel stream
     decltype(muxerAtStream_) muxStrm(new (std::nothrow) decltype(muxerAtStream_)::element_type(&muxer_, QUECTEL_NCP_AT_CHANNEL));
     CHECK_TRUE(muxStrm, SYSTEM_ERROR_NO_MEMORY);
-    CHECK(muxStrm->init(QUECTEL_NCP_AT_CHANNEL_RX_BUFFER_SIZE));
+    CHECK(muxStrm->init(QUECTEL_NCP_AT_CHANNEL_RX_BUFFER_SIZE, QUECTEL_NCP_AT_CHANNEL_TX_BUFFER_SIZE));
     CHECK(initParser(serial.get()));
     decltype(muxerDataStream_) muxDataStrm(new(std::nothrow) decltype(muxerDataStream_)::element_type(&muxer_, QUECTEL_NCP_PPP_CHANNEL));
     CHECK_TRUE(muxDataStrm, SYSTEM_ERROR_NO_MEMORY);
@@ -219,7 +237,11 @@ int QuectelNcpClient::initParser(Stream* stream) {
         CHECK_TRUE(r >= 1, SYSTEM_ERROR_AT_RESPONSE_UNEXPECTED);
 
         bool prevRegStatus = self->csd_.registered();
+        const auto prevStatus = self->csd_.status();
         self->csd_.status(self->csd_.decodeAtStatus(val[0]));
+        if (self->csd_.status() != prevStatus) {
+            self->networkInfoChanged();
+        }
         // Check IMSI only if registered from a non-registered state, to avoid checking IMSI
         // every time there is a cell tower change in which case also we could see a CEREG: {1 or 5} URC
         // TODO: Do this only for Twilio
@@ -256,7 +278,11 @@ int QuectelNcpClient::initParser(Stream* stream) {
         CHECK_TRUE(r >= 1, SYSTEM_ERROR_AT_RESPONSE_UNEXPECTED);
 
         bool prevRegStatus = self->psd_.registered();
+        const auto prevStatus = self->psd_.status();
         self->psd_.status(self->psd_.decodeAtStatus(val[0]));
+        if (self->psd_.status() != prevStatus) {
+            self->networkInfoChanged();
+        }
         // Check IMSI only if registered from a non-registered state, to avoid checking IMSI
         // every time there is a cell tower change in which case also we could see a CGREG: {1 or 5} URC
         // TODO: Do this only for Twilio
@@ -275,8 +301,7 @@ int QuectelNcpClient::initParser(Stream* stream) {
                 case CellularAccessTechnology::UTRAN_HSDPA:
                 case CellularAccessTechnology::UTRAN_HSUPA:
                 case CellularAccessTechnology::UTRAN_HSDPA_HSUPA: {
-                    self->cgi_.location_area_code = static_cast<LacType>(val[1]);
-                    self->cgi_.cell_id = static_cast<CidType>(val[2]);
+                    self->updateCellId(static_cast<LacType>(val[1]), static_cast<CidType>(val[2]));
                     break;
                 }
             }
@@ -301,7 +326,11 @@ int QuectelNcpClient::initParser(Stream* stream) {
         CHECK_TRUE(r >= 1, SYSTEM_ERROR_AT_RESPONSE_UNEXPECTED);
 
         bool prevRegStatus = self->eps_.registered();
+        const auto prevStatus = self->eps_.status();
         self->eps_.status(self->eps_.decodeAtStatus(val[0]));
+        if (self->eps_.status() != prevStatus) {
+            self->networkInfoChanged();
+        }
         // Check IMSI only if registered from a non-registered state, to avoid checking IMSI
         // every time there is a cell tower change in which case also we could see a CEREG: {1 or 5} URC
         // TODO: Do this only for Twilio
@@ -316,8 +345,7 @@ int QuectelNcpClient::initParser(Stream* stream) {
                 case CellularAccessTechnology::LTE:
                 case CellularAccessTechnology::LTE_CAT_M1:
                 case CellularAccessTechnology::LTE_NB_IOT: {
-                    self->cgi_.location_area_code = static_cast<LacType>(val[1]);
-                    self->cgi_.cell_id = static_cast<CidType>(val[2]);
+                    self->updateCellId(static_cast<LacType>(val[1]), static_cast<CidType>(val[2]));
                     break;
                 }
             }
@@ -330,6 +358,19 @@ int QuectelNcpClient::initParser(Stream* stream) {
         self->checkImsi_ = true;
         return SYSTEM_ERROR_NONE;
     }, this));
+    // +QIND: "csq",<rssi>,<ber>
+    // +QIND: "act",<actvalue>
+    CHECK(parser_.addUrcHandler("+QIND", [](AtResponseReader* reader, const char* prefix, void* data) -> int {
+        const auto self = (QuectelNcpClient*)data;
+        char atResponse[64] = {};
+        CHECK_PARSER_URC(reader->readLine(atResponse, sizeof(atResponse)));
+        if (!strncmp(atResponse, "+QIND: \"csq\"", 12)) {
+            self->signalQualChanged_ = true;
+        } else if (!strncmp(atResponse, "+QIND: \"act\"", 12)) {
+            self->networkInfoChanged();
+        }
+        return SYSTEM_ERROR_NONE;
+    }, this));
     return SYSTEM_ERROR_NONE;
 }
 
@@ -616,22 +657,27 @@ int QuectelNcpClient::getCellularGlobalIdentity(CellularGlobalIdentity* cgi) {
     const NcpClientLock lock(this);
     CHECK_TRUE(connState_ != NcpConnectionState::DISCONNECTED, SYSTEM_ERROR_INVALID_STATE);
     CHECK_TRUE(cgi, SYSTEM_ERROR_INVALID_ARGUMENT);
-    CHECK(checkParser());
 
-    // FIXME: this is a workaround for CH28408
-    CellularSignalQuality qual;
-    CHECK(queryAndParseAtCops(&qual));
-    CHECK_TRUE(qual.accessTechnology() != CellularAccessTechnology::NONE, SYSTEM_ERROR_INVALID_STATE);
-    // Update current RAT
-    act_ = qual.accessTechnology();
-    // Invalidate LAC and Cell ID
-    cgi_.location_area_code = std::numeric_limits<LacType>::max();
-    cgi_.cell_id = std::numeric_limits<CidType>::max();
-    // Fill in LAC and Cell ID based on current RAT, prefer PSD and EPS
-    // fallback to CSD
-    CHECK_PARSER_OK(parser_.execCommand("AT+CEREG?"));
-    CHECK_PARSER_OK(parser_.execCommand("AT+CGREG?"));
-    CHECK_PARSER_OK(parser_.execCommand("AT+CREG?"));
+    if (!isCachedInfoFresh(cgiValid_, cgiChanged_, cgiTime_)) {
+        CHECK(checkParser());
+        // FIXME: this is a workaround for CH28408
+        CellularSignalQuality qual;
+        CHECK(queryAndParseAtCops(&qual));
+        CHECK_TRUE(qual.accessTechnology() != CellularAccessTechnology::NONE, SYSTEM_ERROR_INVALID_STATE);
+        // Update current RAT
+        act_ = qual.accessTechnology();
+        // Invalidate LAC and Cell ID
+        cgi_.location_area_code = std::numeric_limits<LacType>::max();
+        cgi_.cell_id = std::numeric_limits<CidType>::max();
+        // Fill in LAC and Cell ID based on current RAT, prefer PSD and EPS
+        // fallback to CSD
+        CHECK_PARSER_OK(parser_.execCommand("AT+CEREG?"));
+        CHECK_PARSER_OK(parser_.execCommand("AT+CGREG?"));
+        CHECK_PARSER_OK(parser_.execCommand("AT+CREG?"));
+        cgiTime_ = millis();
+        cgiValid_ = true;
+        cgiChanged_ = false;
+    }
 
     switch (cgi->version)
     {
@@ -655,7 +701,20 @@ int QuectelNcpClient::getSignalQuality(CellularSignalQuality* qual) {
     const NcpClientLock lock(this);
     CHECK_TRUE(connState_ != NcpConnectionState::DISCONNECTED, SYSTEM_ERROR_INVALID_STATE);
     CHECK_TRUE(qual, SYSTEM_ERROR_INVALID_ARGUMENT);
-    CHECK(checkParser());
+    if (!isCachedInfoFresh(signalQualValid_, signalQualChanged_, signalQualTime_)) {
+        CHECK(checkParser());
+        CellularSignalQuality q;
+        CHECK(querySignalQuality(&q));
+        signalQual_ = q;
+        signalQualTime_ = millis();
+        signalQualValid_ = true;
+        signalQualChanged_ = false;
+    }
+    *qual = signalQual_;
+    return SYSTEM_ERROR_NONE;
+}
+
+int QuectelNcpClient::querySignalQuality(CellularSignalQuality* qual) {
     CHECK(queryAndParseAtCops(qual));
 
     // Using AT+QCSQ first
@@ -1221,6 +1280,10 @@ int QuectelNcpClient::registerNet() {
     CHECK_TRUE(r == AtResponse::OK, SYSTEM_ERROR_UNKNOWN);
     r = CHECK_PARSER(parser_.execCommand("AT+CEREG=2"));
     CHECK_TRUE(r == AtResponse::OK, SYSTEM_ERROR_UNKNOWN);
+    // Report signal quality and access technology changes via URCs, so that the cached network
+    // info can be kept until it changes. Ignore errors as not all modems support all indications
+    CHECK_PARSER(parser_.execCommand("AT+QINDCFG=\"csq\",1,0"));
+    CHECK_PARSER(parser_.execCommand("AT+QINDCFG=\"act\",1,0"));
 
     connectionState(NcpConnectionState::CONNECTING);
 
@@ -1482,6 +1545,23 @@ void QuectelNcpClient::resetRegistrationState() {
     regStartTime_ = millis();
     regCheckTime_ = regStartTime_;
     registrationInterventions_ = 0;
+    signalQualValid_ = false;
+    cgiValid_ = false;
+}
+
+void QuectelNcpClient::networkInfoChanged() {
+    signalQualChanged_ = true;
+    cgiChanged_ = true;
+}
+
+void QuectelNcpClient::updateCellId(uint16_t lac, uint32_t cid) {
+    // A change of a previously known cell is reported by the registration URCs
+    if (cgi_.cell_id != std::numeric_limits<CidType>::max() &&
+            (cgi_.location_area_code != lac || cgi_.cell_id != cid)) {
+        networkInfoChanged();
+    }
+    cgi_.location_area_code = lac;
+    cgi_.cell_id = cid;
 }
 
 void QuectelNcpClient::checkRegistrationState() {
@@ -112,7 +112,16 @@ private:
     volatile bool inFlowControl_ = false;
     bool checkImsi_ = false;
 
+    CellularSignalQuality signalQual_;
+    system_tick_t signalQualTime_ = 0;
+    system_tick_t cgiTime_ = 0;
+    bool signalQualValid_ = false;
+    bool signalQualChanged_ = false;
+    bool cgiValid_ = false;
+    bool cgiChanged_ = false;
+
     int queryAndParseAtCops(CellularSignalQuality* qual);
+    int querySignalQuality(CellularSignalQuality* qual);
     int initParser(Stream* stream);
     int waitReady(bool powerOn = false);
     int initReady(ModemState state);
@@ -132,6 +141,8 @@ private:
     void connectionState(NcpConnectionState state);
     void parserError(int error);
     void resetRegistrationState();
+    void networkInfoChanged();
+    void updateCellId(uint16_t lac, uint32_t cid);
     void checkRegistrationState();
     int interveneRegistration();
     int checkRunningImsi();
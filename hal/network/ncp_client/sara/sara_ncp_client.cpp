@@ -102,6 +102,7 @@ const auto UBLOX_NCP_KEEPALIVE_MAX_MISSED = 5;
 
 // FIXME: for now using a very large buffer
 const auto UBLOX_NCP_AT_CHANNEL_RX_BUFFER_SIZE = 4096;
+const auto UBLOX_NCP_AT_CHANNEL_TX_BUFFER_SIZE = 256;
 const auto UBLOX_NCP_PPP_CHANNEL_RX_BUFFER_SIZE = 256;
 
 const auto UBLOX_NCP_AT_CHANNEL = 1;
@@ -121,6 +122,12 @@ const system_tick_t UBLOX_CFUN_TIMEOUT = 3 * 60 * 1000;
 const system_tick_t UBLOX_CIMI_TIMEOUT = 10 * 1000; // Should be immediate, but have observed 3 seconds occassionally on u-blox and rarely longer times
 const system_tick_t UBLOX_UBANDMASK_TIMEOUT = 10 * 1000;
 
+// Minimum interval between the queries of the signal quality and network identity, even if the
+// modem reports a change via an URC
+const system_tick_t UBLOX_NETWORK_INFO_MIN_REFRESH_INTERVAL = 1000;
+// Maximum age of the cached signal quality and network identity, in case a change was not reported
+const system_tick_t UBLOX_NETWORK_INFO_MAX_AGE = 60 * 1000;
+
 const auto UBLOX_MUXER_T1 = 2530;
 const auto UBLOX_MUXER_T2 = 2540;
 
@@ -133,6 +140,21 @@ const system_tick_t UBLOX_NCP_R4_WINDOW_SIZE_MS = 50;
 const int UBLOX_DEFAULT_CID = 1;
 const char UBLOX_DEFAULT_PDP_TYPE[] = "IP";
 
+// Indicators reported via +CIEV
+const unsigned UBLOX_CIEV_SIGNAL = 2;
+const unsigned UBLOX_CIEV_SERVICE = 3;
+
+bool isCachedInfoFresh(bool valid, bool changed, system_tick_t time) {
+    if (!valid) {
+        return false;
+    }
+    const auto age = millis() - time;
+    if (changed) {
+        return age < UBLOX_NETWORK_INFO_MIN_REFRESH_INTERVAL;
+    }
+    return age < UBLOX_NETWORK_INFO_MAX_AGE;
+}
+
 
 } // anonymous
 
@@ -153,7 +175,7 @@ int SaraNcpClient::init(const NcpClientConfig& conf) {
     // Initialize muxed channel stream
     decltype(muxerAtStream_) muxStrm(new(std::nothrow) decltype(muxerAtStream_)::element_type(&muxer_, UBLOX_NCP_AT_CHANNEL));
     CHECK_TRUE(muxStrm, SYSTEM_ERROR_NO_MEMORY);
-    CHECK(muxStrm->init(UBLOX_NCP_AT_CHANNEL_RX_BUFFER_SIZE));
+    CHECK(muxStrm->init(UBLOX_NCP_AT_CHANNEL_RX_BUFFER_SIZE, UBLOX_NCP_AT_CHANNEL_TX_BUFFER_SIZE));
     CHECK(initParser(serial.get()));
     decltype(muxerDataStream_) muxDataStrm(new(std::nothrow) decltype(muxerDataStream_)::element_type(&muxer_, UBLOX_NCP_PPP_CHANNEL));
     CHECK_TRUE(muxDataStrm, SYSTEM_ERROR_NO_MEMORY);
@@ -216,7 +238,11 @@ int SaraNcpClient::initParser(Stream* stream) {
         CHECK_TRUE(r >= 1, SYSTEM_ERROR_AT_RESPONSE_UNEXPECTED);
 
         bool prevRegStatus = self->csd_.registered();
+        const auto prevStatus = self->csd_.status();
         self->csd_.status(self->csd_.decodeAtStatus(val[0]));
+        if (self->csd_.status() != prevStatus) {
+            self->networkInfoChanged();
+        }
         // Check IMSI only if registered from a non-registered state, to avoid checking IMSI
         // every time there is a cell tower change in which case also we could see a CREG: {1 or 5} URC
         // TODO: Do this only for Twilio
@@ -253,7 +279,11 @@ int SaraNcpClient::initParser(Stream* stream) {
         CHECK_TRUE(r >= 1, SYSTEM_ERROR_AT_RESPONSE_UNEXPECTED);
 
         bool prevRegStatus = self->psd_.registered();
+        const auto prevStatus = self->psd_.status();
         self->psd_.status(self->psd_.decodeAtStatus(val[0]));
+        if (self->psd_.status() != prevStatus) {
+            self->networkInfoChanged();
+        }
         // Check IMSI only if registered from a non-registered state, to avoid checking IMSI
         // every time there is a cell tower change in which case also we could see a CGREG: {1 or 5} URC
         // TODO: Do this only for Twilio
@@ -272,8 +302,7 @@ int SaraNcpClient::initParser(Stream* stream) {
                 case CellularAccessTechnology::UTRAN_HSDPA:
                 case CellularAccessTechnology::UTRAN_HSUPA:
                 case CellularAccessTechnology::UTRAN_HSDPA_HSUPA: {
-                    self->cgi_.location_area_code = static_cast<LacType>(val[1]);
-                    self->cgi_.cell_id = static_cast<CidType>(val[2]);
+                    self->updateCellId(static_cast<LacType>(val[1]), static_cast<CidType>(val[2]));
                     break;
                 }
             }
@@ -297,7 +326,11 @@ int SaraNcpClient::initParser(Stream* stream) {
         CHECK_TRUE(r >= 1, SYSTEM_ERROR_AT_RESPONSE_UNEXPECTED);
 
         bool prevRegStatus = self->eps_.registered();
+        const auto prevStatus = self->eps_.status();
         self->eps_.status(self->eps_.decodeAtStatus(val[0]));
+        if (self->eps_.status() != prevStatus) {
+            self->networkInfoChanged();
+        }
         // Check IMSI only if registered from a non-registered state, to avoid checking IMSI
         // every time there is a cell tower change in which case also we could see a CEREG: {1 or 5} URC
         // TODO: Do this only for Twilio
@@ -312,14 +345,26 @@ int SaraNcpClient::initParser(Stream* stream) {
                 case CellularAccessTechnology::LTE:
                 case CellularAccessTechnology::LTE_CAT_M1:
                 case CellularAccessTechnology::LTE_NB_IOT: {
-                    self->cgi_.location_area_code = static_cast<LacType>(val[1]);
-                    self->cgi_.cell_id = static_cast<CidType>(val[2]);
+                    self->updateCellId(static_cast<LacType>(val[1]), static_cast<CidType>(val[2]));
                     break;
                 }
             }
         }
         return SYSTEM_ERROR_NONE;
     }, this));
+    // +CIEV: <descr>,<value>
+    CHECK(parser_.addUrcHandler("+CIEV", [](AtResponseReader* reader, const char* prefix, void* data) -> int {
+        const auto self = (SaraNcpClient*)data;
+        unsigned descr = 0;
+        const int r = CHECK_PARSER_URC(reader->scanf("+CIEV: %u", &descr));
+        CHECK_TRUE(r == 1, SYSTEM_ERROR_AT_RESPONSE_UNEXPECTED);
+        if (descr == UBLOX_CIEV_SIGNAL) {
+            self->signalQualChanged_ = true;
+        } else if (descr == UBLOX_CIEV_SERVICE) {
+            self->networkInfoChanged();
+        }
+        return SYSTEM_ERROR_NONE;
+    }, this));
     return SYSTEM_ERROR_NONE;
 }
 
@@ -640,25 +685,30 @@ int SaraNcpClient::getCellularGlobalIdentity(CellularGlobalIdentity* cgi) {
     const NcpClientLock lock(this);
     CHECK_TRUE(connState_ != NcpConnectionState::DISCONNECTED, SYSTEM_ERROR_INVALID_STATE);
     CHECK_TRUE(cgi, SYSTEM_ERROR_INVALID_ARGUMENT);
-    CHECK(checkParser());
 
-    // FIXME: this is a workaround for CH28408
-    CellularSignalQuality qual;
-    CHECK(queryAndParseAtCops(&qual));
-    CHECK_TRUE(qual.accessTechnology() != CellularAccessTechnology::NONE, SYSTEM_ERROR_INVALID_STATE);
-    // Update current RAT
-    act_ = qual.accessTechnology();
-    // Invalidate LAC and Cell ID
-    cgi_.location_area_code = std::numeric_limits<LacType>::max();
-    cgi_.cell_id = std::numeric_limits<CidType>::max();
-    // Fill in LAC and Cell ID based on current RAT, prefer PSD and EPS
-    // fallback to CSD
-    if (conf_.ncpIdentifier() != PLATFORM_NCP_SARA_R410) {
-        CHECK_PARSER_OK(parser_.execCommand("AT+CGREG?"));
-        CHECK_PARSER_OK(parser_.execCommand("AT+CREG?"));
-    } else {
-        CHECK_PARSER_OK(parser_.execCommand("AT+CEREG?"));
-        CHECK_PARSER_OK(parser_.execCommand("AT+CREG?"));
+    if (!isCachedInfoFresh(cgiValid_, cgiChanged_, cgiTime_)) {
+        CHECK(checkParser());
+        // FIXME: this is a workaround for CH28408
+        CellularSignalQuality qual;
+        CHECK(queryAndParseAtCops(&qual));
+        CHECK_TRUE(qual.accessTechnology() != CellularAccessTechnology::NONE, SYSTEM_ERROR_INVALID_STATE);
+        // Update current RAT
+        act_ = qual.accessTechnology();
+        // Invalidate LAC and Cell ID
+        cgi_.location_area_code = std::numeric_limits<LacType>::max();
+        cgi_.cell_id = std::numeric_limits<CidType>::max();
+        // Fill in LAC and Cell ID based on current RAT, prefer PSD and EPS
+        // fallback to CSD
+        if (conf_.ncpIdentifier() != PLATFORM_NCP_SARA_R410) {
+            CHECK_PARSER_OK(parser_.execCommand("AT+CGREG?"));
+            CHECK_PARSER_OK(parser_.execCommand("AT+CREG?"));
+        } else {
+            CHECK_PARSER_OK(parser_.execCommand("AT+CEREG?"));
+            CHECK_PARSER_OK(parser_.execCommand("AT+CREG?"));
+        }
+        cgiTime_ = millis();
+        cgiValid_ = true;
+        cgiChanged_ = false;
     }
 
     switch (cgi->version)
@@ -683,7 +733,20 @@ int SaraNcpClient::getSignalQuality(CellularSignalQuality* qual) {
     const NcpClientLock lock(this);
     CHECK_TRUE(connState_ != NcpConnectionState::DISCONNECTED, SYSTEM_ERROR_INVALID_STATE);
     CHECK_TRUE(qual, SYSTEM_ERROR_INVALID_ARGUMENT);
-    CHECK(checkParser());
+    if (!isCachedInfoFresh(signalQualValid_, signalQualChanged_, signalQualTime_)) {
+        CHECK(checkParser());
+        CellularSignalQuality q;
+        CHECK(querySignalQuality(&q));
+        signalQual_ = q;
+        signalQualTime_ = millis();
+        signalQualValid_ = true;
+        signalQualChanged_ = false;
+    }
+    *qual = signalQual_;
+    return SYSTEM_ERROR_NONE;
+}
+
+int SaraNcpClient::querySignalQuality(CellularSignalQuality* qual) {
     CHECK(queryAndParseAtCops(qual));
 
     // Min and max RSRQ index values multiplied by 100
@@ -1533,6 +1596,9 @@ int SaraNcpClient::registerNet() {
         r = CHECK_PARSER(parser_.execCommand("AT+CEREG=2"));
         CHECK_TRUE(r == AtResponse::OK, SYSTEM_ERROR_AT_NOT_OK);
     }
+    // Report signal and service indicator changes via +CIEV URCs, so that the cached network
+    // info can be kept until it changes. Ignore errors as this is an optimization only
+    CHECK_PARSER(parser_.execCommand("AT+CMER=1,0,0,2,1"));
 
     connectionState(NcpConnectionState::CONNECTING);
     registeredTime_ = 0;
@@ -1773,6 +1839,23 @@ void SaraNcpClient::resetRegistrationState() {
     regCheckTime_ = regStartTime_;
     imsiCheckTime_ = regStartTime_;
     registrationInterventions_ = 0;
+    signalQualValid_ = false;
+    cgiValid_ = false;
+}
+
+void SaraNcpClient::networkInfoChanged() {
+    signalQualChanged_ = true;
+    cgiChanged_ = true;
+}
+
+void SaraNcpClient::updateCellId(uint16_t lac, uint32_t cid) {
+    // A change of a previously known cell is reported by the registration URCs
+    if (cgi_.cell_id != std::numeric_limits<CidType>::max() &&
+            (cgi_.location_area_code != lac || cgi_.cell_id != cid)) {
+        networkInfoChanged();
+    }
+    cgi_.location_area_code = lac;
+    cgi_.cell_id = cid;
 }
 
 void SaraNcpClient::checkRegistrationState() {
@@ -302,9 +302,7 @@ int wlan_scan(wlan_scan_result_t callback, void* cookie) {
     };
     const auto mgr = wifiNetworkManager();
     CHECK_TRUE(mgr, SYSTEM_ERROR_UNKNOWN);
-    const auto client = mgr->ncpClient();
-    CHECK_TRUE(client, SYSTEM_ERROR_UNKNOWN);
-    CHECK(client->scan([](WifiScanResult result, void* data) {
+    CHECK(mgr->scan([](WifiScanResult result, void* data) {
         WiFiAccessPoint ap = {};
         ap.size = sizeof(WiFiAccessPoint);
         if (result.ssid()) {
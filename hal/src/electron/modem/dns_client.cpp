@@ -57,9 +57,12 @@
 
 #include "mdm_hal.h"
 #include <stdio.h>
+#include <strings.h>
 #include "timer_hal.h"
 #include "delay_hal.h"
+#include "rng_hal.h"
 #include "system_error.h"
+#include "c_string.h"
 
 #include <memory>
 
@@ -69,29 +72,38 @@ namespace particle {
 
 namespace {
 
-// DNS server address
-const MDM_IP SERVER_ADDRESS = IPADR(8, 8, 8, 8);
+// DNS server addresses. The queries are sent to all servers at once and the first valid response
+// is used
+const MDM_IP SERVER_ADDRESSES[] = { IPADR(8, 8, 8, 8), IPADR(1, 1, 1, 1) };
+const size_t SERVER_COUNT = sizeof(SERVER_ADDRESSES) / sizeof(SERVER_ADDRESSES[0]);
 const uint16_t SERVER_PORT = 53;
 // Maximum host name length
 const size_t MAX_NAME_LENGTH = 255;
 // Maximum number of retries
 const unsigned MAX_DNS_QRY_RETRIES = 3;
 const unsigned MAX_SEND_TO_RETRIES = 1;
+// Maximum number of outstanding requests per query. A late response to a request sent before a
+// retry is still accepted
+const size_t MAX_REQUEST_COUNT = SERVER_COUNT * (MAX_DNS_QRY_RETRIES + 1);
 // Buffer size
 const size_t BUFFER_SIZE = 512; // See RFC 1035 – 4.2.1. UDP usage
+// Maximum number of cached host addresses
+const size_t MAX_CACHE_SIZE = 4;
+// Maximum TTL of a cached address (seconds)
+const uint32_t MAX_CACHE_TTL = 24 * 60 * 60;
 
 // DNS protocol flags
 const unsigned DNS_FLAG1_RD = 0x01;
 const unsigned DNS_FLAG1_RESPONSE = 0x80;
 const unsigned DNS_FLAG2_ERR_MASK = 0x0f;
 
+// RCODE values
+const unsigned DNS_RCODE_NXDOMAIN = 3; // Name Error
+
 // TYPE and CLASS fields
 const unsigned DNS_RRTYPE_A = 1; // A host address
 const unsigned DNS_RRCLASS_IN = 1; // The Internet
 
-// Last used query ID
-uint16_t g_queryId = 0;
-
 struct DnsHeader {
   uint16_t id;
   uint8_t flags1;
@@ -114,16 +126,42 @@ struct DnsAnswer {
     uint16_t len;
 } __attribute__((packed));
 
+// Request sent to a particular DNS server
+struct DnsRequest {
+    MDM_IP server;
+    uint16_t id;
+};
+
 struct DnsQuery {
-    std::unique_ptr<char[]> buf;
+    std::unique_ptr<char[]> buf; // Response buffer
+    std::unique_ptr<char[]> packet; // Query packet
+    size_t packetSize;
     const char* name;
     MDM_IP addr;
-    uint16_t id;
+    uint32_t ttl;
+    DnsRequest reqs[MAX_REQUEST_COUNT];
+    size_t reqCount;
+    unsigned failedServers; // Servers that responded with unusable data (bitmask)
 
     explicit DnsQuery(const char* name) :
+            packetSize(0),
             name(name),
             addr(NOIP),
-            id(0) {
+            ttl(0),
+            reqs(),
+            reqCount(0),
+            failedServers(0) {
+    }
+};
+
+struct DnsCacheEntry {
+    CString name;
+    MDM_IP addr;
+    system_tick_t expireAt;
+
+    DnsCacheEntry() :
+            addr(NOIP),
+            expireAt(0) {
     }
 };
 
@@ -205,6 +243,10 @@ private:
 
 UdpSocket g_sock;
 
+// Cached host addresses. This code is always called with the modem lock held, so no additional
+// synchronization is needed
+DnsCacheEntry g_cache[MAX_CACHE_SIZE];
+
 inline uint16_t htons(uint16_t val) {
 #if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
     return val;
@@ -229,6 +271,49 @@ inline uint32_t ntohl(uint32_t val) {
     return htonl(val);
 }
 
+inline bool isCacheEntryValid(const DnsCacheEntry& entry, system_tick_t now) {
+    return entry.name && (int32_t)(entry.expireAt - now) > 0;
+}
+
+MDM_IP getCachedAddress(const char* name) {
+    const auto now = HAL_Timer_Get_Milli_Seconds();
+    for (auto& entry: g_cache) {
+        if (isCacheEntryValid(entry, now) && strcasecmp(entry.name, name) == 0) {
+            return entry.addr;
+        }
+    }
+    return NOIP;
+}
+
+void cacheAddress(const char* name, MDM_IP addr, uint32_t ttl) {
+    if (!ttl) {
+        return; // Must not be cached
+    }
+    if (ttl > MAX_CACHE_TTL) {
+        ttl = MAX_CACHE_TTL;
+    }
+    const auto now = HAL_Timer_Get_Milli_Seconds();
+    // Reuse an entry for the same name or an expired entry, otherwise replace the entry that
+    // expires first
+    DnsCacheEntry* entry = nullptr;
+    for (auto& e: g_cache) {
+        if (!isCacheEntryValid(e, now)) {
+            if (!entry || isCacheEntryValid(*entry, now)) {
+                entry = &e;
+            }
+        } else if (strcasecmp(e.name, name) == 0) {
+            entry = &e;
+            break;
+        } else if (!entry || (isCacheEntryValid(*entry, now) &&
+                (int32_t)(e.expireAt - entry->expireAt) < 0)) {
+            entry = &e;
+        }
+    }
+    entry->name = name;
+    entry->addr = addr;
+    entry->expireAt = now + ttl * 1000;
+}
+
 int dnsCompareName(const char* name, const char* data, size_t size) {
     size_t offs = 0;
     uint8_t n = 0;
@@ -292,41 +377,16 @@ int dnsSkipName(const char* data, size_t size) {
     return offs + 1;
 }
 
-int recvDnsResponse(UdpSocket* sock, DnsQuery* q) {
-    MDM_IP addr = NOIP;
-    int port = 0;
-    int ret = sock->recvFrom(&addr, &port, q->buf.get(), BUFFER_SIZE);
-    if (ret <= 0) {
-        return ret;
-    }
-    const size_t packetSize = ret;
-    if (packetSize > BUFFER_SIZE) {
-        return SYSTEM_ERROR_TOO_LARGE;
-    }
-    if (addr != SERVER_ADDRESS) {
-        return 0; // Ignore packet
-    }
-    // Is the DNS message big enough?
-    if (packetSize < sizeof(DnsHeader)) {
-        return SYSTEM_ERROR_BAD_DATA;
-    }
-    DnsHeader hdr = {};
-    memcpy(&hdr, q->buf.get(), sizeof(DnsHeader));
-    hdr.id = ntohs(hdr.id);
-    if (hdr.id != q->id) {
-        return 0; // Ignore packet
-    }
-    // Check for errors
-    if (hdr.flags2 & DNS_FLAG2_ERR_MASK) {
-        return SYSTEM_ERROR_UNKNOWN;
-    }
+// Parses the response data and stores the resolved address in the query. Returns 0 on success,
+// or a negative result code if the response is malformed or contains no address
+int parseDnsResponse(DnsQuery* q, DnsHeader hdr, size_t packetSize) {
     hdr.numquestions = ntohs(hdr.numquestions);
     if (!(hdr.flags1 & DNS_FLAG1_RESPONSE) || hdr.numquestions != 1) {
         return SYSTEM_ERROR_BAD_DATA; // Unexpected response data
     }
     // Check if the question section matches the query
     size_t offs = sizeof(DnsHeader);
-    ret = dnsCompareName(q->name, q->buf.get() + offs, packetSize - offs);
+    int ret = dnsCompareName(q->name, q->buf.get() + offs, packetSize - offs);
     if (ret < 0) {
         return SYSTEM_ERROR_BAD_DATA;
     }
@@ -342,11 +402,13 @@ int recvDnsResponse(UdpSocket* sock, DnsQuery* q) {
         return SYSTEM_ERROR_BAD_DATA;
     }
     offs += sizeof(DnsTypeClass);
-    // Process the answer section
+    // Process the answer section. The address is cached for the smallest TTL of the records
+    // leading to it, including any CNAME records
+    uint32_t ttl = 0xffffffff;
     uint16_t nanswers = ntohs(hdr.numanswers);
     while (nanswers > 0 && offs < packetSize) {
         // Skip resource record's host name
-        int ret = dnsSkipName(q->buf.get() + offs, packetSize - offs);
+        ret = dnsSkipName(q->buf.get() + offs, packetSize - offs);
         if (ret < 0) {
             return SYSTEM_ERROR_BAD_DATA;
         }
@@ -359,7 +421,11 @@ int recvDnsResponse(UdpSocket* sock, DnsQuery* q) {
         offs += sizeof(DnsAnswer);
         answer.cls = ntohs(answer.cls);
         answer.type = ntohs(answer.type);
+        answer.ttl = ntohl(answer.ttl);
         answer.len = ntohs(answer.len);
+        if (answer.ttl < ttl) {
+            ttl = answer.ttl;
+        }
         if (answer.cls == DNS_RRCLASS_IN && answer.type == DNS_RRTYPE_A && answer.len == 4) {
             if (packetSize - offs < 4) {
                 return SYSTEM_ERROR_BAD_DATA;
@@ -367,6 +433,7 @@ int recvDnsResponse(UdpSocket* sock, DnsQuery* q) {
             uint32_t addr = 0;
             memcpy(&addr, q->buf.get() + offs, 4);
             q->addr = ntohl(addr);
+            q->ttl = ttl;
             return 0;
         }
         // Skip this answer
@@ -376,19 +443,80 @@ int recvDnsResponse(UdpSocket* sock, DnsQuery* q) {
     return SYSTEM_ERROR_NOT_FOUND;
 }
 
-int sendDnsQuery(UdpSocket* sock, DnsQuery* q) {
-    SPARK_ASSERT(sock && q);
+// Returns 1 if a packet has been received, or 0 if there's no data available
+int recvDnsResponse(UdpSocket* sock, DnsQuery* q) {
+    MDM_IP addr = NOIP;
+    int port = 0;
+    int ret = sock->recvFrom(&addr, &port, q->buf.get(), BUFFER_SIZE);
+    if (ret <= 0) {
+        return ret;
+    }
+    const size_t packetSize = ret;
+    if (packetSize > BUFFER_SIZE) {
+        return SYSTEM_ERROR_TOO_LARGE;
+    }
+    // Is the DNS message big enough?
+    if (packetSize < sizeof(DnsHeader)) {
+        return 1; // Ignore packet
+    }
+    DnsHeader hdr = {};
+    memcpy(&hdr, q->buf.get(), sizeof(DnsHeader));
+    hdr.id = ntohs(hdr.id);
+    // Find the request this packet is a response to. Late responses to the previous queries are
+    // ignored
+    size_t reqIndex = 0;
+    for (; reqIndex < q->reqCount; ++reqIndex) {
+        if (q->reqs[reqIndex].id == hdr.id && q->reqs[reqIndex].server == addr) {
+            break;
+        }
+    }
+    if (reqIndex == q->reqCount) {
+        return 1; // Ignore packet
+    }
+    // Check for errors
+    const unsigned rcode = hdr.flags2 & DNS_FLAG2_ERR_MASK;
+    if (rcode == DNS_RCODE_NXDOMAIN) {
+        return SYSTEM_ERROR_NOT_FOUND;
+    }
+    if (rcode) {
+        // Keep waiting for a response from the other servers
+        q->reqs[reqIndex] = q->reqs[--q->reqCount];
+        return 1;
+    }
+    ret = parseDnsResponse(q, hdr, packetSize);
+    if (ret < 0) {
+        // Keep waiting for a response from the other servers unless all of them have already
+        // responded with unusable data
+        q->reqs[reqIndex] = q->reqs[--q->reqCount];
+        for (size_t i = 0; i < SERVER_COUNT; ++i) {
+            if (SERVER_ADDRESSES[i] == addr) {
+                q->failedServers |= 1u << i;
+                break;
+            }
+        }
+        if (q->failedServers == (1u << SERVER_COUNT) - 1) {
+            return ret;
+        }
+    }
+    return 1;
+}
+
+int initDnsQuery(DnsQuery* q) {
     const size_t packetSize = sizeof(DnsHeader) + strlen(q->name) + 2 + sizeof(DnsTypeClass);
     if (packetSize > BUFFER_SIZE) {
         return SYSTEM_ERROR_TOO_LARGE;
     }
-    q->id = ++g_queryId; // FIXME: Use random IDs
-    // Fill the header section
+    q->buf.reset(new(std::nothrow) char[BUFFER_SIZE]);
+    q->packet.reset(new(std::nothrow) char[packetSize]);
+    if (!q->buf || !q->packet) {
+        return SYSTEM_ERROR_NO_MEMORY;
+    }
+    q->packetSize = packetSize;
+    // Fill the header section. The ID is set for each request separately
     DnsHeader hdr = {};
-    hdr.id = htons(q->id);
     hdr.flags1 = DNS_FLAG1_RD; // Recursion Desired
     hdr.numquestions = htons(1);
-    memcpy(q->buf.get(), &hdr, sizeof(hdr));
+    memcpy(q->packet.get(), &hdr, sizeof(hdr));
     // Fill the question section
     const char* name = q->name - 1;
     size_t offs = sizeof(DnsHeader);
@@ -399,19 +527,45 @@ int sendDnsQuery(UdpSocket* sock, DnsQuery* q) {
         for (; *name != '.' && *name != '\0'; ++name) {
             ++n;
         }
-        q->buf[offs] = n;
-        memcpy(q->buf.get() + offs + 1, namePart, name - namePart);
+        q->packet[offs] = n;
+        memcpy(q->packet.get() + offs + 1, namePart, name - namePart);
         offs += n + 1;
     } while (*name != '\0');
-    q->buf[offs] = '\0';
+    q->packet[offs] = '\0';
     ++offs;
     DnsTypeClass tc = {};
     tc.type = htons(DNS_RRTYPE_A);
     tc.cls = htons(DNS_RRCLASS_IN);
-    memcpy(q->buf.get() + offs, &tc, sizeof(DnsTypeClass));
+    memcpy(q->packet.get() + offs, &tc, sizeof(DnsTypeClass));
+    return 0;
+}
+
+uint16_t newRequestId(const DnsQuery* q) {
+    for (;;) {
+        // Random IDs make it harder to spoof a response
+        const uint16_t id = HAL_RNG_GetRandomNumber();
+        size_t i = 0;
+        while (i < q->reqCount && q->reqs[i].id != id) {
+            ++i;
+        }
+        if (i == q->reqCount) {
+            return id;
+        }
+    }
+}
+
+int sendDnsRequest(UdpSocket* sock, DnsQuery* q, MDM_IP server) {
+    if (q->reqCount == MAX_REQUEST_COUNT) {
+        // Forget the oldest request
+        memmove(q->reqs, q->reqs + 1, (MAX_REQUEST_COUNT - 1) * sizeof(DnsRequest));
+        --q->reqCount;
+    }
+    const uint16_t id = newRequestId(q);
+    const uint16_t netId = htons(id);
+    memcpy(q->packet.get(), &netId, sizeof(netId)); // DnsHeader::id
     unsigned send_retries = 0;
     do {
-        const int ret = sock->sendTo(SERVER_ADDRESS, SERVER_PORT, q->buf.get(), packetSize);
+        const int ret = sock->sendTo(server, SERVER_PORT, q->packet.get(), q->packetSize);
         if (ret < 0) {
             sock->close();
             if (send_retries >= MAX_SEND_TO_RETRIES) {
@@ -423,9 +577,26 @@ int sendDnsQuery(UdpSocket* sock, DnsQuery* q) {
             break;
         }
     } while (send_retries <= MAX_SEND_TO_RETRIES);
+    DnsRequest& req = q->reqs[q->reqCount++];
+    req.server = server;
+    req.id = id;
     return 0;
 }
 
+int sendDnsQuery(UdpSocket* sock, DnsQuery* q) {
+    SPARK_ASSERT(sock && q);
+    // Send the query to all servers using the same socket
+    int ret = 0;
+    bool sent = false;
+    for (size_t i = 0; i < SERVER_COUNT; ++i) {
+        ret = sendDnsRequest(sock, q, SERVER_ADDRESSES[i]);
+        if (ret == 0) {
+            sent = true;
+        }
+    }
+    return sent ? 0 : ret;
+}
+
 } // namespace particle::
 
 int getHostByName(const char* name, MDM_IP* addr) {
@@ -439,19 +610,26 @@ int getHostByName(const char* name, MDM_IP* addr) {
         return SYSTEM_ERROR_TOO_LARGE;
     }
     if (strcmp(name, "localhost") == 0) {
-        return IPADR(127, 0, 0, 1);
+        *addr = IPADR(127, 0, 0, 1);
+        return 0;
     }
     unsigned a = 0, b = 0, c = 0, d = 0;
     if (sscanf(name, "%u.%u.%u.%u", &a, &b, &c, &d) == 4) {
         *addr = IPADR(a, b, c, d);
         return 0;
     }
+    const MDM_IP cachedAddr = getCachedAddress(name);
+    if (cachedAddr != NOIP) {
+        LOG_DEBUG(TRACE, "Using cached address: " IPSTR, IPNUM(cachedAddr));
+        *addr = cachedAddr;
+        return 0;
+    }
     DnsQuery q(name);
-    q.buf.reset(new(std::nothrow) char[BUFFER_SIZE]);
-    if (!q.buf) {
-        return SYSTEM_ERROR_NO_MEMORY;
+    int ret = initDnsQuery(&q);
+    if (ret < 0) {
+        return ret;
     }
-    int ret = g_sock.open();
+    ret = g_sock.open();
     if (ret < 0) {
         LOG(ERROR, "Unable to create socket");
         return ret;
@@ -467,12 +645,18 @@ int getHostByName(const char* name, MDM_IP* addr) {
         const system_tick_t timeStart = HAL_Timer_Get_Milli_Seconds();
         do {
             HAL_Delay_Milliseconds(200);
-            ret = recvDnsResponse(&g_sock, &q);
-            if (ret < 0) {
-                return ret;
-            }
+            // Process all received packets, some of which may be late responses to the previous
+            // queries
+            do {
+                ret = recvDnsResponse(&g_sock, &q);
+                if (ret < 0) {
+                    return ret;
+                }
+            } while (ret > 0 && q.addr == NOIP);
             if (q.addr != NOIP) {
-                LOG_DEBUG(TRACE, "Received DNS response, address: " IPSTR, IPNUM(q.addr));
+                LOG_DEBUG(TRACE, "Received DNS response, address: " IPSTR ", TTL: %u", IPNUM(q.addr),
+                        (unsigned)q.ttl);
+                cacheAddress(name, q.addr, q.ttl);
                 *addr = q.addr;
                 return 0; // OK
             }
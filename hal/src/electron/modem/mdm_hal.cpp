@@ -54,6 +54,7 @@ std::recursive_mutex mdm_mutex;
 #define USO_MAX_WRITE   1024  //!< maximum number of bytes to write to socket (used with TX)
 #define MDM_URC_POLL_INTERVAL_MS (1000) //!< URC poll interval
 #define MDM_SOCKET_SEND_RETRIES_R4_BUG (3)
+#define MDM_SOCKET_SEND_FAST_PATH_MS (1000) //!< time after a successful socket write during which modem checks are skipped
 
 // ID of the PDP context used to configure the default EPS bearer when registering in an LTE network
 // Note: There are no PDP contexts in LTE, SARA-R4 uses this naming for the sake of simplicity
@@ -268,6 +269,8 @@ MDMParser::MDMParser(void)
         _sockets[socket].handle = MDM_SOCKET_ERROR;
     _error = 0;
     _lastProcess = 0;
+    _lastSocketWrite = 0;
+    _socketWriteOk = false;
 #ifdef MDM_DEBUG
     _debugLevel = 3;
 #endif
@@ -1427,10 +1430,18 @@ int MDMParser::_cbCCID(int type, const char* buf, int len, CStringHelper* str)
     return WAIT;
 }
 
-bool MDMParser::_checkEpsReg(void) {
+bool MDMParser::_checkEpsReg(bool force /* = true */) {
     // On the SARA R410M check EPS registration
     if (_dev.dev == DEV_SARA_R410) {
         LOCK();
+        if (!force) {
+            // The +CEREG URC is enabled during registration, so the cached state is up to date
+            // once the pending URCs have been processed
+            waitFinalResp(nullptr, nullptr, 0);
+            if (REG_OK(_net.eps) && _attached) {
+                return true;
+            }
+        }
         int r;
         sendFormated("AT+CEREG?\r\n");
         r = waitFinalResp(nullptr, nullptr, CEREG_TIMEOUT);
@@ -2897,10 +2908,14 @@ int MDMParser::socketSend(int socket, const char * buf, int len)
             }
             int response = 0;
             // On the SARA R410M check EPS registration prior due to an issue
-            // where the USOWR can lockup the modem if connection drops
-            if (!(_checkModem() && _checkEpsReg())) {
+            // where the USOWR can lockup the modem if connection drops.
+            // If the previous write succeeded recently, the modem is known to be responsive
+            // and the cached registration state (kept up to date by URCs) is used instead
+            const bool force = !_socketWriteFastPath();
+            if (!(_checkModem(force) && _checkEpsReg(force))) {
                 return MDM_SOCKET_ERROR;
             }
+            _socketWriteOk = false;
             sendFormated("AT+USOWR=%d,%d\r\n",_sockets[socket].handle,blk);
             response = CHECK_TIMEOUT(waitFinalResp(nullptr, nullptr, usowr_timeout));
             if (response == RESP_PROMPT) {
@@ -2909,6 +2924,8 @@ int MDMParser::socketSend(int socket, const char * buf, int len)
                 response = CHECK_TIMEOUT(waitFinalResp(nullptr, nullptr, usowr_timeout));
                 if (response == RESP_OK) {
                     ok = true;
+                    _socketWriteOk = true;
+                    _lastSocketWrite = HAL_Timer_Get_Milli_Seconds();
                 }
             }
             if (response == RESP_ERROR) {
@@ -2934,6 +2951,10 @@ int MDMParser::socketSend(int socket, const char * buf, int len)
         cnt -= blk;
     }
     LOCK();
+    if (ISSOCKET(socket) && _sockets[socket].pending == 0) {
+        // Process the pending URCs first: a +UUSORD received during the write makes the poll redundant
+        waitFinalResp(nullptr, nullptr, 0);
+    }
     if (ISSOCKET(socket) && (_sockets[socket].pending == 0) && _checkModem()) {
         sendFormated("AT+USORD=%d,0\r\n", _sockets[socket].handle); // TCP
         CHECK_TIMEOUT(waitFinalResp(nullptr, nullptr, USORD_TIMEOUT));
@@ -2941,6 +2962,11 @@ int MDMParser::socketSend(int socket, const char * buf, int len)
     return (len - cnt);
 }
 
+bool MDMParser::_socketWriteFastPath(void) {
+    return _socketWriteOk && _error == 0 &&
+            (HAL_Timer_Get_Milli_Seconds() - _lastSocketWrite) < MDM_SOCKET_SEND_FAST_PATH_MS;
+}
+
 int MDMParser::_socketError(void) {
     sendFormated("AT+USOER\r\n");
     int socket_errno = UBLOX_SARA_USOER_UNKNOWN;
@@ -648,8 +648,9 @@ protected:
     int _checkAtResponse(void);
     bool _atOk(void);
     bool _checkModem(bool force = true);
-    bool _checkEpsReg(void);
+    bool _checkEpsReg(bool force = true);
     int _socketError(void);
+    bool _socketWriteFastPath(void);
     static MDMParser* inst;
     bool _init;
     bool _pwr;
@@ -661,6 +662,8 @@ protected:
     volatile bool _cancel_all_operations;
     volatile uint32_t _error;
     system_tick_t _lastProcess;
+    system_tick_t _lastSocketWrite; //!< timestamp of the last successful socket write
+    bool _socketWriteOk; //!< whether the last socket write succeeded
 #ifdef MDM_DEBUG
     int _debugLevel;
     void _debugPrint(int level, const char* color, const char* format, ...) __attribute__((format(printf, 4, 5)));
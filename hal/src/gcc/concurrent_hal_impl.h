@@ -32,4 +32,5 @@ typedef uintptr_t os_unique_id_t;
 typedef void* os_thread_notify_t;
 
 #define OS_THREAD_PRIORITY_DEFAULT (0)
+#define OS_THREAD_PRIORITY_CRITICAL (9)
 #define OS_THREAD_STACK_SIZE_DEFAULT (0)
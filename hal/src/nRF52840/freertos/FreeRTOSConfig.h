@@ -126,7 +126,11 @@ extern void vApplicationTaskDeleteHook(void *pvTaskToDelete, volatile long* pxPe
 #define configMINIMAL_STACK_SIZE    ( ( unsigned short ) 128 )
 #define configTOTAL_HEAP_SIZE       ( ( size_t ) ( 75 * 1024 ) )
 #define configMAX_TASK_NAME_LEN     ( 16 )
+#ifdef THREAD_PROFILER
+#define configUSE_TRACE_FACILITY    1
+#else
 #define configUSE_TRACE_FACILITY    0
+#endif
 #define configUSE_16_BIT_TICKS      0
 #define configIDLE_SHOULD_YIELD     1
 #define configUSE_MUTEXES           1
@@ -154,7 +158,21 @@ extern void vApplicationTaskDeleteHook(void *pvTaskToDelete, volatile long* pxPe
 
 // This macro allows us to understand when we are included from FreeRTOS sources
 extern void newlib_impure_ptr_change(struct _reent* r);
+#ifdef THREAD_PROFILER
+// Per-thread CPU time accounting (see thread_profiler.cpp)
+extern void thread_profiler_switched_in(void* task);
+extern void thread_profiler_switched_out(void* task);
+extern void thread_profiler_task_deleted(void* task);
+#define traceTASK_SWITCHED_IN() \
+        do { \
+            newlib_impure_ptr_change(&(pxCurrentTCB->xNewLib_reent)); \
+            thread_profiler_switched_in(pxCurrentTCB); \
+        } while (0)
+#define traceTASK_SWITCHED_OUT() thread_profiler_switched_out(pxCurrentTCB)
+#define traceTASK_DELETE(pxTaskToDelete) thread_profiler_task_deleted(pxTaskToDelete)
+#else
 #define traceTASK_SWITCHED_IN() newlib_impure_ptr_change(&(pxCurrentTCB->xNewLib_reent))
+#endif // THREAD_PROFILER
 
 /* Set the following definitions to 1 to include the API function, or zero
 to exclude the API function. */
@@ -169,6 +187,9 @@ to exclude the API function. */
 #define INCLUDE_eTaskGetState           1
 #define INCLUDE_xTaskGetIdleTaskHandle  1
 #define INCLUDE_xTimerPendFunctionCall  1
+#ifdef THREAD_PROFILER
+#define INCLUDE_uxTaskGetStackHighWaterMark 1
+#endif
 
 /* The lowest interrupt priority that can be used in a call to a "set priority"
 function. */
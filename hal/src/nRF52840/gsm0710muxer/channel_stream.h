@@ -26,6 +26,7 @@
 #include "system_error.h"
 #include "concurrent_hal.h"
 #include <memory>
+#include <cstring>
 
 namespace particle {
 
@@ -40,7 +41,15 @@ public:
     MuxerChannelStream(MuxerT* muxer, uint8_t channel);
     virtual ~MuxerChannelStream();
 
-    int init(size_t rxBufSize);
+    /**
+     * Initialize the stream.
+     *
+     * If `txBufSize` is not 0, small writes are coalesced in a buffer of that size and sent as a
+     * single frame when the buffer gets full, or when the stream is flushed, read from or waited on.
+     * This suits request/response traffic such as AT commands, where a command and its terminator
+     * would otherwise be sent in separate frames.
+     */
+    int init(size_t rxBufSize, size_t txBufSize = 0);
 
     static int channelDataCb(const uint8_t* data, size_t size, void* ctx);
 
@@ -61,6 +70,7 @@ public:
 private:
     void suspend();
     void resume();
+    int flushTx();
 
 private:
     MuxerT* muxer_;
@@ -68,6 +78,9 @@ private:
     size_t rxBufSize_ = 0;
     std::unique_ptr<particle::services::RingBuffer<char> > rxBuf_;
     std::unique_ptr<char[]> rxBufData_;
+    size_t txBufSize_ = 0;
+    size_t txLen_ = 0;
+    std::unique_ptr<char[]> txBuf_;
     os_semaphore_t sem_ = nullptr;
     volatile bool flow_ = false;
     volatile bool enabled_ = true;
@@ -89,13 +102,20 @@ inline MuxerChannelStream<MuxerT>::~MuxerChannelStream() {
 }
 
 template <typename MuxerT>
-inline int MuxerChannelStream<MuxerT>::init(size_t rxBufSize) {
+inline int MuxerChannelStream<MuxerT>::init(size_t rxBufSize, size_t txBufSize) {
     if (rxBufSize != rxBufSize_ || !rxBufData_) {
         rxBufSize_ = rxBufSize;
         rxBufData_.reset(new (std::nothrow) char[rxBufSize]);
         CHECK_TRUE(rxBufData_, SYSTEM_ERROR_NO_MEMORY);
     }
 
+    if (txBufSize != txBufSize_) {
+        txBufSize_ = txBufSize;
+        txBuf_.reset(txBufSize ? new (std::nothrow) char[txBufSize] : nullptr);
+        CHECK_TRUE(txBuf_ || !txBufSize, SYSTEM_ERROR_NO_MEMORY);
+    }
+    txLen_ = 0;
+
     if (!rxBuf_) {
         rxBuf_.reset(new (std::nothrow) particle::services::RingBuffer<char>());
         CHECK_TRUE(rxBuf_, SYSTEM_ERROR_NO_MEMORY);
@@ -130,6 +150,8 @@ inline int MuxerChannelStream<MuxerT>::read(char* data, size_t size) {
     if (!enabled_) {
         return SYSTEM_ERROR_INVALID_STATE;
     }
+    // Make sure the other side has received everything it may be responding to
+    flushTx();
     size_t canRead = CHECK(rxBuf_->data());
     size_t willRead = std::min(canRead, size);
     auto r = rxBuf_->get(data, willRead);
@@ -168,6 +190,17 @@ inline int MuxerChannelStream<MuxerT>::write(const char* data, size_t size) {
     if (size == 0) {
         return 0;
     }
+    if (txBuf_) {
+        if (size > txBufSize_ - txLen_ && flushTx() < 0) {
+            return 0; // Flow control, the caller will wait for the stream to become writable
+        }
+        if (size <= txBufSize_ - txLen_) {
+            memcpy(txBuf_.get() + txLen_, data, size);
+            txLen_ += size;
+            return size;
+        }
+        // Too large to be buffered, send it directly
+    }
     auto r = muxer_->writeChannel(channel_, (const uint8_t*)data, size);
     if (!r) {
         return size;
@@ -182,7 +215,21 @@ inline int MuxerChannelStream<MuxerT>::flush() {
     if (!enabled_) {
         return SYSTEM_ERROR_INVALID_STATE;
     }
-    return 0;
+    return flushTx();
+}
+
+template <typename MuxerT>
+inline int MuxerChannelStream<MuxerT>::flushTx() {
+    if (!txLen_) {
+        return 0;
+    }
+    auto r = muxer_->writeChannel(channel_, (const uint8_t*)txBuf_.get(), txLen_);
+    if (r == gsm0710::GSM0710_ERROR_FLOW_CONTROL) {
+        return SYSTEM_ERROR_BUSY;
+    }
+    // The buffered data is dropped on any other error, same as a failed unbuffered write
+    txLen_ = 0;
+    return r ? SYSTEM_ERROR_IO : 0;
 }
 
 template <typename MuxerT>
@@ -207,6 +254,7 @@ inline int MuxerChannelStream<MuxerT>::waitEvent(unsigned flags, unsigned timeou
     unsigned f = 0;
     const auto t = HAL_Timer_Get_Milli_Seconds();
     for (;;) {
+        flushTx();
         if (availForRead() > 0) {
             f |= Stream::READABLE;
         }
@@ -257,6 +305,7 @@ inline void MuxerChannelStream<MuxerT>::enabled(bool enabled) {
     const auto wasEnabled = enabled_;
     enabled_ = enabled;
     if (!enabled && wasEnabled) {
+        txLen_ = 0;
         os_semaphore_give(sem_, false);
     }
 }
@@ -96,4 +96,9 @@
 
 #define HAL_PLATFORM_SOCKET_IOCTL_NOTIFY (1)
 
-#define HAL_PLATFORM_NEWLIB (1)
\ No newline at end of file
+#define HAL_PLATFORM_NEWLIB (1)
+
+// Per-thread CPU time and stack usage statistics (see thread_profiler.cpp)
+#ifdef THREAD_PROFILER
+#define HAL_PLATFORM_THREAD_PROFILER (1)
+#endif // THREAD_PROFILER
@@ -366,6 +366,7 @@ static int flash_bootloader(const hal_module_t* mod, uint32_t moduleLength)
     uint32_t attempt = 0;
     for (;;) {
         int fres = FLASH_ACCESS_RESULT_ERROR;
+        invalidate_verified_modules();
         if (attempt++ > 0) {
             // NOTE: we have to use app_util_ciritical_region_enter/exit here
             // because it does not block SoftDevice interrupts (which we are dependent
@@ -544,6 +545,7 @@ __attribute__((optimize("O0"))) int HAL_FLASH_End(void* reserved)
         moduleCount = MAX_COMBINED_MODULE_COUNT;
     }
     CHECK(validateModules(modules, moduleCount));
+    invalidate_verified_modules();
     bool restartPending = false;
     for (size_t i = 0; i < moduleCount; ++i) {
         const auto module = &modules[i];
@@ -16,13 +16,139 @@
  */
 
 #include <stdlib.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <string.h>
 #include "flash_mal.h"
 #include "ota_module.h"
+#include "core_hal.h"
+#include "hw_config.h"
+#include "platform_headers.h"
 
 namespace {
 
+const uint32_t VERIFIED_MODULE_CACHE_MAGIC = 0x564d4331; // "VMC1"
+const size_t VERIFIED_MODULE_CACHE_SIZE = 4;
+
+// Module in the internal flash whose CRC was verified
+struct VerifiedModule {
+    uint32_t start_address;
+    uint32_t length;
+    uint32_t crc; // CRC-32 stored after the module
+    uint32_t generation; // Flash generation at the time of the check
+};
+
+// The cache is kept in the retained system RAM and survives wake-ups from the System OFF mode.
+// It's only trusted after such a wake-up, since the bootloader may update modules in any other
+// case (e.g. in DFU mode)
+struct VerifiedModuleCache {
+    uint32_t magic;
+    uint32_t generation; // Incremented every time the system firmware modifies the internal flash
+    VerifiedModule modules[VERIFIED_MODULE_CACHE_SIZE];
+    uint32_t checksum;
+};
+
+retained_system VerifiedModuleCache g_verifiedModules;
+
+int g_verifiedModulesTrusted = -1;
+
+uint32_t verified_modules_checksum() {
+    return Compute_CRC32((const uint8_t*)&g_verifiedModules, offsetof(VerifiedModuleCache, checksum), nullptr);
+}
+
+bool verified_modules_valid() {
+    return g_verifiedModules.magic == VERIFIED_MODULE_CACHE_MAGIC && g_verifiedModules.checksum == verified_modules_checksum();
+}
+
+void reset_verified_modules() {
+    memset(&g_verifiedModules, 0, sizeof(g_verifiedModules));
+    g_verifiedModules.magic = VERIFIED_MODULE_CACHE_MAGIC;
+    g_verifiedModules.checksum = verified_modules_checksum();
+}
+
+bool verified_modules_trusted() {
+    if (g_verifiedModulesTrusted < 0) {
+        // Evaluated once per boot
+        g_verifiedModulesTrusted = HAL_Core_System_Reset_FlagSet(POWER_MANAGEMENT_RESET) && !HAL_OTA_Flashed_GetStatus() &&
+                verified_modules_valid();
+        if (!g_verifiedModulesTrusted) {
+            reset_verified_modules();
+        }
+    }
+    return g_verifiedModulesTrusted;
+}
+
+uint32_t stored_module_crc(const module_bounds_t* bounds, uint32_t length) {
+    uint32_t crc = 0;
+    memcpy(&crc, (const void*)(bounds->start_address + length), sizeof(crc));
+    return crc;
+}
+
+bool is_module_verified(const module_bounds_t* bounds, uint32_t length) {
+    if (bounds->store != MODULE_STORE_MAIN || !verified_modules_trusted()) {
+        return false;
+    }
+    const uint32_t crc = stored_module_crc(bounds, length);
+    for (const auto& m: g_verifiedModules.modules) {
+        if (m.start_address == bounds->start_address && m.length == length && m.crc == crc &&
+                m.generation == g_verifiedModules.generation) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void add_verified_module(const module_bounds_t* bounds, uint32_t length) {
+    if (bounds->store != MODULE_STORE_MAIN) {
+        return;
+    }
+    verified_modules_trusted(); // Make sure the cache is initialized
+    VerifiedModule* entry = nullptr;
+    for (auto& m: g_verifiedModules.modules) {
+        if (m.start_address == bounds->start_address) {
+            entry = &m;
+            break;
+        }
+        if (!entry && (m.start_address == 0 || m.generation != g_verifiedModules.generation)) {
+            entry = &m; // Free or stale entry
+        }
+    }
+    if (!entry) {
+        entry = &g_verifiedModules.modules[0];
+    }
+    entry->start_address = bounds->start_address;
+    entry->length = length;
+    entry->crc = stored_module_crc(bounds, length);
+    entry->generation = g_verifiedModules.generation;
+    g_verifiedModules.checksum = verified_modules_checksum();
+}
+
+// Returns the checks to perform when verifying the integrity of a module
+uint8_t module_verify_flags(const module_bounds_t* bounds, const module_info_t* info) {
+    uint8_t flags = FLASH_VERIFY_CRC32;
+    // Additionally check the SHA-256 of the system and user modules received via OTA. Compressed
+    // modules are only verified with the CRC-32
+    const auto func = module_function(info);
+    if (bounds->store == MODULE_STORE_SCRATCHPAD && !(info->flags & MODULE_INFO_FLAG_COMPRESSED) &&
+            (func == MODULE_FUNCTION_SYSTEM_PART || func == MODULE_FUNCTION_USER_PART) &&
+            FLASH_IsSHA256VerificationSupported()) {
+        flags |= FLASH_VERIFY_SHA256;
+    }
+    return flags;
+}
+
+bool verify_module_crc(const module_bounds_t* bounds, const module_info_t* info) {
+    const uint32_t length = module_length(info);
+    if (is_module_verified(bounds, length)) {
+        return true;
+    }
+    if (!FLASH_VerifyModule(FLASH_INTERNAL, bounds->start_address, length, module_verify_flags(bounds, info))) {
+        return false;
+    }
+    add_verified_module(bounds, length);
+    return true;
+}
+
 const module_info_t* get_module_info(const module_bounds_t* bounds, uint32_t* offset = nullptr) {
     // Note: This function uses XIP to access the module info in the OTA flash section
     return FLASH_ModuleInfo(FLASH_INTERNAL, bounds->start_address, offset);
@@ -85,7 +211,7 @@ bool fetch_module(hal_module_t* target, const module_bounds_t* bounds, bool user
             target->suffix = (module_info_suffix_t*)(module_end-sizeof(module_info_suffix_t));
             if (validate_module_dependencies(bounds, userDepsOptional, target->validity_checked & MODULE_VALIDATION_DEPENDENCIES_FULL))
                 target->validity_result |= MODULE_VALIDATION_DEPENDENCIES | (target->validity_checked & MODULE_VALIDATION_DEPENDENCIES_FULL);
-            if ((target->validity_checked & MODULE_VALIDATION_INTEGRITY) && FLASH_VerifyCRC32(FLASH_INTERNAL, bounds->start_address, module_length(target->info)))
+            if ((target->validity_checked & MODULE_VALIDATION_INTEGRITY) && verify_module_crc(bounds, target->info))
                 target->validity_result |= MODULE_VALIDATION_INTEGRITY;
         }
         else
@@ -94,3 +220,15 @@ bool fetch_module(hal_module_t* target, const module_bounds_t* bounds, bool user
     return target->info!=NULL;
 }
 
+/**
+ * Invalidates the results of the previous module integrity checks. Must be called before the
+ * system firmware modifies a module in the internal flash.
+ */
+void invalidate_verified_modules(void)
+{
+    if (!verified_modules_valid()) {
+        reset_verified_modules();
+    }
+    ++g_verifiedModules.generation;
+    g_verifiedModules.checksum = verified_modules_checksum();
+}
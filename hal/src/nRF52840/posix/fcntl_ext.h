@@ -0,0 +1,41 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <fcntl.h>
+
+/**
+ * Non-standard `fcntl()` commands.
+ */
+
+/**
+ * Set the size of the write-back buffer of a file descriptor: `fcntl(fd, F_SETWRBUF, size)`.
+ *
+ * Writes smaller than the buffer are collected in RAM and passed to the filesystem when the
+ * buffer is full, or when the file descriptor is synced with `fsync()`, read from, repositioned
+ * or closed. Buffered data is not visible to other file descriptors until then. Errors that occur
+ * while writing buffered data are reported by the call that caused the buffer to be written.
+ *
+ * Setting the size to 0 writes any buffered data and disables buffering, which is the default.
+ */
+#define F_SETWRBUF 0x5001
+
+/**
+ * Get the size of the write-back buffer of a file descriptor: `fcntl(fd, F_GETWRBUF)`.
+ */
+#define F_GETWRBUF 0x5002
@@ -0,0 +1,40 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <sys/types.h>
+// lwIP's sockets.h defines struct iovec without a guard that other headers could check, so the
+// definition is taken from there to have it defined exactly once
+#include <lwip/sockets.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#ifndef IOV_MAX
+#define IOV_MAX 32
+#endif // IOV_MAX
+
+ssize_t readv(int fd, const struct iovec* iov, int iovcnt);
+
+ssize_t writev(int fd, const struct iovec* iov, int iovcnt);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
@@ -21,8 +21,11 @@
 #include <sys/stat.h>
 #include <unistd.h>
 #include <fcntl.h>
-// IMPORANT: this is our own implementation header
+#include <stdarg.h>
+// IMPORANT: these are our own implementation headers
 #include <sys/dirent.h>
+#include <sys/uio.h>
+#include "fcntl_ext.h"
 #include <errno.h>
 #include "littlefs/filesystem.h"
 #include "check.h"
@@ -30,6 +33,7 @@
 #include "scope_guard.h"
 #include "rtc_hal.h"
 #include <sys/reent.h>
+#include <new>
 
 using namespace particle::fs;
 
@@ -141,6 +145,9 @@ struct FdEntry {
         if (name) {
             delete name;
         }
+        if (wbuf) {
+            delete[] wbuf;
+        }
     }
     int fd = -1;
 
@@ -150,6 +157,11 @@ struct FdEntry {
 
     char* name = nullptr;
 
+    // Write-back buffer, see F_SETWRBUF
+    uint8_t* wbuf = nullptr;
+    size_t wbufSize = 0;
+    size_t wbufLen = 0;
+
     FdEntry* next = nullptr;
 };
 
@@ -227,6 +239,67 @@ private:
 
 FdMap s_fdMap;
 
+const size_t MAX_WRITE_BUFFER_SIZE = 4096;
+
+int flushWriteBuffer(filesystem_t* lfs, FdEntry* entry) {
+    if (!entry->wbufLen) {
+        return 0;
+    }
+    const auto len = entry->wbufLen;
+    // The buffered data is discarded even if it can't be written
+    entry->wbufLen = 0;
+    const int r = lfs_file_write(&lfs->instance, entry->file, entry->wbuf, len);
+    if (r < 0) {
+        return r;
+    }
+    return ((size_t)r == len) ? 0 : LFS_ERR_NOSPC;
+}
+
+int bufferedWrite(filesystem_t* lfs, FdEntry* entry, const void* buf, size_t count) {
+    if (count < entry->wbufSize) {
+        if (entry->wbufLen + count > entry->wbufSize) {
+            const int r = flushWriteBuffer(lfs, entry);
+            if (r < 0) {
+                return r;
+            }
+        }
+        memcpy(entry->wbuf + entry->wbufLen, buf, count);
+        entry->wbufLen += count;
+        return count;
+    }
+    // Large writes bypass the buffer
+    const int r = flushWriteBuffer(lfs, entry);
+    if (r < 0) {
+        return r;
+    }
+    return lfs_file_write(&lfs->instance, entry->file, buf, count);
+}
+
+int setWriteBufferSize(filesystem_t* lfs, FdEntry* entry, size_t size) {
+    const int r = flushWriteBuffer(lfs, entry);
+    if (r < 0) {
+        return r;
+    }
+    if (size == entry->wbufSize) {
+        return 0;
+    }
+    uint8_t* buf = nullptr;
+    if (size > 0) {
+        buf = new(std::nothrow) uint8_t[size];
+        if (!buf) {
+            return LFS_ERR_NOMEM;
+        }
+    }
+    delete[] entry->wbuf;
+    entry->wbuf = buf;
+    entry->wbufSize = size;
+    return 0;
+}
+
+bool isValidIovec(const struct iovec* iov, int iovcnt) {
+    return iov && iovcnt > 0 && iovcnt <= IOV_MAX;
+}
+
 } // anonymous namespace
 
 #define CHECK_LFS_ERRNO_VAL(_expr, _val) \
@@ -283,7 +356,7 @@ int _write(int fd, const void* buf, size_t count) {
         return -1;
     }
 
-    return CHECK_LFS_ERRNO(lfs_file_write(&lfs->instance, entry->file, buf, count));
+    return CHECK_LFS_ERRNO(bufferedWrite(lfs, entry, buf, count));
 }
 
 int _read(int fd, void* buf, size_t count) {
@@ -296,6 +369,7 @@ int _read(int fd, void* buf, size_t count) {
         return -1;
     }
 
+    CHECK_LFS_ERRNO(flushWriteBuffer(lfs, entry));
     return CHECK_LFS_ERRNO(lfs_file_read(&lfs->instance, entry->file, buf, count));
 }
 
@@ -309,6 +383,7 @@ int _fstat(int fd, struct stat* buf) {
         return -1;
     }
 
+    CHECK_LFS_ERRNO(flushWriteBuffer(lfs, entry));
     return stat(entry->name, buf);
 }
 
@@ -326,7 +401,9 @@ int _close(int fd) {
         s_fdMap.remove(entry);
     });
 
+    const int r = flushWriteBuffer(lfs, entry);
     CHECK_LFS_ERRNO(lfs_file_close(&lfs->instance, entry->file));
+    CHECK_LFS_ERRNO(r);
 
     return 0;
 }
@@ -338,9 +415,35 @@ int _execve(const char* filename, char* const argv[], char* const envp[]) {
 }
 
 int _fcntl(int fd, int cmd, ... /* arg */) {
-    // Not implemented
-    errno = ENOSYS;
-    return -1;
+    if (cmd != F_SETWRBUF && cmd != F_GETWRBUF) {
+        // Not implemented
+        errno = ENOSYS;
+        return -1;
+    }
+    auto lfs = filesystem_get_instance(nullptr);
+    FsLock lk(lfs);
+
+    auto entry = s_fdMap.get(fd);
+    if (!entry) {
+        errno = EBADF;
+        return -1;
+    }
+
+    if (cmd == F_GETWRBUF) {
+        return entry->wbufSize;
+    }
+
+    va_list args;
+    va_start(args, cmd);
+    const int size = va_arg(args, int);
+    va_end(args);
+    if (size < 0 || (size_t)size > MAX_WRITE_BUFFER_SIZE) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    CHECK_LFS_ERRNO(setWriteBufferSize(lfs, entry, size));
+    return 0;
 }
 
 pid_t _fork(void) {
@@ -417,7 +520,9 @@ int _fsync(int fd) {
         return -1;
     }
 
+    const int r = flushWriteBuffer(lfs, entry);
     CHECK_LFS_ERRNO(lfs_file_sync(&lfs->instance, entry->file));
+    CHECK_LFS_ERRNO(r);
 
     return 0;
 }
@@ -432,6 +537,7 @@ off_t _lseek(int fd, off_t offset, int whence) {
         return -1;
     }
 
+    CHECK_LFS_ERRNO(flushWriteBuffer(lfs, entry));
     return CHECK_LFS_ERRNO(lfs_file_seek(&lfs->instance, entry->file, offset, posixWhenceToLfs(whence)));
 }
 
@@ -676,6 +782,7 @@ int ftruncate(int fd, off_t length) {
         return -1;
     }
 
+    CHECK_LFS_ERRNO(flushWriteBuffer(lfs, entry));
     return CHECK_LFS_ERRNO(lfs_file_truncate(&lfs->instance, entry->file, length));
 }
 
@@ -696,6 +803,108 @@ int truncate(const char* path, off_t length) {
     return 0;
 }
 
+ssize_t readv(int fd, const struct iovec* iov, int iovcnt) {
+    if (!isValidIovec(iov, iovcnt)) {
+        errno = EINVAL;
+        return -1;
+    }
+    auto lfs = filesystem_get_instance(nullptr);
+    FsLock lk(lfs);
+
+    auto entry = s_fdMap.get(fd);
+    if (!entry) {
+        errno = EBADF;
+        return -1;
+    }
+
+    CHECK_LFS_ERRNO(flushWriteBuffer(lfs, entry));
+    ssize_t total = 0;
+    for (int i = 0; i < iovcnt; i++) {
+        const int r = lfs_file_read(&lfs->instance, entry->file, iov[i].iov_base, iov[i].iov_len);
+        if (r < 0 && total > 0) {
+            // Report the data read so far, the error will be reported by the next call
+            break;
+        }
+        total += CHECK_LFS_ERRNO(r);
+        if ((size_t)r < iov[i].iov_len) {
+            break;
+        }
+    }
+    return total;
+}
+
+ssize_t writev(int fd, const struct iovec* iov, int iovcnt) {
+    if (!isValidIovec(iov, iovcnt)) {
+        errno = EINVAL;
+        return -1;
+    }
+    auto lfs = filesystem_get_instance(nullptr);
+    FsLock lk(lfs);
+
+    auto entry = s_fdMap.get(fd);
+    if (!entry) {
+        errno = EBADF;
+        return -1;
+    }
+
+    ssize_t total = 0;
+    for (int i = 0; i < iovcnt; i++) {
+        const int r = bufferedWrite(lfs, entry, iov[i].iov_base, iov[i].iov_len);
+        if (r < 0 && total > 0) {
+            break;
+        }
+        total += CHECK_LFS_ERRNO(r);
+    }
+    return total;
+}
+
+ssize_t pread(int fd, void* buf, size_t count, off_t offset) {
+    if (offset < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    auto lfs = filesystem_get_instance(nullptr);
+    FsLock lk(lfs);
+
+    auto entry = s_fdMap.get(fd);
+    if (!entry) {
+        errno = EBADF;
+        return -1;
+    }
+
+    CHECK_LFS_ERRNO(flushWriteBuffer(lfs, entry));
+    // The file offset is not changed
+    const auto pos = CHECK_LFS_ERRNO(lfs_file_tell(&lfs->instance, entry->file));
+    CHECK_LFS_ERRNO(lfs_file_seek(&lfs->instance, entry->file, offset, LFS_SEEK_SET));
+    const int r = lfs_file_read(&lfs->instance, entry->file, buf, count);
+    lfs_file_seek(&lfs->instance, entry->file, pos, LFS_SEEK_SET);
+    return CHECK_LFS_ERRNO(r);
+}
+
+ssize_t pwrite(int fd, const void* buf, size_t count, off_t offset) {
+    if (offset < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    auto lfs = filesystem_get_instance(nullptr);
+    FsLock lk(lfs);
+
+    auto entry = s_fdMap.get(fd);
+    if (!entry) {
+        errno = EBADF;
+        return -1;
+    }
+
+    CHECK_LFS_ERRNO(flushWriteBuffer(lfs, entry));
+    // The file offset is not changed. As on Linux, the data is appended to the end of the file
+    // if the file was opened with O_APPEND
+    const auto pos = CHECK_LFS_ERRNO(lfs_file_tell(&lfs->instance, entry->file));
+    CHECK_LFS_ERRNO(lfs_file_seek(&lfs->instance, entry->file, offset, LFS_SEEK_SET));
+    const int r = lfs_file_write(&lfs->instance, entry->file, buf, count);
+    lfs_file_seek(&lfs->instance, entry->file, pos, LFS_SEEK_SET);
+    return CHECK_LFS_ERRNO(r);
+}
+
 // Current newlib doesn't implement or handle these, so we manually alias _ to non-_
 DIR* opendir(const char* name) __attribute__((alias("_opendir")));
 struct dirent* readdir(DIR* pdir) __attribute__((alias("_readdir")));
@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "concurrent_hal.h"
+#include "hal_platform.h"
+#include "system_error.h"
+
+#if HAL_PLATFORM_THREAD_PROFILER
+
+#include <FreeRTOS.h>
+#include <task.h>
+#include "nrf.h"
+
+#include <cstring>
+
+namespace {
+
+const size_t MAX_THREAD_COUNT = 24;
+
+// The slot index of a task is stored in its trace number (see vTaskSetTaskNumber()). Slots are
+// updated by the trace hooks, which run with the interrupts used by the kernel disabled
+struct ThreadSlot {
+    TaskHandle_t task; // Task handle or nullptr if the slot is free
+    uint64_t cycles; // Number of CPU cycles spent running the task
+    uint32_t switchCount; // Number of times the task was switched in
+};
+
+ThreadSlot g_slots[MAX_THREAD_COUNT] = {};
+
+// Value of the cycle counter at the time the current task was switched in. Time spent in
+// interrupt handlers is accounted to the interrupted task
+uint32_t g_switchedInCycles = 0;
+
+inline ThreadSlot* taskSlot(TaskHandle_t task) {
+    const UBaseType_t n = uxTaskGetTaskNumber(task);
+    if (n == 0 || n > MAX_THREAD_COUNT) {
+        return nullptr;
+    }
+    ThreadSlot* slot = &g_slots[n - 1];
+    if (slot->task != task) {
+        return nullptr; // The slot was reassigned after the task was deleted
+    }
+    return slot;
+}
+
+ThreadSlot* allocSlot(TaskHandle_t task) {
+    for (size_t i = 0; i < MAX_THREAD_COUNT; ++i) {
+        ThreadSlot* slot = &g_slots[i];
+        if (!slot->task) {
+            *slot = {};
+            slot->task = task;
+            vTaskSetTaskNumber(task, i + 1);
+            return slot;
+        }
+    }
+    return nullptr;
+}
+
+inline uint64_t cyclesToMicros(uint64_t cycles) {
+    return cycles / (SystemCoreClock / 1000000);
+}
+
+} // namespace
+
+extern "C" {
+
+void thread_profiler_switched_in(void* task) {
+    g_switchedInCycles = DWT->CYCCNT;
+    const auto t = (TaskHandle_t)task;
+    ThreadSlot* slot = taskSlot(t);
+    if (!slot && uxTaskGetTaskNumber(t) == 0) {
+        slot = allocSlot(t);
+    }
+    if (slot) {
+        ++slot->switchCount;
+    }
+}
+
+void thread_profiler_switched_out(void* task) {
+    ThreadSlot* slot = taskSlot((TaskHandle_t)task);
+    if (slot) {
+        slot->cycles += DWT->CYCCNT - g_switchedInCycles;
+    }
+}
+
+// Called by hal_timer_init() with the interrupts disabled after it has reset the cycle counter.
+// `cycles` is the value of the counter before the reset
+void thread_profiler_cycle_counter_reset(uint32_t cycles) {
+    const TaskHandle_t task = xTaskGetCurrentTaskHandle();
+    ThreadSlot* slot = task ? taskSlot(task) : nullptr;
+    if (slot) {
+        slot->cycles += cycles - g_switchedInCycles;
+    }
+    g_switchedInCycles = 0;
+}
+
+void thread_profiler_task_deleted(void* task) {
+    ThreadSlot* slot = taskSlot((TaskHandle_t)task);
+    if (slot) {
+        slot->task = nullptr;
+    }
+}
+
+} // extern "C"
+
+int os_thread_get_stats(os_thread_stats_t* stats, size_t count, void* reserved) {
+    if (count > 0 && !stats) {
+        return SYSTEM_ERROR_INVALID_ARGUMENT;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        if (stats[i].size < sizeof(os_thread_stats_t)) {
+            return SYSTEM_ERROR_INVALID_ARGUMENT;
+        }
+    }
+    // Prevent the tasks from being deleted while their stacks are inspected
+    vTaskSuspendAll();
+    const TaskHandle_t current = xTaskGetCurrentTaskHandle();
+    const TaskHandle_t idle = xTaskGetIdleTaskHandle();
+    size_t n = 0;
+    for (size_t i = 0; i < MAX_THREAD_COUNT; ++i) {
+        taskENTER_CRITICAL();
+        const ThreadSlot slot = g_slots[i];
+        const uint32_t cycles = DWT->CYCCNT - g_switchedInCycles;
+        taskEXIT_CRITICAL();
+        if (!slot.task) {
+            continue;
+        }
+        if (n < count) {
+            os_thread_stats_t* s = &stats[n];
+            s->flags = (slot.task == idle) ? OS_THREAD_STATS_FLAG_IDLE : 0;
+            s->thread = slot.task;
+            const char* name = pcTaskGetName(slot.task);
+            strncpy(s->name, name ? name : "", sizeof(s->name) - 1);
+            s->name[sizeof(s->name) - 1] = '\0';
+            // Account the time slice of the current task that is still in progress
+            s->cpu_time = cyclesToMicros(slot.cycles + ((slot.task == current) ? cycles : 0));
+            s->switch_count = slot.switchCount;
+            s->stack_free = uxTaskGetStackHighWaterMark(slot.task) * sizeof(StackType_t);
+        }
+        ++n;
+    }
+    xTaskResumeAll();
+    return n;
+}
+
+#else // !HAL_PLATFORM_THREAD_PROFILER
+
+int os_thread_get_stats(os_thread_stats_t* stats, size_t count, void* reserved) {
+    return SYSTEM_ERROR_NOT_SUPPORTED;
+}
+
+#endif // !HAL_PLATFORM_THREAD_PROFILER
@@ -47,12 +47,17 @@
 
 #include <stdint.h>
 #include "timer_hal.h"
+#include "hal_platform.h"
 #include <nrf_rtc.h>
 #include <nrf_drv_clock.h>
 #include <core_cmFunc.h>
 #include "service_debug.h"
 #include "hw_ticks.h"
 
+#if HAL_PLATFORM_THREAD_PROFILER
+extern "C" void thread_profiler_cycle_counter_reset(uint32_t cycles); // See thread_profiler.cpp
+#endif
+
 namespace {
 
 volatile uint32_t sOverflowCounter = 0; ///< Counter of RTC overflowCounter, incremented by 2 on each OVERFLOW event.
@@ -265,7 +270,13 @@ int hal_timer_init(const hal_timer_init_config_t* conf) {
     int pri = __get_PRIMASK();
     __disable_irq();
     nrf_rtc_task_trigger(RTC_INSTANCE, NRF_RTC_TASK_START);
+#if HAL_PLATFORM_THREAD_PROFILER
+    const uint32_t cycles = DWT->CYCCNT;
+#endif
     DWT->CYCCNT = 0;
+#if HAL_PLATFORM_THREAD_PROFILER
+    thread_profiler_cycle_counter_reset(cycles);
+#endif
     __set_PRIMASK(pri);
 
     return 0;
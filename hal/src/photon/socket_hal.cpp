@@ -1083,6 +1083,24 @@ sock_result_t socket_sendto(sock_handle_t sd, const void* buffer, socklen_t len,
     return result ? -result : len;
 }
 
+wiced_result_t get_udp_packet_address(wiced_packet_t* packet, sockaddr_t* addr)
+{
+    wiced_ip_address_t wiced_ip_addr;
+    uint16_t port;
+    wiced_result_t result = wiced_udp_packet_get_info(packet, &wiced_ip_addr, &port);
+    if (result==WICED_SUCCESS) {
+        uint32_t ipv4 = GET_IPV4_ADDRESS(wiced_ip_addr);
+        addr->sa_family = AF_INET;
+        addr->sa_data[0] = (port>>8) & 0xFF;
+        addr->sa_data[1] = port & 0xFF;
+        addr->sa_data[2] = (ipv4 >> 24) & 0xFF;
+        addr->sa_data[3] = (ipv4 >> 16) & 0xFF;
+        addr->sa_data[4] = (ipv4 >> 8) & 0xFF;
+        addr->sa_data[5] = ipv4 & 0xFF;
+    }
+    return result;
+}
+
 sock_result_t socket_receivefrom(sock_handle_t sd, void* buffer, socklen_t bufLen, uint32_t flags, sockaddr_t* addr, socklen_t* addrsize)
 {
     return socket_receivefrom_ex(sd, buffer, bufLen, flags, addr, addrsize, WICED_NO_WAIT, nullptr);
@@ -1098,17 +1116,7 @@ sock_result_t socket_receivefrom_ex(sock_handle_t sd, void* buffer, socklen_t bu
         wiced_packet_t* packet = NULL;
         // UDP receive timeout changed to 0 sec so as not to block
         if ((result=wiced_udp_receive(udp(socket), &packet, timeout))==WICED_SUCCESS) {
-            wiced_ip_address_t wiced_ip_addr;
-            uint16_t port;
-            if ((result=wiced_udp_packet_get_info(packet, &wiced_ip_addr, &port))==WICED_SUCCESS) {
-                uint32_t ipv4 = GET_IPV4_ADDRESS(wiced_ip_addr);
-                addr->sa_family = AF_INET;
-                addr->sa_data[0] = (port>>8) & 0xFF;
-                addr->sa_data[1] = port & 0xFF;
-                addr->sa_data[2] = (ipv4 >> 24) & 0xFF;
-                addr->sa_data[3] = (ipv4 >> 16) & 0xFF;
-                addr->sa_data[4] = (ipv4 >> 8) & 0xFF;
-                addr->sa_data[5] = ipv4 & 0xFF;
+            if ((result=get_udp_packet_address(packet, addr))==WICED_SUCCESS) {
                 result=read_packet(packet, (uint8_t*)buffer, bufLen, &read_len);
             }
             wiced_packet_delete(packet);
@@ -1118,6 +1126,182 @@ sock_result_t socket_receivefrom_ex(sock_handle_t sd, void* buffer, socklen_t bu
 }
 
 
+#if HAL_PLATFORM_SOCKET_BUFFERS
+
+/**
+ * Updates the buffer to reference the fragment of the packet at the current offset.
+ */
+wiced_result_t get_buffer_fragment(socket_buffer_t* buf, uint16_t* total)
+{
+    uint8_t* data = nullptr;
+    uint16_t fragment = 0;
+    wiced_result_t result = wiced_packet_get_data((wiced_packet_t*)buf->handle, buf->offset, &data, &fragment, total);
+    if (result==WICED_SUCCESS) {
+        buf->data = data;
+        buf->len = fragment;
+    }
+    return result;
+}
+
+sock_result_t socket_receive_buffer(sock_handle_t sd, socket_buffer_t* buf, system_tick_t timeout, void* reserved)
+{
+    socket_t* socket = from_handle(sd);
+    wiced_result_t result = WICED_INVALID_SOCKET;
+    wiced_packet_t* packet = NULL;
+    uint16_t offset = 0;
+    if (!buf) {
+        return as_sock_result(WICED_BADARG);
+    }
+    if (is_open(socket)) {
+        std::lock_guard<socket_t> lk(*socket);
+        if (is_udp(socket)) {
+            if ((result=wiced_udp_receive(udp(socket), &packet, timeout))==WICED_SUCCESS) {
+                result = get_udp_packet_address(packet, &buf->addr);
+            }
+        }
+        else {
+            tcp_packet_t* tcp_packet = NULL;
+            if (is_tcp(socket)) {
+                tcp_packet = &tcp(socket)->packet;
+            }
+            else if (is_client(socket)) {
+                tcp_packet = &client(socket)->packet;
+            }
+            if (tcp_packet) {
+                if (tcp_packet->packet) {
+                    // Take over the packet partially read with socket_receive()
+                    packet = tcp_packet->packet;
+                    offset = tcp_packet->offset;
+                    tcp_packet->packet = NULL;
+                    tcp_packet->offset = 0;
+                    result = WICED_SUCCESS;
+                }
+                else {
+                    result = wiced_tcp_receive(as_wiced_tcp_socket(socket), &packet, timeout);
+                }
+            }
+        }
+    }
+    buf->handle = packet;
+    buf->offset = offset;
+    uint16_t total = 0;
+    if (result==WICED_SUCCESS) {
+        result = get_buffer_fragment(buf, &total);
+    }
+    if (result!=WICED_SUCCESS || !total) {
+        socket_release_buffer(buf, nullptr);
+        return result!=WICED_SUCCESS && result!=WICED_TIMEOUT ? as_sock_result(result) : 0;
+    }
+    buf->end = offset + total;
+    return total;
+}
+
+sock_result_t socket_buffer_next(socket_buffer_t* buf, void* reserved)
+{
+    if (!buf || !buf->handle) {
+        return as_sock_result(WICED_BADARG);
+    }
+    buf->offset += buf->len;
+    buf->data = NULL;
+    buf->len = 0;
+    if (buf->offset>=buf->end) {
+        return 0;
+    }
+    uint16_t total = 0;
+    wiced_result_t result = get_buffer_fragment(buf, &total);
+    return result ? as_sock_result(result) : buf->len;
+}
+
+void socket_release_buffer(socket_buffer_t* buf, void* reserved)
+{
+    if (buf) {
+        if (buf->handle) {
+            wiced_packet_delete((wiced_packet_t*)buf->handle);
+            buf->handle = NULL;
+        }
+        buf->data = NULL;
+        buf->len = 0;
+        buf->offset = 0;
+        buf->end = 0;
+    }
+}
+
+sock_result_t socket_alloc_buffer(sock_handle_t sd, socket_buffer_t* buf, socklen_t len, void* reserved)
+{
+    socket_t* socket = from_handle(sd);
+    wiced_result_t result = WICED_INVALID_SOCKET;
+    if (!buf) {
+        return as_sock_result(WICED_BADARG);
+    }
+    buf->handle = NULL;
+    if (is_open(socket)) {
+        std::lock_guard<socket_t> lk(*socket);
+        const uint16_t size = std::min(len, socklen_t(0xffff));
+        wiced_packet_t* packet = NULL;
+        uint8_t* data = NULL;
+        uint16_t available = 0;
+        if (is_udp(socket)) {
+            result = wiced_packet_create_udp(udp(socket), size, &packet, &data, &available);
+        }
+        else {
+            wiced_tcp_socket_t* tcp_socket = as_wiced_tcp_socket(socket);
+            if (tcp_socket) {
+                result = wiced_packet_create_tcp(tcp_socket, size, &packet, &data, &available);
+            }
+        }
+        if (result==WICED_SUCCESS) {
+            buf->handle = packet;
+            buf->data = data;
+            buf->len = std::min(available, size);
+            buf->offset = 0;
+            buf->end = buf->len;
+        }
+    }
+    return result ? as_sock_result(result) : buf->len;
+}
+
+sock_result_t socket_send_buffer(sock_handle_t sd, socket_buffer_t* buf, socklen_t len, const sockaddr_t* addr, void* reserved)
+{
+    socket_t* socket = from_handle(sd);
+    wiced_result_t result = WICED_INVALID_SOCKET;
+    if (!buf || !buf->handle || len>buf->len) {
+        socket_release_buffer(buf, nullptr);
+        return as_sock_result(WICED_BADARG);
+    }
+    if (is_open(socket)) {
+        std::lock_guard<socket_t> lk(*socket);
+        wiced_packet_t* packet = (wiced_packet_t*)buf->handle;
+        if (is_udp(socket)) {
+            if (addr) {
+                SOCKADDR_TO_PORT_AND_IPADDR(addr, addr_data, port, ip_addr);
+                wiced_packet_set_data_end(packet, buf->data + len);
+                result = wiced_udp_send(udp(socket), &ip_addr, port, packet);
+                if (result == WICED_SUCCESS) {
+                    // Ownership of the packet is transferred to the IP stack
+                    buf->handle = NULL;
+                }
+            }
+            else {
+                result = WICED_BADARG;
+            }
+        }
+        else {
+            wiced_tcp_socket_t* tcp_socket = as_wiced_tcp_socket(socket);
+            if (tcp_socket) {
+                wiced_packet_set_data_end(packet, buf->data + len);
+                result = wiced_tcp_send_packet(tcp_socket, packet);
+                if (result == WICED_SUCCESS) {
+                    buf->handle = NULL;
+                }
+            }
+        }
+    }
+    socket_release_buffer(buf, nullptr);
+    return result ? as_sock_result(result) : len;
+}
+
+#endif // HAL_PLATFORM_SOCKET_BUFFERS
+
 sock_handle_t socket_handle_invalid()
 {
     return SOCKET_INVALID;
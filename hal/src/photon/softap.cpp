@@ -31,6 +31,40 @@
 # define SOFTAP_HTTP_MAXIMUM_URL_LENGTH 255
 #endif // SOFTAP_HTTP
 
+#ifndef SOFTAP_TCP_MAXIMUM_CONNECTIONS
+# define SOFTAP_TCP_MAXIMUM_CONNECTIONS (5)
+#endif // SOFTAP_TCP_MAXIMUM_CONNECTIONS
+
+// Number of threads handling the requests received by the TCP server. Each thread takes 6 KB
+// of stack, so only one is used by default
+#ifndef SOFTAP_TCP_WORKER_THREADS
+# define SOFTAP_TCP_WORKER_THREADS (1)
+#endif // SOFTAP_TCP_WORKER_THREADS
+
+// Maximum time to wait for the remaining data of a request, in milliseconds
+#ifndef SOFTAP_TCP_READ_TIMEOUT
+# define SOFTAP_TCP_READ_TIMEOUT (10000)
+#endif // SOFTAP_TCP_READ_TIMEOUT
+
+#ifndef SOFTAP_SCAN_MAXIMUM_RESULTS
+# define SOFTAP_SCAN_MAXIMUM_RESULTS (32)
+#endif // SOFTAP_SCAN_MAXIMUM_RESULTS
+
+// Cached scan results older than this are refreshed in the background, in milliseconds
+#ifndef SOFTAP_SCAN_REFRESH_INTERVAL
+# define SOFTAP_SCAN_REFRESH_INTERVAL (10000)
+#endif // SOFTAP_SCAN_REFRESH_INTERVAL
+
+// Cached scan results older than this are not reported, in milliseconds
+#ifndef SOFTAP_SCAN_MAXIMUM_AGE
+# define SOFTAP_SCAN_MAXIMUM_AGE (60000)
+#endif // SOFTAP_SCAN_MAXIMUM_AGE
+
+// Maximum time to wait for a scan to complete, in milliseconds
+#ifndef SOFTAP_SCAN_TIMEOUT
+# define SOFTAP_SCAN_TIMEOUT (15000)
+#endif // SOFTAP_SCAN_TIMEOUT
+
 extern WLanSecurityType toSecurityType(wiced_security_t sec);
 
 // This is a copy-paste from spark_wiring_json.h
@@ -150,8 +184,17 @@ bool is_device_claimed()
  * A command that consumes data from a reader and produces a result to a writer.
  */
 class Command {
+    wiced_mutex_t mutex_;
 
 public:
+    Command() {
+        wiced_rtos_init_mutex(&mutex_);
+    }
+
+    virtual ~Command() {
+        wiced_rtos_deinit_mutex(&mutex_);
+    }
+
     /**
      * Executes this command.
      * @param reader    The data supplied to the command.
@@ -159,6 +202,18 @@ public:
      * @return  A command response code. By convention 0 indicates success.
      */
     virtual int execute(Reader& reader, Writer& writer)=0;
+
+    /**
+     * Executes this command on behalf of a dispatcher. The commands keep the state of the request
+     * being processed, so requests to the same command received via different connections are
+     * processed one at a time.
+     */
+    int run(Reader& reader, Writer& writer) {
+        wiced_rtos_lock_mutex(&mutex_);
+        const int result = execute(reader, writer);
+        wiced_rtos_unlock_mutex(&mutex_);
+        return result;
+    }
 };
 
 /**
@@ -394,51 +449,177 @@ public:
 
 struct ScanEntry {
     char ssid[33];
-    uint8_t done;
     int32_t rssi;
     int32_t security;
     int32_t channel;
     int32_t max_data_rate;
 };
 
+/**
+ * Reports the access points in range. Scanning takes a few seconds, so the results of the last
+ * scan are cached and refreshed in the background while the setup application keeps requesting
+ * them. Only one scan is run at a time.
+ */
 class ScanAPCommand : public JSONCommand {
-    wiced_queue_t queue_;
+    wiced_mutex_t mutex_; // Protects the scan state below
+
+    // Results of the last completed scan
+    ScanEntry* results_;
+    unsigned result_count_;
+    wiced_time_t scan_time_;
+    bool valid_;
+
+    // Results of the scan in progress
+    ScanEntry* pending_;
+    unsigned pending_count_;
+    volatile bool scanning_;
+
+    // Copy of the results being reported to the client
+    ScanEntry* response_;
+    unsigned response_count_;
+
+    int start_scan() {
+        wiced_rtos_lock_mutex(&mutex_);
+        const bool scanning = scanning_;
+        scanning_ = true;
+        wiced_rtos_unlock_mutex(&mutex_);
+        if (scanning) {
+            return 0;
+        }
+        const int result = wiced_wifi_scan_networks(scan_handler, this);
+        if (result) {
+            wiced_rtos_lock_mutex(&mutex_);
+            scanning_ = false;
+            wiced_rtos_unlock_mutex(&mutex_);
+        }
+        return result;
+    }
+
+    bool has_results(wiced_time_t max_age) {
+        wiced_time_t now = 0;
+        wiced_time_get_time(&now);
+        wiced_rtos_lock_mutex(&mutex_);
+        const bool ok = valid_ && now - scan_time_ < max_age;
+        wiced_rtos_unlock_mutex(&mutex_);
+        return ok;
+    }
+
+    void add_pending(const ScanEntry& entry) {
+        if (!pending_) {
+            pending_ = (ScanEntry*)malloc(sizeof(ScanEntry) * SOFTAP_SCAN_MAXIMUM_RESULTS);
+            if (!pending_) {
+                return;
+            }
+        }
+        // Access points sharing the same network are reported once, with the strongest signal
+        ScanEntry* weakest = nullptr;
+        for (unsigned i = 0; i < pending_count_; i++) {
+            ScanEntry& e = pending_[i];
+            if (!strcmp(e.ssid, entry.ssid) && e.security == entry.security) {
+                if (e.rssi < entry.rssi) {
+                    e = entry;
+                }
+                return;
+            }
+            if (!weakest || e.rssi < weakest->rssi) {
+                weakest = &e;
+            }
+        }
+        if (pending_count_ < SOFTAP_SCAN_MAXIMUM_RESULTS) {
+            pending_[pending_count_++] = entry;
+        } else if (weakest->rssi < entry.rssi) {
+            *weakest = entry;
+        }
+    }
 
-    // these can be quite large, so allocate on the heap
-    ScanEntry read_;
-    ScanEntry write_;
+    // Called with the mutex held
+    void scan_complete(bool success) {
+        if (success) {
+            free(results_);
+            results_ = pending_;
+            result_count_ = pending_count_;
+            wiced_time_get_time(&scan_time_);
+            valid_ = true;
+        } else {
+            free(pending_);
+        }
+        pending_ = nullptr;
+        pending_count_ = 0;
+        scanning_ = false;
+    }
 
 public:
-    ScanAPCommand()
-    {
+    ScanAPCommand() :
+            results_(nullptr),
+            result_count_(0),
+            scan_time_(0),
+            valid_(false),
+            pending_(nullptr),
+            pending_count_(0),
+            scanning_(false),
+            response_(nullptr),
+            response_count_(0) {
+        wiced_rtos_init_mutex(&mutex_);
+    }
+
+    ~ScanAPCommand() {
+        // The scan handler must not be called once this command is destroyed
+        if (scanning_) {
+            wwd_wifi_abort_scan();
+            for (unsigned t = 0; scanning_ && t < SOFTAP_SCAN_TIMEOUT; t += 100) {
+                wiced_rtos_delay_milliseconds(100);
+            }
+        }
+        free(results_);
+        free(pending_);
+        free(response_);
+        wiced_rtos_deinit_mutex(&mutex_);
     }
 
     /**
-     * Initializes the scan queue, and start a scan using the WICED wifi scan api.
-     *
+     * Starts a scan in the background unless the cached results are recent enough.
+     */
+    void refresh() {
+        if (!has_results(SOFTAP_SCAN_REFRESH_INTERVAL)) {
+            start_scan();
+        }
+    }
+
+protected:
+    /**
+     * Takes a copy of the cached scan results. If there are no recent enough results, waits for
+     * the scan in progress to complete.
      */
     int process() {
-        int result = wiced_rtos_init_queue(&queue_, NULL, sizeof(ScanEntry), 5);
-        if (!result) {
-            result = wiced_wifi_scan_networks(scan_handler, this);
-            if (result)
-                wiced_rtos_deinit_queue(&queue_);
+        refresh();
+        if (!has_results(SOFTAP_SCAN_MAXIMUM_AGE)) {
+            for (unsigned t = 0; scanning_ && t < SOFTAP_SCAN_TIMEOUT; t += 100) {
+                wiced_rtos_delay_milliseconds(100);
+            }
+            if (!has_results(SOFTAP_SCAN_MAXIMUM_AGE)) {
+                return WICED_TIMEOUT;
+            }
         }
+        int result = 0;
+        wiced_rtos_lock_mutex(&mutex_);
+        if (result_count_) {
+            response_ = (ScanEntry*)malloc(sizeof(ScanEntry) * result_count_);
+            if (response_) {
+                memcpy(response_, results_, sizeof(ScanEntry) * result_count_);
+                response_count_ = result_count_;
+            } else {
+                result = WICED_OUT_OF_HEAP_SPACE;
+            }
+        }
+        wiced_rtos_unlock_mutex(&mutex_);
         return result;
     }
 
     void produce_response(Writer& out, const int result) {
         out.write("{\"scans\":[");
-        bool first = true;
-        ScanEntry& entry = read_;
-        while (!result && !wiced_rtos_pop_from_queue(&queue_, &entry, WICED_NEVER_TIMEOUT)) {
-            if (entry.done)
-                break;
-            if (!*entry.ssid)
-                continue;
-            if (first)
-                first = false;
-            else
+        for (unsigned i = 0; i < response_count_; i++) {
+            const ScanEntry& entry = response_[i];
+            if (i)
                 write_char(out, ',');
             write_char(out, '{');
             write_json_string(out, "ssid", entry.ssid);
@@ -453,31 +634,38 @@ public:
             write_char(out, '}');
         }
         out.write("]}");
-        wiced_rtos_deinit_queue(&queue_);
+        free(response_);
+        response_ = nullptr;
+        response_count_ = 0;
     }
 
     static wiced_result_t scan_handler(wiced_scan_handler_result_t* malloced_scan_result)
     {
         ScanAPCommand& cmd = *(ScanAPCommand*)malloced_scan_result->user_data;
         malloc_transfer_to_curr_thread( malloced_scan_result );
-        ScanEntry& entry = cmd.write_;
-        memset(&entry, 0, sizeof(entry));
+        wiced_rtos_lock_mutex(&cmd.mutex_);
         if (malloced_scan_result->status == WICED_SCAN_INCOMPLETE)
         {
             wiced_scan_result_t& ap_details = malloced_scan_result->ap_details;
             unsigned ssid_len = ap_details.SSID.length > 32 ? 32 : ap_details.SSID.length;
-            memcpy(entry.ssid, ap_details.SSID.value, ssid_len);
-            entry.ssid[ssid_len] = 0;
-            entry.rssi = ap_details.signal_strength;
-            entry.security = ap_details.security;
-            entry.channel = ap_details.channel;
-            entry.max_data_rate = ap_details.max_data_rate;
+            // Hidden networks are not reported
+            if (ssid_len && *ap_details.SSID.value)
+            {
+                ScanEntry entry;
+                memcpy(entry.ssid, ap_details.SSID.value, ssid_len);
+                entry.ssid[ssid_len] = 0;
+                entry.rssi = ap_details.signal_strength;
+                entry.security = ap_details.security;
+                entry.channel = ap_details.channel;
+                entry.max_data_rate = ap_details.max_data_rate;
+                cmd.add_pending(entry);
+            }
         }
         else
         {
-            entry.done = 1;
+            cmd.scan_complete(malloced_scan_result->status == WICED_SCAN_COMPLETED_SUCCESSFULLY);
         }
-        wiced_rtos_push_to_queue(&cmd.queue_, &entry, WICED_WAIT_FOREVER);
+        wiced_rtos_unlock_mutex(&cmd.mutex_);
         free(malloced_scan_result);
         return WICED_SUCCESS;
     }
@@ -976,7 +1164,7 @@ static void tcp_write(Writer* w, const uint8_t *buf, size_t count) {
 
 static int tcp_read(Reader* r, uint8_t *buf, size_t count) {
     wiced_tcp_stream_t* tcp_stream = (wiced_tcp_stream_t*)r->state;
-    int result = wiced_tcp_stream_read(tcp_stream, buf, count, WICED_NEVER_TIMEOUT);
+    int result = wiced_tcp_stream_read(tcp_stream, buf, count, SOFTAP_TCP_READ_TIMEOUT);
     return result==WICED_SUCCESS ? count : (result < 0 ? result : -result);
 }
 
@@ -991,6 +1179,53 @@ static void tcp_stream_reader(Reader& r, wiced_tcp_stream_t* stream) {
     r.state = stream;
 }
 
+/**
+ * Collects the data written to a writer in a dynamically allocated buffer.
+ */
+struct ResponseBuffer {
+    uint8_t* data;
+    size_t size;
+    size_t capacity;
+    bool error;
+
+    ResponseBuffer()
+        : data{nullptr},
+          size{0},
+          capacity{0},
+          error{false} {
+    }
+
+    ~ResponseBuffer() {
+        free(data);
+    }
+
+    static void write(Writer* w, const uint8_t* buf, size_t count) {
+        ResponseBuffer* b = (ResponseBuffer*)w->state;
+        if (b->error) {
+            return;
+        }
+        if (b->size + count > b->capacity) {
+            const size_t capacity = std::max(b->capacity * 2, std::max(b->size + count, (size_t)128));
+            uint8_t* data = (uint8_t*)realloc(b->data, capacity);
+            if (!data) {
+                b->error = true;
+                return;
+            }
+            b->data = data;
+            b->capacity = capacity;
+        }
+        memcpy(b->data + b->size, buf, count);
+        b->size += count;
+    }
+
+    Writer writer() {
+        Writer w;
+        w.callback = write;
+        w.state = this;
+        return w;
+    }
+};
+
 int read_from_buffer(Reader* r, uint8_t* target, size_t length) {
     memcpy(target, r->state, length);
     r->state = ((uint8_t*)r->state)+length;
@@ -1393,7 +1628,7 @@ public:
             if (isCmd) {
                 Command* cmd = (Command*)arg;
                 wiced_http_response_stream_write_header(req->stream, HTTP_200_TYPE, CHUNKED_CONTENT_LENGTH, HTTP_CACHE_DISABLED, MIME_TYPE_JSON, nullptr);
-                result = cmd->execute(r, w);
+                result = cmd->run(r, w);
             } else {
                 PageProvider* p = (PageProvider*)arg;
                 if (p) {
@@ -1477,16 +1712,76 @@ class SimpleProtocolDispatcher
         return cmd;
     }
 
+    /**
+     * Reads a line, discarding the characters that don't fit the buffer.
+     * @return The length of the line, or a negative value on error.
+     */
+    int readLine(Reader& reader, char* buf, size_t size) {
+        size_t len = 0;
+        for (;;) {
+            char c = 0;
+            int result = readChar(reader, &c);
+            if (result < 0)
+                return result;
+            if (c=='\n')
+                break;
+            if (len < size - 1)
+                buf[len++] = c;
+        }
+        buf[len] = 0;
+        return len;
+    }
+
+    /**
+     * Produces the response of a command on a persistent connection. The response is prefixed
+     * with its length, so that the client knows where the next response starts.
+     */
+    int executeFramed(Command& cmd, Reader& reader, Writer& writer, bool* keep_alive) {
+        ResponseBuffer response;
+        Writer w = response.writer();
+        int result = cmd.run(reader, w);
+        if (response.error) {
+            response.size = 0;
+            *keep_alive = false;
+        }
+        char prefix[16];
+        snprintf(prefix, sizeof(prefix), "%u\n\n", (unsigned)response.size);
+        writer.write(prefix);
+        writer.write(response.data, response.size);
+        return result;
+    }
+
 public:
     SimpleProtocolDispatcher(AllSoftAPCommands& commands) : commands_(commands) {}
 
-    int handle(Reader& reader, Writer& writer) {
+    /**
+     * Handles a request of the form:
+     * <pre>
+     * name\n
+     * length\n
+     * [header\n]...
+     * \n
+     * body
+     * </pre>
+     *
+     * The only header that is currently recognized is "keep-alive", which lets the client send
+     * further requests over the same connection. The response to such a request is formatted as
+     * "length\n\nbody", otherwise it's "\n\nbody" and the connection is expected to be closed.
+     *
+     * @param keep_alive Set to true if the connection can be used for further requests.
+     *      If null, persistent connections are not supported by the caller.
+     */
+    int handle(Reader& reader, Writer& writer, bool* keep_alive = nullptr) {
         char name[30];
         int requestLength = 0;
         int idx = 0;
         int result = -1;
 
-        while (idx<30) {
+        if (keep_alive) {
+            *keep_alive = false;
+        }
+
+        while (idx<(int)sizeof(name)-1) {
             char c = 0;
             result = readChar(reader, &c);
             if (!c || c=='\n' || result < 0)
@@ -1506,34 +1801,50 @@ public:
 
         WPRINT_APP_INFO( ( "Request length %d\n", requestLength) );
 
-        // todo - keep reading until a \n\n is encountered.
-        bool seenNewline = true;
+        // Read the optional headers up to the empty line
+        bool keepAlive = false;
         for (;;) {
-            char c = 0;
-            result = readChar(reader, &c);
-            if (result < 0)
+            char header[16];
+            result = readLine(reader, header, sizeof(header));
+            if (result <= 0)
                 break;
-            if (c=='\n') {
-                if (seenNewline)
-                    break;
-                else
-                    seenNewline = true;
-            }
-            else
-                seenNewline = false;
+            if (!strcmp(header, "keep-alive"))
+                keepAlive = (keep_alive != nullptr);
         }
+        if (result < 0)
+            keepAlive = false;
 
         Command* cmd = commandForName(name);
         if (cmd) {
             WPRINT_APP_INFO( ( "invoking command %s\n", name ) );
             reader.bytes_left = requestLength;
-            // allow for some protocol preamble before the payload
-            writer.write("\n\n");
-            result = cmd->execute(reader, writer);
+            if (keepAlive) {
+                *keep_alive = true;
+                result = executeFramed(*cmd, reader, writer, keep_alive);
+            } else {
+                // allow for some protocol preamble before the payload
+                writer.write("\n\n");
+                result = cmd->run(reader, writer);
+            }
             WPRINT_APP_INFO( ( "invoking command %s done\n", name ) );
         }
         else {
             WPRINT_APP_INFO( ( "Unknown command '%s'\n", name ) );
+            if (keepAlive) {
+                *keep_alive = true;
+                reader.bytes_left = requestLength;
+                writer.write("0\n\n");
+            }
+        }
+        if (keepAlive) {
+            // Skip the part of the request that wasn't consumed by the command
+            uint8_t buf[16];
+            while (reader.bytes_left) {
+                if (reader.read(buf, sizeof(buf)) < 0) {
+                    *keep_alive = false;
+                    break;
+                }
+            }
         }
         return result;
     }
@@ -1589,15 +1900,40 @@ struct socket_message_t
 
 
 /**
- * A threaded TCP server that delegates to the SimpleProtocolDispatcher
+ * A connection of the TCP server. The stream is kept for the lifetime of the connection,
+ * so that the client can send several requests over the same connection.
+ */
+struct TCPServerSession
+{
+    wiced_tcp_socket_t* socket;
+    wiced_tcp_stream_t stream;
+};
+
+/**
+ * A thread handling the events of a subset of the TCP server connections.
+ */
+struct TCPServerWorker
+{
+    wiced_thread_t      thread;
+    wiced_queue_t       queue;
+    TCPServerSession    sessions[SOFTAP_TCP_MAXIMUM_CONNECTIONS];
+};
+
+/**
+ * A threaded TCP server that delegates to the SimpleProtocolDispatcher.
+ *
+ * If more than one worker thread is configured, the connections are spread across the workers,
+ * so that a slow client or a long running command doesn't hold up the requests received via
+ * other connections. All events of a given socket are handled by the same worker, which keeps
+ * the requests of a connection in order.
  */
 class TCPServerDispatcher
 {
     SimpleProtocolDispatcher&   dispatcher_;
     wiced_interface_t           iface_;
-    wiced_thread_t              thread_;
-    wiced_queue_t               queue_;
     wiced_tcp_server_t          server_;
+    TCPServerWorker             workers_[SOFTAP_TCP_WORKER_THREADS];
+    unsigned                    worker_count_;
 
     /**
      * The callbacks from the tcp_server don't take a data argument, so we're forced to
@@ -1605,23 +1941,66 @@ class TCPServerDispatcher
      */
     static TCPServerDispatcher*  static_server;
 
+    TCPServerWorker& worker_for(wiced_tcp_socket_t* socket) {
+        // The sockets of the server are allocated as an array, which makes consecutive
+        // connections handled by different workers
+        const uintptr_t index = (uintptr_t)socket / sizeof(wiced_tcp_socket_t);
+        return workers_[index % worker_count_];
+    }
+
+    TCPServerSession* find_session(TCPServerWorker& worker, wiced_tcp_socket_t* socket) {
+        for (TCPServerSession& session: worker.sessions) {
+            if (session.socket == socket)
+                return &session;
+        }
+        return nullptr;
+    }
+
+    TCPServerSession* open_session(TCPServerWorker& worker, wiced_tcp_socket_t* socket) {
+        TCPServerSession* session = find_session(worker, socket);
+        if (!session) {
+            session = find_session(worker, nullptr);
+            if (!session || wiced_tcp_stream_init(&session->stream, socket))
+                return nullptr;
+            session->socket = socket;
+        }
+        return session;
+    }
+
+    void release_session(TCPServerSession& session) {
+        wiced_tcp_stream_deinit(&session.stream);
+        session.socket = nullptr;
+    }
+
+    void close_session(TCPServerWorker& worker, wiced_tcp_socket_t* socket) {
+        TCPServerSession* session = find_session(worker, socket);
+        if (session)
+            release_session(*session);
+        wiced_tcp_server_disconnect_socket(&server_, socket);
+    }
+
+    bool has_data(TCPServerSession& session) {
+        return session.stream.rx_packet ||
+                wiced_tcp_receive(session.socket, &session.stream.rx_packet, WICED_NO_WAIT) == WICED_SUCCESS;
+    }
+
     /**
-     * Creates a stream for the client socket, wraps this in a reader/writer
-     * and delegates to the dispatcher to handle the incoming command and produce the
-     * result.
-     * @param client
+     * Wraps the session stream in a reader/writer and delegates to the dispatcher to handle
+     * the received commands and produce the results.
+     * @return true if the connection should be kept open.
      */
-    void handle_client(wiced_tcp_socket_t& client) {
-        wiced_tcp_stream_t stream;
-        if (!wiced_tcp_stream_init(&stream, &client)) {
+    bool handle_client(TCPServerSession& session) {
+        while (has_data(session)) {
             Reader r; Writer w;
-            tcp_stream_writer(w, &stream);
-            tcp_stream_reader(r, &stream);
-            dispatcher_.handle(r, w);
-            wiced_tcp_stream_flush(&stream);
-            wiced_tcp_stream_deinit(&stream);
-            wiced_tcp_server_disconnect_socket(&server_, &client);
+            tcp_stream_writer(w, &session.stream);
+            tcp_stream_reader(r, &session.stream);
+            bool keep_alive = false;
+            dispatcher_.handle(r, w, &keep_alive);
+            wiced_tcp_stream_flush(&session.stream);
+            if (!keep_alive)
+                return false;
         }
+        return true;
     }
 
     static wiced_result_t connect_callback(wiced_tcp_socket_t* socket, void* data) {
@@ -1642,64 +2021,92 @@ class TCPServerDispatcher
         message.socket = socket;
         message.event_type = event_type;
         if (static_server)
-            wiced_rtos_push_to_queue(&static_server->queue_, &message, WICED_NO_WAIT);
+            wiced_rtos_push_to_queue(&static_server->worker_for(socket).queue, &message, WICED_NO_WAIT);
         return WICED_SUCCESS;
     }
 
 public:
 
     TCPServerDispatcher(SimpleProtocolDispatcher& dispatcher, wiced_interface_t iface)
-        : dispatcher_(dispatcher), iface_(iface)
+        : dispatcher_(dispatcher), iface_(iface), worker_count_(0)
     {
-        memset(&thread_, 0, sizeof(thread_));
         memset(&server_, 0, sizeof(server_));
+        memset(workers_, 0, sizeof(workers_));
     }
 
     void start()
     {
         static_server = this;
 
-        if (wiced_rtos_init_queue(&queue_, NULL, sizeof(socket_message_t), 10))
-            return;
-
-        if (wiced_tcp_server_start(&server_, iface_, 5609, 5, connect_callback, receive_callback, disconnect_callback, NULL))
-            return;
+        for (TCPServerWorker& worker: workers_) {
+            if (wiced_rtos_init_queue(&worker.queue, NULL, sizeof(socket_message_t), 10))
+                break;
+            if (wiced_rtos_create_thread(&worker.thread, WICED_DEFAULT_LIBRARY_PRIORITY, "tcp server", tcp_server_thread, 1024*6, &worker)) {
+                wiced_rtos_deinit_queue(&worker.queue);
+                break;
+            }
+            worker_count_++;
+        }
 
-        wiced_rtos_create_thread(&thread_, WICED_DEFAULT_LIBRARY_PRIORITY, "tcp server", tcp_server_thread, 1024*6, this);
+        if (worker_count_)
+            wiced_tcp_server_start(&server_, iface_, 5609, SOFTAP_TCP_MAXIMUM_CONNECTIONS, connect_callback, receive_callback, disconnect_callback, NULL);
     }
 
     void stop() {
-        post_event(socket_message_t::quit, NULL);
+        for (unsigned i = 0; i < worker_count_; i++) {
+            TCPServerWorker& worker = workers_[i];
+            socket_message_t message;
+            message.socket = NULL;
+            message.event_type = socket_message_t::quit;
+            wiced_rtos_push_to_queue(&worker.queue, &message, WICED_NO_WAIT);
+
+            if ( wiced_rtos_is_current_thread( &worker.thread ) != WICED_SUCCESS )
+            {
+                wiced_rtos_thread_force_awake( &worker.thread );
+                wiced_rtos_thread_join( &worker.thread );
+                wiced_rtos_delete_thread( &worker.thread );
+            }
 
-        if ( wiced_rtos_is_current_thread( &thread_ ) != WICED_SUCCESS )
-        {
-            wiced_rtos_thread_force_awake( &thread_ );
-            wiced_rtos_thread_join( &thread_);
-            wiced_rtos_delete_thread( &thread_ );
+            for (TCPServerSession& session: worker.sessions) {
+                if (session.socket)
+                    release_session(session);
+            }
         }
 
         wiced_tcp_server_stop(&server_);
-        wiced_rtos_deinit_queue(&queue_);
         static_server = NULL;
+        for (unsigned i = 0; i < worker_count_; i++)
+            wiced_rtos_deinit_queue(&workers_[i].queue);
+        worker_count_ = 0;
         WPRINT_APP_INFO( ( "TCP client done\n" ) );
     }
 
-    bool handle_message(socket_message_t& event)
+    bool handle_message(TCPServerWorker& worker, socket_message_t& event)
     {
         bool quit = false;
         switch(event.event_type)
         {
           case socket_message_t::disconnect:
-              wiced_tcp_server_disconnect_socket(&server_, event.socket);
+              close_session(worker, event.socket);
               break;
 
-          case socket_message_t::connect:
+          case socket_message_t::connect: {
+              // Discard the state of a previous connection that used the same socket
+              TCPServerSession* session = find_session(worker, event.socket);
+              if (session)
+                  release_session(*session);
               wiced_tcp_server_accept(&server_, event.socket);
+              if (!open_session(worker, event.socket))
+                  wiced_tcp_server_disconnect_socket(&server_, event.socket);
               break;
+          }
 
-          case socket_message_t::message:
-              handle_client(*event.socket);
+          case socket_message_t::message: {
+              TCPServerSession* session = open_session(worker, event.socket);
+              if (!session || !handle_client(*session))
+                  close_session(worker, event.socket);
               break;
+          }
 
           case socket_message_t::quit:
               quit = true;
@@ -1708,26 +2115,26 @@ public:
         return quit;
     }
 
-    void run() {
+    void run(TCPServerWorker& worker) {
         bool quit = false;
         for (;!quit;)
         {
             socket_message_t event;
-            if (wiced_rtos_pop_from_queue(&queue_, &event, WICED_NEVER_TIMEOUT))
+            if (wiced_rtos_pop_from_queue(&worker.queue, &event, WICED_NEVER_TIMEOUT))
                 break;
 
-            handle_message(event);
+            quit = handle_message(worker, event);
         }
         WPRINT_APP_INFO( ( "TCP server exiting\n" ) );
     }
 
     /**
-     * Function that is main entry point for the tcpserver thread. Just bounces the call
+     * Function that is main entry point for the worker threads. Just bounces the call
      * back to the run() method.
      */
     static void tcp_server_thread(uint32_t value) {
-        TCPServerDispatcher* dispatcher = (TCPServerDispatcher*)value;
-        dispatcher->run();
+        TCPServerWorker* worker = (TCPServerWorker*)value;
+        static_server->run(*worker);
         WICED_END_OF_CURRENT_THREAD( );
     }
 };
@@ -1759,6 +2166,8 @@ public:
             serial(simpleProtocol)
     {
         softAP.start();
+        // Get the scan results ready by the time the setup application asks for them
+        commands.scanAP.refresh();
         serial.start();
         tcpServer.start();
 #if SOFTAP_HTTP
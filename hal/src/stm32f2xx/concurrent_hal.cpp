@@ -43,6 +43,7 @@
 #include "atomic_flag_mutex.h"
 #include "static_recursive_mutex.h"
 #include "service_debug.h"
+#include "system_error.h"
 
 #if PLATFORM_ID == 6 || PLATFORM_ID == 8
 # include "wwd_rtos_interface.h"
@@ -343,6 +344,11 @@ os_scheduler_state_t os_scheduler_get_state(void* reserved)
     return (os_scheduler_state_t)xTaskGetSchedulerState();
 }
 
+int os_thread_get_stats(os_thread_stats_t* stats, size_t count, void* reserved)
+{
+    return SYSTEM_ERROR_NOT_SUPPORTED;
+}
+
 int os_semaphore_create(os_semaphore_t* semaphore, unsigned max, unsigned initial)
 {
     *semaphore = xSemaphoreCreateCounting( ( max ), ( initial ) );
@@ -22,11 +22,13 @@
 // #define LOG_CHECKED_ERRORS 1
 
 #include <memory>
+#include <mutex>
 #include "check.h"
 #include "system_error.h"
 #include "bcd_to_dec.h"
 #include "interrupts_hal.h"
 #include "gpio_hal.h"
+#include "timer_hal.h"
 #include "am18x5_defines.h"
 
 using namespace particle;
@@ -48,6 +50,24 @@ int timevalToCalendar(const struct timeval* tv, struct tm* calendar) {
     return 0;
 }
 
+int calendarRegistersToTimeval(const uint8_t* buff, struct timeval* tv) {
+    struct tm calendar = {};
+    calendar.tm_sec = CHECK(bcdToDec(buff[1]));
+    calendar.tm_min = CHECK(bcdToDec(buff[2]));
+    calendar.tm_hour = CHECK(bcdToDec(buff[3]));
+    calendar.tm_mday = CHECK(bcdToDec(buff[4]));
+    calendar.tm_mon = CHECK(bcdToDec(buff[5]));
+    calendar.tm_mon -= 1;
+    calendar.tm_year = CHECK(bcdToDec(buff[6]));
+    calendar.tm_year += UNIX_TIME_YEAR_BASE;
+    calendar.tm_wday = CHECK(bcdToDec(buff[7]));
+    calendar.tm_isdst = -1;
+
+    tv->tv_sec = mktime(&calendar);
+    tv->tv_usec = (long)buff[0] * MICROS_IN_HUNDREDTH;
+    return 0;
+}
+
 } // anonymous namespace
 
 Am18x5::Am18x5()
@@ -59,7 +79,10 @@ Am18x5::Am18x5()
           alarmHandlerContext_(nullptr),
           exRtcWorkerThread_(nullptr),
           exRtcWorkerSemaphore_(nullptr),
-          exRtcWorkerThreadExit_(false)  {
+          exRtcWorkerThreadExit_(false),
+          timeCache_{},
+          timeCacheValid_(false),
+          timeCacheTicks_(0) {
     begin();
 }
 
@@ -73,15 +96,16 @@ Am18x5& Am18x5::getInstance() {
 }
 
 int Am18x5::begin() {
-    Am18x5Lock lock();
-    CHECK_FALSE(initialized_, SYSTEM_ERROR_NONE);
-    
+    // The bus mutex is created when the interface is initialized
     if (!hal_i2c_is_enabled(wire_, nullptr)) {
         CHECK(hal_i2c_init(wire_, nullptr));
         hal_i2c_set_speed(wire_, CLOCK_SPEED_400KHZ, nullptr);
         hal_i2c_begin(wire_, I2C_MODE_MASTER, 0x00, nullptr);
     }
 
+    std::lock_guard<const Am18x5> lock(*this);
+    CHECK_FALSE(initialized_, SYSTEM_ERROR_NONE);
+
     if (os_semaphore_create(&exRtcWorkerSemaphore_, 1, 0)) {
         exRtcWorkerSemaphore_ = nullptr;
         LOG(ERROR, "os_semaphore_create() failed");
@@ -121,31 +145,38 @@ int Am18x5::begin() {
 }
 
 int Am18x5::end() {
-    Am18x5Lock lock();
-    CHECK_TRUE(initialized_, SYSTEM_ERROR_NONE);
+    {
+        std::lock_guard<const Am18x5> lock(*this);
+        CHECK_TRUE(initialized_, SYSTEM_ERROR_NONE);
 
-    exRtcWorkerThreadExit_ = true;
+        exRtcWorkerThreadExit_ = true;
+    }
+    // The worker thread takes the lock, so it's woken up and joined without holding the lock
+    sync();
     os_thread_join(exRtcWorkerThread_);
     os_thread_cleanup(exRtcWorkerThread_);
-    os_semaphore_destroy(exRtcWorkerSemaphore_);
+
+    std::lock_guard<const Am18x5> lock(*this);
+    const auto semaphore = exRtcWorkerSemaphore_;
+    exRtcWorkerSemaphore_ = nullptr;
+    os_semaphore_destroy(semaphore);
     exRtcWorkerThreadExit_ = false;
     exRtcWorkerThread_ = nullptr;
-    exRtcWorkerSemaphore_ = nullptr;
 
     initialized_ = false;
     return SYSTEM_ERROR_NONE;
 }
 
-int Am18x5::lock() {
+int Am18x5::lock() const {
     return hal_i2c_lock(wire_, nullptr);
 }
 
-int Am18x5::unlock() {
+int Am18x5::unlock() const {
     return hal_i2c_unlock(wire_, nullptr);
 }
 
 int Am18x5::getPartNumber(uint16_t* id) const {
-    Am18x5Lock lock();
+    std::lock_guard<const Am18x5> lock(*this);
     CHECK_TRUE(initialized_, SYSTEM_ERROR_INVALID_STATE);
     uint8_t val = 0x00;
     CHECK(readRegister(Am18x5Register::ID0, &val));
@@ -159,7 +190,7 @@ int Am18x5::setTime(const struct timeval* tv) const {
     struct tm calendar;
     CHECK(timevalToCalendar(tv, &calendar));
 
-    Am18x5Lock lock();
+    std::lock_guard<const Am18x5> lock(*this);
     CHECK_TRUE(initialized_, SYSTEM_ERROR_INVALID_STATE);
     uint8_t buff[8] = {0};
     buff[0] = CHECK(decToBcd(tv->tv_usec / MICROS_IN_HUNDREDTH));
@@ -171,39 +202,61 @@ int Am18x5::setTime(const struct timeval* tv) const {
     buff[6] = CHECK(decToBcd(calendar.tm_year - UNIX_TIME_YEAR_BASE));
     buff[7] = CHECK(decToBcd(calendar.tm_wday));
     CHECK(writeContinuousRegisters(Am18x5Register::HUNDREDTHS, buff, sizeof(buff)));
+    // The RTC only keeps hundredths of a second
+    struct timeval rtcTime = *tv;
+    rtcTime.tv_usec -= rtcTime.tv_usec % MICROS_IN_HUNDREDTH;
+    updateTimeCache(&rtcTime);
     return SYSTEM_ERROR_NONE;
 }
 
 int Am18x5::getTime(struct timeval* tv) const {
     CHECK_TRUE(tv, SYSTEM_ERROR_INVALID_ARGUMENT);
 
-    Am18x5Lock lock();
+    std::lock_guard<const Am18x5> lock(*this);
     CHECK_TRUE(initialized_, SYSTEM_ERROR_INVALID_STATE);
+    if (getCachedTime(tv)) {
+        return SYSTEM_ERROR_NONE;
+    }
     uint8_t buff[8] = {0};
     CHECK(readContinuousRegisters(Am18x5Register::HUNDREDTHS, buff, sizeof(buff)));
+    CHECK(calendarRegistersToTimeval(buff, tv));
+    updateTimeCache(tv);
+    return SYSTEM_ERROR_NONE;
+}
 
-    struct tm calendar = {};
-    calendar.tm_sec = CHECK(bcdToDec(buff[1]));
-    calendar.tm_min = CHECK(bcdToDec(buff[2]));
-    calendar.tm_hour = CHECK(bcdToDec(buff[3]));
-    calendar.tm_mday = CHECK(bcdToDec(buff[4]));
-    calendar.tm_mon = CHECK(bcdToDec(buff[5]));
-    calendar.tm_mon -= 1;
-    calendar.tm_year = CHECK(bcdToDec(buff[6]));
-    calendar.tm_year += UNIX_TIME_YEAR_BASE;
-    calendar.tm_wday = CHECK(bcdToDec(buff[7]));
-    calendar.tm_isdst = -1;
+bool Am18x5::getCachedTime(struct timeval* tv) const {
+#if HAL_PLATFORM_EXTERNAL_RTC_CACHE_TIMEOUT > 0
+    if (!timeCacheValid_) {
+        return false;
+    }
+    const uint64_t elapsed = hal_timer_micros(nullptr) - timeCacheTicks_;
+    if (elapsed >= (uint64_t)HAL_PLATFORM_EXTERNAL_RTC_CACHE_TIMEOUT * 1000) {
+        return false;
+    }
+    const uint64_t usec = timeCache_.tv_usec + elapsed;
+    tv->tv_sec = timeCache_.tv_sec + usec / 1000000;
+    tv->tv_usec = usec % 1000000;
+    return true;
+#else
+    return false;
+#endif // HAL_PLATFORM_EXTERNAL_RTC_CACHE_TIMEOUT > 0
+}
 
-    tv->tv_sec = mktime(&calendar);
-    tv->tv_usec = (long)buff[0] * MICROS_IN_HUNDREDTH;
-    return SYSTEM_ERROR_NONE;
+void Am18x5::updateTimeCache(const struct timeval* tv) const {
+    timeCache_ = *tv;
+    timeCacheTicks_ = hal_timer_micros(nullptr);
+    timeCacheValid_ = true;
+}
+
+void Am18x5::invalidateTimeCache() const {
+    timeCacheValid_ = false;
 }
 
 int Am18x5::setAlarm(const struct timeval* tv) {
     struct tm calendar;
     CHECK(timevalToCalendar(tv, &calendar));
 
-    Am18x5Lock lock();
+    std::lock_guard<const Am18x5> lock(*this);
     CHECK_TRUE(initialized_, SYSTEM_ERROR_INVALID_STATE);
     uint8_t buff[7] = {0};
     buff[0] = CHECK(decToBcd(tv->tv_usec / MICROS_IN_HUNDREDTH));
@@ -220,7 +273,7 @@ int Am18x5::setAlarm(const struct timeval* tv) {
 }
 
 int Am18x5::enableAlarm(bool enable, Am18x5::AlarmHandler handler, void* context) {
-    Am18x5Lock lock();
+    std::lock_guard<const Am18x5> lock(*this);
     CHECK_TRUE(initialized_, SYSTEM_ERROR_INVALID_STATE);
     alarmHandler_ = handler;
     alarmHandlerContext_ = context;
@@ -255,7 +308,7 @@ int Am18x5::getAlarm(struct timeval* tv) const {
 }
 
 int Am18x5::enableWatchdog(uint8_t value, Am18x5WatchdogFrequency frequency) const {
-    Am18x5Lock lock();
+    std::lock_guard<const Am18x5> lock(*this);
     CHECK_TRUE(initialized_, SYSTEM_ERROR_INVALID_STATE);
     CHECK_TRUE(value < 32, SYSTEM_ERROR_INVALID_ARGUMENT);
     uint8_t regValue = WDT_REGISTER_WDS_MASK;
@@ -265,13 +318,13 @@ int Am18x5::enableWatchdog(uint8_t value, Am18x5WatchdogFrequency frequency) con
 }
 
 int Am18x5::disableWatchdog() const {
-    Am18x5Lock lock();
+    std::lock_guard<const Am18x5> lock(*this);
     CHECK_TRUE(initialized_, SYSTEM_ERROR_INVALID_STATE);
     return writeRegister(Am18x5Register::WDT, 0, false, true, WDT_REGISTER_BMB_MASK, WDT_REGISTER_BMB_SHIFT);
 }
 
 int Am18x5::feedWatchdog() const {
-    Am18x5Lock lock();
+    std::lock_guard<const Am18x5> lock(*this);
     CHECK_TRUE(initialized_, SYSTEM_ERROR_INVALID_STATE);
     if (HAL_GPIO_Read(RTC_WDI) == 1) {
         HAL_GPIO_Write(RTC_WDI, 0);
@@ -282,8 +335,10 @@ int Am18x5::feedWatchdog() const {
 }
 
 int Am18x5::sleep(uint8_t ticks, Am18x5TimerFrequency frequency) const {
-    Am18x5Lock lock();
+    std::lock_guard<const Am18x5> lock(*this);
     CHECK_TRUE(initialized_, SYSTEM_ERROR_INVALID_STATE);
+    // The system tick can't be used to track the time across the power cycle
+    invalidateTimeCache();
     // Enable to access the BATMODE_IO and OUTPUT_CTRL registers
     CHECK(writeRegister(Am18x5Register::CONFIG_KEY, 0x9D));
     // Configure RTC pins to minimize power leakage
@@ -310,13 +365,14 @@ int Am18x5::sleep(uint8_t ticks, Am18x5TimerFrequency frequency) const {
 }
 
 int Am18x5::setHundredths(uint8_t hundredths) const {
-    Am18x5Lock lock();
+    std::lock_guard<const Am18x5> lock(*this);
     CHECK_TRUE(initialized_, SYSTEM_ERROR_INVALID_STATE);
+    invalidateTimeCache();
     return writeRegister(Am18x5Register::HUNDREDTHS, hundredths, true);
 }
 
 int Am18x5::getHundredths() const {
-    Am18x5Lock lock();
+    std::lock_guard<const Am18x5> lock(*this);
     CHECK_TRUE(initialized_, SYSTEM_ERROR_INVALID_STATE);
     uint8_t hundredths = 0;
     CHECK(readRegister(Am18x5Register::HUNDREDTHS, &hundredths, true));
@@ -324,14 +380,15 @@ int Am18x5::getHundredths() const {
 }
 
 int Am18x5::setSeconds(uint8_t seconds) const {
-    Am18x5Lock lock();
+    std::lock_guard<const Am18x5> lock(*this);
     CHECK_TRUE(seconds <= 59, SYSTEM_ERROR_INVALID_ARGUMENT);
     CHECK_TRUE(initialized_, SYSTEM_ERROR_INVALID_STATE);
+    invalidateTimeCache();
     return writeRegister(Am18x5Register::SECONDS, seconds, true, false, SECONDS_MASK);
 }
 
 int Am18x5::getSeconds() const {
-    Am18x5Lock lock();
+    std::lock_guard<const Am18x5> lock(*this);
     CHECK_TRUE(initialized_, SYSTEM_ERROR_INVALID_STATE);
     uint8_t seconds = 0;
     CHECK(readRegister(Am18x5Register::SECONDS, &seconds, true, SECONDS_MASK));
@@ -339,14 +396,15 @@ int Am18x5::getSeconds() const {
 }
 
 int Am18x5::setMinutes(uint8_t minutes) const {
-    Am18x5Lock lock();
+    std::lock_guard<const Am18x5> lock(*this);
     CHECK_TRUE(minutes <= 59, SYSTEM_ERROR_INVALID_ARGUMENT);
     CHECK_TRUE(initialized_, SYSTEM_ERROR_INVALID_STATE);
+    invalidateTimeCache();
     return writeRegister(Am18x5Register::MINUTES, minutes, true, false, MINUTES_MASK);
 }
 
 int Am18x5::getMinutes() const {
-    Am18x5Lock lock();
+    std::lock_guard<const Am18x5> lock(*this);
     CHECK_TRUE(initialized_, SYSTEM_ERROR_INVALID_STATE);
     uint8_t minutes = 0;
     CHECK(readRegister(Am18x5Register::MINUTES, &minutes, true, MINUTES_MASK));
@@ -354,8 +412,9 @@ int Am18x5::getMinutes() const {
 }
 
 int Am18x5::setHours(uint8_t hours, HourFormat format) const {
-    Am18x5Lock lock();
+    std::lock_guard<const Am18x5> lock(*this);
     CHECK_TRUE(initialized_, SYSTEM_ERROR_INVALID_STATE);
+    invalidateTimeCache();
     if (format == HourFormat::HOUR24) {
         CHECK_TRUE(hours <= 23, SYSTEM_ERROR_INVALID_ARGUMENT);
         CHECK(writeRegister(Am18x5Register::CONTROL1, 0, false, true, CONTROL1_1224_MASK, CONTROL1_1224_SHIFT));
@@ -372,7 +431,7 @@ int Am18x5::setHours(uint8_t hours, HourFormat format) const {
 }
 
 int Am18x5::getHours(HourFormat* format) const {
-    Am18x5Lock lock();
+    std::lock_guard<const Am18x5> lock(*this);
     CHECK_TRUE(format, SYSTEM_ERROR_INVALID_ARGUMENT);
     CHECK_TRUE(initialized_, SYSTEM_ERROR_INVALID_STATE);
     uint8_t control1 = 0x00;
@@ -392,14 +451,15 @@ int Am18x5::getHours(HourFormat* format) const {
 }
 
 int Am18x5::setDate(uint8_t date) const {
-    Am18x5Lock lock();
+    std::lock_guard<const Am18x5> lock(*this);
     CHECK_TRUE(date > 0 && date <= 31, SYSTEM_ERROR_INVALID_ARGUMENT);
     CHECK_TRUE(initialized_, SYSTEM_ERROR_INVALID_STATE);
+    invalidateTimeCache();
     return writeRegister(Am18x5Register::DATE, date, true, false, DATE_MASK);
 }
 
 int Am18x5::getDate() const {
-    Am18x5Lock lock();
+    std::lock_guard<const Am18x5> lock(*this);
     CHECK_TRUE(initialized_, SYSTEM_ERROR_INVALID_STATE);
     uint8_t date = 0;
     CHECK(readRegister(Am18x5Register::DATE, &date, true, DATE_MASK));
@@ -407,14 +467,15 @@ int Am18x5::getDate() const {
 }
 
 int Am18x5::setMonths(uint8_t months) const {
-    Am18x5Lock lock();
+    std::lock_guard<const Am18x5> lock(*this);
     CHECK_TRUE(months > 0 && months <= 12, SYSTEM_ERROR_INVALID_ARGUMENT);
     CHECK_TRUE(initialized_, SYSTEM_ERROR_INVALID_STATE);
+    invalidateTimeCache();
     return writeRegister(Am18x5Register::MONTHS, months, true, false, MONTHS_MASK);
 }
 
 int Am18x5::getMonths() const {
-    Am18x5Lock lock();
+    std::lock_guard<const Am18x5> lock(*this);
     CHECK_TRUE(initialized_, SYSTEM_ERROR_INVALID_STATE);
     uint8_t months = 0;
     CHECK(readRegister(Am18x5Register::MONTHS, &months, true, MONTHS_MASK));
@@ -422,13 +483,14 @@ int Am18x5::getMonths() const {
 }
 
 int Am18x5::setYears(uint8_t years) const {
-    Am18x5Lock lock();
+    std::lock_guard<const Am18x5> lock(*this);
     CHECK_TRUE(initialized_, SYSTEM_ERROR_INVALID_STATE);
+    invalidateTimeCache();
     return writeRegister(Am18x5Register::YEARS, years, true, false);
 }
 
 int Am18x5::getYears() const {
-    Am18x5Lock lock();
+    std::lock_guard<const Am18x5> lock(*this);
     CHECK_TRUE(initialized_, SYSTEM_ERROR_INVALID_STATE);
     uint8_t years = 0;
     CHECK(readRegister(Am18x5Register::YEARS, &years, true));
@@ -436,14 +498,15 @@ int Am18x5::getYears() const {
 }
 
 int Am18x5::setWeekday(uint8_t weekday) const {
-    Am18x5Lock lock();
+    std::lock_guard<const Am18x5> lock(*this);
     CHECK_TRUE(weekday > 0 && weekday <= 7, SYSTEM_ERROR_INVALID_ARGUMENT);
     CHECK_TRUE(initialized_, SYSTEM_ERROR_INVALID_STATE);
+    invalidateTimeCache();
     return writeRegister(Am18x5Register::WEEKDAY, weekday, true, false, WEEKDAY_MASK);
 }
 
 int Am18x5::getWeekday() const {
-    Am18x5Lock lock();
+    std::lock_guard<const Am18x5> lock(*this);
     CHECK_TRUE(initialized_, SYSTEM_ERROR_INVALID_STATE);
     uint8_t weekday = 0;
     CHECK(readRegister(Am18x5Register::WEEKDAY, &weekday, true, WEEKDAY_MASK));
@@ -451,7 +514,7 @@ int Am18x5::getWeekday() const {
 }
 
 int Am18x5::xtOscillatorDigitalCalibration(int adjVal) const {
-    Am18x5Lock lock();
+    std::lock_guard<const Am18x5> lock(*this);
     CHECK_TRUE(initialized_, SYSTEM_ERROR_INVALID_STATE);
     uint8_t xtcal, cmdx;
     int offsetx;
@@ -493,7 +556,7 @@ int Am18x5::xtOscillatorDigitalCalibration(int adjVal) const {
 }
 
 int Am18x5::selectOscillator(Am18x5Oscillator oscillator) const {
-    Am18x5Lock lock();
+    std::lock_guard<const Am18x5> lock(*this);
     CHECK_TRUE(initialized_, SYSTEM_ERROR_INVALID_STATE);
     uint8_t val = 0;
     if (oscillator == Am18x5Oscillator::INTERNAL_RC) {
@@ -503,13 +566,13 @@ int Am18x5::selectOscillator(Am18x5Oscillator oscillator) const {
 }
 
 int Am18x5::enableAutoSwitchOnBattery(bool enable) const {
-    Am18x5Lock lock();
+    std::lock_guard<const Am18x5> lock(*this);
     CHECK_TRUE(initialized_, SYSTEM_ERROR_INVALID_STATE);
     return writeRegister(Am18x5Register::OSC_CONTROL, enable, false, true, OSC_CONTROL_AOS_MASK, OSC_CONTROL_AOS_SHIFT);
 }
 
 int Am18x5::writeRegister(const Am18x5Register reg, uint8_t val, bool bcd, bool rw, uint8_t mask, uint8_t shift) const {
-    Am18x5Lock lock();
+    std::lock_guard<const Am18x5> lock(*this);
     uint8_t currValue = 0x00;
     if (rw) {
         CHECK(readRegister(reg, &currValue));
@@ -527,7 +590,7 @@ int Am18x5::writeRegister(const Am18x5Register reg, uint8_t val, bool bcd, bool
 }
 
 int Am18x5::writeContinuousRegisters(const Am18x5Register start_reg, const uint8_t* buff, size_t len) const {
-    Am18x5Lock lock();
+    std::lock_guard<const Am18x5> lock(*this);
     hal_i2c_begin_transmission(wire_, address_, nullptr);
     hal_i2c_write(wire_, static_cast<uint8_t>(start_reg), nullptr);
     for (size_t i = 0; i < len; i++) {
@@ -538,7 +601,7 @@ int Am18x5::writeContinuousRegisters(const Am18x5Register start_reg, const uint8
 }
 
 int Am18x5::readRegister(const Am18x5Register reg, uint8_t* const val, bool bcd, uint8_t mask, uint8_t shift) const {
-    Am18x5Lock lock();
+    std::lock_guard<const Am18x5> lock(*this);
     hal_i2c_begin_transmission(wire_, address_, nullptr);
     hal_i2c_write(wire_, static_cast<uint8_t>(reg), nullptr);
     hal_i2c_end_transmission(wire_, false, nullptr);
@@ -555,7 +618,7 @@ int Am18x5::readRegister(const Am18x5Register reg, uint8_t* const val, bool bcd,
 }
 
 int Am18x5::readContinuousRegisters(const Am18x5Register start_reg, uint8_t* buff, size_t len) const {
-    Am18x5Lock lock();
+    std::lock_guard<const Am18x5> lock(*this);
     hal_i2c_begin_transmission(wire_, address_, nullptr);
     hal_i2c_write(wire_, static_cast<uint8_t>(start_reg), nullptr);
     hal_i2c_end_transmission(wire_, false, nullptr);
@@ -584,19 +647,32 @@ os_thread_return_t Am18x5::exRtcInterruptHandleThread(void* param) {
     auto instance = static_cast<Am18x5*>(param);
     while(!instance->exRtcWorkerThreadExit_) {
         os_semaphore_take(instance->exRtcWorkerSemaphore_, CONCURRENT_WAIT_FOREVER, false);
+        if (instance->exRtcWorkerThreadExit_) {
+            break;
+        }
         {
-            Am18x5Lock lock();
+            std::lock_guard<const Am18x5> lock(*instance);
 
-            uint8_t alm = 0;
-            if (instance->readRegister(Am18x5Register::STATUS, &alm, false, STATUS_ALM_MASK) != SYSTEM_ERROR_NONE) {
+            // Read the calendar and status registers in a single transaction. This clears the
+            // interrupt flags and resynchronizes the cached time at the same time
+            uint8_t buff[static_cast<uint8_t>(Am18x5Register::STATUS) + 1] = {};
+            if (instance->readContinuousRegisters(Am18x5Register::HUNDREDTHS, buff, sizeof(buff)) != (int)sizeof(buff)) {
+                instance->invalidateTimeCache();
                 continue;
             }
-            if (alm) {
-                int currYear = instance->getYears();
+            struct timeval tv = {};
+            if (calendarRegistersToTimeval(buff, &tv) == 0) {
+                instance->updateTimeCache(&tv);
+            } else {
+                instance->invalidateTimeCache();
+            }
+            const uint8_t alm = buff[static_cast<uint8_t>(Am18x5Register::STATUS)] & STATUS_ALM_MASK;
+            if (alm && instance->alarmHandler_) {
+                int currYear = bcdToDec(buff[static_cast<uint8_t>(Am18x5Register::YEARS)]);
                 if (currYear < 0) {
                     continue;
                 }
-                if (instance->alarmYear_ == currYear && instance->alarmHandler_) {
+                if (instance->alarmYear_ == currYear) {
                     instance->alarmHandler_(instance->alarmHandlerContext_);
                 }
             }
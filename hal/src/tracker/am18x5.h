@@ -167,8 +167,8 @@ public:
      */
     int xtOscillatorDigitalCalibration(int adjVal) const;
 
-    int lock();
-    int unlock();
+    int lock() const;
+    int unlock() const;
 
     static Am18x5& getInstance();
 
@@ -194,6 +194,10 @@ private:
     int getYears() const;
     int getWeekday() const;
 
+    bool getCachedTime(struct timeval* tv) const;
+    void updateTimeCache(const struct timeval* tv) const;
+    void invalidateTimeCache() const;
+
     int selectOscillator(Am18x5Oscillator oscillator) const;
     int enableAutoSwitchOnBattery(bool enable) const;
 
@@ -214,6 +218,10 @@ private:
     os_thread_t exRtcWorkerThread_;
     os_queue_t exRtcWorkerSemaphore_;
     bool exRtcWorkerThreadExit_;
+    // Time read from the RTC and the system tick at which it was read
+    mutable struct timeval timeCache_;
+    mutable bool timeCacheValid_;
+    mutable uint64_t timeCacheTicks_;
 }; // class Am18x5
 
 
@@ -25,6 +25,7 @@
 #include "system_error.h"
 #include "gpio_hal.h"
 #include "delay_hal.h"
+#include <mutex>
 
 using namespace particle;
 
@@ -50,7 +51,12 @@ Mcp23s17::~Mcp23s17() {
 }
 
 int Mcp23s17::begin() {
-    Mcp23s17Lock lock();
+    // The bus mutex is created when the interface is initialized
+    if (!hal_spi_is_enabled(spi_)) {
+        hal_spi_init(spi_);
+    }
+
+    std::lock_guard<Mcp23s17> lock(*this);
     CHECK_FALSE(initialized_, SYSTEM_ERROR_NONE);
 
     HAL_Pin_Mode(IOE_CS, OUTPUT);
@@ -59,10 +65,6 @@ int Mcp23s17::begin() {
     HAL_GPIO_Write(IOE_RST, 1);
     HAL_Pin_Mode(IOE_INT, INPUT_PULLUP);
 
-    if (!hal_spi_is_enabled(spi_)) {
-        hal_spi_init(spi_);
-    }
-
     if (os_semaphore_create(&ioExpanderWorkerSemaphore_, 1, 0)) {
         ioExpanderWorkerSemaphore_ = nullptr;
         LOG(ERROR, "os_semaphore_create() failed");
@@ -86,16 +88,23 @@ int Mcp23s17::begin() {
 }
 
 int Mcp23s17::end() {
-    Mcp23s17Lock lock();
-    CHECK_TRUE(initialized_, SYSTEM_ERROR_NONE);
+    {
+        std::lock_guard<Mcp23s17> lock(*this);
+        CHECK_TRUE(initialized_, SYSTEM_ERROR_NONE);
 
-    CHECK(reset());
+        CHECK(reset());
 
-    ioExpanderWorkerThreadExit_ = true;
+        ioExpanderWorkerThreadExit_ = true;
+    }
+    // The worker thread takes the lock, so it's woken up and joined without holding the lock
+    sync();
     os_thread_join(ioExpanderWorkerThread_);
     os_thread_cleanup(ioExpanderWorkerThread_);
-    os_semaphore_destroy(ioExpanderWorkerSemaphore_);
+
+    std::lock_guard<Mcp23s17> lock(*this);
+    const auto semaphore = ioExpanderWorkerSemaphore_;
     ioExpanderWorkerSemaphore_ = nullptr;
+    os_semaphore_destroy(semaphore);
     ioExpanderWorkerThreadExit_ = false;
     ioExpanderWorkerThread_ = nullptr;
 
@@ -110,7 +119,7 @@ bool Mcp23s17::initialized() const {
 }
 
 int Mcp23s17::reset(bool verify) {
-    Mcp23s17Lock lock();
+    std::lock_guard<Mcp23s17> lock(*this);
     CHECK_TRUE(initialized_, SYSTEM_ERROR_INVALID_STATE);
     CHECK_TRUE(IOE_RST != PIN_INVALID, SYSTEM_ERROR_INVALID_ARGUMENT);
     // Assert reset pin
@@ -131,7 +140,7 @@ int Mcp23s17::reset(bool verify) {
 }
 
 int Mcp23s17::setPinMode(uint8_t port, uint8_t pin, PinMode mode, bool verify) {
-    Mcp23s17Lock lock();
+    std::lock_guard<Mcp23s17> lock(*this);
     CHECK_TRUE(initialized_, SYSTEM_ERROR_INVALID_STATE);
     CHECK_TRUE(port < MCP23S17_PORT_COUNT, SYSTEM_ERROR_INVALID_ARGUMENT);
     CHECK_TRUE(pin < MCP23S17_PIN_COUNT_PER_PORT, SYSTEM_ERROR_INVALID_ARGUMENT);
@@ -176,7 +185,7 @@ int Mcp23s17::setPinMode(uint8_t port, uint8_t pin, PinMode mode, bool verify) {
 }
 
 int Mcp23s17::setPinInputInverted(uint8_t port, uint8_t pin, bool enable, bool verify) {
-    Mcp23s17Lock lock();
+    std::lock_guard<Mcp23s17> lock(*this);
     CHECK_TRUE(initialized_, SYSTEM_ERROR_INVALID_STATE);
     CHECK_TRUE(port < MCP23S17_PORT_COUNT, SYSTEM_ERROR_INVALID_ARGUMENT);
     CHECK_TRUE(pin < MCP23S17_PIN_COUNT_PER_PORT, SYSTEM_ERROR_INVALID_ARGUMENT);
@@ -200,7 +209,7 @@ int Mcp23s17::setPinInputInverted(uint8_t port, uint8_t pin, bool enable, bool v
 }
 
 int Mcp23s17::writePinValue(uint8_t port, uint8_t pin, uint8_t value, bool verify) {
-    Mcp23s17Lock lock();
+    std::lock_guard<Mcp23s17> lock(*this);
     CHECK_TRUE(initialized_, SYSTEM_ERROR_INVALID_STATE);
     CHECK_TRUE(port < MCP23S17_PORT_COUNT, SYSTEM_ERROR_INVALID_ARGUMENT);
     CHECK_TRUE(pin < MCP23S17_PIN_COUNT_PER_PORT, SYSTEM_ERROR_INVALID_ARGUMENT);
@@ -224,17 +233,19 @@ int Mcp23s17::writePinValue(uint8_t port, uint8_t pin, uint8_t value, bool verif
 }
 
 int Mcp23s17::readPinValue(uint8_t port, uint8_t pin, uint8_t* value) {
-    Mcp23s17Lock lock();
+    std::lock_guard<Mcp23s17> lock(*this);
     CHECK_TRUE(initialized_, SYSTEM_ERROR_INVALID_STATE);
     CHECK_TRUE(port < MCP23S17_PORT_COUNT, SYSTEM_ERROR_INVALID_ARGUMENT);
     CHECK_TRUE(pin < MCP23S17_PIN_COUNT_PER_PORT, SYSTEM_ERROR_INVALID_ARGUMENT);
     uint8_t newVal = 0x00;
     uint8_t bitMask = 0x01 << pin;
-    CHECK(readRegister(IODIR_ADDR[port], &newVal));
-    if (newVal & bitMask) { // Read input value
+    // The direction and output latch registers are only ever changed by this driver,
+    // the shadow copies are used to avoid reading them back over SPI.
+    if (iodir_[port] & bitMask) { // Read input value
         CHECK(readRegister(GPIO_ADDR[port], &newVal));
+        gpio_[port] = newVal;
     } else {
-        CHECK(readRegister(OLAT_ADDR[port], &newVal));
+        newVal = olat_[port];
     }
     if (newVal & bitMask) {
         *value = 1;
@@ -244,8 +255,48 @@ int Mcp23s17::readPinValue(uint8_t port, uint8_t pin, uint8_t* value) {
     return SYSTEM_ERROR_NONE;
 }
 
+int Mcp23s17::writePinValues(uint16_t mask, uint16_t values, bool verify) {
+    std::lock_guard<Mcp23s17> lock(*this);
+    CHECK_TRUE(initialized_, SYSTEM_ERROR_INVALID_STATE);
+    uint8_t newVal[MCP23S17_PORT_COUNT];
+    for (uint8_t port = 0; port < MCP23S17_PORT_COUNT; port++) {
+        uint8_t portMask = (mask >> (port * MCP23S17_PIN_COUNT_PER_PORT)) & 0xff;
+        uint8_t portValues = (values >> (port * MCP23S17_PIN_COUNT_PER_PORT)) & 0xff;
+        newVal[port] = (olat_[port] & ~portMask) | (portValues & portMask);
+    }
+    CHECK_FALSE(memcmp(newVal, olat_, sizeof(olat_)) == 0, SYSTEM_ERROR_NONE);
+    // Configure the bus once for the write and the readback
+    Mcp23s17SpiConfigurationGuarder spiGuarder(spi_);
+    // OLATA and OLATB are adjacent, both ports are updated in a single transaction
+    CHECK(writeContinuousRegisters(OLAT_ADDR[0], newVal, sizeof(newVal)));
+    if (verify) {
+        uint8_t tmp[MCP23S17_PORT_COUNT];
+        CHECK(readContinuousRegisters(OLAT_ADDR[0], tmp, sizeof(tmp)));
+        CHECK_TRUE(memcmp(tmp, newVal, sizeof(tmp)) == 0, SYSTEM_ERROR_INTERNAL);
+    }
+    memcpy(olat_, newVal, sizeof(olat_));
+    return SYSTEM_ERROR_NONE;
+}
+
+int Mcp23s17::readPinValues(uint16_t* values) {
+    std::lock_guard<Mcp23s17> lock(*this);
+    CHECK_TRUE(initialized_, SYSTEM_ERROR_INVALID_STATE);
+    CHECK_TRUE(values, SYSTEM_ERROR_INVALID_ARGUMENT);
+    uint8_t tmp[MCP23S17_PORT_COUNT];
+    // GPIOA and GPIOB are adjacent, both ports are read in a single transaction
+    CHECK(readContinuousRegisters(GPIO_ADDR[0], tmp, sizeof(tmp)));
+    memcpy(gpio_, tmp, sizeof(gpio_));
+    *values = 0;
+    for (uint8_t port = 0; port < MCP23S17_PORT_COUNT; port++) {
+        // Output pins report the value of the output latch
+        uint8_t portValues = (tmp[port] & iodir_[port]) | (olat_[port] & ~iodir_[port]);
+        *values |= (uint16_t)portValues << (port * MCP23S17_PIN_COUNT_PER_PORT);
+    }
+    return SYSTEM_ERROR_NONE;
+}
+
 int Mcp23s17::attachPinInterrupt(uint8_t port, uint8_t pin, InterruptMode trig, Mcp23s17InterruptCallback callback, void* context, bool verify) {
-    Mcp23s17Lock lock();
+    std::lock_guard<Mcp23s17> lock(*this);
     CHECK_TRUE(initialized_, SYSTEM_ERROR_INVALID_STATE);
     CHECK_TRUE(port < MCP23S17_PORT_COUNT, SYSTEM_ERROR_INVALID_ARGUMENT);
     CHECK_TRUE(pin < MCP23S17_PIN_COUNT_PER_PORT, SYSTEM_ERROR_INVALID_ARGUMENT);
@@ -285,7 +336,7 @@ int Mcp23s17::attachPinInterrupt(uint8_t port, uint8_t pin, InterruptMode trig,
 }
 
 int Mcp23s17::detachPinInterrupt(uint8_t port, uint8_t pin, bool verify) {
-    Mcp23s17Lock lock();
+    std::lock_guard<Mcp23s17> lock(*this);
     CHECK_TRUE(initialized_, SYSTEM_ERROR_INVALID_STATE);
     CHECK_TRUE(port < MCP23S17_PORT_COUNT, SYSTEM_ERROR_INVALID_ARGUMENT);
     CHECK_TRUE(pin < MCP23S17_PIN_COUNT_PER_PORT, SYSTEM_ERROR_INVALID_ARGUMENT);
@@ -373,6 +424,19 @@ int Mcp23s17::readContinuousRegisters(const uint8_t start_addr, uint8_t* const v
     return SYSTEM_ERROR_NONE;
 }
 
+int Mcp23s17::writeContinuousRegisters(const uint8_t start_addr, const uint8_t* const val, uint8_t len) const {
+    CHECK_TRUE(initialized_, SYSTEM_ERROR_NONE);
+    Mcp23s17SpiConfigurationGuarder spiGuarder(spi_);
+    HAL_GPIO_Write(IOE_CS, 0);
+    hal_spi_transfer(spi_, MCP23S17_CMD_WRITE);
+    hal_spi_transfer(spi_, start_addr);
+    for (uint8_t i = 0; i < len; i++) {
+        hal_spi_transfer(spi_, val[i]);
+    }
+    HAL_GPIO_Write(IOE_CS, 1);
+    return SYSTEM_ERROR_NONE;
+}
+
 int Mcp23s17::sync() {
     if (ioExpanderWorkerSemaphore_) {
         return os_semaphore_give(ioExpanderWorkerSemaphore_, false);
@@ -384,19 +448,23 @@ os_thread_return_t Mcp23s17::ioInterruptHandleThread(void* param) {
     auto instance = static_cast<Mcp23s17*>(param);
     while(!instance->ioExpanderWorkerThreadExit_) {
         os_semaphore_take(instance->ioExpanderWorkerSemaphore_, CONCURRENT_WAIT_FOREVER, false);
+        if (instance->ioExpanderWorkerThreadExit_) {
+            break;
+        }
         {
-            Mcp23s17Lock lock();
-            uint8_t intStatus;
-            uint8_t portValue;
-            if (instance->readRegister(instance->INTF_ADDR[0], &intStatus) != SYSTEM_ERROR_NONE) {
-                continue;
-            }
-            // This will clear the interrupt flag.
-            if (instance->readRegister(instance->INTCAP_ADDR[0], &portValue) != SYSTEM_ERROR_NONE) {
+            std::lock_guard<Mcp23s17> lock(*instance);
+            // INTF and INTCAP registers of both ports are adjacent, read them in a single transaction.
+            // Reading INTCAP will clear the interrupt flag.
+            uint8_t regs[MCP23S17_PORT_COUNT * 2];
+            if (instance->readContinuousRegisters(instance->INTF_ADDR[0], regs, sizeof(regs)) != SYSTEM_ERROR_NONE) {
                 continue;
             }
+            memcpy(instance->intf_, regs, sizeof(instance->intf_));
+            memcpy(instance->intcap_, regs + MCP23S17_PORT_COUNT, sizeof(instance->intcap_));
             for (const auto& config : instance->intConfigs_) {
                 uint8_t bitMask = 0x01 << config.pin;
+                uint8_t intStatus = instance->intf_[config.port];
+                uint8_t portValue = instance->intcap_[config.port];
                 if ((intStatus & bitMask) && (config.cb != nullptr)) {
                     if ( ((config.trig == RISING) && (portValue & bitMask)) ||
                          ((config.trig == FALLING) && !(portValue & bitMask)) ||
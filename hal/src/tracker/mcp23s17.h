@@ -49,6 +49,9 @@ public:
     int setPinInputInverted(uint8_t port, uint8_t pin, bool enable, bool verify = true);
     int writePinValue(uint8_t port, uint8_t pin, uint8_t value, bool verify = true);
     int readPinValue(uint8_t port, uint8_t pin, uint8_t* value);
+    // Bits 0-7 of the mask and values correspond to the pins of port A, bits 8-15 to the pins of port B
+    int writePinValues(uint16_t mask, uint16_t values, bool verify = true);
+    int readPinValues(uint16_t* values);
     int attachPinInterrupt(uint8_t port, uint8_t pin, InterruptMode trig, Mcp23s17InterruptCallback callback, void* context, bool verify = true);
     int detachPinInterrupt(uint8_t port, uint8_t pin, bool verify = true);
 
@@ -164,6 +167,7 @@ private:
     int writeRegister(const uint8_t addr, const uint8_t val) const;
     int readRegister(const uint8_t addr, uint8_t* const val) const;
     int readContinuousRegisters(const uint8_t start_addr, uint8_t* const val, uint8_t len) const;
+    int writeContinuousRegisters(const uint8_t start_addr, const uint8_t* const val, uint8_t len) const;
     static os_thread_return_t ioInterruptHandleThread(void* param);
 
     // Resister address
@@ -15,6 +15,11 @@ typedef enum {
   FLASH_ACCESS_RESULT_RESET_PENDING  = 3
 } flash_access_result_t;
 
+typedef enum {
+  FLASH_VERIFY_CRC32  = 0x01, // Verify the CRC-32 stored after the module
+  FLASH_VERIFY_SHA256 = 0x02  // Verify the SHA-256 stored in the module suffix
+} flash_verify_flags_t;
+
 /* MAL access layer for Internal/Serial Flash Routines */
 //New routines specific for BM09/BM14 flash usage
 uint16_t FLASH_SectorToWriteProtect(uint8_t flashDeviceID, uint32_t startAddress);
@@ -63,6 +68,19 @@ uint16_t FLASH_ModuleVersion(flash_device_t flashDeviceID, uint32_t startAddress
 bool FLASH_isUserModuleInfoValid(uint8_t flashDeviceID, uint32_t startAddress, uint32_t expectedAddress);
 bool FLASH_VerifyCRC32(flash_device_t flashDeviceID, uint32_t startAddress, uint32_t length);
 
+/**
+ * Verifies the integrity of a module by reading its data in a single pass.
+ *
+ * @param length Length of the module, not including the CRC-32.
+ * @param flags Checks to perform (see `flash_verify_flags_t`).
+ * @return `true` if all the requested checks passed.
+ */
+bool FLASH_VerifyModule(flash_device_t flashDeviceID, uint32_t startAddress, uint32_t length, uint8_t flags);
+/**
+ * Returns `true` if `FLASH_VERIFY_SHA256` is supported in this build.
+ */
+bool FLASH_IsSHA256VerificationSupported(void);
+
 // Old routine signature for Photon
 void FLASH_ClearFlags(void);
 void FLASH_Erase(void);
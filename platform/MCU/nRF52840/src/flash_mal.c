@@ -24,7 +24,8 @@
  */
 
 /* Includes ------------------------------------------------------------------*/
-//#include <string.h>
+#include <string.h>
+#include <stddef.h>
 #include "hw_config.h"
 #include "module_info.h"
 #include "module_info_hal.h"
@@ -49,9 +50,22 @@
 #define SOFTDEVICE_MBR_UPDATES 0
 #endif // MODULE_FUNCTION == MOD_FUNC_BOOTLOADER
 
+// SHA-256 verification of modules is done by CC310, which is not available in the bootloader
+#if (MODULE_FUNCTION != MOD_FUNC_BOOTLOADER) && !defined(DISABLE_CC310)
+#define HAS_CC310_SHA256 1
+#else
+#define HAS_CC310_SHA256 0
+#endif
+
+#if HAS_CC310_SHA256
+#include "cc310_mbedtls.h"
+#include "crys_hash.h"
+#endif // HAS_CC310_SHA256
+
 #define CEIL_DIV(A, B)        (((A) + (B) - 1) / (B))
 
 #define COPY_BLOCK_SIZE 256
+#define VERIFY_BLOCK_SIZE 512
 
 static bool flash_read(flash_device_t dev, uintptr_t addr, uint8_t* buf, size_t size) {
     bool ok = false;
@@ -801,49 +815,150 @@ bool FLASH_isUserModuleInfoValid(uint8_t flashDeviceID, uint32_t startAddress, u
             && (module_info->platform_id==PLATFORM_ID));
 }
 
-bool FLASH_VerifyCRC32(uint8_t flashDeviceID, uint32_t startAddress, uint32_t length)
-{
-    if(flashDeviceID == FLASH_INTERNAL && length > 0)
-    {
-        uint32_t expectedCRC = __REV((*(__IO uint32_t*) (startAddress + length)));
-        uint32_t computedCRC = Compute_CRC32((uint8_t*)startAddress, length, NULL);
-
-        if (expectedCRC == computedCRC)
-        {
-            return true;
-        }
+// Reads data for module verification. Unlike flash_read(), this function accepts XIP addresses
+// of the external flash as FLASH_INTERNAL addresses
+static bool verify_read(flash_device_t dev, uintptr_t addr, uint8_t* buf, size_t size) {
+    switch (dev) {
+    case FLASH_INTERNAL: {
+        memcpy(buf, (const void*)addr, size);
+        return true;
     }
 #ifdef USE_SERIAL_FLASH
-    else if(flashDeviceID == FLASH_SERIAL && length > 0)
-    {
-        uint8_t serialFlashData[4]; // FIXME: Use XIP or a larger buffer
-        hal_exflash_read((startAddress + length), serialFlashData, 4);
-        uint32_t expectedCRC = (uint32_t)(serialFlashData[3] | (serialFlashData[2] << 8) | (serialFlashData[1] << 16) | (serialFlashData[0] << 24));
-
-        uint32_t endAddress = startAddress + length;
-        uint32_t len = 0;
-        uint32_t computedCRC = 0;
+    case FLASH_SERIAL: {
+        return (hal_exflash_read(addr, buf, size) == 0);
+    }
+#endif // USE_SERIAL_FLASH
+    default:
+        return false;
+    }
+}
 
-        do {
-            len = endAddress - startAddress;
-            if (len > sizeof(serialFlashData)) {
-                len = sizeof(serialFlashData);
+/**
+ * Computes the CRC-32 of `size` bytes at `addr` and, if `sha` is not NULL, the SHA-256 of the
+ * first `sha_size` bytes of the same region in a single pass over the data.
+ *
+ * Internal flash is checksummed in place, unless the data needs to be hashed, in which case it
+ * is copied to a RAM buffer first, since CC310 can't access flash memory. External flash is read
+ * in blocks of VERIFY_BLOCK_SIZE bytes.
+ */
+static bool verify_stream(flash_device_t dev, uintptr_t addr, size_t size, size_t sha_size, uint32_t* crc, uint8_t* sha) {
+    uint32_t computed_crc = 0;
+#if HAS_CC310_SHA256
+    CRYS_HASHUserContext_t sha_ctx;
+    if (sha) {
+        CRYSError_t ret = CRYS_OK;
+        CC310_OPERATION(CRYS_HASH_Init(&sha_ctx, CRYS_HASH_SHA256_mode), ret);
+        if (ret != CRYS_OK) {
+            return false;
+        }
+    }
+#else
+    if (sha) {
+        return false;
+    }
+#endif // !HAS_CC310_SHA256
+    bool ok = true;
+    if (dev == FLASH_INTERNAL && !sha) {
+        computed_crc = Compute_CRC32((const uint8_t*)addr, size, NULL);
+    } else {
+        __attribute__((aligned(4))) uint8_t buf[VERIFY_BLOCK_SIZE];
+        size_t offs = 0;
+        while (offs < size) {
+            size_t n = size - offs;
+            if (n > sizeof(buf)) {
+                n = sizeof(buf);
             }
-            hal_exflash_read(startAddress, serialFlashData, len);
-
-            computedCRC = Compute_CRC32(serialFlashData, len, &computedCRC);
-
-            startAddress += len;
-        } while (startAddress < endAddress);
+            if (!verify_read(dev, addr + offs, buf, n)) {
+                ok = false;
+                break;
+            }
+            computed_crc = Compute_CRC32(buf, n, &computed_crc);
+#if HAS_CC310_SHA256
+            if (sha && offs < sha_size) {
+                const size_t sha_n = (sha_size - offs < n) ? sha_size - offs : n;
+                CRYSError_t ret = CRYS_OK;
+                CC310_OPERATION(CRYS_HASH_Update(&sha_ctx, buf, sha_n), ret);
+                if (ret != CRYS_OK) {
+                    ok = false;
+                    break;
+                }
+            }
+#endif // HAS_CC310_SHA256
+            offs += n;
+        }
+    }
+#if HAS_CC310_SHA256
+    if (sha) {
+        if (ok) {
+            CRYS_HASH_Result_t result;
+            CRYSError_t ret = CRYS_OK;
+            CC310_OPERATION(CRYS_HASH_Finish(&sha_ctx, result), ret);
+            if (ret == CRYS_OK) {
+                memcpy(sha, result, CRYS_HASH_SHA256_DIGEST_SIZE_IN_BYTES);
+            } else {
+                ok = false;
+            }
+        }
+        CC310_OPERATION_NO_RESULT(CRYS_HASH_Free(&sha_ctx));
+    }
+#endif // HAS_CC310_SHA256
+    if (ok) {
+        *crc = computed_crc;
+    }
+    return ok;
+}
 
-        if (expectedCRC == computedCRC)
+bool FLASH_VerifyModule(flash_device_t flashDeviceID, uint32_t startAddress, uint32_t length, uint8_t flags)
+{
+    if (length == 0 || !(flags & (FLASH_VERIFY_CRC32 | FLASH_VERIFY_SHA256)))
+    {
+        return false;
+    }
+    // The SHA-256 is stored in the module suffix and covers the module data up to the hash itself
+    const size_t sha_tail_size = sizeof(module_info_suffix_t) - offsetof(module_info_suffix_t, sha);
+    if ((flags & FLASH_VERIFY_SHA256) && length < sha_tail_size)
+    {
+        return false;
+    }
+    // The CRC-32 is stored in big-endian order immediately after the module
+    uint8_t expected_crc_buf[4];
+    if (!verify_read(flashDeviceID, startAddress + length, expected_crc_buf, sizeof(expected_crc_buf)))
+    {
+        return false;
+    }
+    const uint32_t expectedCRC = (uint32_t)(expected_crc_buf[3] | (expected_crc_buf[2] << 8) | (expected_crc_buf[1] << 16) | (expected_crc_buf[0] << 24));
+    uint8_t computed_sha[32];
+    const size_t sha_size = (flags & FLASH_VERIFY_SHA256) ? length - sha_tail_size : 0;
+    uint32_t computedCRC = 0;
+    if (!verify_stream(flashDeviceID, startAddress, length, sha_size, &computedCRC,
+            (flags & FLASH_VERIFY_SHA256) ? computed_sha : NULL))
+    {
+        return false;
+    }
+    if ((flags & FLASH_VERIFY_CRC32) && computedCRC != expectedCRC)
+    {
+        return false;
+    }
+    if (flags & FLASH_VERIFY_SHA256)
+    {
+        uint8_t expected_sha[32];
+        if (!verify_read(flashDeviceID, startAddress + sha_size, expected_sha, sizeof(expected_sha)) ||
+                memcmp(computed_sha, expected_sha, sizeof(expected_sha)) != 0)
         {
-            return true;
+            return false;
         }
-#endif
     }
+    return true;
+}
 
-    return false;
+bool FLASH_VerifyCRC32(uint8_t flashDeviceID, uint32_t startAddress, uint32_t length)
+{
+    return FLASH_VerifyModule(flashDeviceID, startAddress, length, FLASH_VERIFY_CRC32);
+}
+
+bool FLASH_IsSHA256VerificationSupported(void)
+{
+    return HAS_CC310_SHA256;
 }
 
 void FLASH_ClearFlags(void)
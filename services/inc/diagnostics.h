@@ -58,6 +58,10 @@
 #define DIAG_NAME_CLOUD_TRANSMITTED_MESSAGES "coap:transmit"
 #define DIAG_NAME_CLOUD_COAP_ROUND_TRIP "coap:roundtrip"
 #define DIAG_NAME_CLOUD_RATE_LIMITED_EVENTS "pub:limit"
+#define DIAG_NAME_CLOUD_QUEUED_EVENTS "pub:queue"
+#define DIAG_NAME_CLOUD_DROPPED_EVENTS "pub:qdrop"
+#define DIAG_NAME_SYSTEM_CPU_TIME "sys:cpu"
+#define DIAG_NAME_SYSTEM_MIN_STACK_FREE "sys:minstk"
 #define DIAG_NAME_SYSTEM_TOTAL_RAM "sys:tram"
 #define DIAG_NAME_SYSTEM_USED_RAM "sys:uram"
 
@@ -104,6 +108,10 @@ typedef enum diag_id {
     DIAG_ID_CLOUD_UNACKNOWLEDGED_MESSAGES = 22, // coap:unack
     DIAG_ID_CLOUD_TRANSMITTED_MESSAGES = 23, // coap:transmit
     DIAG_ID_CLOUD_RATE_LIMITED_EVENTS = 20, // pub:throttle
+    DIAG_ID_CLOUD_QUEUED_EVENTS = 44, // pub:queue
+    DIAG_ID_CLOUD_DROPPED_EVENTS = 45, // pub:qdrop
+    DIAG_ID_SYSTEM_CPU_TIME = 46, // sys:cpu
+    DIAG_ID_SYSTEM_MIN_STACK_FREE = 47, // sys:minstk
     DIAG_ID_SYSTEM_TOTAL_RAM = 25, // sys:tram
     DIAG_ID_SYSTEM_USED_RAM = 26, // sys:uram
     DIAG_ID_CLOUD_COAP_ROUND_TRIP = 31, // coap:roundtrip
@@ -0,0 +1,255 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <algorithm>
+#include <cstddef>
+#include <sys/types.h>
+#include "system_error.h"
+#include "check.h"
+
+namespace particle {
+namespace services {
+
+/**
+ * Lock-free single-producer/single-consumer ring buffer.
+ *
+ * The head index is only modified by the producer and the tail index is only modified by the
+ * consumer, so the buffer can be shared between an ISR and a thread, or between two threads,
+ * without locking. The indices run over twice the buffer size, which allows telling a full
+ * buffer from an empty one without any additional shared state.
+ *
+ * `writeSpans()` and `readSpans()` return up to two contiguous regions of the buffer that can be
+ * filled or drained in place (e.g. by DMA) and then committed with `commitWrite()` and
+ * `commitRead()` respectively.
+ */
+template <typename T>
+class SpscRingBuffer {
+public:
+    struct Span {
+        T* data;
+        size_t size;
+    };
+
+    SpscRingBuffer();
+    SpscRingBuffer(T* buffer, size_t size);
+
+    // These methods are not thread-safe
+    void init(T* buffer, size_t size);
+    void reset();
+
+    size_t size() const;
+
+    bool empty() const;
+    bool full() const;
+
+    // Producer
+    size_t space() const;
+    ssize_t put(const T& v);
+    ssize_t put(const T* v, size_t size);
+    size_t writeSpans(Span* first, Span* second) const;
+    void commitWrite(size_t size);
+
+    // Consumer
+    size_t data() const;
+    ssize_t get(T* v);
+    ssize_t get(T* v, size_t size);
+    ssize_t peek(T* v, size_t size) const;
+    size_t readSpans(Span* first, Span* second) const;
+    void commitRead(size_t size);
+
+private:
+    T* buffer_;
+    size_t size_;
+    std::atomic<size_t> head_;
+    std::atomic<size_t> tail_;
+
+    size_t used(size_t head, size_t tail) const;
+    size_t advance(size_t index, size_t n) const;
+    size_t offset(size_t index) const;
+    size_t spans(size_t index, size_t count, Span* first, Span* second) const;
+};
+
+template <typename T>
+inline SpscRingBuffer<T>::SpscRingBuffer()
+        : SpscRingBuffer(nullptr, 0) {
+}
+
+template <typename T>
+inline SpscRingBuffer<T>::SpscRingBuffer(T* buffer, size_t size)
+        : buffer_(buffer),
+          size_(size),
+          head_(0),
+          tail_(0) {
+}
+
+template <typename T>
+inline void SpscRingBuffer<T>::init(T* buffer, size_t size) {
+    buffer_ = buffer;
+    size_ = size;
+    reset();
+}
+
+template <typename T>
+inline void SpscRingBuffer<T>::reset() {
+    head_.store(0, std::memory_order_relaxed);
+    tail_.store(0, std::memory_order_relaxed);
+}
+
+template <typename T>
+inline size_t SpscRingBuffer<T>::size() const {
+    return size_;
+}
+
+template <typename T>
+inline bool SpscRingBuffer<T>::empty() const {
+    return data() == 0;
+}
+
+template <typename T>
+inline bool SpscRingBuffer<T>::full() const {
+    return space() == 0;
+}
+
+template <typename T>
+inline size_t SpscRingBuffer<T>::space() const {
+    // The consumer releases the slots by publishing the tail index
+    const size_t tail = tail_.load(std::memory_order_acquire);
+    const size_t head = head_.load(std::memory_order_relaxed);
+    return size_ - used(head, tail);
+}
+
+template <typename T>
+inline ssize_t SpscRingBuffer<T>::put(const T& v) {
+    return put(&v, 1);
+}
+
+template <typename T>
+inline ssize_t SpscRingBuffer<T>::put(const T* v, size_t size) {
+    if (size == 0) {
+        return 0;
+    }
+    CHECK_TRUE(v, SYSTEM_ERROR_INVALID_ARGUMENT);
+    Span first, second;
+    CHECK_TRUE(writeSpans(&first, &second) >= size, SYSTEM_ERROR_TOO_LARGE);
+    const size_t n = std::min(size, first.size);
+    std::copy(v, v + n, first.data);
+    std::copy(v + n, v + size, second.data);
+    commitWrite(size);
+    return size;
+}
+
+template <typename T>
+inline size_t SpscRingBuffer<T>::writeSpans(Span* first, Span* second) const {
+    const size_t tail = tail_.load(std::memory_order_acquire);
+    const size_t head = head_.load(std::memory_order_relaxed);
+    return spans(head, size_ - used(head, tail), first, second);
+}
+
+template <typename T>
+inline void SpscRingBuffer<T>::commitWrite(size_t size) {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    // Make the written elements visible to the consumer before publishing the new head
+    head_.store(advance(head, size), std::memory_order_release);
+}
+
+template <typename T>
+inline size_t SpscRingBuffer<T>::data() const {
+    // The producer publishes the written elements by updating the head index
+    const size_t head = head_.load(std::memory_order_acquire);
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    return used(head, tail);
+}
+
+template <typename T>
+inline ssize_t SpscRingBuffer<T>::get(T* v) {
+    return get(v, 1);
+}
+
+template <typename T>
+inline ssize_t SpscRingBuffer<T>::get(T* v, size_t size) {
+    if (size == 0) {
+        return 0;
+    }
+    if (v) {
+        CHECK(peek(v, size));
+    } else {
+        CHECK_TRUE(data() >= size, SYSTEM_ERROR_TOO_LARGE);
+    }
+    commitRead(size);
+    return size;
+}
+
+template <typename T>
+inline ssize_t SpscRingBuffer<T>::peek(T* v, size_t size) const {
+    if (size == 0) {
+        return 0;
+    }
+    CHECK_TRUE(v, SYSTEM_ERROR_INVALID_ARGUMENT);
+    Span first, second;
+    CHECK_TRUE(readSpans(&first, &second) >= size, SYSTEM_ERROR_TOO_LARGE);
+    const size_t n = std::min(size, first.size);
+    std::copy(first.data, first.data + n, v);
+    std::copy(second.data, second.data + (size - n), v + n);
+    return size;
+}
+
+template <typename T>
+inline size_t SpscRingBuffer<T>::readSpans(Span* first, Span* second) const {
+    const size_t head = head_.load(std::memory_order_acquire);
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    return spans(tail, used(head, tail), first, second);
+}
+
+template <typename T>
+inline void SpscRingBuffer<T>::commitRead(size_t size) {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    // Finish reading the elements before handing the slots back to the producer
+    tail_.store(advance(tail, size), std::memory_order_release);
+}
+
+template <typename T>
+inline size_t SpscRingBuffer<T>::used(size_t head, size_t tail) const {
+    return (head >= tail) ? head - tail : 2 * size_ + head - tail;
+}
+
+template <typename T>
+inline size_t SpscRingBuffer<T>::advance(size_t index, size_t n) const {
+    index += n;
+    return (index >= 2 * size_) ? index - 2 * size_ : index;
+}
+
+template <typename T>
+inline size_t SpscRingBuffer<T>::offset(size_t index) const {
+    return (index >= size_) ? index - size_ : index;
+}
+
+template <typename T>
+inline size_t SpscRingBuffer<T>::spans(size_t index, size_t count, Span* first, Span* second) const {
+    const size_t offs = offset(index);
+    const size_t n = std::min(count, size_ - offs);
+    first->data = buffer_ + offs;
+    first->size = n;
+    second->data = buffer_;
+    second->size = count - n;
+    return count;
+}
+
+} // services
+} // particle
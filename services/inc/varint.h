@@ -85,11 +85,18 @@ inline int decodeUnsignedVarint(const char* buf, size_t size, T* val) {
         } else {
             b &= 0x7f;
         }
-        // Make sure the value fits into the destination variable
-        if (val && sizeof(unsigned) * 8 - __builtin_clz(b) > sizeof(T) * 8 - bits) {
-            return SYSTEM_ERROR_TOO_LARGE;
+        // Groups without payload bits are skipped: __builtin_clz() is undefined for 0, and so is
+        // shifting by the width of the destination type or more
+        if (b) {
+            // Make sure the value fits into the destination variable
+            if (bits >= sizeof(T) * 8 || sizeof(unsigned) * 8 - __builtin_clz(b) > sizeof(T) * 8 - bits) {
+                if (val) {
+                    return SYSTEM_ERROR_TOO_LARGE;
+                }
+            } else {
+                v |= (T)b << bits;
+            }
         }
-        v |= (T)b << bits;
         bits += 7;
         ++bytes;
     } while (!stop);
@@ -179,6 +179,15 @@ const uint32_t PUBLISH_EVENT_FLAG_WITH_ACK = 0x8;
  * This is a stop-gap solution until all synchronous APIs return futures, allowing asynchronous operation.
  */
 const uint32_t PUBLISH_EVENT_FLAG_ASYNC = EventType::ASYNC;
+/**
+ * Store the event in the persistent publish queue and send it once the device is connected to the
+ * cloud and the event is not rate-limited. Ignored on platforms without a filesystem.
+ */
+const uint32_t PUBLISH_EVENT_FLAG_PERSISTENT = 0x20;
+/**
+ * Send a queued event before the events queued without this flag.
+ */
+const uint32_t PUBLISH_EVENT_FLAG_PRIORITY_HIGH = 0x40;
 
 
 PARTICLE_STATIC_ASSERT(publish_no_ack_flag_matches, PUBLISH_EVENT_FLAG_NO_ACK==EventType::NO_ACK);
@@ -191,17 +200,46 @@ typedef enum
   ALL_DEVICES
 } Spark_Subscription_Scope_TypeDef;
 
+/**
+ * Content types of event data. The values match the CoAP content formats.
+ */
+typedef enum cloud_content_type {
+    CLOUD_CONTENT_TYPE_TEXT = 0,
+    CLOUD_CONTENT_TYPE_BINARY = 42,
+    CLOUD_CONTENT_TYPE_JSON = 50,
+    CLOUD_CONTENT_TYPE_CBOR = 60
+} cloud_content_type;
+
+typedef enum subscribe_flag {
+    SUBSCRIBE_FLAG_BINARY_DATA = 0x01 // The handler is an EventHandlerWithSize and can receive binary data
+} subscribe_flag;
+
+PARTICLE_STATIC_ASSERT(subscribe_binary_data_flag_matches, (int)SUBSCRIBE_FLAG_BINARY_DATA == (int)SubscriptionFlag::BINARY_DATA);
+
+// Additional parameters for spark_subscribe()
+typedef struct {
+    size_t size;
+    uint32_t flags; // See subscribe_flag
+} spark_subscribe_param;
+
 typedef int (*cloud_function_t)(void* data, const char* param, void* reserved);
 
 typedef int (user_function_int_str_t)(String paramString);
 typedef user_function_int_str_t* p_user_function_int_str_t;
 
+typedef enum cloud_function_flag {
+    CLOUD_FUNCTION_FLAG_CONCURRENT = 0x01 // Run the function on a system worker thread rather than the application thread
+} cloud_function_flag;
+
 struct  cloud_function_descriptor {
     uint16_t size;
-    uint16_t padding;
+    uint16_t flags; // See cloud_function_flag
     const char *funcKey;
     cloud_function_t fn;
     void* data;
+    uint16_t max_concurrency; // Maximum number of concurrent calls (CLOUD_FUNCTION_FLAG_CONCURRENT only, 0 means 1)
+    uint16_t reserved;
+    system_tick_t timeout; // Call timeout in milliseconds (CLOUD_FUNCTION_FLAG_CONCURRENT only, 0 means no timeout)
 
      cloud_function_descriptor() {
          memset(this, 0, sizeof(*this));
@@ -209,7 +247,7 @@ struct  cloud_function_descriptor {
      }
 };
 
-PARTICLE_STATIC_ASSERT(cloud_function_descriptor_size, sizeof(cloud_function_descriptor)==16 || sizeof(void*)!=4);
+PARTICLE_STATIC_ASSERT(cloud_function_descriptor_size, sizeof(cloud_function_descriptor)==24 || sizeof(void*)!=4);
 
 typedef struct spark_variable_t
 {
@@ -227,6 +265,21 @@ typedef struct spark_variable_t
      * @return 0 on success or a negative result code in case of an error.
      */
     int (*copy)(const void* var, void** data, size_t* size);
+
+    /**
+     * Read a block of a string variable's value.
+     *
+     * This callback allows serving large values to the cloud block by block without copying the
+     * entire value. It is invoked in the system thread and needs to be thread-safe.
+     *
+     * @param var Variable object.
+     * @param offset Offset in the variable value.
+     * @param data Destination buffer. Can be null if `size` is 0.
+     * @param size Size of the destination buffer.
+     * @param[out] total_size Total size of the variable value.
+     * @return Number of bytes read or a negative result code in case of an error.
+     */
+    int (*read)(const void* var, size_t offset, void* data, size_t size, size_t* total_size);
 } spark_variable_t;
 
 /**
@@ -252,6 +305,9 @@ typedef struct {
     size_t size;
     completion_callback handler_callback;
     void* handler_data;
+    size_t data_size; // Size of the event data. For CLOUD_CONTENT_TYPE_TEXT, 0 means the data is null-terminated
+    uint16_t content_type; // See cloud_content_type
+    uint16_t reserved; // make the padding explicit
 } spark_send_event_data;
 
 /**
@@ -43,9 +43,10 @@ using namespace particle::control::common;
 
 int setAccessPoint(ctrl_request* req) {
     PB(SetAccessPointRequest) pbReq = {};
-    DecodedCString dApn(&pbReq.access_point.apn);
-    DecodedCString dUser(&pbReq.access_point.user);
-    DecodedCString dPwd(&pbReq.access_point.password);
+    RequestArena arena;
+    DecodedCString dApn(&pbReq.access_point.apn, &arena);
+    DecodedCString dUser(&pbReq.access_point.user, &arena);
+    DecodedCString dPwd(&pbReq.access_point.password, &arena);
     CHECK(decodeRequestMessage(req, PB(SetAccessPointRequest_fields), &pbReq));
     const auto sim = (SimType)pbReq.sim_type;
     CellularNetworkConfig conf;
@@ -28,6 +28,8 @@ LOG_SOURCE_CATEGORY("system.ctrl.common");
 #include "check.h"
 #include "scope_guard.h"
 
+#include <cstddef>
+
 using namespace particle;
 
 namespace particle {
@@ -144,6 +146,32 @@ cleanup:
     return ret;
 }
 
+void* RequestArena::alloc(size_t size) {
+    size = (size + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+    if (size <= sizeof(buf_) - offs_) {
+        const auto p = buf_ + offs_;
+        offs_ += size;
+        return p;
+    }
+    // Fall back to the heap for unusually large requests
+    const auto block = (HeapBlock*)malloc(sizeof(HeapBlock) + size);
+    if (!block) {
+        return nullptr;
+    }
+    block->next = heap_;
+    heap_ = block;
+    return block + 1;
+}
+
+void RequestArena::reset() {
+    while (heap_) {
+        const auto next = heap_->next;
+        free(heap_);
+        heap_ = next;
+    }
+    offs_ = 0;
+}
+
 int protoIpFromHal(particle_ctrl_IPAddress* ip, const HAL_IPAddress* sip) {
 #if HAL_IPv6
     if (sip->v == 4) {
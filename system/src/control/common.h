@@ -28,6 +28,7 @@
 #include <pb_encode.h>
 #include <pb_decode.h>
 #include <stdlib.h>
+#include <cstddef>
 
 #include "proto/common.pb.h"
 
@@ -106,19 +107,64 @@ struct DecodedString {
     }
 };
 
+#ifndef CONTROL_REQUEST_ARENA_SIZE
+#define CONTROL_REQUEST_ARENA_SIZE 192
+#endif
+
+/**
+ * Allocator for the temporary data of a control request.
+ *
+ * Memory is allocated from a fixed-size buffer, which is expected to reside on the stack of the
+ * request handler, and is released all at once when the arena is destroyed. Allocations that
+ * don't fit into the buffer are served from the heap.
+ */
+class RequestArena {
+public:
+    RequestArena() :
+            heap_(nullptr),
+            offs_(0) {
+    }
+
+    ~RequestArena() {
+        reset();
+    }
+
+    void* alloc(size_t size);
+    void reset();
+
+    // This class is non-copyable
+    RequestArena(const RequestArena&) = delete;
+    RequestArena& operator=(const RequestArena&) = delete;
+
+private:
+    struct alignas(std::max_align_t) HeapBlock {
+        HeapBlock* next;
+    };
+
+    alignas(std::max_align_t) char buf_[CONTROL_REQUEST_ARENA_SIZE];
+    HeapBlock* heap_;
+    size_t offs_;
+};
+
 // Class storing a null-terminated string
 struct DecodedCString {
     char* data;
     size_t size;
 
-    explicit DecodedCString(pb_callback_t* cb) :
+    // If an arena is provided, the string is allocated from it rather than from the heap
+    explicit DecodedCString(pb_callback_t* cb, RequestArena* arena = nullptr) :
             data(nullptr),
-            size(0) {
+            size(0),
+            arena_(arena) {
         cb->arg = this;
         cb->funcs.decode = [](pb_istream_t* strm, const pb_field_t* field, void** arg) {
             const size_t n = strm->bytes_left;
             const auto str = (DecodedCString*)*arg;
-            str->data = (char*)malloc(n + 1);
+            if (str->arena_) {
+                str->data = (char*)str->arena_->alloc(n + 1);
+            } else {
+                str->data = (char*)malloc(n + 1);
+            }
             if (!str->data) {
                 return false;
             }
@@ -129,12 +175,17 @@ struct DecodedCString {
     }
 
     ~DecodedCString() {
-        free((char*)data);
+        if (!arena_) {
+            free((char*)data);
+        }
     }
 
     // This class is non-copyable
     DecodedCString(const DecodedCString&) = delete;
     DecodedCString& operator=(const DecodedCString&) = delete;
+
+private:
+    RequestArena* arena_;
 };
 
 } } } /* particle::control::common */
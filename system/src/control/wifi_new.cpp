@@ -65,8 +65,9 @@ void bssidFromPb(MacAddress* bssid, const T& pbBssid) {
 
 int joinNewNetwork(ctrl_request* req) {
     PB(JoinNewNetworkRequest) pbReq = {};
-    DecodedCString dSsid(&pbReq.ssid);
-    DecodedCString dPwd(&pbReq.credentials.password);
+    RequestArena arena;
+    DecodedCString dSsid(&pbReq.ssid, &arena);
+    DecodedCString dPwd(&pbReq.credentials.password, &arena);
     CHECK(decodeRequestMessage(req, PB(JoinNewNetworkRequest_fields), &pbReq));
     // Parse new network configuration
     if (pbReq.credentials.type != PB(CredentialsType_NO_CREDENTIALS) &&
@@ -111,7 +112,8 @@ int joinNewNetwork(ctrl_request* req) {
 
 int joinKnownNetwork(ctrl_request* req) {
     PB(JoinKnownNetworkRequest) pbReq = {};
-    DecodedCString dSsid(&pbReq.ssid);
+    RequestArena arena;
+    DecodedCString dSsid(&pbReq.ssid, &arena);
     CHECK(decodeRequestMessage(req, PB(JoinKnownNetworkRequest_fields), &pbReq));
     const auto wifiMgr = wifiNetworkManager();
     CHECK_TRUE(wifiMgr, SYSTEM_ERROR_UNKNOWN);
@@ -158,7 +160,8 @@ int getKnownNetworks(ctrl_request* req) {
 
 int removeKnownNetwork(ctrl_request* req) {
     PB(RemoveKnownNetworkRequest) pbReq = {};
-    DecodedCString dSsid(&pbReq.ssid);
+    RequestArena arena;
+    DecodedCString dSsid(&pbReq.ssid, &arena);
     CHECK(decodeRequestMessage(req, PB(RemoveKnownNetworkRequest_fields), &pbReq));
     const auto wifiMgr = wifiNetworkManager();
     CHECK_TRUE(wifiMgr, SYSTEM_ERROR_UNKNOWN);
@@ -198,7 +201,7 @@ int scanNetworks(ctrl_request* req) {
     CHECK(ncpClient->on());
     // Scan for networks
     Vector<WifiScanResult> networks;
-    CHECK(ncpClient->scan([](WifiScanResult network, void* data) -> int {
+    CHECK(wifiMgr->scan([](WifiScanResult network, void* data) -> int {
         const auto networks = (Vector<WifiScanResult>*)data;
         CHECK_TRUE(networks->append(std::move(network)), SYSTEM_ERROR_NO_MEMORY);
         return 0;
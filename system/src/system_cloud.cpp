@@ -35,12 +35,14 @@
 #include "system_cloud.h"
 #include "system_cloud_internal.h"
 #include "system_publish_vitals.h"
+#include "system_publish_queue.h"
 #include "system_task.h"
 #include "system_threading.h"
 #include "system_update.h"
 #include "system_cloud_internal.h"
 #include "string_convert.h"
 #include "spark_protocol_functions.h"
+#include "completion_handler.h"
 #include "events.h"
 #include "deviceid_hal.h"
 #include "system_mode.h"
@@ -113,7 +115,20 @@ bool spark_subscribe(const char *eventName, EventHandler handler, void* handler_
 {
     SYSTEM_THREAD_CONTEXT_SYNC(spark_subscribe(eventName, handler, handler_data, scope, deviceID, reserved));
     auto event_scope = convert(scope);
-    bool success = spark_protocol_add_event_handler(sp, eventName, handler, event_scope, deviceID, handler_data);
+    unsigned flags = 0;
+    if (reserved) {
+        auto p = static_cast<const spark_subscribe_param*>(reserved);
+        if (offsetof(spark_subscribe_param, flags) + sizeof(spark_subscribe_param::flags) <= p->size) {
+            flags = p->flags;
+        }
+    }
+    bool success = false;
+    if (flags) {
+        success = spark_protocol_add_event_handler_ex(sp, eventName, handler, event_scope, deviceID, handler_data, flags,
+                nullptr /* reserved */);
+    } else {
+        success = spark_protocol_add_event_handler(sp, eventName, handler, event_scope, deviceID, handler_data);
+    }
     if (success && spark_cloud_flag_connected() && (system_mode() != AUTOMATIC || APPLICATION_SETUP_DONE))
     {
         register_event(eventName, event_scope, deviceID);
@@ -163,6 +178,36 @@ inline uint32_t convert(uint32_t flags) {
 	return flags;
 }
 
+#if HAL_PLATFORM_FILESYSTEM
+
+/**
+ * Store an event in the persistent publish queue. The completion handler is invoked as soon as the
+ * event is stored.
+ */
+static bool spark_queue_event(const char* name, const char* data, int ttl, uint32_t flags, const spark_send_event_data* d)
+{
+    size_t dataSize = 0;
+    unsigned contentType = CLOUD_CONTENT_TYPE_TEXT;
+    particle::CompletionHandler handler;
+    if (d) {
+        handler = particle::CompletionHandler(d->handler_callback, d->handler_data);
+        if (offsetof(spark_send_event_data, content_type) + sizeof(spark_send_event_data::content_type) <= d->size) {
+            dataSize = d->data_size;
+            contentType = d->content_type;
+        }
+    }
+    const int r = particle::system::PublishQueue::instance()->push(name, data, dataSize, contentType, ttl, flags);
+    if (r < 0) {
+        LOG(ERROR, "Failed to queue event: %d", r);
+        handler.setError(r);
+        return false;
+    }
+    handler.setResult(true);
+    return true;
+}
+
+#endif // HAL_PLATFORM_FILESYSTEM
+
 bool spark_send_event(const char* name, const char* data, int ttl, uint32_t flags, void* reserved)
 {
     if (flags & PUBLISH_EVENT_FLAG_ASYNC) {
@@ -172,12 +217,23 @@ bool spark_send_event(const char* name, const char* data, int ttl, uint32_t flag
     SYSTEM_THREAD_CONTEXT_SYNC(spark_send_event(name, data, ttl, flags, reserved));
     }
 
+#if HAL_PLATFORM_FILESYSTEM
+    if (flags & PUBLISH_EVENT_FLAG_PERSISTENT) {
+        return spark_queue_event(name, data, ttl, flags, static_cast<const spark_send_event_data*>(reserved));
+    }
+#endif // HAL_PLATFORM_FILESYSTEM
+    flags &= ~(PUBLISH_EVENT_FLAG_PERSISTENT | PUBLISH_EVENT_FLAG_PRIORITY_HIGH);
+
     spark_protocol_send_event_data d = { sizeof(spark_protocol_send_event_data) };
     if (reserved) {
         // Forward completion callback to the protocol implementation
         auto r = static_cast<const spark_send_event_data*>(reserved);
         d.handler_callback = r->handler_callback;
         d.handler_data = r->handler_data;
+        if (offsetof(spark_send_event_data, content_type) + sizeof(spark_send_event_data::content_type) <= r->size) {
+            d.data_size = r->data_size;
+            d.content_type = r->content_type;
+        }
     }
 
     return spark_protocol_send_event(sp, name, data, ttl, convert(flags), &d);
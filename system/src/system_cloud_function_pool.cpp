@@ -0,0 +1,214 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "system_cloud_function_pool.h"
+
+#if PLATFORM_THREADING
+
+#include "logging.h"
+#include "timer_hal.h"
+#include "system_error.h"
+
+#include <cstring>
+#include <cstdlib>
+
+LOG_SOURCE_CATEGORY("system.cloud")
+
+namespace particle {
+
+namespace system {
+
+CloudFunctionPool::CloudFunctionPool() :
+        calls_(),
+        workers_(),
+        queue_(nullptr),
+        started_(false) {
+}
+
+int CloudFunctionPool::schedule(const User_Func_Lookup_Table_t& func, const char* param, SparkDescriptor::FunctionResultCallback callback) {
+    std::lock_guard<Mutex> lock(mutex_);
+    if (!started_) {
+        const int ret = start();
+        if (ret < 0) {
+            return ret;
+        }
+    }
+    Call* call = nullptr;
+    for (auto& c: calls_) {
+        if (c.state == CallState::FREE) {
+            call = &c;
+            break;
+        }
+    }
+    if (!call) {
+        return SYSTEM_ERROR_BUSY;
+    }
+    const auto paramCopy = strdup(param ? param : "");
+    if (!paramCopy) {
+        return SYSTEM_ERROR_NO_MEMORY;
+    }
+    call->callback = std::move(callback);
+    call->fn = func.pUserFunc;
+    call->data = func.pUserFuncData;
+    call->param = paramCopy;
+    call->deadline = func.timeout ? HAL_Timer_Get_Milli_Seconds() + func.timeout : 0;
+    call->result = 0;
+    call->maxConcurrency = func.maxConcurrency ? func.maxConcurrency : 1;
+    call->state = CallState::QUEUED;
+    call->replied = false;
+    notifyWorkers();
+    return 0;
+}
+
+void CloudFunctionPool::process() {
+    if (!started_) {
+        return;
+    }
+    const auto now = HAL_Timer_Get_Milli_Seconds();
+    for (auto& call: calls_) {
+        SparkDescriptor::FunctionResultCallback callback;
+        int result = 0;
+        {
+            std::lock_guard<Mutex> lock(mutex_);
+            if (call.state == CallState::FREE || call.replied) {
+                continue;
+            }
+            if (call.state == CallState::FINISHED) {
+                result = call.result;
+            } else if (call.deadline && (int32_t)(now - call.deadline) >= 0) {
+                LOG(WARN, "Cloud function call timed out");
+                result = SYSTEM_ERROR_TIMEOUT;
+            } else {
+                continue;
+            }
+            call.replied = true;
+            callback = std::move(call.callback);
+            if (call.state == CallState::FINISHED) {
+                releaseCall(&call);
+            } else if (call.state == CallState::QUEUED) {
+                // The call has timed out before it could be picked up by a worker
+                releaseCall(&call);
+            }
+            // A running call is released by its worker
+        }
+        // The callback is invoked outside of the critical section
+        if (callback) {
+            callback((const void*)long(result), SparkReturnType::INT);
+        }
+    }
+}
+
+CloudFunctionPool* CloudFunctionPool::instance() {
+    static CloudFunctionPool pool;
+    return &pool;
+}
+
+int CloudFunctionPool::start() {
+    if (os_queue_create(&queue_, sizeof(uint8_t), MAX_CALLS, nullptr) != 0) {
+        queue_ = nullptr;
+        return SYSTEM_ERROR_NO_MEMORY;
+    }
+    size_t count = 0;
+    for (auto& worker: workers_) {
+        if (os_thread_create(&worker, "cloud_fn", OS_THREAD_PRIORITY_DEFAULT, workerLoop, this, WORKER_STACK_SIZE) != 0) {
+            worker = nullptr;
+            break;
+        }
+        ++count;
+    }
+    if (!count) {
+        os_queue_destroy(queue_, nullptr);
+        queue_ = nullptr;
+        return SYSTEM_ERROR_NO_MEMORY;
+    }
+    if (count < WORKER_COUNT) {
+        LOG(WARN, "Started %u of %u cloud function workers", (unsigned)count, (unsigned)WORKER_COUNT);
+    }
+    started_ = true;
+    return 0;
+}
+
+CloudFunctionPool::Call* CloudFunctionPool::takeRunnableCall() {
+    // Calls are picked up in the order of their slots, which is good enough for a handful of slots
+    for (auto& call: calls_) {
+        if (call.state == CallState::QUEUED && runningCallCount(call.fn, call.data) < call.maxConcurrency) {
+            call.state = CallState::RUNNING;
+            return &call;
+        }
+    }
+    return nullptr;
+}
+
+size_t CloudFunctionPool::runningCallCount(cloud_function_t fn, void* data) const {
+    size_t count = 0;
+    for (const auto& call: calls_) {
+        if (call.state == CallState::RUNNING && call.fn == fn && call.data == data) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+void CloudFunctionPool::notifyWorkers() {
+    const uint8_t token = 0;
+    // The queue may already be full, in which case the workers are going to wake up anyway
+    os_queue_put(queue_, &token, 0, nullptr);
+}
+
+void CloudFunctionPool::releaseCall(Call* call) {
+    free(call->param);
+    call->param = nullptr;
+    call->callback = nullptr;
+    call->state = CallState::FREE;
+}
+
+void CloudFunctionPool::workerLoop(void* arg) {
+    const auto self = static_cast<CloudFunctionPool*>(arg);
+    for (;;) {
+        uint8_t token = 0;
+        if (os_queue_take(self->queue_, &token, CONCURRENT_WAIT_FOREVER, nullptr) != 0) {
+            continue;
+        }
+        Call* call = nullptr;
+        {
+            std::lock_guard<Mutex> lock(self->mutex_);
+            call = self->takeRunnableCall();
+        }
+        if (!call) {
+            continue;
+        }
+        const int result = call->fn(call->data, call->param, nullptr);
+        {
+            std::lock_guard<Mutex> lock(self->mutex_);
+            if (call->replied) {
+                // The cloud has already received a timeout error for this call
+                self->releaseCall(call);
+            } else {
+                call->result = result;
+                call->state = CallState::FINISHED;
+            }
+        }
+        // Calls waiting for this function's concurrency limit may be runnable now
+        self->notifyWorkers();
+    }
+}
+
+} // namespace system
+
+} // namespace particle
+
+#endif // PLATFORM_THREADING
@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#if PLATFORM_THREADING
+
+#include "system_cloud_internal.h"
+#include "spark_descriptor.h"
+#include "concurrent_hal.h"
+#include "spark_wiring_thread.h"
+
+namespace particle {
+
+namespace system {
+
+/**
+ * Pool of worker threads for cloud functions registered with `CLOUD_FUNCTION_FLAG_CONCURRENT`.
+ *
+ * Function calls are queued in a fixed number of slots and picked up by the workers, subject to
+ * the per-function concurrency limit. Results and timeouts are reported to the cloud via `process()`,
+ * which is expected to be called periodically by the thread running the system loop.
+ */
+class CloudFunctionPool {
+public:
+    // Number of worker threads
+    static const size_t WORKER_COUNT = 2;
+    // Maximum number of pending and running calls
+    static const size_t MAX_CALLS = 4;
+    // Stack size of a worker thread
+    static const size_t WORKER_STACK_SIZE = 4 * 1024;
+
+    /**
+     * Schedule a function call.
+     *
+     * @param func Function.
+     * @param param Function argument.
+     * @param callback Result callback.
+     * @return 0 on success or a negative result code in case of an error.
+     */
+    int schedule(const User_Func_Lookup_Table_t& func, const char* param, SparkDescriptor::FunctionResultCallback callback);
+
+    /**
+     * Report the results of completed and timed out calls.
+     */
+    void process();
+
+    static CloudFunctionPool* instance();
+
+private:
+    enum class CallState: uint8_t {
+        FREE,
+        QUEUED,
+        RUNNING,
+        FINISHED
+    };
+
+    struct Call {
+        SparkDescriptor::FunctionResultCallback callback;
+        cloud_function_t fn;
+        void* data;
+        char* param;
+        system_tick_t deadline;
+        int result;
+        uint16_t maxConcurrency;
+        CallState state;
+        bool replied; // Set if the result has been reported to the cloud
+    };
+
+    Call calls_[MAX_CALLS];
+    os_thread_t workers_[WORKER_COUNT];
+    os_queue_t queue_; // Used as a counting semaphore to wake the workers up
+    Mutex mutex_;
+    bool started_;
+
+    CloudFunctionPool();
+
+    int start();
+    Call* takeRunnableCall();
+    size_t runningCallCount(cloud_function_t fn, void* data) const;
+    void notifyWorkers();
+    void releaseCall(Call* call);
+
+    static void workerLoop(void* arg);
+};
+
+} // namespace system
+
+} // namespace particle
+
+#endif // PLATFORM_THREADING
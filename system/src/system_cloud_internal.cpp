@@ -48,6 +48,7 @@
 #include "bytes2hexbuf.h"
 #include "system_event.h"
 #include "system_cloud_connection.h"
+#include "system_cloud_function_pool.h"
 #include "system_network_internal.h"
 #include "str_util.h"
 #include "scope_guard.h"
@@ -147,6 +148,9 @@ User_Var_Lookup_Table_t* find_var_by_key_or_add(const char* varKey, const void*
 		if (offsetof(spark_variable_t, copy) + sizeof(spark_variable_t::copy) <= extra->size) {
 			item.copy = extra->copy;
 		}
+		if (offsetof(spark_variable_t, read) + sizeof(spark_variable_t::read) <= extra->size) {
+			item.read = extra->read;
+		}
 	}
 	memcpy(item.userVarKey, varKey, USER_VAR_KEY_LENGTH);
 
@@ -179,6 +183,12 @@ User_Func_Lookup_Table_t* find_func_by_key_or_add(const char* funcKey, const clo
 	item.pUserFunc = desc->fn;
 	item.pUserFuncData = desc->data;
     memcpy(item.userFuncKey, desc->funcKey, USER_FUNC_KEY_LENGTH);
+    // Older applications don't provide the concurrency settings
+    if (desc->size >= offsetof(cloud_function_descriptor, timeout) + sizeof(cloud_function_descriptor::timeout)) {
+        item.flags = desc->flags;
+        item.maxConcurrency = desc->max_concurrency;
+        item.timeout = desc->timeout;
+    }
 
     User_Func_Lookup_Table_t* result = find_func_by_key(funcKey);
     if (result) {
@@ -306,6 +316,18 @@ void invokeEventHandlerString(uint16_t handlerInfoSize, FilteringEventHandler* h
     invokeEventHandlerInternal(handlerInfoSize, handlerInfo, name.c_str(), data.c_str(), reserved);
 }
 
+bool is_binary_event_handler(uint16_t handlerInfoSize, FilteringEventHandler* handlerInfo) {
+    return offsetof(FilteringEventHandler, flags) + sizeof(FilteringEventHandler::flags) <= handlerInfoSize &&
+            (handlerInfo->flags & SubscriptionFlag::BINARY_DATA);
+}
+
+void invokeBinaryEventHandler(FilteringEventHandler* handlerInfo, const String& name, const String& data,
+                unsigned content_type)
+{
+    auto handler = (EventHandlerWithSize)handlerInfo->handler;
+    handler(handlerInfo->handler_data, name.c_str(), data.c_str(), data.length(), content_type);
+}
+
 void SystemEvents(const char* name, const char* data);
 
 bool is_system_handler(uint16_t handlerInfoSize, FilteringEventHandler* handlerInfo) {
@@ -316,7 +338,27 @@ bool is_system_handler(uint16_t handlerInfoSize, FilteringEventHandler* handlerI
 void invokeEventHandler(uint16_t handlerInfoSize, FilteringEventHandler* handlerInfo,
                 const char* event_name, const char* event_data, void* reserved)
 {
-    if (is_system_handler(handlerInfoSize, handlerInfo) || system_thread_get_state(NULL)==spark::feature::DISABLED)
+    if (is_binary_event_handler(handlerInfoSize, handlerInfo))
+    {
+        size_t data_size = 0;
+        unsigned content_type = CLOUD_CONTENT_TYPE_TEXT;
+        const auto info = static_cast<const EventDataInfo*>(reserved);
+        if (info && offsetof(EventDataInfo, data_size) + sizeof(EventDataInfo::data_size) <= info->size) {
+            data_size = info->data_size;
+            content_type = info->content_type;
+        } else if (event_data) {
+            data_size = strlen(event_data);
+        }
+        // copy the buffers to dynamically allocated storage. The data may contain null characters
+        String name(event_name);
+        String data(event_data, data_size);
+        if (system_thread_get_state(NULL)==spark::feature::DISABLED) {
+            invokeBinaryEventHandler(handlerInfo, name, data, content_type);
+        } else {
+            APPLICATION_THREAD_CONTEXT_ASYNC(invokeBinaryEventHandler(handlerInfo, name, data, content_type));
+        }
+    }
+    else if (is_system_handler(handlerInfoSize, handlerInfo) || system_thread_get_state(NULL)==spark::feature::DISABLED)
     {
         invokeEventHandlerInternal(handlerInfoSize, handlerInfo, event_name, event_data, reserved);
     }
@@ -740,6 +782,23 @@ void getUserVar(const char* varKey, SparkDescriptor::GetVariableCallback callbac
     }
 }
 
+int getUserVarBlock(const char* varKey, size_t offset, void* data, size_t size, size_t* totalSize)
+{
+    const auto item = find_var_by_key(varKey);
+    if (!item) {
+        return -ProtocolError::NOT_FOUND;
+    }
+    if (!item->read) {
+        // The value needs to be copied in the application thread
+        return -ProtocolError::NOT_IMPLEMENTED;
+    }
+    const int n = item->read(item->userVar, offset, data, size, totalSize);
+    if (n < 0) {
+        return -ProtocolError::UNKNOWN;
+    }
+    return n;
+}
+
 void userFuncScheduleImpl(User_Func_Lookup_Table_t* item, const char* paramString, bool freeParamString, SparkDescriptor::FunctionResultCallback callback)
 {
     int result = item->pUserFunc(item->pUserFuncData, paramString, NULL);
@@ -758,6 +817,16 @@ int userFuncSchedule(const char *funcKey, const char *paramString, SparkDescript
         return -1;
 
 #if PLATFORM_THREADING
+    if (item->flags & CLOUD_FUNCTION_FLAG_CONCURRENT) {
+        // Running the function on the application thread would bypass the concurrency limit of the
+        // function, so the call is rejected if it can't be scheduled
+        const int ret = particle::system::CloudFunctionPool::instance()->schedule(*item, paramString, callback);
+        if (ret < 0) {
+            LOG(WARN, "Unable to schedule cloud function call: %d", ret);
+            callback((const void*)long(ret), SparkReturnType::INT);
+        }
+        return 0;
+    }
     paramString = strdup(paramString);      // ensure we have a copy since the oriignal isn't guaranteed to be available once this function returns.
     APPLICATION_THREAD_CONTEXT_ASYNC_RESULT(userFuncScheduleImpl(item, paramString, true, callback), 0);
     userFuncScheduleImpl(item, paramString, true, callback);
@@ -979,6 +1048,7 @@ void Spark_Protocol_Init(void)
         descriptor.get_variable_key = getUserVariableKey;
         descriptor.variable_type = wrapVarTypeInEnum;
         descriptor.get_variable_async = getUserVar;
+        descriptor.get_variable_block = getUserVarBlock;
         descriptor.was_ota_upgrade_successful = HAL_OTA_Flashed_GetStatus;
         descriptor.ota_upgrade_status_sent = HAL_OTA_Flashed_ResetStatus;
         descriptor.append_system_info = system_module_info;
@@ -1033,6 +1103,9 @@ void Spark_Protocol_Init(void)
         if (bootloader_get_version() >= COMPRESSED_OTA_MIN_BOOTLOADER_VERSION) {
             spark_protocol_set_connection_property(sp, particle::protocol::Connection::COMPRESSED_OTA, 0, nullptr, nullptr);
         }
+        // Enable compressed event and response payloads. Incoming payloads are decompressed with
+        // the same inflate implementation that is used for OTA updates
+        spark_protocol_set_connection_property(sp, particle::protocol::Connection::COMPRESSED_PAYLOADS, 0, nullptr, nullptr);
 #endif // HAL_PLATFORM_COMPRESSED_OTA
 
         Particle.subscribe("spark", SystemEvents, MY_DEVICES);
@@ -54,6 +54,7 @@ struct User_Var_Lookup_Table_t
 
     const void* (*update)(const char* name, Spark_Data_TypeDef varType, const void* var, void* reserved);
     int (*copy)(const void* var, void** data, size_t* size);
+    int (*read)(const void* var, size_t offset, void* data, size_t size, size_t* total_size);
 };
 
 
@@ -62,6 +63,9 @@ struct User_Func_Lookup_Table_t
     void* pUserFuncData;
     cloud_function_t pUserFunc;
     char userFuncKey[USER_FUNC_KEY_LENGTH+1];
+    uint16_t flags;
+    uint16_t maxConcurrency;
+    system_tick_t timeout;
 };
 
 
@@ -28,6 +28,7 @@
 #include "debug.h"
 #include "delay_hal.h"
 #include "hal_platform.h"
+#include "system_thread_stats.h"
 
 #include "control/network.h"
 #include "control/wifi_new.h"
@@ -211,6 +212,17 @@ void SystemControl::processRequest(ctrl_request* req, ControlRequestChannel* /*
         }
         break;
     }
+    case CTRL_REQUEST_THREAD_STATS: {
+#if HAL_PLATFORM_THREAD_PROFILER
+        const int ret = formatReplyData(req, [](Appender* appender, void* data) {
+            return formatThreadStats(appender);
+        });
+        setResult(req, ret);
+#else
+        setResult(req, SYSTEM_ERROR_NOT_SUPPORTED);
+#endif
+        break;
+    }
     /* config requests */
     case CTRL_REQUEST_SET_CLAIM_CODE: {
         setResult(req, control::config::handleSetClaimCodeRequest(req));
@@ -0,0 +1,390 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "logging.h"
+LOG_SOURCE_CATEGORY("system.pubq");
+
+#include "system_publish_queue.h"
+
+#if HAL_PLATFORM_FILESYSTEM
+
+#include "system_cloud.h"
+#include "protocol_defs.h"
+#include "timer_hal.h"
+#include "system_error.h"
+#include "check.h"
+
+#include <sys/stat.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+
+namespace particle {
+
+namespace system {
+
+namespace {
+
+using protocol::MAX_EVENT_NAME_LENGTH;
+using protocol::MAX_EVENT_DATA_LENGTH;
+
+const char QUEUE_DIR[] = "/sys/pubq";
+
+const char* const LOG_NAMES[PublishQueue::PRIORITY_COUNT] = {
+    "high",
+    "normal"
+};
+
+// Capacity of the queue for each priority
+const size_t EVENTS_PER_SEGMENT[PublishQueue::PRIORITY_COUNT] = { 8, 16 };
+const size_t MAX_SEGMENTS[PublishQueue::PRIORITY_COUNT] = { 4, 8 };
+
+// The cloud allows a burst of 4 application events per second
+const unsigned BATCH_SIZE = 4;
+// Maximum number of events covered by a batch, including the events that are not sent because
+// they were acknowledged earlier or are corrupted (see PublishQueue::ackMask_)
+const unsigned MAX_BATCH_SPAN = 32;
+
+static_assert(MAX_BATCH_SPAN <= sizeof(uint32_t) * 8, "MAX_BATCH_SPAN is too large");
+const system_tick_t BATCH_INTERVAL = 1000;
+// Delay before resending a batch that couldn't be sent
+const system_tick_t RETRY_INTERVAL = 5000;
+// Maximum time to wait for the events of a batch to be acknowledged
+const system_tick_t BATCH_TIMEOUT = 60000;
+
+// Publish flags stored with a queued event
+const uint32_t STORED_EVENT_FLAGS = PUBLISH_EVENT_FLAG_PRIVATE | PUBLISH_EVENT_FLAG_NO_ACK | PUBLISH_EVENT_FLAG_WITH_ACK;
+
+struct EventHeader {
+    uint16_t contentType;
+    uint8_t flags;
+    uint8_t nameSize;
+    int32_t ttl;
+    // Followed by the event name and data
+} __attribute__((packed));
+
+const size_t MAX_EVENT_SIZE = sizeof(EventHeader) + MAX_EVENT_NAME_LENGTH + MAX_EVENT_DATA_LENGTH;
+
+// Removes the files of a log created with a different format
+int removeLogDir(const char* dir) {
+    DIR* const d = opendir(dir);
+    if (!d) {
+        return (errno == ENOENT) ? 0 : SYSTEM_ERROR_FILE;
+    }
+    char path[80] = {};
+    struct dirent* ent = nullptr;
+    while ((ent = readdir(d))) {
+        if (ent->d_type == DT_REG && snprintf(path, sizeof(path), "%s/%s", dir, ent->d_name) < (int)sizeof(path)) {
+            unlink(path);
+        }
+    }
+    closedir(d);
+    return (rmdir(dir) == 0) ? 0 : SYSTEM_ERROR_FILE;
+}
+
+inline bool timeReached(system_tick_t now, system_tick_t time) {
+    return (int32_t)(now - time) >= 0;
+}
+
+PublishQueue g_publishQueue(QUEUE_DIR);
+
+} // namespace
+
+PublishQueue::QueuedEventsDiagnosticData::QueuedEventsDiagnosticData(const PublishQueue* queue) :
+        AbstractUnsignedIntegerDiagnosticData(DIAG_ID_CLOUD_QUEUED_EVENTS, DIAG_NAME_CLOUD_QUEUED_EVENTS),
+        queue_(queue) {
+}
+
+int PublishQueue::QueuedEventsDiagnosticData::get(IntType& val) {
+    val = queue_->count();
+    return 0;
+}
+
+PublishQueue::PublishQueue(const char* dir) :
+        dir_(dir),
+        queuedDiag_(this),
+        dropped_(DIAG_ID_CLOUD_DROPPED_EVENTS, DIAG_NAME_CLOUD_DROPPED_EVENTS),
+        buf_(nullptr),
+        sendCtx_(),
+        batchBegin_(0),
+        batchEnd_(0),
+        ackMask_(0),
+        batchTime_(0),
+        nextTime_(0),
+        batchLog_(-1),
+        ackLog_(-1),
+        sentCount_(0),
+        doneCount_(0),
+        batchId_(0),
+        failed_(false),
+        inited_(false),
+        checked_(false) {
+}
+
+PublishQueue::~PublishQueue() {
+    free(buf_);
+}
+
+int PublishQueue::push(const char* name, const char* data, size_t dataSize, unsigned contentType, int ttl,
+        uint32_t flags) {
+    CHECK_TRUE(name, SYSTEM_ERROR_INVALID_ARGUMENT);
+    const size_t nameSize = strlen(name);
+    CHECK_TRUE(nameSize > 0 && nameSize <= MAX_EVENT_NAME_LENGTH, SYSTEM_ERROR_INVALID_ARGUMENT);
+    if (contentType == CLOUD_CONTENT_TYPE_TEXT && !dataSize) {
+        // Text data is truncated the same way as when it's published directly
+        dataSize = data ? strnlen(data, MAX_EVENT_DATA_LENGTH) : 0;
+    }
+    CHECK_TRUE(data || !dataSize, SYSTEM_ERROR_INVALID_ARGUMENT);
+    CHECK_TRUE(dataSize <= MAX_EVENT_DATA_LENGTH, SYSTEM_ERROR_TOO_LARGE);
+    CHECK(init());
+    EventHeader h = {};
+    h.contentType = contentType;
+    h.flags = flags & STORED_EVENT_FLAGS;
+    h.nameSize = nameSize;
+    h.ttl = ttl;
+    memcpy(buf_, &h, sizeof(h));
+    memcpy(buf_ + sizeof(h), name, nameSize);
+    if (dataSize > 0) {
+        memcpy(buf_ + sizeof(h) + nameSize, data, dataSize);
+    }
+    RecordLog* const log = &logs_[(flags & PUBLISH_EVENT_FLAG_PRIORITY_HIGH) ? PRIORITY_HIGH : PRIORITY_NORMAL];
+    const uint32_t pending = log->consumed();
+    CHECK(log->append(buf_, sizeof(h) + nameSize + dataSize));
+    if (log->begin() > pending) {
+        // The oldest unsent events were discarded to make room for the new event
+        const unsigned n = log->begin() - pending;
+        LOG(WARN, "Publish queue is full, %u event(s) discarded", n);
+        dropped_ += n;
+    }
+    CHECK(log->sync());
+    return 0;
+}
+
+void PublishQueue::process() {
+    if (!inited_) {
+        if (checked_) {
+            return;
+        }
+        // Open the queue on startup if there are any events left from before a reset
+        checked_ = true;
+        struct stat st = {};
+        if (stat(dir_, &st) != 0) {
+            return;
+        }
+        const int r = init();
+        if (r < 0) {
+            LOG(ERROR, "Failed to open publish queue: %d", r);
+            return;
+        }
+    }
+    const auto now = HAL_Timer_Get_Milli_Seconds();
+    if (batchLog_ >= 0) {
+        if (doneCount_ == sentCount_) {
+            endBatch(!failed_, now);
+        } else if (now - batchTime_ >= BATCH_TIMEOUT) {
+            LOG(WARN, "Timeout while sending queued events");
+            endBatch(false /* ok */, now);
+        } else {
+            return;
+        }
+    }
+    if (timeReached(now, nextTime_)) {
+        sendBatch(now);
+    }
+}
+
+size_t PublishQueue::count() const {
+    if (!inited_) {
+        return 0;
+    }
+    size_t n = 0;
+    for (const RecordLog& log: logs_) {
+        n += log.end() - log.consumed();
+    }
+    return n;
+}
+
+PublishQueue* PublishQueue::instance() {
+    return &g_publishQueue;
+}
+
+int PublishQueue::init() {
+    if (inited_) {
+        return 0;
+    }
+    if (!buf_) {
+        // Reserve a byte for the term. null of text data
+        buf_ = (char*)malloc(MAX_EVENT_SIZE + 1);
+        CHECK_TRUE(buf_, SYSTEM_ERROR_NO_MEMORY);
+    }
+    CHECK_TRUE(mkdir(dir_, 0777) == 0 || errno == EEXIST, SYSTEM_ERROR_FILE);
+    for (int i = 0; i < PRIORITY_COUNT; ++i) {
+        char logDir[64] = {};
+        int r = snprintf(logDir, sizeof(logDir), "%s/%s", dir_, LOG_NAMES[i]);
+        if (r >= (int)sizeof(logDir)) {
+            r = SYSTEM_ERROR_TOO_LARGE;
+        } else {
+            r = logs_[i].open(logDir, MAX_EVENT_SIZE, EVENTS_PER_SEGMENT[i], MAX_SEGMENTS[i]);
+            if (r == SYSTEM_ERROR_BAD_DATA || r == SYSTEM_ERROR_INVALID_ARGUMENT) {
+                // The queue was created by a different version of the firmware
+                LOG(WARN, "Discarding incompatible publish queue: %s", logDir);
+                r = removeLogDir(logDir);
+                if (r == 0) {
+                    r = logs_[i].open(logDir, MAX_EVENT_SIZE, EVENTS_PER_SEGMENT[i], MAX_SEGMENTS[i]);
+                }
+            }
+        }
+        if (r < 0) {
+            for (int j = 0; j < i; ++j) {
+                logs_[j].close();
+            }
+            return r;
+        }
+    }
+    inited_ = true;
+    return 0;
+}
+
+void PublishQueue::sendBatch(system_tick_t now) {
+    for (int i = 0; i < PRIORITY_COUNT; ++i) {
+        RecordLog* const log = &logs_[i];
+        const uint32_t begin = log->consumed();
+        if (begin == log->end()) {
+            continue;
+        }
+        if (i != ackLog_ || begin != batchBegin_) {
+            // The acknowledgements are only kept while the same events are being resent
+            ackMask_ = 0;
+        }
+        batchLog_ = i;
+        ackLog_ = i;
+        batchBegin_ = begin;
+        batchEnd_ = begin;
+        batchTime_ = now;
+        sentCount_ = 0;
+        doneCount_ = 0;
+        failed_ = false;
+        ++batchId_; // Completions of the events from a previous batch are ignored
+        while (sentCount_ < BATCH_SIZE && batchEnd_ < log->end() && batchEnd_ - begin < MAX_BATCH_SPAN &&
+                !failed_) {
+            const uint32_t bit = (uint32_t)1 << (batchEnd_ - begin);
+            if (!(ackMask_ & bit)) {
+                const int r = sendEvent(log, batchEnd_);
+                if (r == SYSTEM_ERROR_BUSY) {
+                    break; // Too many events are awaiting completion
+                }
+                if (r < 0) {
+                    if (r != SYSTEM_ERROR_BAD_DATA) {
+                        LOG(ERROR, "Failed to read queued event: %d", r);
+                        failed_ = true;
+                        break;
+                    }
+                    LOG(WARN, "Skipping corrupted event: %u", (unsigned)batchEnd_);
+                    ackMask_ |= bit;
+                }
+            }
+            ++batchEnd_;
+        }
+        nextTime_ = now + BATCH_INTERVAL;
+        break;
+    }
+}
+
+int PublishQueue::sendEvent(RecordLog* log, uint32_t index) {
+    SendContext* ctx = nullptr;
+    for (SendContext& c: sendCtx_) {
+        if (!c.used) {
+            ctx = &c;
+            break;
+        }
+    }
+    CHECK_TRUE(ctx, SYSTEM_ERROR_BUSY);
+    const int n = CHECK(log->read(index, buf_, MAX_EVENT_SIZE));
+    EventHeader h = {};
+    CHECK_TRUE((size_t)n >= sizeof(h), SYSTEM_ERROR_BAD_DATA);
+    memcpy(&h, buf_, sizeof(h));
+    CHECK_TRUE(h.nameSize > 0 && h.nameSize <= MAX_EVENT_NAME_LENGTH && sizeof(h) + h.nameSize <= (size_t)n,
+            SYSTEM_ERROR_BAD_DATA);
+    char name[MAX_EVENT_NAME_LENGTH + 1] = {};
+    memcpy(name, buf_ + sizeof(h), h.nameSize);
+    char* const data = buf_ + sizeof(h) + h.nameSize;
+    const size_t dataSize = n - sizeof(h) - h.nameSize;
+    data[dataSize] = '\0';
+    spark_send_event_data d = { sizeof(spark_send_event_data) };
+    d.handler_callback = sendCompletion;
+    d.handler_data = ctx;
+    d.data_size = dataSize;
+    d.content_type = h.contentType;
+    // Request an acknowledgement so that the event is only removed from the queue once it's delivered
+    const uint32_t flags = (h.flags & ~PUBLISH_EVENT_FLAG_NO_ACK) | PUBLISH_EVENT_FLAG_WITH_ACK;
+    // The completion handler can be invoked synchronously
+    ctx->queue = this;
+    ctx->batchId = batchId_;
+    ctx->offset = index - batchBegin_;
+    ctx->used = true;
+    ++sentCount_;
+    spark_send_event(name, data, h.ttl, flags, &d);
+    return 0;
+}
+
+void PublishQueue::endBatch(bool ok, system_tick_t now) {
+    RecordLog* const log = &logs_[batchLog_];
+    batchLog_ = -1;
+    // Remove the acknowledged events preceding the first event that needs to be resent
+    const uint32_t span = batchEnd_ - batchBegin_;
+    uint32_t n = 0;
+    while (n < span && (ackMask_ & ((uint32_t)1 << n))) {
+        ++n;
+    }
+    if (n > 0) {
+        const int r = log->consumed(batchBegin_ + n);
+        if (r < 0) {
+            LOG(ERROR, "Failed to update publish queue: %d", r);
+            ok = false;
+        } else {
+            batchBegin_ += n;
+            ackMask_ = (n < MAX_BATCH_SPAN) ? (ackMask_ >> n) : 0;
+        }
+    }
+    if (!ok) {
+        // Resend the events that were not acknowledged
+        nextTime_ = now + RETRY_INTERVAL;
+    }
+}
+
+void PublishQueue::sendCompletion(int error, const void* data, void* callbackData, void* reserved) {
+    const auto ctx = (SendContext*)callbackData;
+    const auto q = ctx->queue;
+    ctx->used = false;
+    if (q->batchLog_ < 0 || ctx->batchId != q->batchId_) {
+        return;
+    }
+    if (error != SYSTEM_ERROR_NONE) {
+        q->failed_ = true;
+    } else {
+        q->ackMask_ |= (uint32_t)1 << ctx->offset;
+    }
+    ++q->doneCount_;
+}
+
+} // namespace system
+
+} // namespace particle
+
+#endif // HAL_PLATFORM_FILESYSTEM
@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "hal_platform.h"
+
+#if HAL_PLATFORM_FILESYSTEM
+
+#include "spark_wiring_record_log.h"
+#include "spark_wiring_diagnostics.h"
+
+#include "system_tick_hal.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace particle {
+
+namespace system {
+
+/**
+ * Persistent queue of events published with `PUBLISH_EVENT_FLAG_PERSISTENT`.
+ *
+ * Queued events are stored on the filesystem and sent to the cloud in batches once the device is
+ * connected, at the maximum rate allowed for application events. Events are removed from the queue
+ * only after they have been acknowledged by the cloud, so an event can be sent more than once if
+ * the connection is lost while a batch is in flight.
+ *
+ * High priority events are sent before normal priority events. The queue for each priority has a
+ * fixed capacity, and the oldest events of a priority are discarded when its queue is full.
+ *
+ * This class is not thread-safe and should only be used from the system thread.
+ */
+class PublishQueue {
+public:
+    enum Priority {
+        PRIORITY_HIGH = 0,
+        PRIORITY_NORMAL = 1,
+        PRIORITY_COUNT = 2
+    };
+
+    /**
+     * Constructor.
+     *
+     * @param dir Directory for the queue files. The string must remain valid for the lifetime
+     *        of the queue.
+     */
+    explicit PublishQueue(const char* dir);
+    ~PublishQueue();
+
+    /**
+     * Add an event to the queue.
+     *
+     * @param name Event name.
+     * @param data Event data.
+     * @param dataSize Size of the event data. For `CLOUD_CONTENT_TYPE_TEXT`, 0 means the data is
+     *        null-terminated.
+     * @param contentType Content type of the event data (see `cloud_content_type`).
+     * @param ttl Event TTL.
+     * @param flags Publish flags (see `PUBLISH_EVENT_FLAG_*`).
+     * @return 0 on success, or a negative result code in case of an error.
+     */
+    int push(const char* name, const char* data, size_t dataSize, unsigned contentType, int ttl, uint32_t flags);
+    /**
+     * Send the queued events. This method should be called periodically while the device is
+     * connected to the cloud.
+     */
+    void process();
+
+    /**
+     * Get the number of events that have not been sent yet.
+     */
+    size_t count() const;
+    /**
+     * Get the number of events that were discarded before they could be sent.
+     */
+    size_t dropped() const {
+        return dropped_;
+    }
+
+    static PublishQueue* instance();
+
+private:
+    // Maximum number of sent events whose completion is pending
+    static const unsigned MAX_PENDING_EVENTS = 8;
+
+    // Completion context of a sent event
+    struct SendContext {
+        PublishQueue* queue;
+        uint8_t batchId; // ID of the batch the event was sent in
+        uint8_t offset; // Index of the event relative to the first event of the batch
+        bool used; // Set until the completion handler is invoked
+    };
+
+    class QueuedEventsDiagnosticData: public AbstractUnsignedIntegerDiagnosticData {
+    public:
+        explicit QueuedEventsDiagnosticData(const PublishQueue* queue);
+
+        int get(IntType& val) override;
+
+    private:
+        const PublishQueue* queue_;
+    };
+
+    RecordLog logs_[PRIORITY_COUNT];
+    const char* dir_;
+    QueuedEventsDiagnosticData queuedDiag_;
+    SimpleUnsignedIntegerDiagnosticData dropped_;
+    char* buf_; // Buffer for a serialized event
+    SendContext sendCtx_[MAX_PENDING_EVENTS];
+    uint32_t batchBegin_; // Index of the first event in the current batch
+    uint32_t batchEnd_; // Index following the last event in the current batch
+    uint32_t ackMask_; // Events of the batch that were acknowledged or skipped, relative to its first event
+    system_tick_t batchTime_; // Time when the current batch was sent
+    system_tick_t nextTime_; // Time when the next batch can be sent
+    int batchLog_; // Priority of the events in the current batch, or -1 if no batch is in flight
+    int ackLog_; // Priority of the events in the last batch
+    unsigned sentCount_; // Number of events sent in the current batch
+    unsigned doneCount_; // Number of events in the current batch whose sending has completed
+    uint8_t batchId_; // Used to ignore completions of the events from a previous batch
+    bool failed_; // Set if an event in the current batch couldn't be sent
+    bool inited_;
+    bool checked_;
+
+    int init();
+    void sendBatch(system_tick_t now);
+    int sendEvent(RecordLog* log, uint32_t index);
+    void endBatch(bool ok, system_tick_t now);
+
+    static void sendCompletion(int error, const void* data, void* callbackData, void* reserved);
+};
+
+} // namespace system
+
+} // namespace particle
+
+#endif // HAL_PLATFORM_FILESYSTEM
@@ -28,6 +28,8 @@
 #include "system_cloud.h"
 #include "system_cloud_internal.h"
 #include "system_cloud_connection.h"
+#include "system_cloud_function_pool.h"
+#include "system_publish_queue.h"
 #include "system_mode.h"
 #include "system_network.h"
 #include "system_network_internal.h"
@@ -436,6 +438,11 @@ void handle_cloud_connection(bool force_events)
         if (SPARK_FLASH_UPDATE || force_events || System.mode() != MANUAL || system_thread_get_state(NULL)==spark::feature::ENABLED)
         {
             Spark_Process_Events();
+#if HAL_PLATFORM_FILESYSTEM
+            if (SPARK_CLOUD_CONNECTED) {
+                particle::system::PublishQueue::instance()->process();
+            }
+#endif // HAL_PLATFORM_FILESYSTEM
         }
     }
 }
@@ -486,6 +493,10 @@ void Spark_Idle_Events(bool force_events/*=false*/)
         manage_ip_config();
 
         manage_cloud_connection(force_events);
+
+#if PLATFORM_THREADING
+        particle::system::CloudFunctionPool::instance()->process();
+#endif
     }
     else
     {
@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "system_thread_stats.h"
+
+#if HAL_PLATFORM_THREAD_PROFILER
+
+#include "spark_wiring_diagnostics.h"
+
+#include "concurrent_hal.h"
+#include "timer_hal.h"
+
+#include "appender.h"
+#include "endian_util.h"
+#include "system_error.h"
+#include "check.h"
+
+#include <algorithm>
+#include <memory>
+#include <cstring>
+
+namespace particle {
+
+namespace system {
+
+namespace {
+
+// Returns the number of elements in the array
+int getThreadStats(std::unique_ptr<os_thread_stats_t[]>* stats) {
+    const int count = CHECK(os_thread_get_stats(nullptr, 0, nullptr));
+    std::unique_ptr<os_thread_stats_t[]> s(new(std::nothrow) os_thread_stats_t[count]);
+    CHECK_TRUE(s, SYSTEM_ERROR_NO_MEMORY);
+    for (int i = 0; i < count; ++i) {
+        s[i] = {};
+        s[i].size = sizeof(os_thread_stats_t);
+    }
+    // Threads created after the first call are not reported
+    const int n = CHECK(os_thread_get_stats(s.get(), count, nullptr));
+    *stats = std::move(s);
+    return std::min(n, count);
+}
+
+class CpuTimeDiagnosticData: public AbstractUnsignedIntegerDiagnosticData {
+public:
+    CpuTimeDiagnosticData() :
+            AbstractUnsignedIntegerDiagnosticData(DIAG_ID_SYSTEM_CPU_TIME, DIAG_NAME_SYSTEM_CPU_TIME) {
+    }
+
+    // Time in milliseconds spent running threads other than the idle thread
+    virtual int get(IntType& val) override {
+        std::unique_ptr<os_thread_stats_t[]> stats;
+        const int count = CHECK(getThreadStats(&stats));
+        uint64_t time = 0;
+        for (int i = 0; i < count; ++i) {
+            if (!(stats[i].flags & OS_THREAD_STATS_FLAG_IDLE)) {
+                time += stats[i].cpu_time;
+            }
+        }
+        val = time / 1000;
+        return 0;
+    }
+};
+
+class MinStackFreeDiagnosticData: public AbstractUnsignedIntegerDiagnosticData {
+public:
+    MinStackFreeDiagnosticData() :
+            AbstractUnsignedIntegerDiagnosticData(DIAG_ID_SYSTEM_MIN_STACK_FREE, DIAG_NAME_SYSTEM_MIN_STACK_FREE) {
+    }
+
+    // Smallest amount of free stack space among all threads
+    virtual int get(IntType& val) override {
+        std::unique_ptr<os_thread_stats_t[]> stats;
+        const int count = CHECK(getThreadStats(&stats));
+        CHECK_TRUE(count > 0, SYSTEM_ERROR_NOT_FOUND);
+        IntType minFree = stats[0].stack_free;
+        for (int i = 1; i < count; ++i) {
+            minFree = std::min<IntType>(minFree, stats[i].stack_free);
+        }
+        val = minFree;
+        return 0;
+    }
+};
+
+CpuTimeDiagnosticData g_cpuTimeDiagData;
+MinStackFreeDiagnosticData g_minStackFreeDiagData;
+
+} // namespace
+
+int formatThreadStats(Appender* appender) {
+    std::unique_ptr<os_thread_stats_t[]> stats;
+    const int count = CHECK(getThreadStats(&stats));
+    appender->appendUInt32LE(HAL_Timer_Get_Milli_Seconds());
+    appender->appendUInt16LE(count);
+    for (int i = 0; i < count; ++i) {
+        const os_thread_stats_t& s = stats[i];
+        char name[OS_THREAD_STATS_NAME_SIZE] = {};
+        strncpy(name, s.name, sizeof(name));
+        appender->append((const uint8_t*)name, sizeof(name));
+        const uint64_t cpuTime = nativeToLittleEndian(s.cpu_time);
+        appender->append((const uint8_t*)&cpuTime, sizeof(cpuTime));
+        appender->appendUInt32LE(s.switch_count);
+        appender->appendUInt32LE(s.stack_free);
+        appender->appendUInt16LE(s.flags);
+    }
+    return 0;
+}
+
+} // namespace system
+
+} // namespace particle
+
+#endif // HAL_PLATFORM_THREAD_PROFILER
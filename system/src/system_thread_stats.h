@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "hal_platform.h"
+
+#if HAL_PLATFORM_THREAD_PROFILER
+
+namespace particle {
+
+class Appender;
+
+namespace system {
+
+/**
+ * Format the run-time statistics of the system threads.
+ *
+ * The statistics are serialized in the following format (all integers are little-endian):
+ *
+ * Field        | Size | Description
+ * -------------|------|------------
+ * uptime       | 4    | Uptime of the device in milliseconds
+ * count        | 2    | Number of thread records that follow
+ *
+ * Each thread record has the following format:
+ *
+ * Field        | Size | Description
+ * -------------|------|------------
+ * name         | 16   | Thread name padded with null characters
+ * cpu_time     | 8    | Time spent running the thread in microseconds
+ * switch_count | 4    | Number of times the thread was scheduled to run
+ * stack_free   | 4    | Smallest amount of free stack space observed, in bytes
+ * flags        | 2    | Flags (see `os_thread_stats_flag_t`)
+ *
+ * @param appender Appender instance.
+ * @return 0 on success, or a negative result code in case of an error.
+ */
+int formatThreadStats(Appender* appender);
+
+} // namespace system
+
+} // namespace particle
+
+#endif // HAL_PLATFORM_THREAD_PROFILER
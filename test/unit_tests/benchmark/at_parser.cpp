@@ -0,0 +1,199 @@
+#include "benchmark.h"
+
+#include "at_parser.h"
+#include "at_response.h"
+#include "stream.h"
+#include "system_error.h"
+#include "check.h"
+
+#include <string>
+#include <algorithm>
+#include <cstring>
+
+using namespace particle;
+using namespace particle::test;
+
+namespace {
+
+// Stream that echoes the command line and replays a canned response every time a command is
+// written to it
+class ReplayStream: public Stream {
+public:
+    ReplayStream() :
+            offs_(0) {
+    }
+
+    void response(std::string resp) {
+        resp_ = std::move(resp);
+    }
+
+    // Makes data available for reading as if it was received from the modem
+    void feed(const std::string& data) {
+        if (offs_ == in_.size()) {
+            in_.clear();
+            offs_ = 0;
+        }
+        in_ += data;
+    }
+
+    int read(char* data, size_t size) override {
+        const size_t n = CHECK(peek(data, size));
+        offs_ += n;
+        return n;
+    }
+
+    int peek(char* data, size_t size) override {
+        const size_t n = std::min(size, in_.size() - offs_);
+        memcpy(data, in_.data() + offs_, n);
+        return n;
+    }
+
+    int skip(size_t size) override {
+        const size_t n = std::min(size, in_.size() - offs_);
+        offs_ += n;
+        return n;
+    }
+
+    int availForRead() override {
+        return in_.size() - offs_;
+    }
+
+    int write(const char* data, size_t size) override {
+        cmd_.append(data, size);
+        if (size > 0 && data[size - 1] == '\r') {
+            // End of the command line
+            feed(cmd_);
+            feed(resp_);
+            cmd_.clear();
+        }
+        return size;
+    }
+
+    int flush() override {
+        return 0;
+    }
+
+    int availForWrite() override {
+        return 1024;
+    }
+
+    int waitEvent(unsigned flags, unsigned timeout) override {
+        if ((flags & InputStream::READABLE) && availForRead() > 0) {
+            return InputStream::READABLE;
+        }
+        if (flags & OutputStream::WRITABLE) {
+            return OutputStream::WRITABLE;
+        }
+        return SYSTEM_ERROR_TIMEOUT;
+    }
+
+private:
+    std::string in_;
+    std::string cmd_;
+    std::string resp_;
+    size_t offs_;
+};
+
+int initParser(AtParser* parser, ReplayStream* strm) {
+    return parser->init(AtParserConfig().stream(strm).commandTimeout(1000).streamTimeout(1000).logEnabled(false));
+}
+
+int urcHandler(AtResponseReader* reader, const char* prefix, void* data) {
+    int stat = 0;
+    unsigned tac = 0;
+    unsigned ci = 0;
+    if (reader->scanf("+CEREG: %d,\"%x\",\"%x\"", &stat, &tac, &ci) != 3) {
+        return SYSTEM_ERROR_BAD_DATA;
+    }
+    ++*(unsigned*)data;
+    return 0;
+}
+
+} // namespace
+
+BENCHMARK("hal/AtParser::sendCommand") {
+    ReplayStream strm;
+    strm.response("\r\n+CSQ: 23,99\r\n\r\nOK\r\n");
+    AtParser parser;
+    if (initParser(&parser, &strm) < 0) {
+        state.fail("Unable to initialize parser");
+        return;
+    }
+    while (state.keepRunning()) {
+        auto resp = parser.sendCommand("AT+CSQ");
+        int rssi = 0;
+        int qual = 0;
+        if (resp.scanf("+CSQ: %d,%d", &rssi, &qual) != 2 || resp.readResult() != AtResponse::OK) {
+            state.fail("Unexpected response");
+        }
+        doNotOptimize(rssi);
+    }
+    state.setItemsProcessed(state.iterations());
+}
+
+BENCHMARK("hal/AtParser::sendCommand/multiline") {
+    // Response to a command listing the sockets or the operators has a number of lines
+    std::string r = "\r\n";
+    for (int i = 0; i < 8; ++i) {
+        r += "+USOCTL: " + std::to_string(i) + ",10,1440\r\n";
+    }
+    r += "\r\nOK\r\n";
+    ReplayStream strm;
+    strm.response(r);
+    AtParser parser;
+    if (initParser(&parser, &strm) < 0) {
+        state.fail("Unable to initialize parser");
+        return;
+    }
+    while (state.keepRunning()) {
+        auto resp = parser.sendCommand("AT+USOCTL=0,10");
+        int lines = 0;
+        while (resp.hasNextLine()) {
+            char buf[64] = {};
+            if (resp.readLine(buf, sizeof(buf)) < 0) {
+                state.fail("Unable to read line");
+                break;
+            }
+            ++lines;
+        }
+        if (lines != 8 || resp.readResult() != AtResponse::OK) {
+            state.fail("Unexpected response");
+        }
+    }
+    state.setItemsProcessed(state.iterations() * 8);
+}
+
+BENCHMARK("hal/AtParser::processUrc") {
+    ReplayStream strm;
+    AtParser parser;
+    if (initParser(&parser, &strm) < 0) {
+        state.fail("Unable to initialize parser");
+        return;
+    }
+    // URCs are received between the responses to the commands sent by the NCP client
+    strm.response("\r\nOK\r\n");
+    if (parser.execCommand("AT") != AtResponse::OK) {
+        state.fail("Unexpected response");
+        return;
+    }
+    unsigned count = 0;
+    // Handlers that don't match the URC are checked too
+    const char* const prefixes[] = { "+UUSORD", "+UUSOCL", "+CIEV", "+CREG", "+CGREG", "+CEREG" };
+    for (const char* p: prefixes) {
+        if (parser.addUrcHandler(p, urcHandler, &count) < 0) {
+            state.fail("Unable to add URC handler");
+            return;
+        }
+    }
+    const std::string urc = "\r\n+CEREG: 5,\"2B67\",\"01A2D001\"\r\n";
+    while (state.keepRunning()) {
+        strm.feed(urc);
+        if (parser.processUrc() != 1) {
+            state.fail("Unable to process URC");
+        }
+    }
+    if (count != state.iterations()) {
+        state.fail("URC handler was not called");
+    }
+    state.setItemsProcessed(state.iterations());
+}
@@ -0,0 +1,196 @@
+#pragma once
+
+#include "preprocessor.h"
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+/**
+ * Defines a benchmark.
+ *
+ * The body of the benchmark is a function taking a `BenchmarkState& state` argument. Code that
+ * needs to be measured should be placed in a `while (state.keepRunning())` loop, everything else
+ * is not included in the measured time:
+ *
+ * ```
+ * BENCHMARK("services/example") {
+ *     Example ex; // Not measured
+ *     while (state.keepRunning()) {
+ *         doNotOptimize(ex.run()); // Measured
+ *     }
+ * }
+ * ```
+ *
+ * Benchmark names are prefixed with the name of the tested module, e.g. "communication/...".
+ */
+#define BENCHMARK(_name) \
+        _BENCHMARK(_name, PP_CAT(benchmark_, __COUNTER__))
+
+#define _BENCHMARK(_name, _func) \
+        static void _func(::particle::test::BenchmarkState& state); \
+        static const ::particle::test::BenchmarkRegistrar PP_CAT(_func, _registrar)(_name, _func); \
+        static void _func(::particle::test::BenchmarkState& state)
+
+namespace particle {
+
+namespace test {
+
+class BenchmarkState {
+public:
+    explicit BenchmarkState(uint64_t iterations);
+
+    /**
+     * Returns `true` if another iteration needs to be run.
+     *
+     * The timer is started on the first call to this method and stopped when all iterations have
+     * been run.
+     */
+    bool keepRunning();
+
+    // Excludes a part of an iteration from the measured time
+    void pauseTiming();
+    void resumeTiming();
+
+    /**
+     * Marks the benchmark as failed.
+     *
+     * The current iteration is the last one to be run.
+     */
+    void fail(std::string error);
+
+    /**
+     * Sets the total number of bytes or items processed by all iterations.
+     *
+     * If set, the processing rate is included in the benchmark results.
+     */
+    void setBytesProcessed(uint64_t bytes);
+    void setItemsProcessed(uint64_t items);
+
+    uint64_t iterations() const;
+    uint64_t bytesProcessed() const;
+    uint64_t itemsProcessed() const;
+
+    std::chrono::nanoseconds elapsed() const;
+
+    bool failed() const;
+    const std::string& error() const;
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    Clock::time_point start_;
+    Clock::duration elapsed_;
+    uint64_t maxIters_;
+    uint64_t iters_;
+    uint64_t bytes_;
+    uint64_t items_;
+    std::string error_;
+    bool running_;
+};
+
+typedef void(*BenchmarkFn)(BenchmarkState& state);
+
+struct Benchmark {
+    std::string name;
+    BenchmarkFn fn;
+};
+
+class BenchmarkRegistrar {
+public:
+    BenchmarkRegistrar(const char* name, BenchmarkFn fn);
+
+    static const std::vector<Benchmark>& benchmarks();
+
+private:
+    static std::vector<Benchmark>& registry();
+};
+
+// Prevents the compiler from optimizing away a computed value
+template<typename T>
+inline void doNotOptimize(const T& val) {
+    asm volatile("" : : "r,m"(val) : "memory");
+}
+
+// Forces the compiler to assume that all memory has been modified
+inline void clobberMemory() {
+    asm volatile("" : : : "memory");
+}
+
+inline BenchmarkState::BenchmarkState(uint64_t iterations) :
+        elapsed_(Clock::duration::zero()),
+        maxIters_(iterations),
+        iters_(0),
+        bytes_(0),
+        items_(0),
+        running_(false) {
+}
+
+inline bool BenchmarkState::keepRunning() {
+    if (iters_ < maxIters_) {
+        if (iters_++ == 0) {
+            resumeTiming();
+        }
+        return true;
+    }
+    pauseTiming();
+    return false;
+}
+
+inline void BenchmarkState::pauseTiming() {
+    if (running_) {
+        elapsed_ += Clock::now() - start_;
+        running_ = false;
+    }
+}
+
+inline void BenchmarkState::resumeTiming() {
+    if (!running_) {
+        running_ = true;
+        start_ = Clock::now();
+    }
+}
+
+inline void BenchmarkState::fail(std::string error) {
+    if (error_.empty()) {
+        error_ = std::move(error);
+    }
+    maxIters_ = iters_;
+}
+
+inline void BenchmarkState::setBytesProcessed(uint64_t bytes) {
+    bytes_ = bytes;
+}
+
+inline void BenchmarkState::setItemsProcessed(uint64_t items) {
+    items_ = items;
+}
+
+inline uint64_t BenchmarkState::iterations() const {
+    return iters_;
+}
+
+inline uint64_t BenchmarkState::bytesProcessed() const {
+    return bytes_;
+}
+
+inline uint64_t BenchmarkState::itemsProcessed() const {
+    return items_;
+}
+
+inline std::chrono::nanoseconds BenchmarkState::elapsed() const {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed_);
+}
+
+inline bool BenchmarkState::failed() const {
+    return !error_.empty();
+}
+
+inline const std::string& BenchmarkState::error() const {
+    return error_;
+}
+
+} // namespace test
+
+} // namespace particle
@@ -0,0 +1,220 @@
+#include "benchmark.h"
+
+#include "coap_channel.h"
+#include "messages.h"
+#include "subscriptions.h"
+
+#include <string>
+#include <cstring>
+
+using namespace particle::protocol;
+using namespace particle::test;
+
+namespace {
+
+class NullMessageChannel: public MessageChannel {
+public:
+    bool is_unreliable() override {
+        return false;
+    }
+
+    ProtocolError send(Message& msg) override {
+        return NO_ERROR;
+    }
+
+    ProtocolError receive(Message& msg) override {
+        return NO_ERROR;
+    }
+
+    ProtocolError create(Message& msg, size_t size) override {
+        return NO_ERROR;
+    }
+
+    ProtocolError establish() override {
+        return NO_ERROR;
+    }
+
+    ProtocolError response(Message& original, Message& response, size_t required) override {
+        return NO_ERROR;
+    }
+
+    ProtocolError command(Command cmd, void* arg) override {
+        return NO_ERROR;
+    }
+
+    ProtocolError notify_established() override {
+        return NO_ERROR;
+    }
+
+    void notify_client_messages_processed() override {
+    }
+
+    AppStateDescriptor cached_app_state_descriptor() const override {
+        return AppStateDescriptor();
+    }
+
+    void reset() override {
+    }
+};
+
+const size_t BUFFER_SIZE = 1024;
+
+// Event data that is typical for a device publishing sensor readings
+std::string sensorData(size_t size) {
+    std::string s;
+    for (unsigned i = 0; s.size() < size; ++i) {
+        s += "{\"sensor\":\"temp" + std::to_string(i % 4) + "\",\"value\":" + std::to_string(200 + i * 7 % 50) + "},";
+    }
+    s.resize(size);
+    return s;
+}
+
+void eventHandler(const char* name, const char* data) {
+    doNotOptimize(name);
+}
+
+uint64_t g_handlerCalls = 0;
+
+void callEventHandler(uint16_t size, FilteringEventHandler* handler, const char* event, const char* data, void* reserved) {
+    doNotOptimize(data);
+    ++g_handlerCalls;
+}
+
+int addEventHandlers(Subscriptions* subs) {
+    // Handlers that don't match the event are checked too
+    const char* const filters[] = { "spark/", "particle/", "config/", "sensor/temperature" };
+    for (const char* f: filters) {
+        if (subs->add_event_handler(f, eventHandler, nullptr, SubscriptionScope::MY_DEVICES, nullptr) != NO_ERROR) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+void handleEvent(BenchmarkState& state, const uint8_t* msg, size_t msgSize) {
+    Subscriptions subs;
+    if (addEventHandlers(&subs) < 0) {
+        state.fail("Unable to add event handlers");
+        return;
+    }
+    NullMessageChannel channel;
+    uint8_t buf[BUFFER_SIZE] = {};
+    g_handlerCalls = 0;
+    while (state.keepRunning()) {
+        // The message is modified in place by the handler
+        memcpy(buf, msg, msgSize);
+        Message m(buf, sizeof(buf) - 1, msgSize);
+        if (subs.handle_event(m, callEventHandler, channel) != NO_ERROR) {
+            state.fail("Unable to handle event");
+        }
+    }
+    if (g_handlerCalls != state.iterations()) {
+        state.fail("Event handler was not called");
+    }
+    state.setItemsProcessed(state.iterations());
+}
+
+} // namespace
+
+BENCHMARK("communication/Messages::event") {
+    const auto data = sensorData(128);
+    uint8_t buf[BUFFER_SIZE] = {};
+    uint16_t id = 0;
+    while (state.keepRunning()) {
+        doNotOptimize(Messages::event(buf, id++, "sensor/temperature", data.c_str(), 60, EventType::PRIVATE, true));
+        clobberMemory();
+    }
+    state.setBytesProcessed(state.iterations() * data.size());
+}
+
+BENCHMARK("communication/Messages::compressed_event") {
+    const auto data = sensorData(512);
+    uint8_t buf[BUFFER_SIZE] = {};
+    uint16_t id = 0;
+    while (state.keepRunning()) {
+        const size_t n = Messages::compressed_event(buf, sizeof(buf), id++, "sensor/temperature", data.c_str(), 60,
+                EventType::PRIVATE, true);
+        if (!n) {
+            state.fail("Unable to compress event data");
+        }
+        clobberMemory();
+    }
+    state.setBytesProcessed(state.iterations() * data.size());
+}
+
+BENCHMARK("communication/Messages::function_return") {
+    uint8_t buf[BUFFER_SIZE] = {};
+    uint16_t id = 0;
+    while (state.keepRunning()) {
+        doNotOptimize(Messages::function_return(buf, id++, 0x7a, 1234, false));
+        clobberMemory();
+    }
+}
+
+BENCHMARK("communication/Messages::coded_ack") {
+    uint8_t buf[BUFFER_SIZE] = {};
+    const uint8_t data[] = "{\"ok\":true}";
+    uint16_t id = 0;
+    while (state.keepRunning()) {
+        doNotOptimize(Messages::coded_ack(buf, 0x7a, CoAPCode::CONTENT, id >> 8, id & 0xff, (uint8_t*)data, sizeof(data) - 1));
+        ++id;
+        clobberMemory();
+    }
+}
+
+BENCHMARK("communication/CoAPMessageStore::send+receive") {
+    // Keep a number of unacknowledged messages in the store, which is what happens when the
+    // device is publishing events faster than they get acknowledged
+    const size_t PENDING_MESSAGES = 8;
+    NullMessageChannel channel;
+    CoAPMessageStore store;
+    const auto data = sensorData(64);
+    uint8_t buf[BUFFER_SIZE] = {};
+    uint8_t ack[BUFFER_SIZE] = {};
+    message_id_t id = 0;
+    system_tick_t time = 0;
+    auto sendEvent = [&]() {
+        const size_t n = Messages::event(buf, id, "sensor/temperature", data.c_str(), 60, EventType::PRIVATE, true);
+        Message m(buf, sizeof(buf), n);
+        m.set_id(id++);
+        return store.send(m, time++);
+    };
+    for (size_t i = 0; i < PENDING_MESSAGES; ++i) {
+        if (sendEvent() != NO_ERROR) {
+            state.fail("Unable to send message");
+            return;
+        }
+    }
+    while (state.keepRunning()) {
+        if (sendEvent() != NO_ERROR) {
+            state.fail("Unable to send message");
+        }
+        // Acknowledge the oldest message
+        const message_id_t ackId = id - PENDING_MESSAGES - 1;
+        const size_t n = Messages::empty_ack(ack, ackId >> 8, ackId & 0xff);
+        Message m(ack, sizeof(ack), n);
+        if (store.receive(m, channel, time) != NO_ERROR || m.length() == 0) {
+            state.fail("Unable to receive message");
+        }
+    }
+    state.setItemsProcessed(state.iterations());
+}
+
+BENCHMARK("communication/Subscriptions::handle_event") {
+    const auto data = sensorData(256);
+    uint8_t msg[BUFFER_SIZE] = {};
+    const size_t n = Messages::event(msg, 0x1234, "sensor/temperature", data.c_str(), 60, EventType::PUBLIC, false);
+    handleEvent(state, msg, n);
+}
+
+BENCHMARK("communication/Subscriptions::handle_event/compressed") {
+    const auto data = sensorData(512);
+    uint8_t msg[BUFFER_SIZE] = {};
+    const size_t n = Messages::compressed_event(msg, sizeof(msg), 0x1234, "sensor/temperature", data.c_str(), 60,
+            EventType::PUBLIC, false);
+    if (!n) {
+        state.fail("Unable to compress event data");
+        return;
+    }
+    handleEvent(state, msg, n);
+}
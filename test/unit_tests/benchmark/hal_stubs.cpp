@@ -0,0 +1,31 @@
+#include "timer_hal.h"
+#include "diagnostics.h"
+
+#include <chrono>
+#include <cstdlib>
+
+namespace {
+
+const auto start = std::chrono::steady_clock::now();
+
+} // namespace
+
+extern "C" uint32_t HAL_RNG_GetRandomNumber() {
+    return rand();
+}
+
+system_tick_t HAL_Timer_Get_Micro_Seconds() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+system_tick_t HAL_Timer_Get_Milli_Seconds() {
+    return hal_timer_millis(nullptr);
+}
+
+uint64_t hal_timer_millis(void* reserved) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+extern "C" int diag_register_source(const diag_source* src, void* reserved) {
+    return 0;
+}
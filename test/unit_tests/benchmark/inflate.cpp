@@ -0,0 +1,113 @@
+#include "benchmark.h"
+
+#include "inflate.h"
+
+#include <zlib.h>
+
+#include <random>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+using namespace particle::test;
+
+namespace {
+
+// Size of a compressed firmware module is typically a few hundred kilobytes
+const size_t DATA_SIZE = 256 * 1024;
+// Size of a chunk of an OTA update
+const size_t CHUNK_SIZE = 512;
+
+// Generates data that compresses roughly as well as machine code
+std::string genCompressibleData(size_t size) {
+    std::default_random_engine gen(1);
+    std::uniform_int_distribution<unsigned> byte(0, 255);
+    std::vector<std::string> chunks;
+    for (size_t i = 0; i < 64; ++i) {
+        std::string c;
+        const size_t n = std::uniform_int_distribution<size_t>(4, 64)(gen);
+        for (size_t j = 0; j < n; ++j) {
+            c += (char)byte(gen);
+        }
+        chunks.push_back(c);
+    }
+    std::uniform_int_distribution<size_t> index(0, chunks.size() * 2 - 1);
+    std::string d;
+    while (d.size() < size) {
+        const size_t i = index(gen);
+        if (i < chunks.size()) {
+            d += chunks[i];
+        } else {
+            d += (char)byte(gen);
+        }
+    }
+    d.resize(size);
+    return d;
+}
+
+// Compresses data as a raw deflate stream
+std::string deflate(const std::string& data, unsigned windowBits) {
+    z_stream strm = {};
+    if (deflateInit2(&strm, Z_BEST_COMPRESSION, Z_DEFLATED, -(int)windowBits, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return std::string();
+    }
+    std::string out(deflateBound(&strm, data.size()), '\0');
+    strm.next_in = (Bytef*)data.data();
+    strm.avail_in = data.size();
+    strm.next_out = (Bytef*)&out.front();
+    strm.avail_out = out.size();
+    const int r = ::deflate(&strm, Z_FINISH);
+    out.resize(out.size() - strm.avail_out);
+    deflateEnd(&strm);
+    return (r == Z_STREAM_END) ? out : std::string();
+}
+
+int discardOutput(const char* data, size_t size, void* userData) {
+    *(size_t*)userData += size;
+    return size;
+}
+
+void inflateData(BenchmarkState& state, unsigned windowBits) {
+    const auto data = genCompressibleData(DATA_SIZE);
+    const auto compressed = deflate(data, windowBits);
+    if (compressed.empty()) {
+        state.fail("Unable to compress data");
+        return;
+    }
+    size_t outSize = 0;
+    inflate_opts opts = {};
+    opts.window_bits = windowBits;
+    inflate_ctx* ctx = nullptr;
+    if (inflate_create(&ctx, &opts, discardOutput, &outSize) != 0) {
+        state.fail("Unable to create decompressor");
+        return;
+    }
+    while (state.keepRunning()) {
+        inflate_reset(ctx);
+        outSize = 0;
+        size_t offs = 0;
+        int r = 0;
+        do {
+            // Feed the data in chunks, as it is received over the air
+            size_t n = std::min(CHUNK_SIZE, compressed.size() - offs);
+            const bool last = (offs + n == compressed.size());
+            r = inflate_input(ctx, compressed.data() + offs, &n, last ? 0 : INFLATE_HAS_MORE_INPUT);
+            offs += n;
+        } while (r == INFLATE_NEEDS_MORE_INPUT || r == INFLATE_HAS_MORE_OUTPUT);
+        if (r != INFLATE_DONE || outSize != data.size()) {
+            state.fail("Unable to decompress data");
+        }
+    }
+    inflate_destroy(ctx);
+    state.setBytesProcessed(state.iterations() * data.size());
+}
+
+} // namespace
+
+BENCHMARK("hal/inflate") {
+    inflateData(state, INFLATE_MAX_WINDOW_BITS);
+}
+
+BENCHMARK("hal/inflate/window_bits=12") {
+    inflateData(state, 12);
+}
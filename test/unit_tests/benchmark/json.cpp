@@ -0,0 +1,105 @@
+#include "benchmark.h"
+
+#include "spark_wiring_json.h"
+
+#include <cstring>
+
+using namespace spark;
+using namespace particle::test;
+
+namespace {
+
+// Configuration-like document with nested containers, escaped strings and numbers of various
+// types, similar to what is typically received in a function call or a subscription event
+const char JSON_DOC[] = R"JSON({
+    "version": 3,
+    "enabled": true,
+    "name": "Weather station \"north\"",
+    "location": { "lat": 47.6205, "lon": -122.3493, "alt": 184.2 },
+    "interval": 300,
+    "thresholds": [ -10.5, 0, 12.75, 25, 38.125 ],
+    "sensors": [
+        { "id": "temp0", "type": "temperature", "unit": "C", "calibration": [ 1.002, -0.15 ] },
+        { "id": "hum0", "type": "humidity", "unit": "%", "calibration": [ 0.998, 1.2 ] },
+        { "id": "pres0", "type": "pressure", "unit": "hPa", "calibration": [ 1.0, 0.0 ] }
+    ],
+    "tags": [ "outdoor", "roof", "batch\/7", "unicode é" ],
+    "notes": null
+})JSON";
+
+double sumNumbers(const JSONValue& val) {
+    double sum = 0;
+    if (val.isNumber()) {
+        sum = val.toDouble();
+    } else if (val.isArray()) {
+        JSONArrayIterator it(val);
+        while (it.next()) {
+            sum += sumNumbers(it.value());
+        }
+    } else if (val.isObject()) {
+        JSONObjectIterator it(val);
+        while (it.next()) {
+            sum += it.name().size();
+            sum += sumNumbers(it.value());
+        }
+    } else if (val.isString()) {
+        sum = val.toString().size();
+    }
+    return sum;
+}
+
+} // namespace
+
+BENCHMARK("wiring/JSONValue::parseCopy") {
+    while (state.keepRunning()) {
+        const auto val = JSONValue::parseCopy(JSON_DOC, sizeof(JSON_DOC) - 1);
+        if (!val.isObject()) {
+            state.fail("Unable to parse JSON");
+        }
+        doNotOptimize(val);
+    }
+    state.setBytesProcessed(state.iterations() * (sizeof(JSON_DOC) - 1));
+}
+
+BENCHMARK("wiring/JSONValue::parse") {
+    char buf[sizeof(JSON_DOC)] = {};
+    while (state.keepRunning()) {
+        // The document is modified in place by the parser
+        memcpy(buf, JSON_DOC, sizeof(JSON_DOC));
+        const auto val = JSONValue::parse(buf, sizeof(JSON_DOC) - 1);
+        if (!val.isObject()) {
+            state.fail("Unable to parse JSON");
+        }
+        doNotOptimize(val);
+    }
+    state.setBytesProcessed(state.iterations() * (sizeof(JSON_DOC) - 1));
+}
+
+BENCHMARK("wiring/JSONValue::parseCopy+iterate") {
+    while (state.keepRunning()) {
+        const auto val = JSONValue::parseCopy(JSON_DOC, sizeof(JSON_DOC) - 1);
+        doNotOptimize(sumNumbers(val));
+    }
+    state.setBytesProcessed(state.iterations() * (sizeof(JSON_DOC) - 1));
+}
+
+BENCHMARK("wiring/JSONBufferWriter") {
+    char buf[512] = {};
+    while (state.keepRunning()) {
+        JSONBufferWriter w(buf, sizeof(buf));
+        w.beginObject();
+        w.name("name").value("Weather station \"north\"");
+        w.name("interval").value(300);
+        w.name("temp").value(21.375, 3);
+        w.name("sensors").beginArray();
+        for (int i = 0; i < 3; ++i) {
+            w.beginObject().name("id").value(i).name("ok").value(true).endObject();
+        }
+        w.endArray();
+        w.endObject();
+        if (w.dataSize() > w.bufferSize()) {
+            state.fail("Buffer is too small");
+        }
+        clobberMemory();
+    }
+}
@@ -0,0 +1,96 @@
+#include "benchmark.h"
+
+#include "logging.h"
+
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+
+using namespace particle::test;
+
+namespace {
+
+const char* const CATEGORY = "comm.protocol";
+
+char g_output[LOG_MAX_STRING_LENGTH * 2];
+size_t g_outputSize = 0;
+
+// Formats messages the same way as the default log handler
+void logMessage(const char* msg, int level, const char* category, const LogAttributes* attr, void* reserved) {
+    const int n = snprintf(g_output, sizeof(g_output), "%010u [%s] %s: %s\r\n", (unsigned)attr->time,
+            category ? category : "", log_level_name(level, nullptr), msg);
+    g_outputSize += n;
+}
+
+void logWrite(const char* data, size_t size, int level, const char* category, void* reserved) {
+    memcpy(g_output, data, std::min(size, sizeof(g_output)));
+    g_outputSize += size;
+}
+
+int logEnabled(int level, const char* category, void* reserved) {
+    // Only the messages of the INFO level and higher are enabled
+    return level >= LOG_LEVEL_INFO;
+}
+
+class LogCallbacks {
+public:
+    LogCallbacks() {
+        g_outputSize = 0;
+        log_set_callbacks(logMessage, logWrite, logEnabled, nullptr);
+    }
+
+    ~LogCallbacks() {
+        log_set_callbacks(nullptr, nullptr, nullptr, nullptr);
+    }
+};
+
+// Generates a message the same way as the LOG() macro
+template<typename... ArgsT>
+void logAttr(int level, const char* fmt, ArgsT... args) {
+    if (!log_enabled(level, CATEGORY, nullptr)) {
+        return;
+    }
+    LogAttributes attr = {};
+    attr.size = sizeof(LogAttributes);
+    LOG_ATTR_SET(attr, file, __FILE__);
+    LOG_ATTR_SET(attr, line, __LINE__);
+    LOG_ATTR_SET(attr, function, __func__);
+    log_message(level, CATEGORY, &attr, nullptr, fmt, args...);
+}
+
+} // namespace
+
+BENCHMARK("services/log_message") {
+    LogCallbacks cb;
+    unsigned id = 0;
+    while (state.keepRunning()) {
+        logAttr(LOG_LEVEL_INFO, "Received message, ID: %u, type: %d, size: %u", id++, 2, 64u);
+    }
+    if (!g_outputSize) {
+        state.fail("Log handler was not called");
+    }
+    state.setBytesProcessed(g_outputSize);
+}
+
+BENCHMARK("services/log_message/disabled") {
+    LogCallbacks cb;
+    unsigned id = 0;
+    while (state.keepRunning()) {
+        logAttr(LOG_LEVEL_TRACE, "Received message, ID: %u, type: %d, size: %u", id++, 2, 64u);
+    }
+    if (g_outputSize) {
+        state.fail("Log handler was called");
+    }
+}
+
+BENCHMARK("services/log_dump") {
+    LogCallbacks cb;
+    uint8_t data[64] = {};
+    for (size_t i = 0; i < sizeof(data); ++i) {
+        data[i] = i;
+    }
+    while (state.keepRunning()) {
+        log_dump(LOG_LEVEL_INFO, CATEGORY, data, sizeof(data), 0, nullptr);
+    }
+    state.setBytesProcessed(state.iterations() * sizeof(data));
+}
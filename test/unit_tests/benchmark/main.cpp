@@ -0,0 +1,251 @@
+#include "benchmark.h"
+
+#include "system_version.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <cstring>
+#include <cstdlib>
+#include <ctime>
+
+using namespace particle::test;
+
+namespace {
+
+const unsigned DEFAULT_MIN_TIME_MS = 200;
+const uint64_t MAX_ITERATIONS = 1000000000;
+
+struct Options {
+    std::string filter;
+    std::string jsonFile;
+    unsigned minTimeMs = DEFAULT_MIN_TIME_MS;
+    unsigned repetitions = 1;
+    bool list = false;
+};
+
+struct Result {
+    std::string name;
+    std::string error;
+    uint64_t iterations = 0;
+    double nsPerOp = 0; // Median of all repetitions
+    double nsPerOpMin = 0;
+    double nsPerOpMax = 0;
+    double bytesPerSec = 0;
+    double itemsPerSec = 0;
+};
+
+void printUsage(const char* prog) {
+    std::cerr << "Usage: " << prog << " [options]\n"
+            "  --filter <str>     Run only the benchmarks whose names contain <str>\n"
+            "  --min-time <ms>    Minimum measured time per benchmark (default: " << DEFAULT_MIN_TIME_MS << ")\n"
+            "  --repetitions <n>  Number of times to run each benchmark (default: 1)\n"
+            "  --json <file>      Write the results to a JSON file (\"-\" for stdout)\n"
+            "  --list             List the benchmarks\n";
+}
+
+bool parseArgs(int argc, char* argv[], Options* opts) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const char* val = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        if (!strcmp(arg, "--list")) {
+            opts->list = true;
+            continue;
+        }
+        if (!val) {
+            return false;
+        }
+        if (!strcmp(arg, "--filter")) {
+            opts->filter = val;
+        } else if (!strcmp(arg, "--min-time")) {
+            opts->minTimeMs = strtoul(val, nullptr, 10);
+        } else if (!strcmp(arg, "--repetitions")) {
+            opts->repetitions = std::max(strtoul(val, nullptr, 10), 1ul);
+        } else if (!strcmp(arg, "--json")) {
+            opts->jsonFile = val;
+        } else {
+            return false;
+        }
+        ++i;
+    }
+    return true;
+}
+
+// Runs a benchmark for at least the specified amount of time
+BenchmarkState runOnce(const Benchmark& bench, std::chrono::nanoseconds minTime) {
+    uint64_t iters = 1;
+    for (;;) {
+        BenchmarkState state(iters);
+        bench.fn(state);
+        const auto t = state.elapsed();
+        if (state.failed() || t >= minTime || iters >= MAX_ITERATIONS) {
+            return state;
+        }
+        // Estimate the number of iterations needed to reach the minimum time, but don't grow
+        // too fast as the first runs are usually not representative
+        uint64_t n = iters * 10;
+        if (t.count() > 0) {
+            n = std::min<uint64_t>(n, (double)minTime.count() / t.count() * iters * 1.4);
+        }
+        iters = std::min(std::max(n, iters + 1), MAX_ITERATIONS);
+    }
+}
+
+Result run(const Benchmark& bench, const Options& opts) {
+    Result result;
+    result.name = bench.name;
+    const auto minTime = std::chrono::milliseconds(opts.minTimeMs);
+    std::vector<double> nsPerOp;
+    for (unsigned i = 0; i < opts.repetitions; ++i) {
+        const auto state = runOnce(bench, minTime);
+        if (state.failed()) {
+            result.error = state.error();
+            return result;
+        }
+        if (state.iterations() == 0) {
+            result.error = "No iterations were run";
+            return result;
+        }
+        const double ns = state.elapsed().count();
+        const double sec = ns / 1e9;
+        nsPerOp.push_back(ns / state.iterations());
+        result.iterations = state.iterations();
+        if (sec > 0) {
+            result.bytesPerSec = state.bytesProcessed() / sec;
+            result.itemsPerSec = state.itemsProcessed() / sec;
+        }
+    }
+    std::sort(nsPerOp.begin(), nsPerOp.end());
+    result.nsPerOp = nsPerOp[nsPerOp.size() / 2];
+    result.nsPerOpMin = nsPerOp.front();
+    result.nsPerOpMax = nsPerOp.back();
+    return result;
+}
+
+std::string escapeJson(const std::string& str) {
+    std::ostringstream s;
+    for (char c: str) {
+        if (c == '"' || c == '\\') {
+            s << '\\' << c;
+        } else if ((unsigned char)c < 0x20) {
+            s << "\\u" << std::hex << std::setw(4) << std::setfill('0') << (unsigned)c << std::dec;
+        } else {
+            s << c;
+        }
+    }
+    return s.str();
+}
+
+void writeJson(std::ostream& out, const std::vector<Result>& results, const Options& opts) {
+    char date[32] = {};
+    const time_t t = time(nullptr);
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", gmtime(&t));
+    char version[16] = {};
+    snprintf(version, sizeof(version), "0x%08x", (unsigned)SYSTEM_VERSION);
+    out << "{\n";
+    out << "  \"context\": {\n";
+    out << "    \"date\": \"" << date << "\",\n";
+    out << "    \"system_version\": \"" << version << "\",\n";
+    out << "    \"compiler\": \"" << escapeJson(__VERSION__) << "\",\n";
+    out << "    \"min_time_ms\": " << opts.minTimeMs << ",\n";
+    out << "    \"repetitions\": " << opts.repetitions << "\n";
+    out << "  },\n";
+    out << "  \"benchmarks\": [";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const auto& r = results[i];
+        out << (i ? ",\n" : "\n") << "    {\"name\": \"" << escapeJson(r.name) << "\"";
+        if (!r.error.empty()) {
+            out << ", \"error\": \"" << escapeJson(r.error) << "\"}";
+            continue;
+        }
+        out << std::fixed << std::setprecision(2);
+        out << ", \"iterations\": " << r.iterations;
+        out << ", \"ns_per_op\": " << r.nsPerOp;
+        out << ", \"ns_per_op_min\": " << r.nsPerOpMin;
+        out << ", \"ns_per_op_max\": " << r.nsPerOpMax;
+        if (r.bytesPerSec > 0) {
+            out << ", \"bytes_per_second\": " << r.bytesPerSec;
+        }
+        if (r.itemsPerSec > 0) {
+            out << ", \"items_per_second\": " << r.itemsPerSec;
+        }
+        out << "}";
+    }
+    out << "\n  ]\n}\n";
+}
+
+void printResult(std::ostream& out, const Result& r) {
+    out << std::left << std::setw(56) << r.name << std::right;
+    if (!r.error.empty()) {
+        out << " FAILED: " << r.error << std::endl;
+        return;
+    }
+    out << std::fixed << std::setprecision(1) << std::setw(14) << r.nsPerOp << " ns/op" << std::setw(12) << r.iterations;
+    if (r.bytesPerSec > 0) {
+        out << std::setprecision(2) << std::setw(12) << r.bytesPerSec / (1024 * 1024) << " MB/s";
+    } else if (r.itemsPerSec > 0) {
+        out << std::setprecision(2) << std::setw(12) << r.itemsPerSec / 1e6 << " M/s";
+    }
+    out << std::endl;
+}
+
+} // namespace
+
+particle::test::BenchmarkRegistrar::BenchmarkRegistrar(const char* name, BenchmarkFn fn) {
+    registry().push_back({ name, fn });
+}
+
+const std::vector<Benchmark>& particle::test::BenchmarkRegistrar::benchmarks() {
+    return registry();
+}
+
+std::vector<Benchmark>& particle::test::BenchmarkRegistrar::registry() {
+    static std::vector<Benchmark> r;
+    return r;
+}
+
+int main(int argc, char* argv[]) {
+    Options opts;
+    if (!parseArgs(argc, argv, &opts)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    auto benchmarks = BenchmarkRegistrar::benchmarks();
+    std::stable_sort(benchmarks.begin(), benchmarks.end(), [](const Benchmark& b1, const Benchmark& b2) {
+        return b1.name < b2.name;
+    });
+    if (opts.list) {
+        for (const auto& b: benchmarks) {
+            std::cout << b.name << std::endl;
+        }
+        return 0;
+    }
+    // Print the results to stderr if the JSON data is written to stdout
+    std::ostream& out = (opts.jsonFile == "-") ? std::cerr : std::cout;
+    std::vector<Result> results;
+    bool ok = true;
+    for (const auto& b: benchmarks) {
+        if (!opts.filter.empty() && b.name.find(opts.filter) == std::string::npos) {
+            continue;
+        }
+        const auto r = run(b, opts);
+        printResult(out, r);
+        if (!r.error.empty()) {
+            ok = false;
+        }
+        results.push_back(r);
+    }
+    if (opts.jsonFile == "-") {
+        writeJson(std::cout, results, opts);
+    } else if (!opts.jsonFile.empty()) {
+        std::ofstream f(opts.jsonFile);
+        writeJson(f, results, opts);
+        if (!f) {
+            std::cerr << "Unable to write " << opts.jsonFile << std::endl;
+            return 1;
+        }
+    }
+    return ok ? 0 : 1;
+}
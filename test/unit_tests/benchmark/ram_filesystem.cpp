@@ -0,0 +1,115 @@
+/*
+ * RAM-backed implementation of the filesystem HAL used by the benchmarks. The configuration
+ * matches the one used on Gen 3 devices, so the number of block device operations performed by
+ * littlefs is the same as on the device.
+ */
+
+#include "filesystem.h"
+
+#include <cstring>
+
+namespace {
+
+const size_t BLOCK_SIZE = 4096;
+const size_t BLOCK_COUNT = 128;
+
+uint8_t g_storage[BLOCK_SIZE * BLOCK_COUNT];
+
+filesystem_t g_instance = {};
+
+int fsRead(const struct lfs_config* c, lfs_block_t block, lfs_off_t off, void* buffer, lfs_size_t size) {
+    memcpy(buffer, g_storage + block * c->block_size + off, size);
+    return 0;
+}
+
+int fsProg(const struct lfs_config* c, lfs_block_t block, lfs_off_t off, const void* buffer, lfs_size_t size) {
+    // NOR flash can only clear bits
+    uint8_t* dest = g_storage + block * c->block_size + off;
+    const uint8_t* src = (const uint8_t*)buffer;
+    for (size_t i = 0; i < size; ++i) {
+        dest[i] &= src[i];
+    }
+    return 0;
+}
+
+int fsErase(const struct lfs_config* c, lfs_block_t block) {
+    memset(g_storage + block * c->block_size, 0xff, c->block_size);
+    return 0;
+}
+
+int fsSync(const struct lfs_config* c) {
+    return 0;
+}
+
+} // namespace
+
+int filesystem_mount(filesystem_t* fs) {
+    if (fs->state) {
+        return 0;
+    }
+    fs->config.context = fs;
+    fs->config.read = fsRead;
+    fs->config.prog = fsProg;
+    fs->config.erase = fsErase;
+    fs->config.sync = fsSync;
+    fs->config.read_size = FILESYSTEM_READ_SIZE;
+    fs->config.prog_size = FILESYSTEM_PROG_SIZE;
+    fs->config.block_size = BLOCK_SIZE;
+    fs->config.block_count = BLOCK_COUNT;
+    fs->config.lookahead = FILESYSTEM_LOOKAHEAD;
+    int r = lfs_mount(&fs->instance, &fs->config);
+    if (r) {
+        memset(g_storage, 0xff, sizeof(g_storage));
+        r = lfs_format(&fs->instance, &fs->config);
+        if (!r) {
+            r = lfs_mount(&fs->instance, &fs->config);
+        }
+    }
+    if (!r) {
+        fs->state = true;
+        r = lfs_mkdir(&fs->instance, "/usr");
+        if (r == LFS_ERR_EXIST) {
+            r = 0;
+        }
+    }
+    return r;
+}
+
+int filesystem_unmount(filesystem_t* fs) {
+    if (!fs->state) {
+        return 0;
+    }
+    fs->state = false;
+    return lfs_unmount(&fs->instance);
+}
+
+filesystem_t* filesystem_get_instance(void* reserved) {
+    return &g_instance;
+}
+
+int filesystem_dump_info(filesystem_t* fs) {
+    return 0;
+}
+
+int filesystem_lock(filesystem_t* fs) {
+    return 0;
+}
+
+int filesystem_unlock(filesystem_t* fs) {
+    return 0;
+}
+
+// Same as the device implementation in hal/src/nRF52840/littlefs/lfs_utils.cpp
+void lfs_crc(uint32_t* __restrict__ crc, const void* buffer, size_t size) {
+    static const uint32_t rtable[16] = {
+        0x00000000, 0x1db71064, 0x3b6e20c8, 0x26d930ac,
+        0x76dc4190, 0x6b6b51f4, 0x4db26158, 0x5005713c,
+        0xedb88320, 0xf00f9344, 0xd6d6a3e8, 0xcb61b38c,
+        0x9b64c2b0, 0x86d3d2d4, 0xa00ae278, 0xbdbdf21c,
+    };
+    const uint8_t* data = (const uint8_t*)buffer;
+    for (size_t i = 0; i < size; i++) {
+        *crc = (*crc >> 4) ^ rtable[(*crc ^ (data[i] >> 0)) & 0xf];
+        *crc = (*crc >> 4) ^ rtable[(*crc ^ (data[i] >> 4)) & 0xf];
+    }
+}
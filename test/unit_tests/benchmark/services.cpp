@@ -0,0 +1,109 @@
+#include "benchmark.h"
+
+#include "ringbuffer.h"
+#include "spsc_ringbuffer.h"
+#include "varint.h"
+
+#include <random>
+#include <vector>
+
+using namespace particle;
+using namespace particle::services;
+using namespace particle::test;
+
+namespace {
+
+const size_t RING_BUFFER_SIZE = 1024;
+// Typical size of a chunk of data received from a UART or a network socket
+const size_t CHUNK_SIZE = 61;
+
+std::vector<uint32_t> randomValues(size_t count) {
+    std::default_random_engine gen(1);
+    std::vector<uint32_t> v;
+    v.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        // Skew the distribution towards smaller values, which are more common in practice
+        const unsigned bits = std::uniform_int_distribution<unsigned>(1, 32)(gen);
+        v.push_back(std::uniform_int_distribution<uint32_t>(0, (1ull << bits) - 1)(gen));
+    }
+    return v;
+}
+
+} // namespace
+
+BENCHMARK("services/RingBuffer::put+get") {
+    std::vector<char> buf(RING_BUFFER_SIZE);
+    RingBuffer<char> rb(buf.data(), buf.size());
+    char in[CHUNK_SIZE] = {};
+    char out[CHUNK_SIZE] = {};
+    while (state.keepRunning()) {
+        if (rb.put(in, sizeof(in)) != sizeof(in) || rb.get(out, sizeof(out)) != sizeof(out)) {
+            state.fail("Unexpected ring buffer state");
+        }
+        clobberMemory();
+    }
+    state.setBytesProcessed(state.iterations() * CHUNK_SIZE);
+}
+
+BENCHMARK("services/RingBuffer::acquire+consume") {
+    std::vector<char> buf(RING_BUFFER_SIZE);
+    RingBuffer<char> rb(buf.data(), buf.size());
+    while (state.keepRunning()) {
+        // This is how the ring buffer is used by DMA-based drivers
+        rb.acquireBegin();
+        const size_t n = std::min(rb.acquirable(), CHUNK_SIZE);
+        doNotOptimize(rb.acquire(n));
+        rb.acquireCommit(n);
+        const size_t m = std::min(rb.consumable(), CHUNK_SIZE);
+        doNotOptimize(rb.consume(m));
+        rb.consumeCommit(m);
+    }
+    state.setBytesProcessed(state.iterations() * CHUNK_SIZE);
+}
+
+BENCHMARK("services/SpscRingBuffer::put+get") {
+    std::vector<char> buf(RING_BUFFER_SIZE);
+    SpscRingBuffer<char> rb(buf.data(), buf.size());
+    char in[CHUNK_SIZE] = {};
+    char out[CHUNK_SIZE] = {};
+    while (state.keepRunning()) {
+        if (rb.put(in, sizeof(in)) != sizeof(in) || rb.get(out, sizeof(out)) != sizeof(out)) {
+            state.fail("Unexpected ring buffer state");
+        }
+        clobberMemory();
+    }
+    state.setBytesProcessed(state.iterations() * CHUNK_SIZE);
+}
+
+BENCHMARK("services/encodeUnsignedVarint") {
+    const auto values = randomValues(1024);
+    char buf[maxUnsignedVarintSize<uint32_t>()] = {};
+    size_t i = 0;
+    while (state.keepRunning()) {
+        doNotOptimize(encodeUnsignedVarint(buf, sizeof(buf), values[i++ % values.size()]));
+        clobberMemory();
+    }
+    state.setItemsProcessed(state.iterations());
+}
+
+BENCHMARK("services/decodeUnsignedVarint") {
+    const auto values = randomValues(1024);
+    std::vector<char> encoded;
+    std::vector<size_t> offsets;
+    for (uint32_t v: values) {
+        char buf[maxUnsignedVarintSize<uint32_t>()] = {};
+        const int n = encodeUnsignedVarint(buf, sizeof(buf), v);
+        offsets.push_back(encoded.size());
+        encoded.insert(encoded.end(), buf, buf + n);
+    }
+    size_t i = 0;
+    while (state.keepRunning()) {
+        const size_t offs = offsets[i++ % offsets.size()];
+        uint32_t v = 0;
+        if (decodeUnsignedVarint(encoded.data() + offs, encoded.size() - offs, &v) < 0) {
+            state.fail("Unable to decode value");
+        }
+        doNotOptimize(v);
+    }
+    state.setItemsProcessed(state.iterations());
+}
@@ -0,0 +1,100 @@
+#include "benchmark.h"
+
+#include "tlv_file.h"
+#include "system_error.h"
+
+#include <cstring>
+
+using namespace particle::services::settings;
+using namespace particle::test;
+
+namespace {
+
+const char* const TLV_FILE_PATH = "/sys/benchmark.dat";
+
+// Number of entries in the file, which is similar to the number of settings stored by the system
+const unsigned ENTRY_COUNT = 16;
+const uint16_t VALUE_SIZE = 32;
+
+int initFile(TlvFile* file) {
+    // Note: TlvFile::init() mounts the filesystem in an assertion, which is compiled out in
+    // release builds
+    int r = filesystem_mount(filesystem_get_instance(nullptr));
+    if (r < 0) {
+        return r;
+    }
+    r = file->init();
+    if (r < 0) {
+        return r;
+    }
+    // Start with an empty file
+    file->purge();
+    r = file->init();
+    if (r < 0) {
+        return r;
+    }
+    uint8_t val[VALUE_SIZE] = {};
+    for (unsigned i = 0; i < ENTRY_COUNT; ++i) {
+        memset(val, i, sizeof(val));
+        r = file->add(i, val, sizeof(val));
+        if (r < 0) {
+            return r;
+        }
+    }
+    return 0;
+}
+
+} // namespace
+
+BENCHMARK("services/TlvFile::get") {
+    TlvFile file(TLV_FILE_PATH);
+    if (initFile(&file) < 0) {
+        state.fail("Unable to initialize file");
+        return;
+    }
+    uint8_t val[VALUE_SIZE] = {};
+    unsigned key = 0;
+    while (state.keepRunning()) {
+        if (file.get(key, val, sizeof(val)) != VALUE_SIZE) {
+            state.fail("Unable to read entry");
+        }
+        key = (key + 1) % ENTRY_COUNT;
+    }
+    file.deInit();
+    state.setItemsProcessed(state.iterations());
+}
+
+BENCHMARK("services/TlvFile::set") {
+    TlvFile file(TLV_FILE_PATH);
+    if (initFile(&file) < 0) {
+        state.fail("Unable to initialize file");
+        return;
+    }
+    uint8_t val[VALUE_SIZE] = {};
+    unsigned key = 0;
+    while (state.keepRunning()) {
+        memset(val, key + 1, sizeof(val));
+        if (file.set(key, val, sizeof(val)) < 0) {
+            state.fail("Unable to write entry");
+        }
+        key = (key + 1) % ENTRY_COUNT;
+    }
+    file.deInit();
+    state.setItemsProcessed(state.iterations());
+}
+
+BENCHMARK("services/TlvFile::add+del") {
+    TlvFile file(TLV_FILE_PATH);
+    if (initFile(&file) < 0) {
+        state.fail("Unable to initialize file");
+        return;
+    }
+    uint8_t val[VALUE_SIZE] = {};
+    while (state.keepRunning()) {
+        if (file.add(ENTRY_COUNT, val, sizeof(val)) < 0 || file.del(ENTRY_COUNT, 0) < 0) {
+            state.fail("Unable to update file");
+        }
+    }
+    file.deInit();
+    state.setItemsProcessed(state.iterations());
+}
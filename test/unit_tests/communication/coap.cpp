@@ -89,3 +89,54 @@ SCENARIO("CoAP::path is retrieved from a CoAP message")
 	}
 }
 
+
+SCENARIO("CoAP::block_option encodes and decodes Block2 options")
+{
+	GIVEN("a buffer for a message with a Block2 option")
+	{
+		uint8_t msg[16] = { 0x41, 0x45, 0x00, 0x00, 0x01 }; // Separate response with a one-byte token
+		WHEN("the option is encoded and then decoded")
+		{
+			const size_t size = 5 + CoAP::block_option(msg + 5, CoAPOption::NONE, CoAPOption::BLOCK2, 1234, true, 5);
+			const uint8_t* value = nullptr;
+			size_t value_size = 0;
+			REQUIRE(CoAP::find_option(msg, size, CoAPOption::BLOCK2, &value, &value_size));
+			uint32_t num = 0;
+			bool more = false;
+			uint8_t szx = 0;
+			REQUIRE(CoAP::decode_block_option(value, value_size, &num, &more, &szx));
+			THEN("the decoded fields match the original values")
+			{
+				REQUIRE(value_size == 2);
+				REQUIRE(num == 1234);
+				REQUIRE(more == true);
+				REQUIRE(szx == 5);
+				REQUIRE(CoAP::block_size(szx) == 512);
+			}
+		}
+		WHEN("the first block is encoded")
+		{
+			const size_t size = 5 + CoAP::block_option(msg + 5, CoAPOption::NONE, CoAPOption::BLOCK2, 0, false, 0);
+			const uint8_t* value = nullptr;
+			size_t value_size = 0;
+			THEN("the option value is empty")
+			{
+				REQUIRE(CoAP::find_option(msg, size, CoAPOption::BLOCK2, &value, &value_size));
+				REQUIRE(value_size == 0);
+			}
+		}
+	}
+	GIVEN("a message with Uri-Path options only")
+	{
+		const uint8_t msg[] = { 0x40, 0x01, 0x12, 0x34, 0xb1, 'v', 0x03, 'f', 'o', 'o' };
+		THEN("the Block2 option is not found")
+		{
+			const uint8_t* value = nullptr;
+			size_t value_size = 0;
+			REQUIRE_FALSE(CoAP::find_option(msg, sizeof(msg), CoAPOption::BLOCK2, &value, &value_size));
+			REQUIRE(CoAP::find_option(msg, sizeof(msg), CoAPOption::URI_PATH, &value, &value_size));
+			REQUIRE(value_size == 1);
+			REQUIRE(value[0] == 'v');
+		}
+	}
+}
@@ -18,6 +18,8 @@
  */
 
 #include "messages.h"
+#include <string>
+#include <cstring>
 
 #include <catch2/catch.hpp>
 
@@ -290,3 +292,118 @@ SCENARIO("confirmable messages")
 	}
 
 }
+
+SCENARIO("encoding an event with a compressed payload")
+{
+	const char data[] = "{\"t\":21.5,\"h\":40,\"p\":1013}{\"t\":21.5,\"h\":40,\"p\":1013}{\"t\":21.5,\"h\":40,\"p\":1013}";
+	uint8_t buf[256] = {};
+	WHEN("the payload is compressible")
+	{
+		const size_t plain_len = Messages::event(buf, 0x1234, "e", data, 120, EventType::PRIVATE, true);
+		const size_t len = Messages::compressed_event(buf, sizeof(buf), 0x1234, "e", data, 120, EventType::PRIVATE, true);
+		THEN("the message is smaller than an uncompressed one")
+		{
+			REQUIRE(len > 0);
+			REQUIRE(len < plain_len);
+		}
+		THEN("the message has a Content-Format option followed by a Max-Age option")
+		{
+			const uint8_t* value = nullptr;
+			size_t size = 0;
+			REQUIRE(CoAP::find_option(buf, len, CoAPOption::CONTENT_FORMAT, &value, &size));
+			REQUIRE(size == 2);
+			REQUIRE(((value[0] << 8) | value[1]) == CoAPContentFormat::DEFLATE);
+			REQUIRE(CoAP::find_option(buf, len, 14 /* Max-Age */, &value, &size));
+			REQUIRE(size == 3);
+			REQUIRE(value[2] == 120);
+			const uint8_t* payload = nullptr;
+			REQUIRE(CoAP::find_payload(buf, len, &payload, &size));
+			REQUIRE(payload + size == buf + len);
+		}
+	}
+	WHEN("the payload is too short")
+	{
+		THEN("no message is encoded")
+		{
+			REQUIRE(Messages::compressed_event(buf, sizeof(buf), 0x1234, "e", "abcabc", 60, EventType::PRIVATE, true) == 0);
+		}
+	}
+	WHEN("the buffer is too small for the compressed payload")
+	{
+		THEN("no message is encoded")
+		{
+			REQUIRE(Messages::compressed_event(buf, 16, 0x1234, "e", data, 60, EventType::PRIVATE, true) == 0);
+		}
+	}
+	WHEN("the payload size is given explicitly")
+	{
+		const std::string prefix(data, 52);
+		uint8_t expected[256] = {};
+		const size_t expected_len = Messages::compressed_event(expected, sizeof(expected), 0x1234, "e", prefix.c_str(), 60,
+				EventType::PRIVATE, true);
+		const size_t len = Messages::compressed_event(buf, sizeof(buf), 0x1234, "e", data, prefix.size(), 60,
+				EventType::PRIVATE, true);
+		THEN("only the given number of bytes is compressed")
+		{
+			REQUIRE(expected_len > 0);
+			REQUIRE(len == expected_len);
+			REQUIRE(memcmp(buf, expected, len) == 0);
+		}
+	}
+}
+
+SCENARIO("encoding the header of a Block2 response")
+{
+	uint8_t buf[Messages::MAX_BLOCK2_RESPONSE_HEADER_SIZE] = {};
+	WHEN("the first block of the smallest size is followed by more blocks")
+	{
+		const size_t len = Messages::block2_response_header(buf, 0x1234, 0x01, CoAPCode::CONTENT, 0 /* block_num */,
+				true /* more */, 0 /* szx */, true);
+		THEN("the Block2 option has the more flag set")
+		{
+			const uint8_t* value = nullptr;
+			size_t size = 0;
+			REQUIRE(CoAP::find_option(buf, len, CoAPOption::BLOCK2, &value, &size));
+			uint32_t num = 1;
+			bool more = false;
+			uint8_t szx = 1;
+			REQUIRE(CoAP::decode_block_option(value, size, &num, &more, &szx));
+			REQUIRE(num == 0);
+			REQUIRE(more);
+			REQUIRE(szx == 0);
+			REQUIRE(buf[len - 1] == 0xff);
+		}
+		THEN("the header is one byte larger than the header of the last block")
+		{
+			uint8_t last[Messages::MAX_BLOCK2_RESPONSE_HEADER_SIZE] = {};
+			const size_t last_len = Messages::block2_response_header(last, 0x1234, 0x01, CoAPCode::CONTENT, 0 /* block_num */,
+					false /* more */, 0 /* szx */, true);
+			REQUIRE(len == last_len + 1);
+		}
+	}
+	WHEN("the header has an ETag")
+	{
+		const uint8_t etag[Messages::MAX_BLOCK2_ETAG_SIZE] = { 0x01, 0x02, 0x03, 0x04 };
+		const size_t len = Messages::block2_response_header(buf, 0x1234, 0x01, CoAPCode::CONTENT, 0x12345 /* block_num */,
+				true /* more */, 6 /* szx */, true, etag, sizeof(etag));
+		THEN("the header includes the ETag and Block2 options")
+		{
+			const size_t max_len = Messages::MAX_BLOCK2_RESPONSE_HEADER_SIZE;
+			REQUIRE(len == max_len);
+			const uint8_t* value = nullptr;
+			size_t size = 0;
+			REQUIRE(CoAP::find_option(buf, len, CoAPOption::ETAG, &value, &size));
+			REQUIRE(size == sizeof(etag));
+			REQUIRE(memcmp(value, etag, sizeof(etag)) == 0);
+			REQUIRE(CoAP::find_option(buf, len, CoAPOption::BLOCK2, &value, &size));
+			uint32_t num = 0;
+			bool more = false;
+			uint8_t szx = 0;
+			REQUIRE(CoAP::decode_block_option(value, size, &num, &more, &szx));
+			REQUIRE(num == 0x12345);
+			REQUIRE(more);
+			REQUIRE(szx == 6);
+			REQUIRE(buf[len - 1] == 0xff);
+		}
+	}
+}
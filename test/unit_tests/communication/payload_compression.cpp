@@ -0,0 +1,86 @@
+#include "payload_compression.h"
+#include "system_error.h"
+
+#include <zlib.h>
+
+#include <random>
+#include <string>
+
+#include <catch2/catch.hpp>
+
+using namespace particle::protocol;
+
+namespace {
+
+std::string compress(const std::string& data, size_t maxSize = 1024) {
+    std::string buf(maxSize, '\0');
+    const int r = compress_payload(data.data(), data.size(), &buf.front(), buf.size());
+    REQUIRE(r >= 0);
+    buf.resize(r);
+    return buf;
+}
+
+std::string decompress(const std::string& data) {
+    z_stream strm = {};
+    REQUIRE(inflateInit2(&strm, -(int)PAYLOAD_COMPRESSION_WINDOW_BITS) == Z_OK);
+    std::string out(4096, '\0');
+    strm.next_in = (Bytef*)data.data();
+    strm.avail_in = data.size();
+    strm.next_out = (Bytef*)&out.front();
+    strm.avail_out = out.size();
+    const int r = inflate(&strm, Z_FINISH);
+    inflateEnd(&strm);
+    REQUIRE(r == Z_STREAM_END);
+    REQUIRE(strm.avail_in == 0);
+    out.resize(out.size() - strm.avail_out);
+    return out;
+}
+
+} // namespace
+
+TEST_CASE("compress_payload()") {
+    SECTION("produces a raw deflate stream") {
+        const std::string data = "{\"temp\":21.5,\"hum\":40,\"temp\":21.5,\"hum\":40,\"temp\":21.5,\"hum\":41}";
+        const auto c = compress(data);
+        CHECK(c.size() < data.size());
+        CHECK(decompress(c) == data);
+    }
+    SECTION("handles empty and short inputs") {
+        CHECK(decompress(compress("")) == "");
+        CHECK(decompress(compress("a")) == "a");
+        CHECK(decompress(compress("abcabc")) == "abcabc");
+    }
+    SECTION("handles long runs") {
+        const std::string data(600, 'x');
+        const auto c = compress(data);
+        CHECK(c.size() < 20);
+        CHECK(decompress(c) == data);
+    }
+    SECTION("handles random data") {
+        std::mt19937 gen(1);
+        std::uniform_int_distribution<int> dist(0, 255);
+        for (int i = 0; i < 50; ++i) {
+            std::string data(gen() % 800, '\0');
+            for (auto& c: data) {
+                c = (char)dist(gen);
+            }
+            CHECK(decompress(compress(data, 2048)) == data);
+        }
+    }
+    SECTION("handles repetitive data with a limited alphabet") {
+        std::mt19937 gen(2);
+        std::uniform_int_distribution<int> dist('a', 'd');
+        for (int i = 0; i < 50; ++i) {
+            std::string data(gen() % 2000, '\0');
+            for (auto& c: data) {
+                c = (char)dist(gen);
+            }
+            CHECK(decompress(compress(data, 4096)) == data);
+        }
+    }
+    SECTION("fails if the output doesn't fit in the buffer") {
+        const std::string data = "0123456789abcdef";
+        char buf[8] = {};
+        CHECK(compress_payload(data.data(), data.size(), buf, sizeof(buf)) == SYSTEM_ERROR_TOO_LARGE);
+    }
+}
@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "spsc_ringbuffer.h"
+
+#include <catch2/catch.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+using namespace particle::services;
+
+namespace {
+
+// Runs a producer and a consumer thread that transfer `count` values through the buffer and
+// returns true if the consumer received all values in order
+bool transfer(SpscRingBuffer<uint32_t>* rb, uint32_t count, size_t maxChunk) {
+    bool ok = true;
+    std::thread producer([rb, count, maxChunk]() {
+        uint32_t next = 0;
+        size_t chunk = 1;
+        while (next < count) {
+            SpscRingBuffer<uint32_t>::Span first, second;
+            size_t n = std::min<size_t>(rb->writeSpans(&first, &second), count - next);
+            n = std::min(n, chunk);
+            if (n == 0) {
+                std::this_thread::yield();
+                continue;
+            }
+            for (size_t i = 0; i < n; ++i) {
+                uint32_t* p = (i < first.size) ? first.data + i : second.data + (i - first.size);
+                *p = next++;
+            }
+            rb->commitWrite(n);
+            chunk = (chunk % maxChunk) + 1;
+        }
+    });
+    std::thread consumer([rb, count, maxChunk, &ok]() {
+        uint32_t expected = 0;
+        size_t chunk = maxChunk;
+        std::vector<uint32_t> buf(maxChunk);
+        while (expected < count) {
+            const size_t n = std::min(rb->data(), chunk);
+            if (n == 0) {
+                std::this_thread::yield();
+                continue;
+            }
+            if (rb->get(buf.data(), n) != (ssize_t)n) {
+                ok = false;
+                break;
+            }
+            for (size_t i = 0; i < n; ++i) {
+                if (buf[i] != expected++) {
+                    ok = false;
+                }
+            }
+            chunk = (chunk > 1) ? chunk - 1 : maxChunk;
+        }
+    });
+    producer.join();
+    consumer.join();
+    return ok && rb->empty();
+}
+
+} // namespace
+
+TEST_CASE("SpscRingBuffer") {
+    uint32_t buf[8] = {};
+    SpscRingBuffer<uint32_t> rb(buf, sizeof(buf) / sizeof(buf[0]));
+
+    SECTION("is empty initially") {
+        CHECK(rb.empty());
+        CHECK_FALSE(rb.full());
+        CHECK(rb.data() == 0);
+        CHECK(rb.space() == 8);
+    }
+    SECTION("can be filled and drained") {
+        const uint32_t in[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+        CHECK(rb.put(in, 8) == 8);
+        CHECK(rb.full());
+        CHECK(rb.put(9) == SYSTEM_ERROR_TOO_LARGE);
+        uint32_t out[8] = {};
+        CHECK(rb.get(out, 8) == 8);
+        CHECK(std::equal(in, in + 8, out));
+        CHECK(rb.empty());
+        CHECK(rb.get(out, 1) == SYSTEM_ERROR_TOO_LARGE);
+    }
+    SECTION("returns two spans when the data wraps around") {
+        const uint32_t in[6] = { 1, 2, 3, 4, 5, 6 };
+        REQUIRE(rb.put(in, 6) == 6);
+        REQUIRE(rb.get(nullptr, 5) == 5);
+        SpscRingBuffer<uint32_t>::Span first, second;
+        CHECK(rb.writeSpans(&first, &second) == 7);
+        CHECK(first.data == buf + 6);
+        CHECK(first.size == 2);
+        CHECK(second.data == buf);
+        CHECK(second.size == 5);
+        REQUIRE(rb.put(in, 4) == 4);
+        CHECK(rb.readSpans(&first, &second) == 5);
+        CHECK(first.data == buf + 5);
+        CHECK(first.size == 3);
+        CHECK(second.size == 2);
+        uint32_t out[5] = {};
+        CHECK(rb.peek(out, 5) == 5);
+        CHECK(out[0] == 6);
+        CHECK(out[1] == 1);
+        CHECK(out[4] == 4);
+        CHECK(rb.data() == 5);
+    }
+    SECTION("keeps the indices consistent after many wrap-arounds") {
+        for (uint32_t i = 0; i < 100; ++i) {
+            REQUIRE(rb.put(i) == 1);
+            REQUIRE(rb.put(i + 1) == 1);
+            REQUIRE(rb.put(i + 2) == 1);
+            uint32_t v = 0;
+            REQUIRE(rb.get(&v) == 1);
+            CHECK(v == i);
+            REQUIRE(rb.get(nullptr, 2) == 2);
+            CHECK(rb.empty());
+        }
+    }
+}
+
+TEST_CASE("SpscRingBuffer stress test") {
+    // Use a buffer size that is not a power of two to exercise the index wrap-around logic
+    std::vector<uint32_t> buf(61);
+    SpscRingBuffer<uint32_t> rb(buf.data(), buf.size());
+    CHECK(transfer(&rb, 2000000, 17));
+}
+
+TEST_CASE("SpscRingBuffer throughput", "[.][benchmark]") {
+    std::vector<uint32_t> buf(4096);
+    SpscRingBuffer<uint32_t> rb(buf.data(), buf.size());
+    const uint32_t count = 50000000;
+    const auto t1 = std::chrono::steady_clock::now();
+    REQUIRE(transfer(&rb, count, 256));
+    const auto t2 = std::chrono::steady_clock::now();
+    const double sec = std::chrono::duration<double>(t2 - t1).count();
+    WARN("SpscRingBuffer: " << (uint64_t)(count / sec) << " elements/s");
+}
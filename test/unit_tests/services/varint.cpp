@@ -207,6 +207,47 @@ TEST_CASE("decodeUnsignedVarint()") {
             CHECK(v == 0xffffffff);
         }
     }
+
+    SECTION("decodes the maximum value that fits into the destination variable") {
+        {
+            uint8_t v = 0;
+            char buf[] = "\xff\x01"; // 0xff
+            auto r = decodeUnsignedVarint(buf, sizeof(buf), &v);
+            CHECK(r == 2);
+            CHECK(v == 0xff);
+        }
+        {
+            uint64_t v = 0;
+            char buf[] = "\xff\xff\xff\xff\xff\xff\xff\xff\xff\x01"; // 0xffffffffffffffff
+            auto r = decodeUnsignedVarint(buf, sizeof(buf), &v);
+            CHECK(r == 10);
+            CHECK(v == 0xffffffffffffffffull);
+        }
+    }
+
+    SECTION("decodes values with a zero top group") {
+        {
+            uint8_t v = 0;
+            char buf[] = "\xff\x00"; // 127
+            auto r = decodeUnsignedVarint(buf, sizeof(buf), &v);
+            CHECK(r == 2);
+            CHECK(v == 127);
+        }
+        {
+            uint32_t v = -1;
+            char buf[] = "\x80\x80\x80\x80\x80\x00"; // 0
+            auto r = decodeUnsignedVarint(buf, sizeof(buf), &v);
+            CHECK(r == 6);
+            CHECK(v == 0);
+        }
+    }
+
+    SECTION("fails if a non-zero group is past the width of the destination variable") {
+        uint32_t v = 0;
+        char buf[] = "\x80\x80\x80\x80\x80\x01"; // 0x800000000
+        auto r = decodeUnsignedVarint(buf, sizeof(buf), &v);
+        CHECK(r == SYSTEM_ERROR_TOO_LARGE);
+    }
 }
 
 TEST_CASE("maxUnsignedVarintSize()") {
@@ -0,0 +1,232 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Catch has to be included before the Device OS headers that define the stringify() macro
+#include <catch2/catch.hpp>
+
+#include "system_cloud_function_pool.h"
+#include "system_error.h"
+
+#include "hal_stubs.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace particle::system;
+
+namespace {
+
+const size_t MAX_CALLS = CloudFunctionPool::MAX_CALLS;
+const size_t WORKER_COUNT = CloudFunctionPool::WORKER_COUNT;
+
+// Cloud function that blocks until it's released by the test
+class Function {
+public:
+    Function() :
+            running_(0),
+            maxRunning_(0),
+            released_(false) {
+    }
+
+    ~Function() {
+        release();
+    }
+
+    User_Func_Lookup_Table_t entry(uint16_t maxConcurrency = 1, system_tick_t timeout = 0) {
+        User_Func_Lookup_Table_t e = {};
+        e.pUserFuncData = this;
+        e.pUserFunc = call;
+        e.flags = CLOUD_FUNCTION_FLAG_CONCURRENT;
+        e.maxConcurrency = maxConcurrency;
+        e.timeout = timeout;
+        return e;
+    }
+
+    void release() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        released_ = true;
+        cond_.notify_all();
+    }
+
+    // Waits until the given number of calls are running
+    bool waitRunning(unsigned count) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return cond_.wait_for(lock, std::chrono::seconds(5), [this, count]() { return running_ >= count; });
+    }
+
+    unsigned running() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return running_;
+    }
+
+    unsigned maxRunning() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return maxRunning_;
+    }
+
+    std::vector<std::string> params() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return params_;
+    }
+
+private:
+    std::vector<std::string> params_;
+    mutable std::mutex mutex_;
+    std::condition_variable cond_;
+    unsigned running_;
+    unsigned maxRunning_;
+    bool released_;
+
+    static int call(void* data, const char* param, void* reserved) {
+        const auto self = static_cast<Function*>(data);
+        std::unique_lock<std::mutex> lock(self->mutex_);
+        self->params_.push_back(param);
+        if (++self->running_ > self->maxRunning_) {
+            self->maxRunning_ = self->running_;
+        }
+        self->cond_.notify_all();
+        self->cond_.wait(lock, [self]() { return self->released_; });
+        --self->running_;
+        return self->params_.size();
+    }
+};
+
+// Collects the results reported by the pool
+class Results {
+public:
+    SparkDescriptor::FunctionResultCallback callback() {
+        return [this](const void* result, SparkReturnType::Enum type) {
+            results_.push_back((int)(long)result);
+            return true;
+        };
+    }
+
+    // Processes the pool until the given number of results have been reported
+    bool wait(size_t count) {
+        const auto pool = CloudFunctionPool::instance();
+        for (unsigned i = 0; i < 5000 && results_.size() < count; ++i) {
+            pool->process();
+            if (results_.size() < count) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+        return results_.size() >= count;
+    }
+
+    const std::vector<int>& values() const {
+        return results_;
+    }
+
+private:
+    std::vector<int> results_;
+};
+
+} // namespace
+
+TEST_CASE("CloudFunctionPool") {
+    const auto pool = CloudFunctionPool::instance();
+    Results results;
+
+    SECTION("runs a call on a worker thread and reports its result") {
+        Function fn;
+        fn.release();
+        REQUIRE(pool->schedule(fn.entry(), "abc", results.callback()) == 0);
+        REQUIRE(results.wait(1));
+        CHECK(results.values() == std::vector<int>({ 1 }));
+        CHECK(fn.params() == std::vector<std::string>({ "abc" }));
+    }
+
+    SECTION("doesn't run more calls of a function than its concurrency limit allows") {
+        Function fn;
+        const auto e = fn.entry(1 /* maxConcurrency */);
+        REQUIRE(pool->schedule(e, "1", results.callback()) == 0);
+        REQUIRE(pool->schedule(e, "2", results.callback()) == 0);
+        REQUIRE(fn.waitRunning(1));
+        // Give the other worker a chance to pick up the second call
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        pool->process();
+        CHECK(fn.running() == 1);
+        CHECK(results.values().empty());
+        fn.release();
+        REQUIRE(results.wait(2));
+        CHECK(fn.maxRunning() == 1);
+        CHECK(fn.params() == std::vector<std::string>({ "1", "2" }));
+    }
+
+    SECTION("runs calls of a function concurrently up to its concurrency limit") {
+        Function fn;
+        const auto e = fn.entry(WORKER_COUNT /* maxConcurrency */);
+        for (size_t i = 0; i < WORKER_COUNT; ++i) {
+            REQUIRE(pool->schedule(e, "", results.callback()) == 0);
+        }
+        REQUIRE(fn.waitRunning(WORKER_COUNT));
+        fn.release();
+        REQUIRE(results.wait(WORKER_COUNT));
+        CHECK(fn.maxRunning() == WORKER_COUNT);
+    }
+
+    SECTION("rejects a call when all slots are in use instead of running it elsewhere") {
+        Function fn;
+        const auto e = fn.entry(1 /* maxConcurrency */);
+        for (size_t i = 0; i < MAX_CALLS; ++i) {
+            REQUIRE(pool->schedule(e, "", results.callback()) == 0);
+        }
+        REQUIRE(fn.waitRunning(1));
+        CHECK(pool->schedule(e, "", results.callback()) == SYSTEM_ERROR_BUSY);
+        CHECK(fn.running() == 1);
+        fn.release();
+        REQUIRE(results.wait(MAX_CALLS));
+        CHECK(fn.maxRunning() == 1);
+        CHECK(fn.params().size() == MAX_CALLS);
+        // The slots are available again
+        Function fn2;
+        fn2.release();
+        REQUIRE(pool->schedule(fn2.entry(), "", results.callback()) == 0);
+        REQUIRE(results.wait(MAX_CALLS + 1));
+    }
+
+    SECTION("reports a timeout if a call doesn't finish in time") {
+        test::setMillis(1000);
+        Function fn;
+        REQUIRE(pool->schedule(fn.entry(1 /* maxConcurrency */, 100 /* timeout */), "", results.callback()) == 0);
+        REQUIRE(fn.waitRunning(1));
+        test::advanceMillis(99);
+        pool->process();
+        CHECK(results.values().empty());
+        test::advanceMillis(1);
+        pool->process();
+        CHECK(results.values() == std::vector<int>({ SYSTEM_ERROR_TIMEOUT }));
+        fn.release();
+        // The slot of the timed out call is released by the worker once the call returns
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        Function fn2;
+        for (size_t i = 0; i < MAX_CALLS; ++i) {
+            REQUIRE(pool->schedule(fn2.entry(MAX_CALLS /* maxConcurrency */), "",
+                    results.callback()) == 0);
+        }
+        fn2.release();
+        REQUIRE(results.wait(MAX_CALLS + 1));
+        // The result of the timed out call is not reported
+        pool->process();
+        CHECK(results.values().size() == MAX_CALLS + 1);
+        CHECK(results.values().front() == SYSTEM_ERROR_TIMEOUT);
+    }
+}
@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Host implementations of the HAL functions used by the system code under test. Threads, queues
+// and mutexes are backed by the standard library, the millisecond counter is controlled by the tests
+
+#include "hal_stubs.h"
+
+#include "concurrent_hal.h"
+#include "core_hal.h"
+#include "timer_hal.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct Queue {
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::deque<std::vector<char>> items;
+    size_t itemSize;
+    size_t itemCount;
+};
+
+std::atomic<system_tick_t> g_millis(0);
+
+} // namespace
+
+void test::setMillis(system_tick_t millis) {
+    g_millis = millis;
+}
+
+void test::advanceMillis(system_tick_t millis) {
+    g_millis += millis;
+}
+
+system_tick_t HAL_Timer_Get_Milli_Seconds() {
+    return g_millis;
+}
+
+os_result_t os_thread_create(os_thread_t* thread, const char* name, os_thread_prio_t priority, os_thread_fn_t fn,
+        void* arg, size_t stackSize) {
+    // The threads run until the test process exits
+    std::thread t(fn, arg);
+    *thread = (os_thread_t)t.native_handle();
+    t.detach();
+    return 0;
+}
+
+int os_queue_create(os_queue_t* queue, size_t itemSize, size_t itemCount, void* reserved) {
+    const auto q = new Queue();
+    q->itemSize = itemSize;
+    q->itemCount = itemCount;
+    *queue = q;
+    return 0;
+}
+
+int os_queue_put(os_queue_t queue, const void* item, system_tick_t delay, void* reserved) {
+    const auto q = static_cast<Queue*>(queue);
+    std::unique_lock<std::mutex> lock(q->mutex);
+    if (q->items.size() >= q->itemCount) {
+        return 1; // The tests don't need to wait for a free slot
+    }
+    const auto p = static_cast<const char*>(item);
+    q->items.emplace_back(p, p + q->itemSize);
+    q->cond.notify_one();
+    return 0;
+}
+
+int os_queue_take(os_queue_t queue, void* item, system_tick_t delay, void* reserved) {
+    const auto q = static_cast<Queue*>(queue);
+    std::unique_lock<std::mutex> lock(q->mutex);
+    if (delay == CONCURRENT_WAIT_FOREVER) {
+        q->cond.wait(lock, [q]() { return !q->items.empty(); });
+    } else if (!q->cond.wait_for(lock, std::chrono::milliseconds(delay), [q]() { return !q->items.empty(); })) {
+        return 1;
+    }
+    memcpy(item, q->items.front().data(), q->itemSize);
+    q->items.pop_front();
+    return 0;
+}
+
+int os_queue_destroy(os_queue_t queue, void* reserved) {
+    delete static_cast<Queue*>(queue);
+    return 0;
+}
+
+int os_mutex_create(os_mutex_t* mutex) {
+    *mutex = new std::mutex();
+    return 0;
+}
+
+int os_mutex_destroy(os_mutex_t mutex) {
+    delete static_cast<std::mutex*>(mutex);
+    return 0;
+}
+
+int os_mutex_lock(os_mutex_t mutex) {
+    static_cast<std::mutex*>(mutex)->lock();
+    return 0;
+}
+
+int os_mutex_trylock(os_mutex_t mutex) {
+    return static_cast<std::mutex*>(mutex)->try_lock() ? 0 : 1;
+}
+
+int os_mutex_unlock(os_mutex_t mutex) {
+    static_cast<std::mutex*>(mutex)->unlock();
+    return 0;
+}
+
+uint32_t HAL_Core_Compute_CRC32(const uint8_t* buf, uint32_t size) {
+    uint32_t crc = 0xffffffff;
+    for (uint32_t i = 0; i < size; ++i) {
+        crc ^= buf[i];
+        for (int j = 0; j < 8; ++j) {
+            crc = (crc >> 1) ^ (0xedb88320 & -(crc & 1));
+        }
+    }
+    return ~crc;
+}
@@ -0,0 +1,294 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Catch has to be included before the Device OS headers that define the stringify() macro
+#include <catch2/catch.hpp>
+
+#include "system_publish_queue.h"
+#include "system_cloud.h"
+#include "system_error.h"
+#include "diagnostics.h"
+
+#include "hal_stubs.h"
+
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+using namespace particle::system;
+
+namespace {
+
+struct SentEvent {
+    std::string name;
+    std::string data;
+    uint32_t flags;
+    completion_callback callback;
+    void* callbackData;
+
+    void complete(int error = SYSTEM_ERROR_NONE) const {
+        callback(error, nullptr, callbackData, nullptr);
+    }
+};
+
+std::vector<SentEvent> g_sent;
+
+void removeDir(const std::string& path) {
+    DIR* d = opendir(path.data());
+    if (d) {
+        struct dirent* ent = nullptr;
+        while ((ent = readdir(d))) {
+            if (strcmp(ent->d_name, ".") == 0 || strcmp(ent->d_name, "..") == 0) {
+                continue;
+            }
+            const auto p = path + '/' + ent->d_name;
+            if (ent->d_type == DT_DIR) {
+                removeDir(p);
+            } else {
+                unlink(p.data());
+            }
+        }
+        closedir(d);
+    }
+    rmdir(path.data());
+}
+
+class TempDir {
+public:
+    TempDir() {
+        char tmpl[] = "/tmp/publish_queue_XXXXXX";
+        REQUIRE(mkdtemp(tmpl));
+        path_ = tmpl;
+        // The queue creates its directory on demand
+        path_ += "/pubq";
+    }
+
+    ~TempDir() {
+        removeDir(path_.substr(0, path_.rfind('/')));
+    }
+
+    const char* path() const {
+        return path_.data();
+    }
+
+private:
+    std::string path_;
+};
+
+std::string eventName(unsigned index) {
+    return "event" + std::to_string(index);
+}
+
+void pushEvents(PublishQueue& queue, unsigned begin, unsigned end) {
+    for (unsigned i = begin; i < end; ++i) {
+        const auto name = eventName(i);
+        REQUIRE(queue.push(name.data(), "data", 0 /* dataSize */, CLOUD_CONTENT_TYPE_TEXT, 60 /* ttl */,
+                PUBLISH_EVENT_FLAG_PRIVATE | PUBLISH_EVENT_FLAG_PERSISTENT) == 0);
+    }
+}
+
+std::vector<std::string> sentNames() {
+    std::vector<std::string> names;
+    for (const auto& e: g_sent) {
+        names.push_back(e.name);
+    }
+    return names;
+}
+
+void completeAll(int error = SYSTEM_ERROR_NONE) {
+    const auto sent = g_sent;
+    g_sent.clear();
+    for (const auto& e: sent) {
+        e.complete(error);
+    }
+}
+
+// Overwrites the stored name of an event so that the checksum of its record no longer matches
+void corruptEvent(const std::string& logDir, const std::string& name) {
+    bool found = false;
+    DIR* d = opendir(logDir.data());
+    REQUIRE(d);
+    struct dirent* ent = nullptr;
+    while ((ent = readdir(d)) && !found) {
+        if (ent->d_type != DT_REG) {
+            continue;
+        }
+        const auto path = logDir + '/' + ent->d_name;
+        const int fd = open(path.data(), O_RDWR);
+        REQUIRE(fd >= 0);
+        struct stat st = {};
+        REQUIRE(fstat(fd, &st) == 0);
+        std::string buf(st.st_size, '\0');
+        REQUIRE(pread(fd, &buf[0], buf.size(), 0) == (ssize_t)buf.size());
+        const auto pos = buf.find(name);
+        if (pos != std::string::npos) {
+            REQUIRE(pwrite(fd, "X", 1, pos) == 1);
+            found = true;
+        }
+        close(fd);
+    }
+    closedir(d);
+    REQUIRE(found);
+}
+
+} // namespace
+
+bool spark_send_event(const char* name, const char* data, int ttl, uint32_t flags, void* reserved) {
+    const auto d = static_cast<const spark_send_event_data*>(reserved);
+    REQUIRE(d);
+    SentEvent e = {};
+    e.name = name;
+    e.data = std::string(data, d->data_size);
+    e.flags = flags;
+    e.callback = d->handler_callback;
+    e.callbackData = d->handler_data;
+    g_sent.push_back(e);
+    return true;
+}
+
+int diag_register_source(const diag_source* src, void* reserved) {
+    return 0;
+}
+
+TEST_CASE("PublishQueue") {
+    test::setMillis(1000);
+    g_sent.clear();
+    TempDir dir;
+    PublishQueue queue(dir.path());
+
+    SECTION("sends the queued events in batches") {
+        pushEvents(queue, 0, 6);
+        CHECK(queue.count() == 6);
+        queue.process();
+        CHECK(sentNames() == std::vector<std::string>({ "event0", "event1", "event2", "event3" }));
+        CHECK(g_sent.front().data == "data");
+        CHECK((g_sent.front().flags & PUBLISH_EVENT_FLAG_PRIVATE));
+        CHECK((g_sent.front().flags & PUBLISH_EVENT_FLAG_WITH_ACK));
+        // The events are not removed from the queue until they're acknowledged
+        queue.process();
+        CHECK(queue.count() == 6);
+        completeAll();
+        queue.process();
+        CHECK(queue.count() == 2);
+        // The next batch is sent no earlier than a second after the previous one
+        test::advanceMillis(999);
+        queue.process();
+        CHECK(g_sent.empty());
+        test::advanceMillis(1);
+        queue.process();
+        CHECK(sentNames() == std::vector<std::string>({ "event4", "event5" }));
+        completeAll();
+        queue.process();
+        CHECK(queue.count() == 0);
+    }
+
+    SECTION("discards the oldest events when the queue is full") {
+        pushEvents(queue, 0, 200);
+        const size_t dropped = queue.dropped();
+        CHECK(dropped > 0);
+        CHECK(queue.count() + dropped == 200);
+        queue.process();
+        REQUIRE(!g_sent.empty());
+        CHECK(g_sent.front().name == eventName(dropped));
+    }
+
+    SECTION("resends the events that couldn't be sent") {
+        pushEvents(queue, 0, 2);
+        queue.process();
+        REQUIRE(g_sent.size() == 2);
+        g_sent[0].complete();
+        g_sent[1].complete(SYSTEM_ERROR_NETWORK);
+        g_sent.clear();
+        queue.process();
+        // The acknowledged event is removed from the queue
+        CHECK(queue.count() == 1);
+        test::advanceMillis(4999);
+        queue.process();
+        CHECK(g_sent.empty());
+        test::advanceMillis(1);
+        queue.process();
+        CHECK(sentNames() == std::vector<std::string>({ "event1" }));
+        completeAll();
+        queue.process();
+        CHECK(queue.count() == 0);
+    }
+
+    SECTION("doesn't resend the acknowledged events that follow a failed event") {
+        pushEvents(queue, 0, 4);
+        queue.process();
+        REQUIRE(g_sent.size() == 4);
+        g_sent[0].complete();
+        g_sent[1].complete(SYSTEM_ERROR_LIMIT_EXCEEDED);
+        g_sent[2].complete();
+        g_sent[3].complete(SYSTEM_ERROR_LIMIT_EXCEEDED);
+        g_sent.clear();
+        queue.process();
+        CHECK(queue.count() == 3);
+        test::advanceMillis(5000);
+        queue.process();
+        CHECK(sentNames() == std::vector<std::string>({ "event1", "event3" }));
+        completeAll();
+        queue.process();
+        CHECK(queue.count() == 0);
+        // The acknowledgements don't apply to the events that are queued later
+        pushEvents(queue, 4, 6);
+        test::advanceMillis(1000);
+        queue.process();
+        CHECK(sentNames() == std::vector<std::string>({ "event4", "event5" }));
+    }
+
+    SECTION("resends a batch if its events are not acknowledged in time") {
+        pushEvents(queue, 0, 1);
+        queue.process();
+        REQUIRE(g_sent.size() == 1);
+        const auto late = g_sent.front();
+        g_sent.clear();
+        test::advanceMillis(59999);
+        queue.process();
+        CHECK(g_sent.empty());
+        test::advanceMillis(1);
+        queue.process();
+        CHECK(g_sent.empty());
+        test::advanceMillis(5000);
+        queue.process();
+        CHECK(sentNames() == std::vector<std::string>({ "event0" }));
+        // A late completion of the cancelled batch is ignored
+        late.complete();
+        queue.process();
+        CHECK(queue.count() == 1);
+        CHECK(sentNames() == std::vector<std::string>({ "event0" }));
+        completeAll();
+        queue.process();
+        CHECK(queue.count() == 0);
+    }
+
+    SECTION("skips corrupted events") {
+        pushEvents(queue, 1, 4);
+        corruptEvent(std::string(dir.path()) + "/normal", "event2");
+        queue.process();
+        CHECK(sentNames() == std::vector<std::string>({ "event1", "event3" }));
+        completeAll();
+        queue.process();
+        CHECK(queue.count() == 0);
+    }
+}
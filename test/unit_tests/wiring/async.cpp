@@ -1,7 +1,9 @@
 #include "spark_wiring_async.h"
 
 #include <deque>
+#include <memory>
 #include <thread>
+#include <vector>
 
 #include <boost/optional.hpp>
 
@@ -370,6 +372,72 @@ TEST_CASE("Future<int>") {
         p.setResult(1);
         CHECK(result == 1);
     }
+
+    SECTION("callback with a large capture list") {
+        Promise p;
+        Future f = p.future();
+        char buf[128] = {};
+        int result = 0;
+        f.onSuccess([&result, buf](int r) {
+            result = r + buf[0];
+        });
+        p.setResult(1);
+        CHECK(result == 1);
+    }
+
+    SECTION("callback objects are destroyed with the future") {
+        auto ptr = std::make_shared<int>(0);
+        {
+            Promise p;
+            Future f = p.future();
+            f.onSuccess([ptr](int) {
+            });
+            CHECK(ptr.use_count() == 2);
+        }
+        CHECK(ptr.use_count() == 1);
+    }
+
+    SECTION("passing promise via data pointer") {
+        Promise p;
+        Future f = p.future();
+        void* data = p.dataPtr();
+        auto p2 = Promise::fromDataPtr(data);
+        p2.setResult(1);
+        CHECK(f.result() == 1);
+    }
+
+    SECTION("creating more futures than there are preallocated states") {
+        std::vector<Promise> promises(PARTICLE_FUTURE_POOL_SIZE * 2);
+        std::vector<Future> futures;
+        for (size_t i = 0; i < promises.size(); ++i) {
+            futures.push_back(promises[i].future());
+            promises[i].setResult(i);
+        }
+        for (size_t i = 0; i < futures.size(); ++i) {
+            CHECK(futures[i].result() == (int)i);
+        }
+    }
+
+    SECTION("setting more callbacks than there are preallocated blocks") {
+        std::vector<Promise> promises(PARTICLE_FUTURE_POOL_SIZE * 2);
+        std::vector<int> results(promises.size());
+        for (size_t i = 0; i < promises.size(); ++i) {
+            auto f = promises[i].future();
+            f.onSuccess([&results, i](int r) {
+                results[i] = r;
+            });
+            // Replacing a callback releases the block of the old one
+            f.onError([](const Error&) {
+            });
+            f.onError([&results, i](const Error&) {
+                results[i] = -1;
+            });
+        }
+        for (size_t i = 0; i < promises.size(); ++i) {
+            promises[i].setResult(i + 1);
+            CHECK(results[i] == (int)i + 1);
+        }
+    }
 }
 
 TEST_CASE("AdaptedFuture<int>") {
@@ -0,0 +1,180 @@
+#include "spark_wiring_cbor.h"
+
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+using namespace particle;
+
+namespace {
+
+class Writer: public CBORBufferWriter {
+public:
+    Writer() :
+            CBORBufferWriter(buf_, sizeof(buf_)) {
+    }
+
+    std::vector<uint8_t> data() const {
+        return std::vector<uint8_t>(buf_, buf_ + std::min(dataSize(), sizeof(buf_)));
+    }
+
+private:
+    uint8_t buf_[256] = {};
+};
+
+std::vector<uint8_t> bytes(std::initializer_list<int> list) {
+    std::vector<uint8_t> v;
+    for (int b: list) {
+        v.push_back(b);
+    }
+    return v;
+}
+
+} // namespace
+
+TEST_CASE("CBORWriter") {
+    Writer w;
+
+    SECTION("integers") {
+        w.value(0).value(23).value(24).value(1000).value(1000000).value(1000000000000ULL).value(-1).value(-1000);
+        CHECK(w.data() == bytes({ 0x00, 0x17, 0x18, 0x18, 0x19, 0x03, 0xe8, 0x1a, 0x00, 0x0f, 0x42, 0x40,
+                0x1b, 0x00, 0x00, 0x00, 0xe8, 0xd4, 0xa5, 0x10, 0x00, 0x20, 0x39, 0x03, 0xe7 }));
+    }
+    SECTION("simple values") {
+        w.value(false).value(true).nullValue();
+        CHECK(w.data() == bytes({ 0xf4, 0xf5, 0xf6 }));
+    }
+    SECTION("floating point values") {
+        w.value(100000.0).value(1.1);
+        CHECK(w.data() == bytes({ 0xfa, 0x47, 0xc3, 0x50, 0x00, 0xfb, 0x3f, 0xf1, 0x99, 0x99, 0x99, 0x99, 0x99, 0x9a }));
+    }
+    SECTION("doubles out of the range of float") {
+        w.value(1e300).value(-1e300).value(std::numeric_limits<double>::infinity());
+        CHECK(w.data() == bytes({ 0xfb, 0x7e, 0x37, 0xe4, 0x3c, 0x88, 0x00, 0x75, 0x9c, 0xfb, 0xfe, 0x37, 0xe4, 0x3c, 0x88,
+                0x00, 0x75, 0x9c, 0xfa, 0x7f, 0x80, 0x00, 0x00 }));
+    }
+    SECTION("strings") {
+        w.value("IETF").bytes("\x01\x02\x03\x04", 4).value("");
+        CHECK(w.data() == bytes({ 0x64, 0x49, 0x45, 0x54, 0x46, 0x44, 0x01, 0x02, 0x03, 0x04, 0x60 }));
+    }
+    SECTION("definite-length containers") {
+        w.beginMap(2).name("a").value(1).name("b").beginArray(2).value(2).value(3);
+        CHECK(w.data() == bytes({ 0xa2, 0x61, 0x61, 0x01, 0x61, 0x62, 0x82, 0x02, 0x03 }));
+    }
+    SECTION("indefinite-length containers") {
+        w.beginMap().name("a").beginArray().value(1).endArray().endMap();
+        CHECK(w.data() == bytes({ 0xbf, 0x61, 0x61, 0x9f, 0x01, 0xff, 0xff }));
+    }
+    SECTION("tags") {
+        w.tag(1).value(1363896240);
+        CHECK(w.data() == bytes({ 0xc1, 0x1a, 0x51, 0x4b, 0x67, 0xb0 }));
+    }
+    SECTION("buffer overflow") {
+        uint8_t buf[4] = {};
+        CBORBufferWriter bw(buf, sizeof(buf));
+        bw.value("abcdef");
+        CHECK(bw.dataSize() == 7);
+        CHECK(memcmp(buf, "\x66" "abc", 4) == 0);
+    }
+}
+
+TEST_CASE("CBORReader") {
+    SECTION("reads back values written by CBORWriter") {
+        Writer w;
+        w.beginMap(6).name("i").value(-1000).name("u").value(4000000000u).name("f").value(21.5).name("s").value("text")
+                .name("b").value(true).name("n").nullValue();
+        const auto d = w.data();
+        CBORReader r(d.data(), d.size());
+        REQUIRE(r.next());
+        REQUIRE(r.type() == CBORType::MAP);
+        REQUIRE(r.size() == 6);
+        REQUIRE(r.next());
+        CHECK(r.toString() == "i");
+        REQUIRE(r.next());
+        CHECK(r.type() == CBORType::NEGATIVE_INT);
+        CHECK(r.toInt() == -1000);
+        REQUIRE(r.next());
+        REQUIRE(r.next());
+        CHECK(r.type() == CBORType::UNSIGNED_INT);
+        CHECK(r.toUInt() == 4000000000u);
+        REQUIRE(r.next());
+        REQUIRE(r.next());
+        CHECK(r.type() == CBORType::FLOAT);
+        CHECK(r.toDouble() == 21.5);
+        REQUIRE(r.next());
+        REQUIRE(r.next());
+        CHECK(r.type() == CBORType::TEXT);
+        CHECK(std::string(r.data(), r.size()) == "text");
+        REQUIRE(r.next());
+        REQUIRE(r.next());
+        CHECK(r.type() == CBORType::BOOL);
+        CHECK(r.toBool());
+        REQUIRE(r.next());
+        REQUIRE(r.next());
+        CHECK(r.type() == CBORType::NULL_VALUE);
+        CHECK_FALSE(r.next());
+        CHECK_FALSE(r.hasError());
+    }
+    SECTION("decodes half-precision floats") {
+        const auto d = bytes({ 0xf9, 0x3c, 0x00, 0xf9, 0xc4, 0x00, 0xf9, 0x00, 0x01 });
+        CBORReader r(d.data(), d.size());
+        REQUIRE(r.next());
+        CHECK(r.toDouble() == 1.0);
+        REQUIRE(r.next());
+        CHECK(r.toDouble() == -4.0);
+        REQUIRE(r.next());
+        CHECK(r.toDouble() == Approx(5.960464477539063e-8));
+    }
+    SECTION("converts floats that are out of the range of an integer type") {
+        Writer w;
+        w.value(std::numeric_limits<double>::quiet_NaN()).value(std::numeric_limits<double>::infinity())
+                .value(-std::numeric_limits<double>::infinity()).value(1e30).value(-1e30).value(-2.5);
+        const auto d = w.data();
+        CBORReader r(d.data(), d.size());
+        REQUIRE(r.next());
+        REQUIRE(r.type() == CBORType::FLOAT);
+        CHECK(r.toInt() == 0);
+        CHECK(r.toUInt() == 0);
+        REQUIRE(r.next());
+        CHECK(r.toInt() == std::numeric_limits<int64_t>::max());
+        CHECK(r.toUInt() == std::numeric_limits<uint64_t>::max());
+        REQUIRE(r.next());
+        CHECK(r.toInt() == std::numeric_limits<int64_t>::min());
+        CHECK(r.toUInt() == 0);
+        REQUIRE(r.next());
+        CHECK(r.toInt() == std::numeric_limits<int64_t>::max());
+        CHECK(r.toUInt() == std::numeric_limits<uint64_t>::max());
+        REQUIRE(r.next());
+        CHECK(r.toInt() == std::numeric_limits<int64_t>::min());
+        CHECK(r.toUInt() == 0);
+        REQUIRE(r.next());
+        CHECK(r.toInt() == -2);
+        CHECK(r.toUInt() == 0);
+        CHECK_FALSE(r.next());
+        CHECK_FALSE(r.hasError());
+    }
+    SECTION("skips nested containers") {
+        Writer w;
+        w.beginArray(3).beginMap().name("x").beginArray(2).value(1).value("y").endMap().value(2).beginArray(0).value(3);
+        const auto d = w.data();
+        CBORReader r(d.data(), d.size());
+        REQUIRE(r.next());
+        REQUIRE(r.skip());
+        REQUIRE(r.next());
+        CHECK(r.toInt() == 3);
+        CHECK(r.offset() == d.size());
+    }
+    SECTION("fails on truncated data") {
+        const auto d = bytes({ 0x64, 0x49, 0x45 });
+        CBORReader r(d.data(), d.size());
+        CHECK_FALSE(r.next());
+        CHECK(r.hasError());
+        const auto d2 = bytes({ 0x82, 0x01 });
+        CBORReader r2(d2.data(), d2.size());
+        REQUIRE(r2.next());
+        CHECK_FALSE(r2.skip());
+        CHECK(r2.hasError());
+    }
+}
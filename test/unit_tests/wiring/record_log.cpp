@@ -0,0 +1,241 @@
+#include "spark_wiring_record_log.h"
+
+#include "system_error.h"
+
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include <catch2/catch.hpp>
+
+using namespace particle;
+
+extern "C" uint32_t HAL_Core_Compute_CRC32(const uint8_t* buf, uint32_t size) {
+    uint32_t crc = 0xffffffff;
+    for (uint32_t i = 0; i < size; ++i) {
+        crc ^= buf[i];
+        for (int j = 0; j < 8; ++j) {
+            crc = (crc >> 1) ^ (0xedb88320 & -(crc & 1));
+        }
+    }
+    return ~crc;
+}
+
+namespace {
+
+const size_t RECORD_SIZE = 16;
+const size_t RECORDS_PER_SEGMENT = 4;
+const size_t MAX_SEGMENTS = 3;
+
+class TempDir {
+public:
+    TempDir() {
+        char tmpl[] = "/tmp/record_log_XXXXXX";
+        REQUIRE(mkdtemp(tmpl));
+        path_ = tmpl;
+    }
+
+    ~TempDir() {
+        DIR* d = opendir(path_.data());
+        if (d) {
+            struct dirent* ent = nullptr;
+            while ((ent = readdir(d))) {
+                if (strcmp(ent->d_name, ".") != 0 && strcmp(ent->d_name, "..") != 0) {
+                    unlink(filePath(ent->d_name).data());
+                }
+            }
+            closedir(d);
+        }
+        rmdir(path_.data());
+    }
+
+    std::string filePath(const std::string& name) const {
+        return path_ + '/' + name;
+    }
+
+    const char* path() const {
+        return path_.data();
+    }
+
+private:
+    std::string path_;
+};
+
+std::string record(uint32_t index) {
+    return "record " + std::to_string(index);
+}
+
+void appendRecords(RecordLog& log, uint32_t begin, uint32_t end) {
+    for (uint32_t i = begin; i < end; ++i) {
+        const auto r = record(i);
+        uint32_t index = 0;
+        REQUIRE(log.append(r.data(), r.size(), &index) == 0);
+        REQUIRE(index == i);
+    }
+}
+
+std::string readRecord(RecordLog& log, uint32_t index) {
+    char buf[RECORD_SIZE] = {};
+    const int r = log.read(index, buf, sizeof(buf));
+    REQUIRE(r >= 0);
+    return std::string(buf, r);
+}
+
+off_t fileSize(const std::string& path) {
+    struct stat st = {};
+    REQUIRE(stat(path.data(), &st) == 0);
+    return st.st_size;
+}
+
+} // namespace
+
+TEST_CASE("RecordLog") {
+    TempDir dir;
+    RecordLog log;
+    REQUIRE(log.open(dir.path(), RECORD_SIZE, RECORDS_PER_SEGMENT, MAX_SEGMENTS) == 0);
+    REQUIRE(log.isOpen());
+
+    SECTION("can append and read records") {
+        CHECK(log.count() == 0);
+        appendRecords(log, 0, 6);
+        CHECK(log.begin() == 0);
+        CHECK(log.end() == 6);
+        for (uint32_t i = 0; i < 6; ++i) {
+            CHECK(readRecord(log, i) == record(i));
+        }
+        char buf[RECORD_SIZE] = {};
+        CHECK(log.read(6, buf, sizeof(buf)) == SYSTEM_ERROR_NOT_FOUND);
+    }
+
+    SECTION("truncates data that doesn't fit the buffer") {
+        appendRecords(log, 0, 1);
+        char buf[3] = {};
+        CHECK(log.read(0, buf, sizeof(buf)) == (int)record(0).size());
+        CHECK(std::string(buf, sizeof(buf)) == "rec");
+    }
+
+    SECTION("rejects records larger than the record size") {
+        const std::string r(RECORD_SIZE + 1, 'x');
+        CHECK(log.append(r.data(), r.size()) == SYSTEM_ERROR_TOO_LARGE);
+        CHECK(log.count() == 0);
+    }
+
+    SECTION("removes the oldest segment when the log is full") {
+        appendRecords(log, 0, RECORDS_PER_SEGMENT * MAX_SEGMENTS + 1);
+        CHECK(log.begin() == RECORDS_PER_SEGMENT);
+        CHECK(log.end() == RECORDS_PER_SEGMENT * MAX_SEGMENTS + 1);
+        char buf[RECORD_SIZE] = {};
+        CHECK(log.read(0, buf, sizeof(buf)) == SYSTEM_ERROR_NOT_FOUND);
+        CHECK(readRecord(log, RECORDS_PER_SEGMENT) == record(RECORDS_PER_SEGMENT));
+        CHECK(access(dir.filePath("00000000").data(), F_OK) != 0);
+    }
+
+    SECTION("recovers the log after it's reopened") {
+        appendRecords(log, 0, 10);
+        REQUIRE(log.close() == 0);
+        REQUIRE(log.open(dir.path(), RECORD_SIZE, RECORDS_PER_SEGMENT, MAX_SEGMENTS) == 0);
+        CHECK(log.begin() == 0);
+        CHECK(log.end() == 10);
+        appendRecords(log, 10, 20);
+        CHECK(log.begin() == 8);
+        for (uint32_t i = 8; i < 20; ++i) {
+            CHECK(readRecord(log, i) == record(i));
+        }
+    }
+
+    SECTION("fails to open a log with different geometry") {
+        appendRecords(log, 0, 1);
+        REQUIRE(log.close() == 0);
+        CHECK(log.open(dir.path(), RECORD_SIZE * 2, RECORDS_PER_SEGMENT, MAX_SEGMENTS) == SYSTEM_ERROR_INVALID_ARGUMENT);
+        CHECK(!log.isOpen());
+    }
+
+    SECTION("discards a partially written record") {
+        appendRecords(log, 0, 2);
+        REQUIRE(log.close() == 0);
+        const auto path = dir.filePath("00000000");
+        const off_t size = fileSize(path);
+        REQUIRE(truncate(path.data(), size - 3) == 0);
+        REQUIRE(log.open(dir.path(), RECORD_SIZE, RECORDS_PER_SEGMENT, MAX_SEGMENTS) == 0);
+        CHECK(log.end() == 1);
+        appendRecords(log, 1, 3);
+        CHECK(readRecord(log, 0) == record(0));
+        CHECK(readRecord(log, 2) == record(2));
+    }
+
+    SECTION("discards an incomplete segment") {
+        appendRecords(log, 0, RECORDS_PER_SEGMENT);
+        REQUIRE(log.close() == 0);
+        const int fd = open(dir.filePath("00000001").data(), O_CREAT | O_WRONLY, 0666);
+        REQUIRE(fd >= 0);
+        REQUIRE(write(fd, "RL", 2) == 2);
+        close(fd);
+        REQUIRE(log.open(dir.path(), RECORD_SIZE, RECORDS_PER_SEGMENT, MAX_SEGMENTS) == 0);
+        CHECK(log.begin() == 0);
+        CHECK(log.end() == RECORDS_PER_SEGMENT);
+        appendRecords(log, RECORDS_PER_SEGMENT, RECORDS_PER_SEGMENT + 1);
+        CHECK(readRecord(log, RECORDS_PER_SEGMENT) == record(RECORDS_PER_SEGMENT));
+    }
+
+    SECTION("detects corrupted records") {
+        appendRecords(log, 0, 1);
+        REQUIRE(log.close() == 0);
+        const int fd = open(dir.filePath("00000000").data(), O_WRONLY);
+        REQUIRE(fd >= 0);
+        REQUIRE(pwrite(fd, "X", 1, fileSize(dir.filePath("00000000")) - 1 - (RECORD_SIZE - record(0).size())) == 1);
+        close(fd);
+        REQUIRE(log.open(dir.path(), RECORD_SIZE, RECORDS_PER_SEGMENT, MAX_SEGMENTS) == 0);
+        char buf[RECORD_SIZE] = {};
+        CHECK(log.read(0, buf, sizeof(buf)) == SYSTEM_ERROR_BAD_DATA);
+    }
+
+    SECTION("persists the consumed position") {
+        appendRecords(log, 0, 5);
+        CHECK(log.consumed() == 0);
+        REQUIRE(log.consumed(3) == 0);
+        CHECK(log.consumed(6) == SYSTEM_ERROR_OUT_OF_RANGE);
+        REQUIRE(log.close() == 0);
+        REQUIRE(log.open(dir.path(), RECORD_SIZE, RECORDS_PER_SEGMENT, MAX_SEGMENTS) == 0);
+        CHECK(log.consumed() == 3);
+    }
+}
+
+TEST_CASE("RecordLogReader") {
+    TempDir dir;
+    RecordLog log;
+    REQUIRE(log.open(dir.path(), RECORD_SIZE, RECORDS_PER_SEGMENT, MAX_SEGMENTS) == 0);
+
+    SECTION("reads the records starting from the consumed position") {
+        appendRecords(log, 0, 5);
+        REQUIRE(log.consumed(2) == 0);
+        RecordLogReader reader(log);
+        char buf[RECORD_SIZE] = {};
+        uint32_t index = 0;
+        for (uint32_t i = 2; i < 5; ++i) {
+            const int r = reader.next(buf, sizeof(buf), &index);
+            REQUIRE(r >= 0);
+            CHECK(index == i);
+            CHECK(std::string(buf, r) == record(i));
+        }
+        CHECK(reader.next(buf, sizeof(buf)) == SYSTEM_ERROR_END_OF_STREAM);
+        REQUIRE(reader.commit() == 0);
+        CHECK(log.consumed() == 5);
+    }
+
+    SECTION("skips the records removed from the log") {
+        appendRecords(log, 0, 2);
+        RecordLogReader reader(log);
+        appendRecords(log, 2, RECORDS_PER_SEGMENT * (MAX_SEGMENTS + 1));
+        char buf[RECORD_SIZE] = {};
+        uint32_t index = 0;
+        REQUIRE(reader.next(buf, sizeof(buf), &index) >= 0);
+        CHECK(index == RECORDS_PER_SEGMENT);
+        CHECK(reader.position() == RECORDS_PER_SEGMENT + 1);
+    }
+}
@@ -77,6 +77,7 @@
 #include "spark_wiring_error.h"
 #include "spark_wiring_led.h"
 #include "spark_wiring_diagnostics.h"
+#include "spark_wiring_record_log.h"
 #include "fast_pin.h"
 #include "string_convert.h"
 #include "debug_output_handler.h"
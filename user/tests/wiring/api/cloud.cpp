@@ -160,6 +160,9 @@ test(api_spark_publish) {
     API_COMPILE(Particle.publish(String("event"), String("data"), 60, PUBLIC));
     API_COMPILE(Particle.publish(String("event"), String("data"), 60, PUBLIC, NO_ACK));
     API_COMPILE(Particle.publish(String("event"), String("data"), 60, PUBLIC | NO_ACK));
+
+    API_COMPILE(Particle.publish("event", "data", PRIVATE | PERSISTENT));
+    API_COMPILE(Particle.publish("event", "data", 60, PRIVATE, PERSISTENT | PRIORITY_HIGH));
 }
 
 test(api_spark_publish_vitals) {
@@ -85,6 +85,31 @@ test(Spark_Subscribe_When_Not_Connected_Recieves_Events_When_Connected) {
     assertEqual(not_connected_handler_count, 1);
 }
 
+#if HAL_PLATFORM_FILESYSTEM
+
+test(Spark_Persistent_Publish_When_Not_Connected_Is_Sent_When_Connected) {
+    disconnect();
+    Particle.unsubscribe();
+    not_connected_handler_count = 0;
+    const char* eventName = "test/Spark_Persistent_Publish_When_Not_Connected";
+    assertTrue(Particle.subscribe(eventName, Spark_Subscribe_When_Not_Connected_Handler));
+
+    String deviceID = Particle.deviceID();
+    auto result = Particle.publish(eventName, deviceID.c_str(), PRIVATE | PERSISTENT);
+    assertTrue(result.isSucceeded());
+    result = Particle.publish(eventName, deviceID.c_str(), PRIVATE | PERSISTENT | PRIORITY_HIGH);
+    assertTrue(result.isSucceeded());
+
+    connect();
+    long start = millis();
+    while ((millis()-start)<publish_timeout && not_connected_handler_count < 2)
+        idle();
+
+    assertEqual(not_connected_handler_count, 2);
+}
+
+#endif // HAL_PLATFORM_FILESYSTEM
+
 void Subscribe_To_Same_Event_Is_No_Op_Handler(const char* topic, const char* data) {
 
 }
@@ -25,6 +25,8 @@
 #include <limits.h>
 #include <algorithm>
 #include <fcntl.h>
+#include <sys/uio.h>
+#include "fcntl_ext.h"
 #include "random.h"
 
 #if HAL_PLATFORM_FILESYSTEM
@@ -494,6 +496,60 @@ test(FS_POSIX_03_Truncate) {
     }
 }
 
+test(FS_POSIX_04_VectoredAndBufferedIo) {
+    auto files = generateRandomFilenames(TEST_DIR, 1);
+    const char* path = files[0];
+
+    int fd = open(path, O_CREAT | O_RDWR);
+    assertMoreOrEqual(fd, 0);
+
+    // Small writes are collected in the write-back buffer
+    assertEqual(0, fcntl(fd, F_GETWRBUF));
+    assertEqual(0, fcntl(fd, F_SETWRBUF, 64));
+    assertEqual(64, fcntl(fd, F_GETWRBUF));
+    assertEqual(-1, fcntl(fd, F_SETWRBUF, -1));
+    for (int i = 0; i < 10; i++) {
+        assertEqual(4, write(fd, "0123", 4));
+    }
+    char hdr[] = "hdr:";
+    char payload[] = "payload";
+    struct iovec wiov[] = {
+        { hdr, sizeof(hdr) - 1 },
+        { payload, sizeof(payload) - 1 }
+    };
+    assertEqual(11, writev(fd, wiov, 2));
+
+    // Positional I/O doesn't change the file offset
+    assertEqual(51, lseek(fd, 0, SEEK_CUR));
+    assertEqual(2, pwrite(fd, "AB", 2, 0));
+    char tmp[8] = {};
+    assertEqual(4, pread(fd, tmp, 4, 0));
+    assertEqual(0, strncmp(tmp, "AB23", 4));
+    assertEqual(51, lseek(fd, 0, SEEK_CUR));
+
+    // Buffered data is committed by fsync()
+    assertEqual(0, fsync(fd));
+    struct stat st;
+    assertEqual(0, stat(path, &st));
+    assertEqual(st.st_size, 51);
+
+    char rhdr[4] = {};
+    char rpayload[7] = {};
+    struct iovec riov[] = {
+        { rhdr, sizeof(rhdr) },
+        { rpayload, sizeof(rpayload) }
+    };
+    assertEqual(40, lseek(fd, 40, SEEK_SET));
+    assertEqual(11, readv(fd, riov, 2));
+    assertEqual(0, strncmp(rhdr, "hdr:", sizeof(rhdr)));
+    assertEqual(0, strncmp(rpayload, "payload", sizeof(rpayload)));
+    assertEqual(0, readv(fd, riov, 2));
+    assertEqual(-1, readv(fd, riov, 0));
+
+    assertEqual(0, close(fd));
+    assertEqual(0, unlink(path));
+}
+
 test(FS_POSIX_99_Cleanup) {
     assertTrue(dirExists(TEST_DIR));
     assertEqual(0, rmDir(TEST_DIR));
@@ -25,22 +25,242 @@
 #include "system_task.h"
 
 #include <functional>
-#include <memory>
+#include <type_traits>
 #include <atomic>
+#include <new>
 
-#if (ATOMIC_POINTER_LOCK_FREE != 2) || (ATOMIC_CHAR_LOCK_FREE != 2) || (ATOMIC_BOOL_LOCK_FREE != 2)
+#if (ATOMIC_POINTER_LOCK_FREE != 2) || (ATOMIC_CHAR_LOCK_FREE != 2) || (ATOMIC_BOOL_LOCK_FREE != 2) || (ATOMIC_INT_LOCK_FREE != 2)
 #error "std::atomic is not always lock-free for required types"
 #endif
 
+// Size of the inline storage for a completion callback. Larger function objects are allocated on the heap
+#ifndef PARTICLE_FUTURE_CALLBACK_INLINE_SIZE
+#define PARTICLE_FUTURE_CALLBACK_INLINE_SIZE (4 * sizeof(void*))
+#endif
+
+// Number of statically allocated blocks per block size. The blocks are used for future states and
+// completion callbacks
+#ifndef PARTICLE_FUTURE_POOL_SIZE
+#define PARTICLE_FUTURE_POOL_SIZE (4)
+#endif
+
 namespace particle {
 
 namespace detail {
 
+// Move-only callable wrapper. Small function objects are stored inline, larger ones are allocated
+// on the heap
+template<typename SignatureT>
+class FutureCallback;
+
+template<typename... ArgsT>
+class FutureCallback<void(ArgsT...)> {
+public:
+    FutureCallback() :
+            invoke_(nullptr),
+            manage_(nullptr) {
+    }
+
+    template<typename FunctionT, typename = typename std::enable_if<
+            !std::is_same<typename std::decay<FunctionT>::type, FutureCallback>::value>::type>
+    explicit FutureCallback(FunctionT&& fn) :
+            FutureCallback() {
+        assign<typename std::decay<FunctionT>::type>(std::forward<FunctionT>(fn), IsInline<typename std::decay<FunctionT>::type>());
+    }
+
+    FutureCallback(FutureCallback&& cb) :
+            FutureCallback() {
+        moveFrom(cb);
+    }
+
+    ~FutureCallback() {
+        reset();
+    }
+
+    void reset() {
+        if (manage_) {
+            manage_(nullptr, &storage_);
+            invoke_ = nullptr;
+            manage_ = nullptr;
+        }
+    }
+
+    void operator()(ArgsT... args) {
+        invoke_(&storage_, args...);
+    }
+
+    explicit operator bool() const {
+        return invoke_;
+    }
+
+    FutureCallback& operator=(FutureCallback&& cb) {
+        if (this != &cb) {
+            reset();
+            moveFrom(cb);
+        }
+        return *this;
+    }
+
+    FutureCallback(const FutureCallback&) = delete;
+    FutureCallback& operator=(const FutureCallback&) = delete;
+
+private:
+    typedef typename std::aligned_storage<PARTICLE_FUTURE_CALLBACK_INLINE_SIZE>::type Storage;
+
+    // Invokes the function object stored in `storage`
+    typedef void(*InvokeFn)(void* storage, ArgsT... args);
+    // Moves the function object from `src` to `dest`, or destroys it if `dest` is null
+    typedef void(*ManageFn)(void* dest, void* src);
+
+    template<typename FunctionT>
+    using IsInline = std::integral_constant<bool, sizeof(FunctionT) <= sizeof(Storage) &&
+            alignof(Storage) % alignof(FunctionT) == 0 && std::is_nothrow_move_constructible<FunctionT>::value>;
+
+    Storage storage_;
+    InvokeFn invoke_;
+    ManageFn manage_;
+
+    template<typename FunctionT, typename ArgT>
+    void assign(ArgT&& fn, std::true_type /* inline */) {
+        new(&storage_) FunctionT(std::forward<ArgT>(fn));
+        invoke_ = [](void* storage, ArgsT... args) {
+            (*static_cast<FunctionT*>(storage))(args...);
+        };
+        manage_ = [](void* dest, void* src) {
+            const auto fn = static_cast<FunctionT*>(src);
+            if (dest) {
+                new(dest) FunctionT(std::move(*fn));
+            }
+            fn->~FunctionT();
+        };
+    }
+
+    template<typename FunctionT, typename ArgT>
+    void assign(ArgT&& fn, std::false_type /* inline */) {
+        *reinterpret_cast<FunctionT**>(&storage_) = new FunctionT(std::forward<ArgT>(fn));
+        invoke_ = [](void* storage, ArgsT... args) {
+            (**static_cast<FunctionT**>(storage))(args...);
+        };
+        manage_ = [](void* dest, void* src) {
+            const auto fn = static_cast<FunctionT**>(src);
+            if (dest) {
+                *static_cast<FunctionT**>(dest) = *fn;
+            } else {
+                delete *fn;
+            }
+        };
+    }
+
+    void moveFrom(FutureCallback& cb) {
+        if (cb.manage_) {
+            cb.manage_(&storage_, &cb.storage_);
+            invoke_ = cb.invoke_;
+            manage_ = cb.manage_;
+            cb.invoke_ = nullptr;
+            cb.manage_ = nullptr;
+        }
+    }
+};
+
+// Pool of statically allocated blocks of a given size. Falls back to the heap when all blocks are
+// in use
+template<size_t BlockSize>
+class FutureStatePool {
+public:
+    static void* alloc() {
+        for (size_t i = 0; i < PARTICLE_FUTURE_POOL_SIZE; ++i) {
+            if (!used_[i].exchange(true, std::memory_order_acquire)) {
+                return &blocks_[i];
+            }
+        }
+        return ::operator new(BlockSize);
+    }
+
+    static void free(void* ptr) {
+        const auto block = static_cast<Block*>(ptr);
+        if (block >= blocks_ && block < blocks_ + PARTICLE_FUTURE_POOL_SIZE) {
+            used_[block - blocks_].store(false, std::memory_order_release);
+        } else {
+            ::operator delete(ptr);
+        }
+    }
+
+private:
+    typedef typename std::aligned_storage<BlockSize>::type Block;
+
+    static Block blocks_[PARTICLE_FUTURE_POOL_SIZE];
+    static std::atomic<bool> used_[PARTICLE_FUTURE_POOL_SIZE];
+};
+
+template<size_t BlockSize>
+typename FutureStatePool<BlockSize>::Block FutureStatePool<BlockSize>::blocks_[PARTICLE_FUTURE_POOL_SIZE];
+
+template<size_t BlockSize>
+std::atomic<bool> FutureStatePool<BlockSize>::used_[PARTICLE_FUTURE_POOL_SIZE];
+
+// Slot for a completion callback. The callback is kept in a pooled block and the slot is updated
+// by exchanging a pointer to it, so that it can be checked and taken by the thread or ISR
+// completing the future without any locking
+template<typename SignatureT>
+class FutureCallbackSlot {
+public:
+    typedef FutureCallback<SignatureT> Callback;
+
+    FutureCallbackSlot() :
+            cb_(nullptr) {
+    }
+
+    ~FutureCallbackSlot() {
+        destroy(cb_.load(std::memory_order_relaxed));
+    }
+
+    // Replaces the callback. The old callback is destroyed
+    void set(Callback&& callback) {
+        Callback* cb = nullptr;
+        if (callback) {
+            cb = new(Pool::alloc()) Callback(std::move(callback));
+        }
+        destroy(cb_.exchange(cb, std::memory_order_acq_rel));
+    }
+
+    // Takes the callback from the slot
+    Callback take() {
+        Callback callback;
+        const auto cb = cb_.exchange(nullptr, std::memory_order_acq_rel);
+        if (cb) {
+            callback = std::move(*cb);
+            destroy(cb);
+        }
+        return callback;
+    }
+
+    bool isSet() const {
+        return cb_.load(std::memory_order_relaxed);
+    }
+
+    FutureCallbackSlot(const FutureCallbackSlot&) = delete;
+    FutureCallbackSlot& operator=(const FutureCallbackSlot&) = delete;
+
+private:
+    typedef FutureStatePool<sizeof(Callback)> Pool;
+
+    std::atomic<Callback*> cb_;
+
+    static void destroy(Callback* cb) {
+        if (cb) {
+            cb->~Callback();
+            Pool::free(cb);
+        }
+    }
+};
+
 // Completion callback types
 template<typename ResultT>
 struct FutureCallbackTypes {
     typedef std::function<void(const ResultT&)> OnSuccess;
     typedef std::function<void(const Error&)> OnError;
+    typedef FutureCallbackSlot<void(const ResultT&)> OnSuccessSlot;
+    typedef FutureCallbackSlot<void(const Error&)> OnErrorSlot;
 };
 
 // Completion callback types. Specialization for void result type
@@ -48,14 +268,49 @@ template<>
 struct FutureCallbackTypes<void> {
     typedef std::function<void()> OnSuccess;
     typedef std::function<void(const Error&)> OnError;
+    typedef FutureCallbackSlot<void()> OnSuccessSlot;
+    typedef FutureCallbackSlot<void(const Error&)> OnErrorSlot;
 };
 
-// Helper function for FutureImplBase::invokeCallback()
+// Intrusively reference-counted base class for future states
+class FutureStateBase {
+public:
+    void addRef() {
+        refCount_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void release() {
+        if (refCount_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            destroy();
+        }
+    }
+
+    // Invokes completion callbacks. Called in the application context
+    virtual void invokeCallbacks() = 0;
+
+protected:
+    FutureStateBase() :
+            refCount_(0) {
+    }
+
+    ~FutureStateBase() = default;
+
+    // Destroys this object and releases its memory
+    virtual void destroy() = 0;
+
+private:
+    std::atomic<int> refCount_;
+};
+
+// Helper function for FutureImplBase::notifyCallbacks()
 void futureCallbackWrapper(void* data);
 
+template<typename ResultT, typename ContextT>
+class FutureImpl;
+
 // Internal future implementation. Base class for FutureImpl
 template<typename ResultT, typename ContextT>
-class FutureImplBase {
+class FutureImplBase: public FutureStateBase {
 public:
     // Future state
     enum class State: char {
@@ -69,11 +324,6 @@ public:
     typedef typename detail::FutureCallbackTypes<ResultT>::OnSuccess OnSuccessCallback;
     typedef typename detail::FutureCallbackTypes<ResultT>::OnError OnErrorCallback;
 
-    ~FutureImplBase() {
-        delete onSuccess_.load(std::memory_order_relaxed);
-        delete onError_.load(std::memory_order_relaxed);
-    }
-
     bool wait(int timeout = 0) const {
         // TODO: Waiting for a future in a non-default application thread is not supported
         if (ContextT::isApplicationThreadCurrent()) {
@@ -119,16 +369,17 @@ public:
     }
 
 protected:
+    typedef typename FutureCallbackTypes<ResultT>::OnSuccessSlot OnSuccessSlot;
+    typedef typename FutureCallbackTypes<ResultT>::OnErrorSlot OnErrorSlot;
+
     std::atomic<State> state_; // Future state
     std::atomic<bool> done_; // Flag signaling that future is in a final state
-    std::atomic<typename FutureCallbackTypes<ResultT>::OnSuccess*> onSuccess_; // User callback for succeeded operation
-    std::atomic<typename FutureCallbackTypes<ResultT>::OnError*> onError_; // User callback for failed operation
+    OnSuccessSlot onSuccess_; // User callback for succeeded operation
+    OnErrorSlot onError_; // User callback for failed operation
 
     explicit FutureImplBase(State state) :
             state_(state),
-            done_(state != State::RUNNING),
-            onSuccess_(nullptr),
-            onError_(nullptr) {
+            done_(state != State::RUNNING) {
     }
 
     bool changeState(State state) {
@@ -148,34 +399,38 @@ protected:
         return state_.load(std::memory_order_relaxed);
     }
 
-    template<typename FunctionT>
-    static void setCallback(std::atomic<std::function<FunctionT>*>& wrapper, std::function<FunctionT>&& callback) {
-        auto callbackPtr = new std::function<FunctionT>(callback); // New callback
-        callbackPtr = wrapper.exchange(callbackPtr, std::memory_order_acq_rel);
-        delete callbackPtr; // Delete old callback
+    template<typename SignatureT, typename CallbackT>
+    static void setCallback(FutureCallbackSlot<SignatureT>& slot, CallbackT&& callback) {
+        slot.set(FutureCallback<SignatureT>(std::forward<CallbackT>(callback)));
     }
 
-    // Takes a callback from its atomic wrapper and invokes it
-    template<typename FunctionT, typename... ArgsT>
-    static void invokeCallback(std::atomic<std::function<FunctionT>*>& wrapper, ArgsT&&... args) {
-        std::function<FunctionT>* callbackPtr = wrapper.exchange(nullptr, std::memory_order_acq_rel);
-        if (callbackPtr) {
-            invokeCallback(*callbackPtr, std::forward<ArgsT>(args)...);
-            delete callbackPtr;
-        }
+    // Takes a callback from its slot
+    template<typename SignatureT>
+    static FutureCallback<SignatureT> takeCallback(FutureCallbackSlot<SignatureT>& slot) {
+        return slot.take();
     }
 
-    // Invokes std::function in the application context
-    template<typename FunctionT, typename... ArgsT>
-    static void invokeCallback(const std::function<FunctionT>& callback, ArgsT&&... args) {
+    template<typename SignatureT>
+    static bool hasCallback(const FutureCallbackSlot<SignatureT>& slot) {
+        return slot.isSet();
+    }
+
+    // Invokes completion callbacks in the application context
+    void notifyCallbacks() {
         if (ContextT::isApplicationThreadCurrent()) {
-            callback(std::forward<ArgsT>(args)...); // Synchronous call
+            invokeCallbacks(); // Synchronous call
         } else {
-            // Bind all arguments and wrap resulting function into a pointer
-            auto callbackPtr = new std::function<void()>(std::bind(callback, std::forward<ArgsT>(args)...));
-            ContextT::invokeApplicationCallback(futureCallbackWrapper, callbackPtr);
+            // The application context holds a reference to this future until the callbacks are invoked
+            addRef();
+            ContextT::invokeApplicationCallback(futureCallbackWrapper, static_cast<FutureStateBase*>(this));
         }
     }
+
+    void destroy() override {
+        const auto p = static_cast<FutureImpl<ResultT, ContextT>*>(this);
+        p->~FutureImpl();
+        FutureStatePool<sizeof(FutureImpl<ResultT, ContextT>)>::free(p);
+    }
 };
 
 // Internal future implementation
@@ -218,7 +473,9 @@ public:
         if (this->changeState(State::SUCCEEDED)) {
             new(&result_) ResultT(std::move(result));
             this->releaseDone();
-            this->invokeCallback(this->onSuccess_, result_);
+            if (this->hasCallback(this->onSuccess_)) {
+                this->notifyCallbacks();
+            }
         }
     }
 
@@ -234,7 +491,9 @@ public:
         if (this->changeState(State::FAILED)) {
             new(&error_) Error(std::move(error));
             this->releaseDone();
-            this->invokeCallback(this->onError_, error_);
+            if (this->hasCallback(this->onError_)) {
+                this->notifyCallbacks();
+            }
         }
     }
 
@@ -246,18 +505,38 @@ public:
         return Error::NONE;
     }
 
-    void onSuccess(OnSuccessCallback callback) {
-        this->setCallback(this->onSuccess_, std::move(callback));
+    template<typename CallbackT>
+    void onSuccess(CallbackT&& callback) {
+        this->setCallback(this->onSuccess_, std::forward<CallbackT>(callback));
         // Ensure that the newly assigned callback is invoked for already completed future
         if (this->acquireDone() && this->isSucceeded()) {
-            this->invokeCallback(this->onSuccess_, result_);
+            this->notifyCallbacks();
         }
     }
 
-    void onError(OnErrorCallback callback) {
-        this->setCallback(this->onError_, std::move(callback));
+    template<typename CallbackT>
+    void onError(CallbackT&& callback) {
+        this->setCallback(this->onError_, std::forward<CallbackT>(callback));
         if (this->acquireDone() && this->isFailed()) {
-            this->invokeCallback(this->onError_, error_);
+            this->notifyCallbacks();
+        }
+    }
+
+    void invokeCallbacks() override {
+        if (!this->acquireDone()) {
+            return;
+        }
+        const State s = this->state();
+        if (s == State::SUCCEEDED) {
+            auto callback = this->takeCallback(this->onSuccess_);
+            if (callback) {
+                callback(result_);
+            }
+        } else if (s == State::FAILED) {
+            auto callback = this->takeCallback(this->onError_);
+            if (callback) {
+                callback(error_);
+            }
         }
     }
 
@@ -292,7 +571,9 @@ public:
     void setResult() {
         if (this->changeState(State::SUCCEEDED)) {
             this->releaseDone();
-            this->invokeCallback(this->onSuccess_);
+            if (this->hasCallback(this->onSuccess_)) {
+                this->notifyCallbacks();
+            }
         }
     }
 
@@ -300,7 +581,9 @@ public:
         if (this->changeState(State::FAILED)) {
             error_ = std::move(error);
             this->releaseDone();
-            this->invokeCallback(this->onError_, error_);
+            if (this->hasCallback(this->onError_)) {
+                this->notifyCallbacks();
+            }
         }
     }
 
@@ -312,18 +595,38 @@ public:
         return Error::NONE;
     }
 
-    void onSuccess(OnSuccessCallback callback) {
-        this->setCallback(this->onSuccess_, std::move(callback));
+    template<typename CallbackT>
+    void onSuccess(CallbackT&& callback) {
+        this->setCallback(this->onSuccess_, std::forward<CallbackT>(callback));
         // Ensure that the newly assigned callback is invoked for already completed future
         if (this->acquireDone() && this->isSucceeded()) {
-            this->invokeCallback(this->onSuccess_);
+            this->notifyCallbacks();
         }
     }
 
-    void onError(OnErrorCallback callback) {
-        this->setCallback(this->onError_, std::move(callback));
+    template<typename CallbackT>
+    void onError(CallbackT&& callback) {
+        this->setCallback(this->onError_, std::forward<CallbackT>(callback));
         if (this->acquireDone() && this->isFailed()) {
-            this->invokeCallback(this->onError_, error_);
+            this->notifyCallbacks();
+        }
+    }
+
+    void invokeCallbacks() override {
+        if (!this->acquireDone()) {
+            return;
+        }
+        const State s = this->state();
+        if (s == State::SUCCEEDED) {
+            auto callback = this->takeCallback(this->onSuccess_);
+            if (callback) {
+                callback();
+            }
+        } else if (s == State::FAILED) {
+            auto callback = this->takeCallback(this->onError_);
+            if (callback) {
+                callback(error_);
+            }
         }
     }
 
@@ -331,8 +634,71 @@ private:
     Error error_;
 };
 
+// Smart pointer to an intrusively reference-counted future state
 template<typename ResultT, typename ContextT>
-using FutureImplPtr = std::shared_ptr<FutureImpl<ResultT, ContextT>>;
+class FutureImplPtr {
+public:
+    typedef FutureImpl<ResultT, ContextT> Impl;
+
+    FutureImplPtr() :
+            p_(nullptr) {
+    }
+
+    // Takes ownership over a raw pointer. If `addRef` is false, the pointer is expected to hold a
+    // reference already (see FutureImplPtr::detach())
+    explicit FutureImplPtr(Impl* p, bool addRef = true) :
+            p_(p) {
+        if (p_ && addRef) {
+            p_->addRef();
+        }
+    }
+
+    FutureImplPtr(const FutureImplPtr& ptr) :
+            FutureImplPtr(ptr.p_) {
+    }
+
+    FutureImplPtr(FutureImplPtr&& ptr) :
+            p_(ptr.p_) {
+        ptr.p_ = nullptr;
+    }
+
+    ~FutureImplPtr() {
+        if (p_) {
+            p_->release();
+        }
+    }
+
+    // Releases ownership over the pointer without decrementing the reference counter
+    Impl* detach() {
+        const auto p = p_;
+        p_ = nullptr;
+        return p;
+    }
+
+    Impl* get() const {
+        return p_;
+    }
+
+    Impl* operator->() const {
+        return p_;
+    }
+
+    FutureImplPtr& operator=(FutureImplPtr ptr) {
+        std::swap(p_, ptr.p_);
+        return *this;
+    }
+
+private:
+    Impl* p_;
+};
+
+// Allocates a future state from the pool
+template<typename ResultT, typename ContextT, typename... ArgsT>
+inline FutureImplPtr<ResultT, ContextT> makeFutureImpl(ArgsT&&... args) {
+    typedef FutureImpl<ResultT, ContextT> Impl;
+    const auto p = new(FutureStatePool<sizeof(Impl)>::alloc()) Impl(std::forward<ArgsT>(args)...);
+    return FutureImplPtr<ResultT, ContextT>(p);
+}
 
 // Event loop and threading abstraction. Used for unit testing
 struct FutureContext {
@@ -366,7 +732,7 @@ template<typename ResultT, typename ContextT>
 class PromiseBase {
 public:
     PromiseBase() :
-            p_(new detail::FutureImpl<ResultT, ContextT>(State::RUNNING)) {
+            p_(detail::makeFutureImpl<ResultT, ContextT>(State::RUNNING)) {
     }
 
     explicit PromiseBase(detail::FutureImplPtr<ResultT, ContextT> ptr) :
@@ -387,16 +753,13 @@ public:
 
     // Wraps this promise into an object pointer that can be passed to a C function
     void* dataPtr() const {
-        // TODO: Use custom reference counting object to avoid unnecessary memory allocation
-        return new detail::FutureImplPtr<ResultT, ContextT>(p_);
+        return detail::FutureImplPtr<ResultT, ContextT>(p_).detach();
     }
 
     // Unwraps promise from an object pointer created via dataPtr() method
     static Promise<ResultT, ContextT> fromDataPtr(void* data) {
-        auto d = static_cast<detail::FutureImplPtr<ResultT, ContextT>*>(data);
-        const Promise<ResultT, ContextT> p(*d);
-        delete d;
-        return p;
+        auto d = static_cast<detail::FutureImpl<ResultT, ContextT>*>(data);
+        return Promise<ResultT, ContextT>(detail::FutureImplPtr<ResultT, ContextT>(d, false /* addRef */));
     }
 
 protected:
@@ -458,7 +821,7 @@ public:
 
     // Construct failed future
     explicit FutureBase(Error error) :
-            p_(new detail::FutureImpl<ResultT, ContextT>(std::move(error))) {
+            p_(detail::makeFutureImpl<ResultT, ContextT>(std::move(error))) {
     }
 
     explicit FutureBase(Error::Type error) :
@@ -497,13 +860,17 @@ public:
         return p_->isDone();
     }
 
-    Future<ResultT, ContextT>& onSuccess(OnSuccessCallback callback) {
-        p_->onSuccess(std::move(callback));
+    // Callbacks can be any callable objects compatible with OnSuccessCallback and OnErrorCallback.
+    // Small function objects are stored without heap allocation
+    template<typename CallbackT>
+    Future<ResultT, ContextT>& onSuccess(CallbackT&& callback) {
+        p_->onSuccess(std::forward<CallbackT>(callback));
         return *static_cast<Future<ResultT, ContextT>*>(this);
     }
 
-    Future<ResultT, ContextT>& onError(OnErrorCallback callback) {
-        p_->onError(std::move(callback));
+    template<typename CallbackT>
+    Future<ResultT, ContextT>& onError(CallbackT&& callback) {
+        p_->onError(std::forward<CallbackT>(callback));
         return *static_cast<Future<ResultT, ContextT>*>(this);
     }
 
@@ -520,7 +887,7 @@ public:
 
     // Constructs succeeded future
     explicit Future(ResultT result = ResultT()) :
-            FutureBase<ResultT, ContextT>(std::make_shared<detail::FutureImpl<ResultT, ContextT>>(std::move(result))) {
+            FutureBase<ResultT, ContextT>(detail::makeFutureImpl<ResultT, ContextT>(std::move(result))) {
     }
 
     ResultT result() const {
@@ -544,7 +911,7 @@ public:
 
     // Constructs succeeded future
     Future() :
-            FutureBase<void, ContextT>(std::make_shared<detail::FutureImpl<void, ContextT>>(State::SUCCEEDED)) {
+            FutureBase<void, ContextT>(detail::makeFutureImpl<void, ContextT>(State::SUCCEEDED)) {
     }
 
 private:
@@ -0,0 +1,285 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "spark_wiring_print.h"
+#include "spark_wiring_string.h"
+
+#include <cstring>
+#include <cstdint>
+
+namespace particle {
+
+/**
+ * CBOR data item types (RFC 7049).
+ */
+enum class CBORType {
+    INVALID,
+    UNSIGNED_INT,
+    NEGATIVE_INT,
+    BYTES,
+    TEXT,
+    ARRAY,
+    MAP,
+    TAG,
+    BOOL,
+    NULL_VALUE,
+    UNDEFINED,
+    FLOAT,
+    BREAK // End of an indefinite-length array or map
+};
+
+/**
+ * Abstract CBOR document writer.
+ *
+ * Arrays and maps can be written with a known number of elements, which is the most compact
+ * encoding, or as indefinite-length items terminated with `endArray()` or `endMap()`. Map keys
+ * are written with `name()` or any of the `value()` methods.
+ */
+class CBORWriter {
+public:
+    CBORWriter() = default;
+    virtual ~CBORWriter() = default;
+
+    CBORWriter& beginArray();
+    CBORWriter& beginArray(size_t count);
+    CBORWriter& endArray();
+    CBORWriter& beginMap();
+    CBORWriter& beginMap(size_t count);
+    CBORWriter& endMap();
+    CBORWriter& name(const char* name);
+    CBORWriter& name(const char* name, size_t size);
+    CBORWriter& name(const String& name);
+    CBORWriter& value(bool val);
+    CBORWriter& value(int val);
+    CBORWriter& value(unsigned val);
+    CBORWriter& value(long val);
+    CBORWriter& value(unsigned long val);
+    CBORWriter& value(long long val);
+    CBORWriter& value(unsigned long long val);
+    CBORWriter& value(float val);
+    CBORWriter& value(double val); // Encoded as a single-precision value if no precision is lost
+    CBORWriter& value(const char* val);
+    CBORWriter& value(const char* val, size_t size);
+    CBORWriter& value(const String& val);
+    CBORWriter& bytes(const void* data, size_t size);
+    CBORWriter& tag(uint64_t tag);
+    CBORWriter& nullValue();
+
+protected:
+    virtual void write(const uint8_t* data, size_t size) = 0;
+
+private:
+    void writeHead(uint8_t majorType, uint64_t val);
+    void writeByte(uint8_t b);
+};
+
+class CBORStreamWriter: public CBORWriter {
+public:
+    explicit CBORStreamWriter(Print& stream);
+
+    Print* stream() const;
+
+protected:
+    virtual void write(const uint8_t* data, size_t size) override;
+
+private:
+    Print& strm_;
+};
+
+class CBORBufferWriter: public CBORWriter {
+public:
+    CBORBufferWriter(uint8_t* buf, size_t size);
+
+    uint8_t* buffer() const;
+    size_t bufferSize() const;
+
+    size_t dataSize() const; // Returned value can be greater than buffer size
+
+protected:
+    virtual void write(const uint8_t* data, size_t size) override;
+
+private:
+    uint8_t* buf_;
+    size_t bufSize_, n_;
+};
+
+/**
+ * Pull parser for CBOR documents.
+ *
+ * Each call to `next()` decodes the next data item. The elements of an array or map are decoded
+ * by subsequent calls to `next()`; `skip()` can be used to skip the contents of a compound item.
+ * The reader doesn't copy the document data. Indefinite-length strings are not supported.
+ */
+class CBORReader {
+public:
+    CBORReader(const uint8_t* data, size_t size);
+
+    bool next();
+    bool skip();
+
+    CBORType type() const;
+
+    bool isIndefinite() const;
+    bool hasError() const;
+
+    bool toBool() const;
+    int64_t toInt() const;
+    uint64_t toUInt() const;
+    double toDouble() const;
+    String toString() const;
+
+    const char* data() const; // Text or byte string data
+    size_t size() const; // Size of a string, or number of elements in an array or map
+
+    size_t offset() const;
+
+private:
+    const uint8_t* data_;
+    size_t size_;
+    size_t offs_;
+    CBORType type_;
+    uint64_t val_;
+    double dval_;
+    const char* str_;
+    bool indef_;
+    bool error_;
+
+    bool readHead(uint8_t* majorType, uint8_t* info, uint64_t* val);
+    bool setError();
+};
+
+} // namespace particle
+
+// particle::CBORWriter
+inline particle::CBORWriter& particle::CBORWriter::name(const char* name) {
+    return value(name, strlen(name));
+}
+
+inline particle::CBORWriter& particle::CBORWriter::name(const char* name, size_t size) {
+    return value(name, size);
+}
+
+inline particle::CBORWriter& particle::CBORWriter::name(const String& name) {
+    return value(name.c_str(), name.length());
+}
+
+inline particle::CBORWriter& particle::CBORWriter::value(const char* val) {
+    return value(val, strlen(val));
+}
+
+inline particle::CBORWriter& particle::CBORWriter::value(const String& val) {
+    return value(val.c_str(), val.length());
+}
+
+inline particle::CBORWriter& particle::CBORWriter::value(int val) {
+    return value((long long)val);
+}
+
+inline particle::CBORWriter& particle::CBORWriter::value(unsigned val) {
+    return value((unsigned long long)val);
+}
+
+inline particle::CBORWriter& particle::CBORWriter::value(long val) {
+    return value((long long)val);
+}
+
+inline particle::CBORWriter& particle::CBORWriter::value(unsigned long val) {
+    return value((unsigned long long)val);
+}
+
+inline void particle::CBORWriter::writeByte(uint8_t b) {
+    write(&b, 1);
+}
+
+// particle::CBORStreamWriter
+inline particle::CBORStreamWriter::CBORStreamWriter(Print& stream) :
+        strm_(stream) {
+}
+
+inline Print* particle::CBORStreamWriter::stream() const {
+    return &strm_;
+}
+
+inline void particle::CBORStreamWriter::write(const uint8_t* data, size_t size) {
+    strm_.write(data, size);
+}
+
+// particle::CBORBufferWriter
+inline particle::CBORBufferWriter::CBORBufferWriter(uint8_t* buf, size_t size) :
+        buf_(buf),
+        bufSize_(size),
+        n_(0) {
+}
+
+inline uint8_t* particle::CBORBufferWriter::buffer() const {
+    return buf_;
+}
+
+inline size_t particle::CBORBufferWriter::bufferSize() const {
+    return bufSize_;
+}
+
+inline size_t particle::CBORBufferWriter::dataSize() const {
+    return n_;
+}
+
+// particle::CBORReader
+inline particle::CBORReader::CBORReader(const uint8_t* data, size_t size) :
+        data_(data),
+        size_(size),
+        offs_(0),
+        type_(CBORType::INVALID),
+        val_(0),
+        dval_(0),
+        str_(nullptr),
+        indef_(false),
+        error_(false) {
+}
+
+inline particle::CBORType particle::CBORReader::type() const {
+    return type_;
+}
+
+inline bool particle::CBORReader::isIndefinite() const {
+    return indef_;
+}
+
+inline bool particle::CBORReader::hasError() const {
+    return error_;
+}
+
+inline bool particle::CBORReader::toBool() const {
+    return (type_ == CBORType::BOOL) && val_;
+}
+
+inline const char* particle::CBORReader::data() const {
+    return str_;
+}
+
+inline size_t particle::CBORReader::size() const {
+    return (type_ == CBORType::TEXT || type_ == CBORType::BYTES || type_ == CBORType::ARRAY || type_ == CBORType::MAP) ? val_ : 0;
+}
+
+inline size_t particle::CBORReader::offset() const {
+    return offs_;
+}
+
+inline String particle::CBORReader::toString() const {
+    return (type_ == CBORType::TEXT) ? String(str_, val_) : String();
+}
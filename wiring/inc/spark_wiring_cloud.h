@@ -44,6 +44,28 @@
 typedef std::function<user_function_int_str_t> user_std_function_int_str_t;
 typedef std::function<void (const char*, const char*)> wiring_event_handler_t;
 
+namespace particle {
+
+/**
+ * Content type of event data.
+ */
+enum class ContentType {
+    TEXT = CLOUD_CONTENT_TYPE_TEXT,
+    BINARY = CLOUD_CONTENT_TYPE_BINARY,
+    JSON = CLOUD_CONTENT_TYPE_JSON,
+    CBOR = CLOUD_CONTENT_TYPE_CBOR
+};
+
+} // namespace particle
+
+// Handler for events with binary data. The data is not null-terminated
+typedef std::function<void (const char* name, const uint8_t* data, size_t size, particle::ContentType type)> wiring_binary_event_handler_t;
+
+// Reads a block of a string variable's value. The function returns the number of bytes read or a
+// negative result code, and stores the total size of the value in `totalSize`. It is called in the
+// system thread and needs to be thread-safe
+typedef int (cloud_variable_reader_fn)(size_t offset, char* data, size_t size, size_t* totalSize);
+
 #ifndef __XSTRING
 #define	__STRING(x)	#x		/* stringify without expanding x */
 #define	__XSTRING(x)	__STRING(x)	/* expand x, then stringify */
@@ -57,6 +79,8 @@ const PublishFlag PUBLIC(PUBLISH_EVENT_FLAG_PUBLIC);
 const PublishFlag PRIVATE(PUBLISH_EVENT_FLAG_PRIVATE);
 const PublishFlag NO_ACK(PUBLISH_EVENT_FLAG_NO_ACK);
 const PublishFlag WITH_ACK(PUBLISH_EVENT_FLAG_WITH_ACK);
+const PublishFlag PERSISTENT(PUBLISH_EVENT_FLAG_PERSISTENT);
+const PublishFlag PRIORITY_HIGH(PUBLISH_EVENT_FLAG_PRIORITY_HIGH);
 
 // Test if the paramater a regular C "string" literal
 template <typename T>
@@ -93,6 +117,31 @@ private:
     CloudDisconnectOptions(unsigned flags, system_tick_t timeout, bool graceful);
 };
 
+class CloudFunctionOptions {
+public:
+    CloudFunctionOptions();
+
+    // Run the function on a system worker thread, concurrently with the application loop
+    CloudFunctionOptions& concurrent(bool enabled);
+    bool concurrent() const;
+
+    // Maximum number of concurrent calls of the function (1 by default)
+    CloudFunctionOptions& maxConcurrency(uint16_t count);
+    uint16_t maxConcurrency() const;
+
+    // Time after which the cloud receives a timeout error if the function hasn't returned
+    CloudFunctionOptions& timeout(system_tick_t timeout);
+    CloudFunctionOptions& timeout(std::chrono::milliseconds ms);
+    system_tick_t timeout() const;
+
+    void toSystemDescriptor(cloud_function_descriptor* desc) const;
+
+private:
+    system_tick_t timeout_;
+    uint16_t maxConcurrency_;
+    bool concurrent_;
+};
+
 class CloudClass {
 public:
     template <typename T, typename... ArgsT>
@@ -205,6 +254,10 @@ public:
         return false;
     }
 
+    // Registers a string variable whose value is read in blocks on demand. Large values are sent
+    // to the cloud block by block without copying the entire value
+    static bool _variable(const char* varKey, cloud_variable_reader_fn* reader);
+
     template <typename T, class ... Types>
     static inline bool function(const T &name, Types ... args)
     {
@@ -238,6 +291,30 @@ public:
       return _function(funcKey, std::bind(func, instance, _1));
     }
 
+    static bool _function(const char *funcKey, user_function_int_str_t* func, const CloudFunctionOptions& options)
+    {
+        return register_function(call_raw_user_function, (void*)func, funcKey, &options);
+    }
+
+    static bool _function(const char *funcKey, user_std_function_int_str_t func, const CloudFunctionOptions& options)
+    {
+        bool success = false;
+        if (func)
+        {
+            auto wrapper = new user_std_function_int_str_t(func);
+            if (wrapper) {
+                success = register_function(call_std_user_function, wrapper, funcKey, &options);
+            }
+        }
+        return success;
+    }
+
+    template <typename T>
+    static bool _function(const char *funcKey, int (T::*func)(String), T *instance, const CloudFunctionOptions& options) {
+      using namespace std::placeholders;
+      return _function(funcKey, std::bind(func, instance, _1), options);
+    }
+
     inline particle::Future<bool> publish(const char *eventName, PublishFlags flags1, PublishFlags flags2 = PublishFlags())
     {
         return publish(eventName, NULL, flags1, flags2);
@@ -257,6 +334,20 @@ public:
     particle::Future<bool> publish(const char* name, const char* data);
     particle::Future<bool> publish(const char* name, const char* data, int ttl);
 
+    /**
+     * Publish an event with binary data.
+     *
+     * @param name Event name.
+     * @param data Event data.
+     * @param size Size of the event data.
+     * @param type Content type of the event data.
+     */
+    inline particle::Future<bool> publish(const char* name, const void* data, size_t size, particle::ContentType type,
+            PublishFlags flags1 = PublishFlags(), PublishFlags flags2 = PublishFlags())
+    {
+        return publish_event(name, (const char*)data, size, type, DEFAULT_CLOUD_EVENT_TTL, flags1 | flags2);
+    }
+
     /**
      * @brief Publish vitals information
      *
@@ -318,6 +409,13 @@ public:
 
     bool subscribe(const char* name, EventHandler handler);
     bool subscribe(const char* name, wiring_event_handler_t handler);
+
+    /**
+     * Subscribe to events with binary data. The handler receives the size and content type of
+     * the event data; text events are delivered with `ContentType::TEXT`.
+     */
+    bool subscribe(const char* name, wiring_binary_event_handler_t handler, Spark_Subscription_Scope_TypeDef scope = ALL_DEVICES,
+            const char* deviceID = nullptr);
     template<typename T>
     bool subscribe(const char* name, void (T::*handler)(const char*, const char*), T* instance);
 
@@ -398,13 +496,19 @@ public:
 
 private:
 
-    static bool register_function(cloud_function_t fn, void* data, const char* funcKey);
+    static bool register_function(cloud_function_t fn, void* data, const char* funcKey, const CloudFunctionOptions* options = nullptr);
+    static int read_variable_block(const void* var, size_t offset, void* data, size_t size, size_t* total_size);
+    static int copy_variable_blocks(const void* var, void** data, size_t* size);
     static int call_raw_user_function(void* data, const char* param, void* reserved);
     static int call_std_user_function(void* data, const char* param, void* reserved);
 
     static void call_wiring_event_handler(const void* param, const char *event_name, const char *data);
+    static void call_wiring_binary_event_handler(void* param, const char* event_name, const char* data, size_t data_size,
+            unsigned content_type);
 
     static particle::Future<bool> publish_event(const char *eventName, const char *eventData, int ttl, PublishFlags flags);
+    static particle::Future<bool> publish_event(const char* eventName, const char* eventData, size_t dataSize,
+            particle::ContentType type, int ttl, PublishFlags flags);
 
     static ProtocolFacade* sp()
     {
@@ -554,6 +658,49 @@ inline bool CloudDisconnectOptions::isTimeoutSet() const {
     return (flags_ & OptionFlag::TIMEOUT);
 }
 
+inline CloudFunctionOptions::CloudFunctionOptions() :
+        timeout_(0),
+        maxConcurrency_(1),
+        concurrent_(false) {
+}
+
+inline CloudFunctionOptions& CloudFunctionOptions::concurrent(bool enabled) {
+    concurrent_ = enabled;
+    return *this;
+}
+
+inline bool CloudFunctionOptions::concurrent() const {
+    return concurrent_;
+}
+
+inline CloudFunctionOptions& CloudFunctionOptions::maxConcurrency(uint16_t count) {
+    maxConcurrency_ = count;
+    return *this;
+}
+
+inline uint16_t CloudFunctionOptions::maxConcurrency() const {
+    return maxConcurrency_;
+}
+
+inline CloudFunctionOptions& CloudFunctionOptions::timeout(system_tick_t timeout) {
+    timeout_ = timeout;
+    return *this;
+}
+
+inline CloudFunctionOptions& CloudFunctionOptions::timeout(std::chrono::milliseconds ms) {
+    return timeout(ms.count());
+}
+
+inline system_tick_t CloudFunctionOptions::timeout() const {
+    return timeout_;
+}
+
+inline void CloudFunctionOptions::toSystemDescriptor(cloud_function_descriptor* desc) const {
+    desc->flags = concurrent_ ? CLOUD_FUNCTION_FLAG_CONCURRENT : 0;
+    desc->max_concurrency = maxConcurrency_;
+    desc->timeout = timeout_;
+}
+
 inline particle::Future<bool> CloudClass::publish(const char* name) {
     return publish(name, PUBLIC);
 }
@@ -0,0 +1,226 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "hal_platform.h"
+
+#if HAL_PLATFORM_FILESYSTEM
+
+#include <cstddef>
+#include <cstdint>
+
+namespace particle {
+
+/**
+ * Circular log of records stored on the filesystem.
+ *
+ * The log is stored in a directory as a sequence of segment files, each holding a fixed number of
+ * fixed-size record slots. Records are only ever appended to the newest segment, and once the log
+ * reaches its maximum number of segments, the oldest segment is removed as a whole. This keeps
+ * the cost of appending a record independent of the amount of logged data, and allows reading any
+ * record by its index without scanning the log.
+ *
+ * Each record is assigned a sequential index, starting from 0 for the first record ever written
+ * to the log. The indices of the records that are still available are in the range
+ * [`begin()`, `end()`).
+ *
+ * Appended records are durable once `sync()` is called, or when the log starts a new segment or
+ * is closed. After a reset, the log is recovered to its last durable state.
+ *
+ * The log also stores a persistent "consumed" position, which can be used to keep track of the
+ * records that have already been sent elsewhere. See `RecordLogReader`.
+ *
+ * This class is not thread-safe.
+ */
+class RecordLog {
+public:
+    RecordLog();
+    ~RecordLog();
+
+    /**
+     * Open or create a log.
+     *
+     * The capacity of the log is `maxSegments * recordsPerSegment` records. An existing log must
+     * have been created with the same record and segment sizes.
+     *
+     * @param dir Directory of the log. The directory is created if it doesn't exist.
+     * @param recordSize Maximum size of a record in bytes.
+     * @param recordsPerSegment Number of records per segment file.
+     * @param maxSegments Maximum number of segment files (at least 2).
+     * @return 0 on success, or a negative result code in case of an error.
+     */
+    int open(const char* dir, size_t recordSize, size_t recordsPerSegment, size_t maxSegments);
+    /**
+     * Close the log.
+     *
+     * @return 0 on success, or a negative result code in case of an error.
+     */
+    int close();
+
+    /**
+     * Append a record.
+     *
+     * @param data Record data.
+     * @param size Size of the data, which can't exceed the record size of the log.
+     * @param index[out] Index of the appended record.
+     * @return 0 on success, or a negative result code in case of an error.
+     */
+    int append(const void* data, size_t size, uint32_t* index = nullptr);
+    /**
+     * Read a record.
+     *
+     * @param index Record index.
+     * @param data Buffer for the record data.
+     * @param size Buffer size. If the buffer is smaller than the record, the data is truncated.
+     * @return Size of the record, `SYSTEM_ERROR_NOT_FOUND` if the record is not available, or
+     *         another negative result code in case of an error.
+     */
+    int read(uint32_t index, void* data, size_t size);
+    /**
+     * Make all appended records durable.
+     *
+     * @return 0 on success, or a negative result code in case of an error.
+     */
+    int sync();
+
+    /**
+     * Get the index of the oldest available record.
+     */
+    uint32_t begin() const {
+        return tailSeg_ * recordsPerSeg_;
+    }
+    /**
+     * Get the index following the newest record.
+     */
+    uint32_t end() const {
+        return headSeg_ * recordsPerSeg_ + headCount_;
+    }
+    /**
+     * Get the number of available records.
+     */
+    uint32_t count() const {
+        return end() - begin();
+    }
+
+    /**
+     * Get the consumed position.
+     *
+     * @return Index of the first record that has not been consumed yet.
+     */
+    uint32_t consumed() const;
+    /**
+     * Set and persist the consumed position.
+     *
+     * @param index Index of the first record that has not been consumed yet.
+     * @return 0 on success, or a negative result code in case of an error.
+     */
+    int consumed(uint32_t index);
+
+    /**
+     * Check if the log is open.
+     */
+    bool isOpen() const {
+        return path_;
+    }
+
+    RecordLog(const RecordLog&) = delete;
+    RecordLog& operator=(const RecordLog&) = delete;
+
+private:
+    char* path_; // Directory path followed by a buffer for a file name
+    size_t dirLen_;
+    uint8_t* slot_; // Buffer for a record slot
+    size_t recordSize_;
+    uint32_t recordsPerSeg_;
+    uint32_t maxSegs_;
+    uint32_t tailSeg_;
+    uint32_t headSeg_;
+    uint32_t headCount_;
+    uint32_t consumed_;
+    int headFd_;
+    int readFd_;
+    uint32_t readSeg_;
+
+    int recover();
+    int loadConsumed();
+    int startSegment();
+    int readFd(uint32_t seg);
+    const char* filePath(const char* name);
+    const char* segmentPath(uint32_t seg);
+    size_t slotSize() const;
+    void reset();
+};
+
+/**
+ * Sequential reader of a record log.
+ *
+ * The reader starts at the consumed position of the log. Records that were removed from the log
+ * before they could be read are skipped. Once the records have been sent elsewhere, calling
+ * `commit()` persists the position of the reader as the consumed position of the log, so that
+ * the records are not sent again after a reset:
+ * ```
+ * RecordLogReader reader(log);
+ * uint8_t buf[RECORD_SIZE];
+ * int size = 0;
+ * while ((size = reader.next(buf, sizeof(buf))) >= 0) {
+ *     Serial.write(buf, size);
+ * }
+ * reader.commit();
+ * ```
+ */
+class RecordLogReader {
+public:
+    explicit RecordLogReader(RecordLog& log);
+
+    /**
+     * Read the next record.
+     *
+     * @param data Buffer for the record data.
+     * @param size Buffer size.
+     * @param index[out] Index of the record.
+     * @return Size of the record, `SYSTEM_ERROR_END_OF_STREAM` if there are no more records, or
+     *         another negative result code in case of an error.
+     */
+    int next(void* data, size_t size, uint32_t* index = nullptr);
+    /**
+     * Set the position of the reader.
+     */
+    void seek(uint32_t index) {
+        pos_ = index;
+    }
+    /**
+     * Get the index of the next record to be read.
+     */
+    uint32_t position() const {
+        return pos_;
+    }
+    /**
+     * Persist the position of the reader as the consumed position of the log.
+     *
+     * @return 0 on success, or a negative result code in case of an error.
+     */
+    int commit();
+
+private:
+    RecordLog& log_;
+    uint32_t pos_;
+};
+
+} // namespace particle
+
+#endif // HAL_PLATFORM_FILESYSTEM
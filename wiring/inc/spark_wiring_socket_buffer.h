@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "hal_platform.h"
+
+#if HAL_PLATFORM_SOCKET_BUFFERS
+
+#include "spark_wiring_ipaddress.h"
+#include "socket_hal.h"
+
+#include <utility>
+
+/**
+ * Buffer of the network stack lent to the application.
+ *
+ * This class allows reading received data and writing data to send without copying it to or
+ * from an intermediate buffer. The buffer is returned to the network stack when the object is
+ * destroyed or `release()` is called.
+ *
+ * Received data can be stored in a number of fragments:
+ * ```
+ * SocketBuffer buf;
+ * if (udp.receivePacket(&buf) > 0) {
+ *     do {
+ *         process(buf.data(), buf.size());
+ *     } while (buf.next());
+ * }
+ * ```
+ */
+class SocketBuffer {
+public:
+    SocketBuffer() :
+            buf_() {
+        buf_.size = sizeof(buf_);
+    }
+
+    SocketBuffer(SocketBuffer&& buf) :
+            SocketBuffer() {
+        swap(*this, buf);
+    }
+
+    ~SocketBuffer() {
+        release();
+    }
+
+    /**
+     * Get the data of the current fragment.
+     */
+    uint8_t* data() const {
+        return buf_.data;
+    }
+
+    /**
+     * Get the size of the current fragment.
+     */
+    size_t size() const {
+        return buf_.len;
+    }
+
+    /**
+     * Move to the next fragment of the received data.
+     *
+     * @return `true` if there's more data, or `false` otherwise.
+     */
+    bool next() {
+        return buf_.handle && socket_buffer_next(&buf_, nullptr) > 0;
+    }
+
+    /**
+     * Return the buffer to the network stack.
+     */
+    void release() {
+        socket_release_buffer(&buf_, nullptr);
+    }
+
+    /**
+     * Check if the buffer is valid.
+     */
+    bool isValid() const {
+        return buf_.handle;
+    }
+
+    /**
+     * Get the address of the remote host (UDP only).
+     */
+    IPAddress remoteIP() const {
+        return IPAddress(buf_.addr.sa_data[2], buf_.addr.sa_data[3], buf_.addr.sa_data[4], buf_.addr.sa_data[5]);
+    }
+
+    /**
+     * Get the port of the remote host (UDP only).
+     */
+    uint16_t remotePort() const {
+        return buf_.addr.sa_data[0] << 8 | buf_.addr.sa_data[1];
+    }
+
+    explicit operator bool() const {
+        return isValid();
+    }
+
+    SocketBuffer& operator=(SocketBuffer&& buf) {
+        SocketBuffer b(std::move(buf));
+        swap(*this, b);
+        return *this;
+    }
+
+    SocketBuffer(const SocketBuffer&) = delete;
+    SocketBuffer& operator=(const SocketBuffer&) = delete;
+
+private:
+    socket_buffer_t buf_;
+
+    friend void swap(SocketBuffer& buf1, SocketBuffer& buf2) {
+        using std::swap;
+        swap(buf1.buf_, buf2.buf_);
+    }
+
+    friend class UDP;
+    friend class TCPClient;
+};
+
+#endif // HAL_PLATFORM_SOCKET_BUFFERS
@@ -31,6 +31,7 @@
 #include "spark_wiring_ipaddress.h"
 #include "spark_wiring_print.h"
 #include "socket_hal.h"
+#include "spark_wiring_socket_buffer.h"
 
 #include <memory>
 
@@ -58,6 +59,40 @@ public:
     virtual int peek();
     virtual void flush();
     void flush_buffer();
+
+#if HAL_PLATFORM_SOCKET_BUFFERS
+    /**
+     * Receive data without copying it. The data is referenced by the buffer until the buffer
+     * is released.
+     *
+     * Data already buffered by `available()`, `read()` or `peek()` needs to be read first.
+     *
+     * @param buf Buffer.
+     * @param timeout Timeout in milliseconds.
+     * @return Size of the received data, 0 if no data was received, or a negative value on error.
+     */
+    int receive(SocketBuffer* buf, system_tick_t timeout = 0);
+
+    /**
+     * Allocate a buffer of the network stack for sending data. The data can be written directly
+     * to the buffer and then sent with `send()`.
+     *
+     * @param buf Buffer.
+     * @param size Size of the data.
+     * @return Size of the allocated buffer, which can be smaller than requested, or a negative
+     *         value on error.
+     */
+    int allocBuffer(SocketBuffer* buf, size_t size);
+
+    /**
+     * Send a buffer allocated with `allocBuffer()`. The buffer is released in any case.
+     *
+     * @param buf Buffer.
+     * @param size Size of the data.
+     * @return Number of bytes sent, or a negative value on error.
+     */
+    int send(SocketBuffer* buf, size_t size);
+#endif // HAL_PLATFORM_SOCKET_BUFFERS
     virtual void stop();
     virtual uint8_t connected();
     virtual operator bool();
@@ -31,6 +31,7 @@
 #include "spark_wiring_printable.h"
 #include "spark_wiring_stream.h"
 #include "socket_hal.h"
+#include "spark_wiring_socket_buffer.h"
 
 class UDP : public Stream, public Printable {
 private:
@@ -153,6 +154,40 @@ public:
         return receivePacket((uint8_t*)buffer, buf_size, timeout);
     }
 
+#if HAL_PLATFORM_SOCKET_BUFFERS
+    /**
+     * Retrieves a packet without copying its data. The packet is referenced by the buffer until
+     * the buffer is released.
+     *
+     * @param buf           The buffer
+     * @param timeout       The timeout in milliseconds
+     * @return The size of the packet, 0 if no packet was received, or a negative value on error.
+     */
+    int receivePacket(SocketBuffer* buf, system_tick_t timeout = 0);
+
+    /**
+     * Allocates a buffer of the network stack for a packet. The packet data can be written
+     * directly to the buffer and then sent with `sendPacket()`.
+     *
+     * @param buf           The buffer
+     * @param size          The size of the packet
+     * @return The size of the allocated buffer, which can be smaller than requested, or a negative
+     *         value on error.
+     */
+    int allocPacket(SocketBuffer* buf, size_t size);
+
+    /**
+     * Sends a packet allocated with `allocPacket()`. The buffer is released in any case.
+     *
+     * @param buf           The buffer
+     * @param size          The size of the packet data
+     * @param destination   The destination address
+     * @param port          The destination port
+     * @return The number of bytes sent, or a negative value on error.
+     */
+    int sendPacket(SocketBuffer* buf, size_t size, IPAddress destination, uint16_t port);
+#endif // HAL_PLATFORM_SOCKET_BUFFERS
+
     /**
      * Begin writing a packet to the given destination.
      * @param ip        The IP address of the destination peer.
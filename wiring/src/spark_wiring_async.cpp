@@ -18,7 +18,7 @@
 #include "spark_wiring_async.h"
 
 void particle::detail::futureCallbackWrapper(void* data) {
-    auto callbackPtr = static_cast<const std::function<void()>*>(data);
-    (*callbackPtr)();
-    delete callbackPtr;
+    const auto state = static_cast<FutureStateBase*>(data);
+    state->invokeCallbacks();
+    state->release();
 }
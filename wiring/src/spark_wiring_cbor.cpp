@@ -0,0 +1,437 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "spark_wiring_cbor.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+using namespace particle;
+
+enum MajorType {
+    MAJOR_UNSIGNED_INT = 0,
+    MAJOR_NEGATIVE_INT = 1,
+    MAJOR_BYTES = 2,
+    MAJOR_TEXT = 3,
+    MAJOR_ARRAY = 4,
+    MAJOR_MAP = 5,
+    MAJOR_TAG = 6,
+    MAJOR_SIMPLE = 7
+};
+
+enum SimpleValue {
+    SIMPLE_FALSE = 20,
+    SIMPLE_TRUE = 21,
+    SIMPLE_NULL = 22,
+    SIMPLE_UNDEFINED = 23,
+    SIMPLE_HALF_FLOAT = 25,
+    SIMPLE_FLOAT = 26,
+    SIMPLE_DOUBLE = 27
+};
+
+const uint8_t INDEFINITE_LENGTH = 31;
+const uint8_t BREAK_CODE = 0xff;
+
+// Maximum nesting level of compound items that can be skipped
+const unsigned MAX_SKIP_DEPTH = 16;
+
+double halfToDouble(uint16_t h) {
+    const int exp = (h >> 10) & 0x1f;
+    const int mant = h & 0x3ff;
+    double v = 0;
+    if (exp == 0) {
+        v = std::ldexp(mant, -24);
+    } else if (exp != 31) {
+        v = std::ldexp(mant + 1024, exp - 25);
+    } else {
+        v = mant ? NAN : INFINITY;
+    }
+    return (h & 0x8000) ? -v : v;
+}
+
+bool skipItem(CBORReader* r, unsigned depth) {
+    if (depth > MAX_SKIP_DEPTH) {
+        return false;
+    }
+    const auto type = r->type();
+    if (type != CBORType::ARRAY && type != CBORType::MAP) {
+        return !r->hasError();
+    }
+    if (r->isIndefinite()) {
+        for (;;) {
+            if (!r->next()) {
+                return false;
+            }
+            if (r->type() == CBORType::BREAK) {
+                return true;
+            }
+            if (!skipItem(r, depth + 1)) {
+                return false;
+            }
+        }
+    }
+    uint64_t count = r->size();
+    if (type == CBORType::MAP) {
+        count *= 2;
+    }
+    for (uint64_t i = 0; i < count; ++i) {
+        if (!r->next() || r->type() == CBORType::BREAK || !skipItem(r, depth + 1)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Converting a floating point value that is out of the range of the integer type is undefined
+// behavior, so the value is clamped first. 2^63 and 2^64 are exactly representable as doubles,
+// unlike the maximum values of the integer types
+int64_t doubleToInt(double val) {
+    if (std::isnan(val)) {
+        return 0;
+    }
+    if (val >= 9223372036854775808.0) {
+        return std::numeric_limits<int64_t>::max();
+    }
+    if (val <= -9223372036854775808.0) {
+        return std::numeric_limits<int64_t>::min();
+    }
+    return val;
+}
+
+uint64_t doubleToUInt(double val) {
+    if (std::isnan(val) || val <= 0) {
+        return 0;
+    }
+    if (val >= 18446744073709551616.0) {
+        return std::numeric_limits<uint64_t>::max();
+    }
+    return val;
+}
+
+} // namespace
+
+// particle::CBORWriter
+particle::CBORWriter& particle::CBORWriter::beginArray() {
+    writeByte((MAJOR_ARRAY << 5) | INDEFINITE_LENGTH);
+    return *this;
+}
+
+particle::CBORWriter& particle::CBORWriter::beginArray(size_t count) {
+    writeHead(MAJOR_ARRAY, count);
+    return *this;
+}
+
+particle::CBORWriter& particle::CBORWriter::endArray() {
+    writeByte(BREAK_CODE);
+    return *this;
+}
+
+particle::CBORWriter& particle::CBORWriter::beginMap() {
+    writeByte((MAJOR_MAP << 5) | INDEFINITE_LENGTH);
+    return *this;
+}
+
+particle::CBORWriter& particle::CBORWriter::beginMap(size_t count) {
+    writeHead(MAJOR_MAP, count);
+    return *this;
+}
+
+particle::CBORWriter& particle::CBORWriter::endMap() {
+    writeByte(BREAK_CODE);
+    return *this;
+}
+
+particle::CBORWriter& particle::CBORWriter::value(bool val) {
+    writeByte((MAJOR_SIMPLE << 5) | (val ? SIMPLE_TRUE : SIMPLE_FALSE));
+    return *this;
+}
+
+particle::CBORWriter& particle::CBORWriter::value(long long val) {
+    if (val < 0) {
+        writeHead(MAJOR_NEGATIVE_INT, -1 - val);
+    } else {
+        writeHead(MAJOR_UNSIGNED_INT, val);
+    }
+    return *this;
+}
+
+particle::CBORWriter& particle::CBORWriter::value(unsigned long long val) {
+    writeHead(MAJOR_UNSIGNED_INT, val);
+    return *this;
+}
+
+particle::CBORWriter& particle::CBORWriter::value(float val) {
+    uint32_t v = 0;
+    memcpy(&v, &val, sizeof(v));
+    const uint8_t d[5] = { (MAJOR_SIMPLE << 5) | SIMPLE_FLOAT, (uint8_t)(v >> 24), (uint8_t)(v >> 16), (uint8_t)(v >> 8),
+            (uint8_t)v };
+    write(d, sizeof(d));
+    return *this;
+}
+
+particle::CBORWriter& particle::CBORWriter::value(double val) {
+    // Converting a finite value that is out of the range of float is undefined behavior
+    if (!std::isfinite(val) || (std::fabs(val) <= FLT_MAX && (double)(float)val == val)) {
+        return value((float)val);
+    }
+    uint64_t v = 0;
+    memcpy(&v, &val, sizeof(v));
+    uint8_t d[9] = { (MAJOR_SIMPLE << 5) | SIMPLE_DOUBLE };
+    for (unsigned i = 0; i < 8; ++i) {
+        d[8 - i] = (uint8_t)(v >> (i * 8));
+    }
+    write(d, sizeof(d));
+    return *this;
+}
+
+particle::CBORWriter& particle::CBORWriter::value(const char* val, size_t size) {
+    writeHead(MAJOR_TEXT, size);
+    write((const uint8_t*)val, size);
+    return *this;
+}
+
+particle::CBORWriter& particle::CBORWriter::bytes(const void* data, size_t size) {
+    writeHead(MAJOR_BYTES, size);
+    write((const uint8_t*)data, size);
+    return *this;
+}
+
+particle::CBORWriter& particle::CBORWriter::tag(uint64_t tag) {
+    writeHead(MAJOR_TAG, tag);
+    return *this;
+}
+
+particle::CBORWriter& particle::CBORWriter::nullValue() {
+    writeByte((MAJOR_SIMPLE << 5) | SIMPLE_NULL);
+    return *this;
+}
+
+void particle::CBORWriter::writeHead(uint8_t majorType, uint64_t val) {
+    uint8_t d[9] = {};
+    size_t n = 0;
+    if (val < 24) {
+        d[0] = (majorType << 5) | val;
+        n = 1;
+    } else if (val <= 0xff) {
+        d[0] = (majorType << 5) | 24;
+        n = 2;
+    } else if (val <= 0xffff) {
+        d[0] = (majorType << 5) | 25;
+        n = 3;
+    } else if (val <= 0xffffffffu) {
+        d[0] = (majorType << 5) | 26;
+        n = 5;
+    } else {
+        d[0] = (majorType << 5) | 27;
+        n = 9;
+    }
+    for (size_t i = n - 1; i > 0; --i) {
+        d[i] = val & 0xff;
+        val >>= 8;
+    }
+    write(d, n);
+}
+
+// particle::CBORBufferWriter
+void particle::CBORBufferWriter::write(const uint8_t* data, size_t size) {
+    if (n_ < bufSize_) {
+        memcpy(buf_ + n_, data, std::min(size, bufSize_ - n_));
+    }
+    n_ += size;
+}
+
+// particle::CBORReader
+bool particle::CBORReader::next() {
+    type_ = CBORType::INVALID;
+    val_ = 0;
+    dval_ = 0;
+    str_ = nullptr;
+    indef_ = false;
+    if (error_ || offs_ >= size_) {
+        return false;
+    }
+    uint8_t major = 0;
+    uint8_t info = 0;
+    if (!readHead(&major, &info, &val_)) {
+        return setError();
+    }
+    switch (major) {
+    case MAJOR_UNSIGNED_INT:
+        type_ = CBORType::UNSIGNED_INT;
+        break;
+    case MAJOR_NEGATIVE_INT:
+        type_ = CBORType::NEGATIVE_INT;
+        break;
+    case MAJOR_BYTES:
+    case MAJOR_TEXT:
+        if (indef_ || val_ > size_ - offs_) {
+            return setError();
+        }
+        type_ = (major == MAJOR_TEXT) ? CBORType::TEXT : CBORType::BYTES;
+        str_ = (const char*)data_ + offs_;
+        offs_ += val_;
+        break;
+    case MAJOR_ARRAY:
+        type_ = CBORType::ARRAY;
+        break;
+    case MAJOR_MAP:
+        type_ = CBORType::MAP;
+        break;
+    case MAJOR_TAG:
+        if (indef_) {
+            return setError();
+        }
+        type_ = CBORType::TAG;
+        break;
+    default: { // MAJOR_SIMPLE
+        if (indef_) {
+            indef_ = false;
+            type_ = CBORType::BREAK;
+            break;
+        }
+        switch (info) {
+        case SIMPLE_FALSE:
+        case SIMPLE_TRUE:
+            type_ = CBORType::BOOL;
+            val_ = (info == SIMPLE_TRUE);
+            break;
+        case SIMPLE_NULL:
+            type_ = CBORType::NULL_VALUE;
+            break;
+        case SIMPLE_UNDEFINED:
+            type_ = CBORType::UNDEFINED;
+            break;
+        case SIMPLE_HALF_FLOAT:
+            type_ = CBORType::FLOAT;
+            dval_ = halfToDouble(val_);
+            break;
+        case SIMPLE_FLOAT: {
+            const uint32_t v = val_;
+            float f = 0;
+            memcpy(&f, &v, sizeof(f));
+            type_ = CBORType::FLOAT;
+            dval_ = f;
+            break;
+        }
+        case SIMPLE_DOUBLE:
+            type_ = CBORType::FLOAT;
+            memcpy(&dval_, &val_, sizeof(dval_));
+            break;
+        default:
+            return setError(); // Unassigned simple value
+        }
+        val_ = (type_ == CBORType::BOOL) ? val_ : 0;
+        break;
+    }
+    }
+    return true;
+}
+
+bool particle::CBORReader::skip() {
+    if (!skipItem(this, 0)) {
+        return setError();
+    }
+    return true;
+}
+
+int64_t particle::CBORReader::toInt() const {
+    switch (type_) {
+    case CBORType::UNSIGNED_INT:
+        return val_;
+    case CBORType::NEGATIVE_INT:
+        return -1 - (int64_t)val_;
+    case CBORType::FLOAT:
+        return doubleToInt(dval_);
+    case CBORType::BOOL:
+        return val_;
+    default:
+        return 0;
+    }
+}
+
+uint64_t particle::CBORReader::toUInt() const {
+    switch (type_) {
+    case CBORType::UNSIGNED_INT:
+    case CBORType::BOOL:
+        return val_;
+    case CBORType::FLOAT:
+        return doubleToUInt(dval_);
+    default:
+        return 0;
+    }
+}
+
+double particle::CBORReader::toDouble() const {
+    switch (type_) {
+    case CBORType::UNSIGNED_INT:
+    case CBORType::BOOL:
+        return val_;
+    case CBORType::NEGATIVE_INT:
+        return -1.0 - (double)val_;
+    case CBORType::FLOAT:
+        return dval_;
+    default:
+        return 0;
+    }
+}
+
+bool particle::CBORReader::readHead(uint8_t* majorType, uint8_t* info, uint64_t* val) {
+    const uint8_t b = data_[offs_++];
+    *majorType = b >> 5;
+    *info = b & 0x1f;
+    size_t n = 0;
+    if (*info < 24) {
+        *val = *info;
+        return true;
+    } else if (*info == INDEFINITE_LENGTH) {
+        if (*majorType == MAJOR_UNSIGNED_INT || *majorType == MAJOR_NEGATIVE_INT) {
+            return false;
+        }
+        indef_ = true;
+        *val = 0;
+        return true;
+    } else if (*info == 24) {
+        n = 1;
+    } else if (*info == 25) {
+        n = 2;
+    } else if (*info == 26) {
+        n = 4;
+    } else if (*info == 27) {
+        n = 8;
+    } else {
+        return false; // Reserved
+    }
+    if (n > size_ - offs_) {
+        return false;
+    }
+    uint64_t v = 0;
+    for (size_t i = 0; i < n; ++i) {
+        v = (v << 8) | data_[offs_++];
+    }
+    *val = v;
+    return true;
+}
+
+bool particle::CBORReader::setError() {
+    type_ = CBORType::INVALID;
+    error_ = true;
+    return false;
+}
@@ -1,7 +1,9 @@
 #include "spark_wiring_cloud.h"
 
 #include <functional>
+#include <new>
 #include "system_cloud.h"
+#include "hal_platform.h"
 
 namespace {
 
@@ -52,21 +54,108 @@ void CloudClass::call_wiring_event_handler(const void* handler_data, const char
     (*fn)(event_name, data);
 }
 
-bool CloudClass::register_function(cloud_function_t fn, void* data, const char* funcKey)
+void CloudClass::call_wiring_binary_event_handler(void* handler_data, const char* event_name, const char* data,
+        size_t data_size, unsigned content_type)
+{
+    const auto fn = (wiring_binary_event_handler_t*)handler_data;
+    (*fn)(event_name, (const uint8_t*)data, data_size, (ContentType)content_type);
+}
+
+bool CloudClass::subscribe(const char* name, wiring_binary_event_handler_t handler, Spark_Subscription_Scope_TypeDef scope,
+        const char* deviceID)
+{
+    if (!handler) {
+        return false;
+    }
+    const auto wrapper = new(std::nothrow) wiring_binary_event_handler_t(std::move(handler));
+    if (!wrapper) {
+        return false;
+    }
+    spark_subscribe_param param = {};
+    param.size = sizeof(param);
+    param.flags = SUBSCRIBE_FLAG_BINARY_DATA;
+    if (!spark_subscribe(name, (EventHandler)call_wiring_binary_event_handler, wrapper, scope, deviceID, &param)) {
+        delete wrapper;
+        return false;
+    }
+    return true;
+}
+
+bool CloudClass::register_function(cloud_function_t fn, void* data, const char* funcKey, const CloudFunctionOptions* options)
 {
     cloud_function_descriptor desc = {};
     desc.size = sizeof(desc);
     desc.fn = fn;
     desc.data = (void*)data;
     desc.funcKey = funcKey;
+    if (options) {
+        options->toSystemDescriptor(&desc);
+    }
     return spark_function(NULL, (user_function_int_str_t*)&desc, NULL);
 }
 
+bool CloudClass::_variable(const char* varKey, cloud_variable_reader_fn* reader)
+{
+    spark_variable_t extra = {};
+    extra.size = sizeof(extra);
+    extra.read = read_variable_block;
+    extra.copy = copy_variable_blocks; // Used if the system doesn't support block reads
+    return spark_variable(varKey, (const void*)reader, CloudVariableTypeString::TYPE_ID, &extra);
+}
+
+int CloudClass::read_variable_block(const void* var, size_t offset, void* data, size_t size, size_t* total_size)
+{
+    const auto reader = (cloud_variable_reader_fn*)var;
+    return reader(offset, (char*)data, size, total_size);
+}
+
+int CloudClass::copy_variable_blocks(const void* var, void** data, size_t* size)
+{
+    const auto reader = (cloud_variable_reader_fn*)var;
+    size_t total = 0;
+    int ret = reader(0 /* offset */, nullptr /* data */, 0 /* size */, &total);
+    if (ret < 0) {
+        return ret;
+    }
+    const auto buf = (char*)malloc(total ? total : 1);
+    if (!buf) {
+        return SYSTEM_ERROR_NO_MEMORY;
+    }
+    size_t offs = 0;
+    while (offs < total) {
+        size_t t = 0;
+        ret = reader(offs, buf + offs, total - offs, &t);
+        if (ret <= 0) {
+            break; // The value has shrunk or an error occured
+        }
+        offs += ret;
+    }
+    if (ret < 0) {
+        free(buf);
+        return ret;
+    }
+    *data = buf;
+    *size = offs;
+    return 0;
+}
+
 Future<bool> CloudClass::publish_event(const char *eventName, const char *eventData, int ttl, PublishFlags flags) {
+    return publish_event(eventName, eventData, 0 /* dataSize */, ContentType::TEXT, ttl, flags);
+}
+
+Future<bool> CloudClass::publish_event(const char* eventName, const char* eventData, size_t dataSize, ContentType type,
+        int ttl, PublishFlags flags) {
+#if HAL_PLATFORM_FILESYSTEM
+    // Persistent events are stored in the publish queue while the device is offline
+    if (!connected() && !(flags & PERSISTENT)) {
+#else
     if (!connected()) {
+#endif
         return Future<bool>(Error::INVALID_STATE);
     }
     spark_send_event_data d = { sizeof(spark_send_event_data) };
+    d.data_size = dataSize;
+    d.content_type = (uint16_t)type;
 
     // Completion handler
     Promise<bool> p;
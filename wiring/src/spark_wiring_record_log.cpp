@@ -0,0 +1,468 @@
+/*
+ * Copyright (c) 2020 Particle Industries, Inc.  All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "spark_wiring_record_log.h"
+
+#if HAL_PLATFORM_FILESYSTEM
+
+#include "core_hal.h"
+#include "system_error.h"
+#include "check.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+#include <limits>
+
+namespace particle {
+
+namespace {
+
+const uint32_t SEGMENT_MAGIC = 0x474f4c52; // "RLOG"
+const uint16_t SEGMENT_VERSION = 1;
+
+const uint32_t CONSUMED_MAGIC = 0x534e4f43; // "CONS"
+
+const char CONSUMED_FILE_NAME[] = "consumed";
+const char CONSUMED_TEMP_FILE_NAME[] = "consumed.tmp";
+
+// Segment files are named after their sequence number, as 8 hex digits
+const size_t SEGMENT_NAME_LENGTH = 8;
+const size_t MAX_FILE_NAME_LENGTH = std::max(SEGMENT_NAME_LENGTH, sizeof(CONSUMED_TEMP_FILE_NAME) - 1);
+
+struct SegmentHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t recordSize;
+    uint32_t recordsPerSegment;
+    uint32_t segment;
+} __attribute__((packed));
+
+struct RecordHeader {
+    uint16_t size;
+    uint16_t reserved;
+    uint32_t crc;
+} __attribute__((packed));
+
+struct ConsumedMarker {
+    uint32_t magic;
+    uint32_t index;
+} __attribute__((packed));
+
+bool parseSegmentName(const char* name, uint32_t* seg) {
+    if (strlen(name) != SEGMENT_NAME_LENGTH) {
+        return false;
+    }
+    uint32_t val = 0;
+    for (size_t i = 0; i < SEGMENT_NAME_LENGTH; ++i) {
+        const char c = name[i];
+        uint32_t d = 0;
+        if (c >= '0' && c <= '9') {
+            d = c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+            d = c - 'a' + 10;
+        } else {
+            return false;
+        }
+        val = (val << 4) | d;
+    }
+    *seg = val;
+    return true;
+}
+
+uint32_t recordCrc(const uint8_t* data, size_t size) {
+    return HAL_Core_Compute_CRC32(data, size);
+}
+
+} // namespace
+
+RecordLog::RecordLog() :
+        path_(nullptr),
+        dirLen_(0),
+        slot_(nullptr),
+        recordSize_(0),
+        recordsPerSeg_(1),
+        maxSegs_(0),
+        tailSeg_(0),
+        headSeg_(0),
+        headCount_(0),
+        consumed_(0),
+        headFd_(-1),
+        readFd_(-1),
+        readSeg_(0) {
+}
+
+RecordLog::~RecordLog() {
+    close();
+}
+
+int RecordLog::open(const char* dir, size_t recordSize, size_t recordsPerSegment, size_t maxSegments) {
+    CHECK_FALSE(isOpen(), SYSTEM_ERROR_INVALID_STATE);
+    CHECK_TRUE(dir && *dir, SYSTEM_ERROR_INVALID_ARGUMENT);
+    CHECK_TRUE(recordSize > 0 && recordSize <= std::numeric_limits<uint16_t>::max(), SYSTEM_ERROR_INVALID_ARGUMENT);
+    CHECK_TRUE(recordsPerSegment > 0 && maxSegments >= 2, SYSTEM_ERROR_INVALID_ARGUMENT);
+    CHECK_TRUE(recordsPerSegment <= std::numeric_limits<uint32_t>::max() / maxSegments, SYSTEM_ERROR_INVALID_ARGUMENT);
+    const size_t dirLen = strlen(dir);
+    path_ = (char*)malloc(dirLen + MAX_FILE_NAME_LENGTH + 2); // Separator and term. null
+    slot_ = (uint8_t*)malloc(sizeof(RecordHeader) + recordSize);
+    if (!path_ || !slot_) {
+        reset();
+        return SYSTEM_ERROR_NO_MEMORY;
+    }
+    memcpy(path_, dir, dirLen);
+    path_[dirLen] = '/';
+    path_[dirLen + 1] = '\0';
+    dirLen_ = dirLen;
+    recordSize_ = recordSize;
+    recordsPerSeg_ = recordsPerSegment;
+    maxSegs_ = maxSegments;
+    path_[dirLen] = '\0';
+    int r = mkdir(path_, 0777);
+    path_[dirLen] = '/';
+    if (r < 0 && errno != EEXIST) {
+        reset();
+        return SYSTEM_ERROR_FILE;
+    }
+    r = recover();
+    if (r < 0) {
+        reset();
+        return r;
+    }
+    return 0;
+}
+
+int RecordLog::close() {
+    int result = 0;
+    if (headFd_ >= 0 && ::close(headFd_) < 0) {
+        result = SYSTEM_ERROR_FILE;
+    }
+    headFd_ = -1;
+    reset();
+    return result;
+}
+
+int RecordLog::append(const void* data, size_t size, uint32_t* index) {
+    CHECK_TRUE(isOpen(), SYSTEM_ERROR_INVALID_STATE);
+    CHECK_TRUE(size <= recordSize_, SYSTEM_ERROR_TOO_LARGE);
+    CHECK_TRUE(data || !size, SYSTEM_ERROR_INVALID_ARGUMENT);
+    if (headFd_ < 0 || headCount_ >= recordsPerSeg_) {
+        CHECK(startSegment());
+    }
+    RecordHeader h = {};
+    h.size = size;
+    h.crc = recordCrc((const uint8_t*)data, size);
+    memcpy(slot_, &h, sizeof(h));
+    if (size > 0) {
+        memcpy(slot_ + sizeof(h), data, size);
+    }
+    memset(slot_ + sizeof(h) + size, 0, recordSize_ - size);
+    const ssize_t n = ::write(headFd_, slot_, slotSize());
+    if (n != (ssize_t)slotSize()) {
+        // Discard a partially written slot
+        const off_t offs = sizeof(SegmentHeader) + (off_t)headCount_ * slotSize();
+        if (n > 0 && (ftruncate(headFd_, offs) < 0 || lseek(headFd_, offs, SEEK_SET) < 0)) {
+            ::close(headFd_);
+            headFd_ = -1;
+        }
+        return SYSTEM_ERROR_FILE;
+    }
+    if (index) {
+        *index = end();
+    }
+    ++headCount_;
+    return 0;
+}
+
+int RecordLog::read(uint32_t index, void* data, size_t size) {
+    CHECK_TRUE(isOpen(), SYSTEM_ERROR_INVALID_STATE);
+    CHECK_TRUE(data || !size, SYSTEM_ERROR_INVALID_ARGUMENT);
+    if (index < begin() || index >= end()) {
+        return SYSTEM_ERROR_NOT_FOUND;
+    }
+    const uint32_t seg = index / recordsPerSeg_;
+    const int fd = (seg == headSeg_) ? headFd_ : CHECK(readFd(seg));
+    const off_t offs = sizeof(SegmentHeader) + (off_t)(index % recordsPerSeg_) * slotSize();
+    // pread() doesn't change the file offset of the head segment
+    const ssize_t n = pread(fd, slot_, slotSize(), offs);
+    CHECK_TRUE(n == (ssize_t)slotSize(), SYSTEM_ERROR_FILE);
+    RecordHeader h = {};
+    memcpy(&h, slot_, sizeof(h));
+    const uint8_t* const d = slot_ + sizeof(h);
+    CHECK_TRUE(h.size <= recordSize_ && recordCrc(d, h.size) == h.crc, SYSTEM_ERROR_BAD_DATA);
+    if (size > 0) {
+        memcpy(data, d, std::min<size_t>(size, h.size));
+    }
+    return h.size;
+}
+
+int RecordLog::sync() {
+    CHECK_TRUE(isOpen(), SYSTEM_ERROR_INVALID_STATE);
+    if (headFd_ >= 0 && fsync(headFd_) < 0) {
+        return SYSTEM_ERROR_FILE;
+    }
+    return 0;
+}
+
+uint32_t RecordLog::consumed() const {
+    return std::min(std::max(consumed_, begin()), end());
+}
+
+int RecordLog::consumed(uint32_t index) {
+    CHECK_TRUE(isOpen(), SYSTEM_ERROR_INVALID_STATE);
+    CHECK_TRUE(index <= end(), SYSTEM_ERROR_OUT_OF_RANGE);
+    // Write the marker to a temporary file and rename it, so that either the old or the new
+    // marker is available after a reset
+    const int fd = ::open(filePath(CONSUMED_TEMP_FILE_NAME), O_CREAT | O_TRUNC | O_WRONLY, 0666);
+    CHECK_TRUE(fd >= 0, SYSTEM_ERROR_FILE);
+    ConsumedMarker m = {};
+    m.magic = CONSUMED_MAGIC;
+    m.index = index;
+    const bool ok = ::write(fd, &m, sizeof(m)) == (ssize_t)sizeof(m) && fsync(fd) == 0;
+    if (::close(fd) < 0 || !ok) {
+        unlink(path_);
+        return SYSTEM_ERROR_FILE;
+    }
+    char* const tempPath = strdup(path_);
+    CHECK_TRUE(tempPath, SYSTEM_ERROR_NO_MEMORY);
+    const int r = rename(tempPath, filePath(CONSUMED_FILE_NAME));
+    free(tempPath);
+    CHECK_TRUE(r == 0, SYSTEM_ERROR_FILE);
+    consumed_ = index;
+    return 0;
+}
+
+int RecordLog::recover() {
+    path_[dirLen_] = '\0';
+    DIR* const d = opendir(path_);
+    path_[dirLen_] = '/';
+    CHECK_TRUE(d, SYSTEM_ERROR_FILE);
+    bool found = false;
+    uint32_t minSeg = 0;
+    uint32_t maxSeg = 0;
+    struct dirent* ent = nullptr;
+    while ((ent = readdir(d))) {
+        uint32_t seg = 0;
+        if (!parseSegmentName(ent->d_name, &seg)) {
+            continue;
+        }
+        if (!found || seg < minSeg) {
+            minSeg = seg;
+        }
+        if (!found || seg > maxSeg) {
+            maxSeg = seg;
+        }
+        found = true;
+    }
+    closedir(d);
+    if (found) {
+        tailSeg_ = minSeg;
+        headSeg_ = maxSeg;
+        // Only the newest segment can be incomplete
+        const int fd = ::open(segmentPath(maxSeg), O_RDWR);
+        CHECK_TRUE(fd >= 0, SYSTEM_ERROR_FILE);
+        SegmentHeader h = {};
+        if (::read(fd, &h, sizeof(h)) == (ssize_t)sizeof(h)) {
+            int r = 0;
+            if (h.magic != SEGMENT_MAGIC || h.version != SEGMENT_VERSION || h.segment != maxSeg) {
+                r = SYSTEM_ERROR_BAD_DATA;
+            } else if (h.recordSize != recordSize_ || h.recordsPerSegment != recordsPerSeg_) {
+                r = SYSTEM_ERROR_INVALID_ARGUMENT;
+            }
+            const off_t size = (r == 0) ? lseek(fd, 0, SEEK_END) : -1;
+            if (r == 0 && size < (off_t)sizeof(h)) {
+                r = SYSTEM_ERROR_FILE;
+            }
+            if (r == 0) {
+                headCount_ = std::min<off_t>((size - sizeof(h)) / slotSize(), recordsPerSeg_);
+                // Discard a partially written slot
+                const off_t offs = sizeof(h) + (off_t)headCount_ * slotSize();
+                if (size != offs && (ftruncate(fd, offs) < 0 || lseek(fd, offs, SEEK_SET) != offs)) {
+                    r = SYSTEM_ERROR_FILE;
+                }
+            }
+            if (r < 0) {
+                ::close(fd);
+                return r;
+            }
+            headFd_ = fd;
+        } else {
+            // The device was reset while the segment was being created
+            ::close(fd);
+            CHECK_TRUE(unlink(segmentPath(maxSeg)) == 0, SYSTEM_ERROR_FILE);
+            if (minSeg == maxSeg) {
+                tailSeg_ = maxSeg;
+            }
+        }
+        // The device was reset after a new segment was created but before the oldest one was removed
+        while (headSeg_ - tailSeg_ >= maxSegs_) {
+            unlink(segmentPath(tailSeg_));
+            ++tailSeg_;
+        }
+    }
+    CHECK(loadConsumed());
+    return 0;
+}
+
+int RecordLog::loadConsumed() {
+    const int fd = ::open(filePath(CONSUMED_FILE_NAME), O_RDONLY);
+    if (fd < 0) {
+        consumed_ = begin();
+        return 0;
+    }
+    ConsumedMarker m = {};
+    const ssize_t n = ::read(fd, &m, sizeof(m));
+    ::close(fd);
+    if (n != (ssize_t)sizeof(m) || m.magic != CONSUMED_MAGIC) {
+        consumed_ = begin();
+        return 0;
+    }
+    consumed_ = m.index;
+    return 0;
+}
+
+int RecordLog::startSegment() {
+    uint32_t seg = headSeg_;
+    if (headFd_ >= 0) {
+        // The current segment is full
+        const int r = ::close(headFd_);
+        headFd_ = -1;
+        CHECK_TRUE(r == 0, SYSTEM_ERROR_FILE);
+        ++seg;
+    }
+    // Remove the oldest segments to make room for the new one
+    while (seg - tailSeg_ >= maxSegs_) {
+        if (readFd_ >= 0 && readSeg_ == tailSeg_) {
+            ::close(readFd_);
+            readFd_ = -1;
+        }
+        if (unlink(segmentPath(tailSeg_)) < 0 && errno != ENOENT) {
+            return SYSTEM_ERROR_FILE;
+        }
+        ++tailSeg_;
+    }
+    headSeg_ = seg;
+    headCount_ = 0;
+    const int fd = ::open(segmentPath(seg), O_CREAT | O_TRUNC | O_RDWR, 0666);
+    CHECK_TRUE(fd >= 0, SYSTEM_ERROR_FILE);
+    SegmentHeader h = {};
+    h.magic = SEGMENT_MAGIC;
+    h.version = SEGMENT_VERSION;
+    h.recordSize = recordSize_;
+    h.recordsPerSegment = recordsPerSeg_;
+    h.segment = seg;
+    // Make sure the segment can be found after a reset even if no records are synced to it
+    if (::write(fd, &h, sizeof(h)) != (ssize_t)sizeof(h) || fsync(fd) < 0) {
+        ::close(fd);
+        unlink(segmentPath(seg));
+        return SYSTEM_ERROR_FILE;
+    }
+    headFd_ = fd;
+    return 0;
+}
+
+int RecordLog::readFd(uint32_t seg) {
+    if (readFd_ >= 0) {
+        if (readSeg_ == seg) {
+            return readFd_;
+        }
+        ::close(readFd_);
+        readFd_ = -1;
+    }
+    const int fd = ::open(segmentPath(seg), O_RDONLY);
+    if (fd < 0) {
+        return (errno == ENOENT) ? SYSTEM_ERROR_NOT_FOUND : SYSTEM_ERROR_FILE;
+    }
+    readFd_ = fd;
+    readSeg_ = seg;
+    return fd;
+}
+
+const char* RecordLog::filePath(const char* name) {
+    strcpy(path_ + dirLen_ + 1, name);
+    return path_;
+}
+
+const char* RecordLog::segmentPath(uint32_t seg) {
+    char name[SEGMENT_NAME_LENGTH + 1] = {};
+    snprintf(name, sizeof(name), "%08lx", (unsigned long)seg);
+    return filePath(name);
+}
+
+size_t RecordLog::slotSize() const {
+    return sizeof(RecordHeader) + recordSize_;
+}
+
+void RecordLog::reset() {
+    if (readFd_ >= 0) {
+        ::close(readFd_);
+    }
+    free(path_);
+    free(slot_);
+    path_ = nullptr;
+    dirLen_ = 0;
+    slot_ = nullptr;
+    recordSize_ = 0;
+    recordsPerSeg_ = 1;
+    maxSegs_ = 0;
+    tailSeg_ = 0;
+    headSeg_ = 0;
+    headCount_ = 0;
+    consumed_ = 0;
+    headFd_ = -1;
+    readFd_ = -1;
+    readSeg_ = 0;
+}
+
+RecordLogReader::RecordLogReader(RecordLog& log) :
+        log_(log),
+        pos_(log.consumed()) {
+}
+
+int RecordLogReader::next(void* data, size_t size, uint32_t* index) {
+    for (;;) {
+        // Skip the records that were removed from the log
+        pos_ = std::max(pos_, log_.begin());
+        if (pos_ >= log_.end()) {
+            return SYSTEM_ERROR_END_OF_STREAM;
+        }
+        const int r = log_.read(pos_, data, size);
+        if (r == SYSTEM_ERROR_NOT_FOUND) {
+            ++pos_;
+            continue;
+        }
+        CHECK(r);
+        if (index) {
+            *index = pos_;
+        }
+        ++pos_;
+        return r;
+    }
+}
+
+int RecordLogReader::commit() {
+    return log_.consumed(pos_);
+}
+
+} // namespace particle
+
+#endif // HAL_PLATFORM_FILESYSTEM
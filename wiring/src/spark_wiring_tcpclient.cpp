@@ -202,6 +202,48 @@ void TCPClient::flush_buffer()
   d_->total = 0;
 }
 
+#if HAL_PLATFORM_SOCKET_BUFFERS
+
+int TCPClient::receive(SocketBuffer* buf, system_tick_t timeout)
+{
+    if (!buf || bufferCount())
+    {
+        return -1;
+    }
+    buf->release();
+    if (!Network.from(nif_).ready() || !isOpen(d_->sock))
+    {
+        return -1;
+    }
+    return socket_receive_buffer(d_->sock, &buf->buf_, timeout, nullptr);
+}
+
+int TCPClient::allocBuffer(SocketBuffer* buf, size_t size)
+{
+    if (!buf || !status())
+    {
+        return -1;
+    }
+    buf->release();
+    return socket_alloc_buffer(d_->sock, &buf->buf_, size, nullptr);
+}
+
+int TCPClient::send(SocketBuffer* buf, size_t size)
+{
+    if (!buf)
+    {
+        return -1;
+    }
+    clearWriteError();
+    int ret = socket_send_buffer(d_->sock, &buf->buf_, size, nullptr, nullptr);
+    if (ret < 0) {
+        setWriteError(ret);
+    }
+    return ret;
+}
+
+#endif // HAL_PLATFORM_SOCKET_BUFFERS
+
 void TCPClient::flush()
 {
 }
@@ -159,7 +159,7 @@ int UDP::endPacket()
     return result;
 }
 
-int UDP::sendPacket(const uint8_t* buffer, size_t buffer_size, IPAddress remoteIP, uint16_t port)
+static sockaddr_t toSockAddr(IPAddress remoteIP, uint16_t port)
 {
     sockaddr_t remoteSockAddr;
     remoteSockAddr.sa_family = AF_INET;
@@ -171,7 +171,12 @@ int UDP::sendPacket(const uint8_t* buffer, size_t buffer_size, IPAddress remoteI
     remoteSockAddr.sa_data[3] = remoteIP[1];
     remoteSockAddr.sa_data[4] = remoteIP[2];
     remoteSockAddr.sa_data[5] = remoteIP[3];
+    return remoteSockAddr;
+}
 
+int UDP::sendPacket(const uint8_t* buffer, size_t buffer_size, IPAddress remoteIP, uint16_t port)
+{
+    sockaddr_t remoteSockAddr = toSockAddr(remoteIP, port);
     int rv = socket_sendto(_sock, buffer, buffer_size, 0, &remoteSockAddr, sizeof(remoteSockAddr));
     DEBUG("sendto(buffer=%lx, size=%d)=%d",buffer, buffer_size , rv);
     return rv;
@@ -226,6 +231,49 @@ int UDP::receivePacket(uint8_t* buffer, size_t size, system_tick_t timeout)
     return ret;
 }
 
+#if HAL_PLATFORM_SOCKET_BUFFERS
+
+int UDP::receivePacket(SocketBuffer* buf, system_tick_t timeout)
+{
+    int ret = -1;
+    if (Network.from(_nif).ready() && isOpen(_sock) && buf)
+    {
+        buf->release();
+        ret = socket_receive_buffer(_sock, &buf->buf_, timeout, nullptr);
+        if (ret > 0)
+        {
+            _remotePort = buf->remotePort();
+            _remoteIP = buf->remoteIP();
+        }
+    }
+    return ret;
+}
+
+int UDP::allocPacket(SocketBuffer* buf, size_t size)
+{
+    int ret = -1;
+    if (isOpen(_sock) && buf)
+    {
+        buf->release();
+        ret = socket_alloc_buffer(_sock, &buf->buf_, size, nullptr);
+    }
+    return ret;
+}
+
+int UDP::sendPacket(SocketBuffer* buf, size_t size, IPAddress remoteIP, uint16_t port)
+{
+    if (!buf)
+    {
+        return -1;
+    }
+    sockaddr_t remoteSockAddr = toSockAddr(remoteIP, port);
+    int rv = socket_send_buffer(_sock, &buf->buf_, size, &remoteSockAddr, nullptr);
+    DEBUG("sendto(size=%d)=%d", size, rv);
+    return rv;
+}
+
+#endif // HAL_PLATFORM_SOCKET_BUFFERS
+
 int UDP::read()
 {
   return available() ? _buffer[_offset++] : -1;